@@ -41,6 +41,8 @@ TwoDARegistry::~TwoDARegistry() {
 }
 
 void TwoDARegistry::clear() {
+	Common::StackLock lock(_mutex);
+
 	for (TwoDAMap::iterator it = _twodas.begin(); it != _twodas.end(); ++it)
 		delete it->second;
 
@@ -48,6 +50,8 @@ void TwoDARegistry::clear() {
 }
 
 const TwoDAFile &TwoDARegistry::get(const Common::UString &name) {
+	Common::StackLock lock(_mutex);
+
 	TwoDAMap::const_iterator twoda = _twodas.find(name);
 	if (twoda != _twodas.end())
 		// Entry exists => return
@@ -64,6 +68,8 @@ const TwoDAFile &TwoDARegistry::get(const Common::UString &name) {
 }
 
 void TwoDARegistry::add(const Common::UString &name) {
+	Common::StackLock lock(_mutex);
+
 	TwoDAMap::iterator twoda = _twodas.find(name);
 	if (twoda != _twodas.end()) {
 		// Entry exists => remove first
@@ -76,6 +82,8 @@ void TwoDARegistry::add(const Common::UString &name) {
 }
 
 void TwoDARegistry::remove(const Common::UString &name) {
+	Common::StackLock lock(_mutex);
+
 	TwoDAMap::iterator twoda = _twodas.find(name);
 	if (twoda == _twodas.end())
 		// Does exist, nothing to do
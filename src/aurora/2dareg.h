@@ -29,6 +29,7 @@
 
 #include "src/common/ustring.h"
 #include "src/common/singleton.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 
@@ -36,7 +37,10 @@ namespace Aurora {
 
 class TwoDAFile;
 
-/** The global 2DA registry, holding all current 2DAs. */
+/** The global 2DA registry, holding all current 2DAs.
+ *
+ *  2DAs can be requested from several threads at the same time.
+ */
 class TwoDARegistry : public Common::Singleton<TwoDARegistry> {
 public:
 	TwoDARegistry();
@@ -57,6 +61,8 @@ private:
 
 	TwoDAMap _twodas;
 
+	Common::Mutex _mutex;
+
 	TwoDAFile *load(const Common::UString &name);
 };
 
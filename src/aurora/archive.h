@@ -69,6 +69,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	virtual Common::SeekableReadStream *getResource(uint32 index) const = 0;
 
+	/** Does the resource need to be decompressed when it's read? */
+	virtual bool isResourceCompressed(uint32 index) const;
+
 	/** Return with which algorithm the name is hashed. */
 	virtual Common::HashAlgo getNameHashAlgo() const;
 };
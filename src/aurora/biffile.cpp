@@ -26,6 +26,8 @@
 #include "src/common/error.h"
 #include "src/common/stream.h"
 #include "src/common/file.h"
+#include "src/common/filepool.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/biffile.h"
 #include "src/aurora/keyfile.h"
@@ -37,11 +39,17 @@ static const uint32 kVersion11 = MKTAG('V', '1', '.', '1');
 
 namespace Aurora {
 
-BIFFile::BIFFile(const Common::UString &fileName) : _fileName(fileName) {
+BIFFile::BIFFile(const Common::UString &fileName, bool mapped) : _fileName(fileName) {
 	load();
+
+	if (mapped)
+		map();
+
+	FilePoolMan.open(_fileName);
 }
 
 BIFFile::~BIFFile() {
+	FilePoolMan.close(_fileName);
 }
 
 void BIFFile::clear() {
@@ -147,20 +155,10 @@ Common::SeekableReadStream *BIFFile::getResource(uint32 index) const {
 	if (res.size == 0)
 		return new Common::MemoryReadStream(0, 0);
 
-	Common::File bif;
-	open(bif);
-
-	if (!bif.seek(res.offset))
-		throw Common::Exception(Common::kSeekError);
-
-	Common::SeekableReadStream *resStream = bif.readStream(res.size);
+	if (_mappedFile)
+		return new Common::MappedFileReadStream(_mappedFile, res.offset, res.size);
 
-	if (!resStream || (((uint32) resStream->size()) != res.size)) {
-		delete resStream;
-		throw Common::Exception(Common::kReadError);
-	}
-
-	return resStream;
+	return FilePoolMan.readStream(_fileName, res.offset, res.size);
 }
 
 void BIFFile::open(Common::File &file) const {
@@ -168,4 +166,13 @@ void BIFFile::open(Common::File &file) const {
 		throw Common::Exception(Common::kOpenError);
 }
 
+void BIFFile::map() {
+	_mappedFile.reset(new Common::MappedFile);
+
+	if (!_mappedFile->open(_fileName)) {
+		warning("Failed to map BIF \"%s\" into memory", _fileName.c_str());
+		_mappedFile.reset();
+	}
+}
+
 } // End of namespace Aurora
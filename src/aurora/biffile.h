@@ -27,6 +27,8 @@
 
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "src/common/types.h"
 
 #include "src/aurora/types.h"
@@ -36,6 +38,7 @@
 namespace Common {
 	class SeekableReadStream;
 	class File;
+	class MappedFile;
 }
 
 namespace Aurora {
@@ -45,7 +48,12 @@ class KEYFile;
 /** Class to hold resource data information of a bif file. */
 class BIFFile : public Archive, public AuroraBase {
 public:
-	BIFFile(const Common::UString &fileName);
+	/** Open a BIF file.
+	 *
+	 *  @param fileName The name of the BIF file.
+	 *  @param mapped Map the BIF into memory and return zero-copy resource streams?
+	 */
+	BIFFile(const Common::UString &fileName, bool mapped = false);
 	~BIFFile();
 
 	/** Clear the resource list. */
@@ -83,7 +91,11 @@ private:
 	/** The name of the BIF file. */
 	Common::UString _fileName;
 
+	/** The BIF file mapped into memory, if requested. */
+	boost::shared_ptr<Common::MappedFile> _mappedFile;
+
 	void open(Common::File &file) const;
+	void map();
 
 	void load();
 	void readVarResTable(Common::SeekableReadStream &bif, uint32 offset);
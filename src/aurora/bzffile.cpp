@@ -31,6 +31,7 @@
 #include "src/common/error.h"
 #include "src/common/stream.h"
 #include "src/common/file.h"
+#include "src/common/filepool.h"
 
 #include "src/aurora/bzffile.h"
 #include "src/aurora/keyfile.h"
@@ -43,9 +44,12 @@ namespace Aurora {
 
 BZFFile::BZFFile(const Common::UString &fileName) : _fileName(fileName) {
 	load();
+
+	FilePoolMan.open(_fileName);
 }
 
 BZFFile::~BZFFile() {
+	FilePoolMan.close(_fileName);
 }
 
 void BZFFile::clear() {
@@ -154,17 +158,11 @@ Common::SeekableReadStream *BZFFile::getResource(uint32 index) const {
 	if ((res.packedSize == 0) || (res.size == 0))
 		return new Common::MemoryReadStream(0, 0);
 
-	Common::File bzf;
-	open(bzf);
-
-	if (!bzf.seek(res.offset))
-		throw Common::Exception(Common::kSeekError);
-
 	byte *compressedData = new byte[res.packedSize];
 
 	Common::SeekableReadStream *resStream = 0;
 	try {
-		if (bzf.read(compressedData, res.packedSize) != res.packedSize)
+		if (FilePoolMan.read(_fileName, res.offset, compressedData, res.packedSize) != res.packedSize)
 			throw Common::Exception(Common::kReadError);
 
 		resStream = decompress(compressedData, res.packedSize, res.size);
@@ -178,6 +176,12 @@ Common::SeekableReadStream *BZFFile::getResource(uint32 index) const {
 	return resStream;
 }
 
+bool BZFFile::isResourceCompressed(uint32 index) const {
+	const IResource &res = getIResource(index);
+
+	return (res.packedSize != 0) && (res.size != 0);
+}
+
 void BZFFile::open(Common::File &file) const {
 	if (!file.open(_fileName))
 		throw Common::Exception(Common::kOpenError);
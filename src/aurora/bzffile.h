@@ -63,6 +63,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index) const;
 
+	/** Does the resource need to be decompressed when it's read? */
+	bool isResourceCompressed(uint32 index) const;
+
 	/** Merge information from the KEY into the BZF. */
 	void mergeKEY(const KEYFile &key, uint32 bifIndex);
 
@@ -24,13 +24,17 @@
 
 #include "src/common/stream.h"
 #include "src/common/file.h"
+#include "src/common/filepool.h"
 #include "src/common/util.h"
 #include "src/common/encoding.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/erffile.h"
 #include "src/aurora/error.h"
 #include "src/aurora/util.h"
 
+#include <cstring>
+
 #include <zlib.h>
 
 static const uint32 kERFID     = MKTAG('E', 'R', 'F', ' ');
@@ -45,13 +49,19 @@ static const uint32 kVersion3  = MKTAG('V', '3', '.', '0');
 
 namespace Aurora {
 
-ERFFile::ERFFile(const Common::UString &fileName, bool noResources) :
+ERFFile::ERFFile(const Common::UString &fileName, bool noResources, bool mapped) :
 	_noResources(noResources), _fileName(fileName) {
 
 	load();
+
+	if (mapped && !_noResources)
+		map();
+
+	FilePoolMan.open(_fileName);
 }
 
 ERFFile::~ERFFile() {
+	FilePoolMan.close(_fileName);
 }
 
 void ERFFile::clear() {
@@ -379,72 +389,80 @@ Common::SeekableReadStream *ERFFile::getResource(uint32 index) const {
 	if (_flags & 0xF0)
 		throw Common::Exception("Unhandled ERF encryption");
 
-	Common::File erf;
-	open(erf);
+	if (_mappedFile) {
+		if (((uint64) res.offset + res.packedSize) > _mappedFile->size())
+			throw Common::Exception(Common::kReadError);
 
-	if (!erf.seek(res.offset))
-		throw Common::Exception(Common::kSeekError);
+		// Uncompressed resources are handed out directly from the mapped file
+		if (getCompressionType() == 0)
+			return new Common::MappedFileReadStream(_mappedFile, res.offset, res.packedSize);
+
+		return decompress(_mappedFile->getData() + res.offset, res.packedSize, res.unpackedSize);
+	}
+
+	// No compression, we can just use the data as is
+	if (getCompressionType() == 0)
+		return FilePoolMan.readStream(_fileName, res.offset, res.packedSize);
 
 	byte *compressedData = new byte[res.packedSize];
 
-	if (erf.read(compressedData, res.packedSize) != res.packedSize) {
+	try {
+		if (FilePoolMan.read(_fileName, res.offset, compressedData, res.packedSize) != res.packedSize)
+			throw Common::Exception(Common::kReadError);
+
+		Common::SeekableReadStream *stream = decompress(compressedData, res.packedSize, res.unpackedSize);
+
+		delete[] compressedData;
+		return stream;
+
+	} catch (...) {
 		delete[] compressedData;
-		throw Common::Exception(Common::kReadError);
+		throw;
 	}
+}
 
-	return decompress(compressedData, res.packedSize, res.unpackedSize);
+bool ERFFile::isResourceCompressed(uint32 index) const {
+	return (getCompressionType() != 0) && (getIResource(index).unpackedSize != 0);
 }
 
 uint32 ERFFile::getCompressionType() const {
 	return (_flags >> 29) & 0x7;
 }
 
-Common::SeekableReadStream *ERFFile::decompress(byte *compressedData, uint32 packedSize, uint32 unpackedSize) const {
+Common::SeekableReadStream *ERFFile::decompress(const byte *compressedData, uint32 packedSize, uint32 unpackedSize) const {
 	switch (getCompressionType()) {
-	case 0:
-		// No compression
-		return new Common::MemoryReadStream(compressedData, packedSize, true);
+	case 0: {
+			// No compression
+			byte *data = new byte[packedSize];
+			std::memcpy(data, compressedData, packedSize);
+
+			return new Common::MemoryReadStream(data, packedSize, true);
+		}
 	case 1:
 		// Bioware Zlib
 		return decompressBiowareZlib(compressedData, packedSize, unpackedSize);
 	case 2:
 	case 3:
 		// Unknown
-		delete[] compressedData;
 		throw Common::Exception("Unknown ERF compression %d", getCompressionType());
 	case 7:
 		// Headerless Zlib
 		return decompressHeaderlessZlib(compressedData, packedSize, unpackedSize);
 	default:
 		// Invalid
-		delete[] compressedData;
 		throw Common::Exception("Invalid ERF compression %d", getCompressionType());
 	}
 }
 
-Common::SeekableReadStream *ERFFile::decompressBiowareZlib(byte *compressedData, uint32 packedSize, uint32 unpackedSize) const {
-	try {
-		Common::SeekableReadStream *stream = decompressZlib(compressedData + 1, packedSize - 1, unpackedSize, *compressedData >> 4);
-		delete[] compressedData;
-		return stream;
-	} catch (Common::Exception &e) {
-		delete[] compressedData;
-		throw;
-	}
+Common::SeekableReadStream *ERFFile::decompressBiowareZlib(const byte *compressedData, uint32 packedSize, uint32 unpackedSize) const {
+	return decompressZlib(compressedData + 1, packedSize - 1, unpackedSize, *compressedData >> 4);
 }
 
-Common::SeekableReadStream *ERFFile::decompressHeaderlessZlib(byte *compressedData, uint32 packedSize, uint32 unpackedSize) const {
-	try {
-		Common::SeekableReadStream *stream = decompressZlib(compressedData, packedSize, unpackedSize, MAX_WBITS);
-		delete[] compressedData;
-		return stream;
-	} catch (Common::Exception &e) {
-		delete[] compressedData;
-		throw;
-	}
+Common::SeekableReadStream *ERFFile::decompressHeaderlessZlib(const byte *compressedData, uint32 packedSize, uint32 unpackedSize) const {
+	return decompressZlib(compressedData, packedSize, unpackedSize, MAX_WBITS);
 }
 
-Common::SeekableReadStream *ERFFile::decompressZlib(byte *compressedData, uint32 packedSize, uint32 unpackedSize, int windowBits) const {
+Common::SeekableReadStream *ERFFile::decompressZlib(const byte *compressedData, uint32 packedSize, uint32 unpackedSize, int windowBits) const {
 	// Allocate the decompressed data
 	byte *decompressedData = new byte[unpackedSize];
 
@@ -453,7 +471,7 @@ Common::SeekableReadStream *ERFFile::decompressZlib(byte *compressedData, uint32
 	strm.zfree    = Z_NULL;
 	strm.opaque   = Z_NULL;
 	strm.avail_in = packedSize;
-	strm.next_in  = compressedData;
+	strm.next_in  = const_cast<byte *>(compressedData);
 
 	// Negative windows bits means there is no zlib header present in the data.
 	int zResult = inflateInit2(&strm, -windowBits);
@@ -484,6 +502,15 @@ void ERFFile::open(Common::File &file) const {
 		throw Common::Exception(Common::kOpenError);
 }
 
+void ERFFile::map() {
+	_mappedFile.reset(new Common::MappedFile);
+
+	if (!_mappedFile->open(_fileName)) {
+		warning("Failed to map ERF \"%s\" into memory", _fileName.c_str());
+		_mappedFile.reset();
+	}
+}
+
 Common::HashAlgo ERFFile::getNameHashAlgo() const {
 	// Only V3 uses hashing
 	return (_version == kVersion3) ? Common::kHashFNV64 : Common::kHashNone;
@@ -27,6 +27,8 @@
 
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 
@@ -38,6 +40,7 @@
 namespace Common {
 	class SeekableReadStream;
 	class File;
+	class MappedFile;
 }
 
 namespace Aurora {
@@ -45,7 +48,13 @@ namespace Aurora {
 /** Class to hold resource data of an ERF file. */
 class ERFFile : public Archive, public AuroraBase {
 public:
-	ERFFile(const Common::UString &fileName, bool noResources = false);
+	/** Open an ERF file.
+	 *
+	 *  @param fileName The name of the ERF file.
+	 *  @param noResources Only read the header and description, not the resource list?
+	 *  @param mapped Map the ERF into memory and return zero-copy streams for uncompressed resources?
+	 */
+	ERFFile(const Common::UString &fileName, bool noResources = false, bool mapped = false);
 	~ERFFile();
 
 	/** Clear the resource list. */
@@ -60,6 +69,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index) const;
 
+	/** Does the resource need to be decompressed when it's read? */
+	bool isResourceCompressed(uint32 index) const;
+
 	/** Return the description. */
 	const LocString &getDescription() const;
 
@@ -103,11 +115,15 @@ private:
 	/** The name of the ERF file. */
 	Common::UString _fileName;
 
+	/** The ERF file mapped into memory, if requested. */
+	boost::shared_ptr<Common::MappedFile> _mappedFile;
+
 	uint32 _flags;
 	uint32 _moduleID;
 	Common::UString _passwordDigest;
 
 	void open(Common::File &file) const;
+	void map();
 
 	void load();
 
@@ -133,10 +149,10 @@ private:
 
 	// Compression
 	uint32 getCompressionType() const;
-	Common::SeekableReadStream *decompress(byte *compressedData, uint32 packedSize, uint32 unpackedSize) const;
-	Common::SeekableReadStream *decompressBiowareZlib(byte *compressedData, uint32 packedSize, uint32 unpackedSize) const;
-	Common::SeekableReadStream *decompressHeaderlessZlib(byte *compressedData, uint32 packedSize, uint32 unpackedSize) const;
-	Common::SeekableReadStream *decompressZlib(byte *compressedData, uint32 packedSize, uint32 unpackedSize, int windowBits) const;
+	Common::SeekableReadStream *decompress(const byte *compressedData, uint32 packedSize, uint32 unpackedSize) const;
+	Common::SeekableReadStream *decompressBiowareZlib(const byte *compressedData, uint32 packedSize, uint32 unpackedSize) const;
+	Common::SeekableReadStream *decompressHeaderlessZlib(const byte *compressedData, uint32 packedSize, uint32 unpackedSize) const;
+	Common::SeekableReadStream *decompressZlib(const byte *compressedData, uint32 packedSize, uint32 unpackedSize, int windowBits) const;
 
 	const IResource &getIResource(uint32 index) const;
 };
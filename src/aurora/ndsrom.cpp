@@ -28,6 +28,7 @@
 
 #include "src/common/util.h"
 #include "src/common/file.h"
+#include "src/common/filepool.h"
 #include "src/common/stream.h"
 #include "src/common/encoding.h"
 
@@ -39,9 +40,12 @@ namespace Aurora {
 
 NDSFile::NDSFile(const Common::UString &fileName) : _fileName(fileName) {
 	load();
+
+	FilePoolMan.open(_fileName);
 }
 
 NDSFile::~NDSFile() {
+	FilePoolMan.close(_fileName);
 }
 
 void NDSFile::clear() {
@@ -142,20 +146,7 @@ Common::SeekableReadStream *NDSFile::getResource(uint32 index) const {
 	if (res.size == 0)
 		return new Common::MemoryReadStream(0, 0);
 
-	Common::File nds;
-	open(nds);
-
-	if (!nds.seek(res.offset))
-		throw Common::Exception(Common::kSeekError);
-
-	Common::SeekableReadStream *resStream = nds.readStream(res.size);
-
-	if (!resStream || (((uint32) resStream->size()) != res.size)) {
-		delete resStream;
-		throw Common::Exception(Common::kReadError);
-	}
-
-	return resStream;
+	return FilePoolMan.readStream(_fileName, res.offset, res.size);
 }
 
 void NDSFile::open(Common::File &file) const {
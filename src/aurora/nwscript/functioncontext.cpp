@@ -138,6 +138,35 @@ const Variable &FunctionContext::getReturn() const {
 	return _return;
 }
 
+void FunctionContext::resetReturn() {
+	// Reset the value in place, so that strings can keep their memory
+	switch (_return.getType()) {
+		case kTypeInt:
+			_return = (int32) 0;
+			break;
+
+		case kTypeFloat:
+			_return = 0.0f;
+			break;
+
+		case kTypeString:
+			_return.getString().clear();
+			break;
+
+		case kTypeObject:
+			_return = (Object *) 0;
+			break;
+
+		case kTypeVector:
+			_return.setVector(0.0f, 0.0f, 0.0f);
+			break;
+
+		default:
+			_return.setType(_return.getType());
+			break;
+	}
+}
+
 Parameters &FunctionContext::getParams() {
 	return _parameters;
 }
@@ -69,6 +69,9 @@ public:
 	Variable &getReturn();
 	const Variable &getReturn() const;
 
+	/** Reset the return value to its type's default, for reusing the context. */
+	void resetReturn();
+
 	Parameters &getParams();
 	const Parameters &getParams() const;
 
@@ -38,7 +38,7 @@ FunctionManager::FunctionEntry::FunctionEntry(const Common::UString &name) :
 }
 
 
-FunctionManager::FunctionManager() {
+FunctionManager::FunctionManager() : _revision(0) {
 }
 
 FunctionManager::~FunctionManager() {
@@ -47,6 +47,8 @@ FunctionManager::~FunctionManager() {
 void FunctionManager::clear() {
 	_functionMap.clear();
 	_functionArray.clear();
+
+	_revision++;
 }
 
 void FunctionManager::registerFunction(const Common::UString &name, uint32 id,
@@ -77,6 +79,8 @@ void FunctionManager::registerFunction(const Common::UString &name, uint32 id,
 		_functionArray.resize(id + 1);
 
 	_functionArray[id] = f;
+
+	_revision++;
 }
 
 FunctionContext FunctionManager::createContext(const Common::UString &function) const {
@@ -95,6 +99,14 @@ void FunctionManager::call(uint32 function, FunctionContext &ctx) const {
 	find(function).func(ctx);
 }
 
+const Function &FunctionManager::getFunction(uint32 function) const {
+	return find(function).func;
+}
+
+uint32 FunctionManager::getRevision() const {
+	return _revision;
+}
+
 const FunctionManager::FunctionEntry &FunctionManager::find(const Common::UString &function) const {
 	FunctionMap::const_iterator f = _functionMap.find(function);
 	if ((f == _functionMap.end()) || f->second.empty)
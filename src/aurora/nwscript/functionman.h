@@ -56,6 +56,17 @@ public:
 	FunctionContext createContext(uint32 function) const;
 	void call(uint32 function, FunctionContext &ctx) const;
 
+	/** Return the function itself, to be called directly with a reused context. */
+	const Function &getFunction(uint32 function) const;
+
+	/** Return the revision of the registered functions.
+	 *
+	 *  The revision changes whenever functions are registered or cleared,
+	 *  so that anything holding on to functions can check whether they're
+	 *  still valid.
+	 */
+	uint32 getRevision() const;
+
 private:
 	struct FunctionEntry {
 		bool empty;
@@ -72,6 +83,8 @@ private:
 	FunctionMap _functionMap;
 	FunctionArray _functionArray;
 
+	uint32 _revision; ///< Incremented whenever the registered functions change.
+
 	const FunctionEntry &find(const Common::UString &function) const;
 	const FunctionEntry &find(uint32 function) const;
 };
@@ -34,6 +34,7 @@
 
 #include "src/aurora/nwscript/ncsfile.h"
 #include "src/aurora/nwscript/object.h"
+#include "src/aurora/nwscript/enginetype.h"
 #include "src/aurora/nwscript/functionman.h"
 
 using Common::kDebugScripts;
@@ -49,15 +50,21 @@ namespace Aurora {
 
 namespace NWScript {
 
-NCSStack::NCSStack() {
-	reset();
+const uint32 NCSStack::kNoEngineType;
+
+NCSStack::NCSStack() : _stackPtr(-1), _basePtr(-1) {
 }
 
 NCSStack::~NCSStack() {
+	reset();
 }
 
 void NCSStack::reset() {
-	clear();
+	for (int32 i = 0; i <= _stackPtr; i++)
+		release(_values[i]);
+
+	// Strings stay in the pool, to be reused
+	_strings.clear();
 
 	_stackPtr = -1;
 	_basePtr  = -1;
@@ -67,77 +74,432 @@ bool NCSStack::empty() const {
 	return _stackPtr < 0;
 }
 
-Variable &NCSStack::top() {
+void NCSStack::addRef(const Value &value) {
+	if      (value.type == kTypeString)
+		_strings.ref(value.string);
+	else if ((value.type == kTypeEngineType) && (value.engineType != kNoEngineType))
+		_engineTypes.ref(value.engineType);
+}
+
+void NCSStack::release(Value &value) {
+	if      (value.type == kTypeString)
+		_strings.unref(value.string);
+	else if ((value.type == kTypeEngineType) && (value.engineType != kNoEngineType)) {
+		if (_engineTypes.unref(value.engineType)) {
+			delete _engineTypes.get(value.engineType);
+			_engineTypes.get(value.engineType) = 0;
+		}
+	}
+
+	value.type    = kTypeVoid;
+	value.integer = 0;
+}
+
+NCSStack::Value &NCSStack::pushValue() {
+	if (_stackPtr == 0x7FFFFFFF) // Like this will ever happen :P
+		throw Common::Exception("NCSStack: Stack overflow");
+
+	if (++_stackPtr == (int32)_values.size())
+		_values.push_back(Value());
+
+	// Values above the stack pointer never hold pooled data, so there's nothing to release
+	return _values[_stackPtr];
+}
+
+NCSStack::Value &NCSStack::top() {
 	if (_stackPtr == -1)
 		throw Common::Exception("NCSStack: Stack underflow");
 
-	return at(_stackPtr);
+	return _values[_stackPtr];
 }
 
-Variable NCSStack::pop() {
-	if (_stackPtr == -1)
+NCSStack::Value &NCSStack::at(uint32 index) {
+	return _values[index];
+}
+
+void NCSStack::push(const Variable &var) {
+	switch (var.getType()) {
+		case kTypeVoid:
+			pushValue() = Value();
+			break;
+
+		case kTypeInt:
+			pushInt(var.getInt());
+			break;
+
+		case kTypeFloat:
+			pushFloat(var.getFloat());
+			break;
+
+		case kTypeString:
+			pushString(var.getString());
+			break;
+
+		case kTypeObject:
+			pushObject(var.getObject());
+			break;
+
+		case kTypeEngineType:
+			pushEngineType(var.getEngineType());
+			break;
+
+		default:
+			throw Common::Exception("NCSStack::push(): Can't push a variable of type %d", var.getType());
+	}
+}
+
+void NCSStack::pop(Variable &var) {
+	Value &value = top();
+
+	if (var.getType() != value.type)
+		var.setType(value.type);
+
+	switch (value.type) {
+		case kTypeInt:
+			var = value.integer;
+			break;
+
+		case kTypeFloat:
+			var = value.floating;
+			break;
+
+		case kTypeString:
+			var = _strings.get(value.string);
+			break;
+
+		case kTypeObject:
+			var = value.object;
+			break;
+
+		case kTypeEngineType:
+			var = (const EngineType *) getEngineType(value);
+			break;
+
+		default:
+			break;
+	}
+
+	release(value);
+	_stackPtr--;
+}
+
+void NCSStack::pop() {
+	release(top());
+	_stackPtr--;
+}
+
+void NCSStack::pushInt(int32 value) {
+	Value &v = pushValue();
+
+	v.type    = kTypeInt;
+	v.integer = value;
+}
+
+void NCSStack::pushFloat(float value) {
+	Value &v = pushValue();
+
+	v.type     = kTypeFloat;
+	v.floating = value;
+}
+
+void NCSStack::pushObject(Object *value) {
+	Value &v = pushValue();
+
+	v.type   = kTypeObject;
+	v.object = value;
+}
+
+void NCSStack::pushString(const Common::UString &value) {
+	const uint32 string = addString(value);
+
+	Value &v = pushValue();
+
+	v.type   = kTypeString;
+	v.string = string;
+}
+
+void NCSStack::pushString(uint32 string) {
+	_strings.ref(string);
+
+	Value &v = pushValue();
+
+	v.type   = kTypeString;
+	v.string = string;
+}
+
+void NCSStack::pushEngineType(const EngineType *value) {
+	uint32 engineType = kNoEngineType;
+	if (value) {
+		engineType = _engineTypes.add();
+
+		_engineTypes.get(engineType) = value->clone();
+	}
+
+	Value &v = pushValue();
+
+	v.type       = kTypeEngineType;
+	v.engineType = engineType;
+}
+
+void NCSStack::pushEmpty(Type type) {
+	switch (type) {
+		case kTypeInt:
+			pushInt(0);
+			break;
+
+		case kTypeFloat:
+			pushFloat(0.0f);
+			break;
+
+		case kTypeString:
+			pushString(Common::UString());
+			break;
+
+		case kTypeObject:
+			pushObject(0);
+			break;
+
+		case kTypeEngineType:
+			pushEngineType(0);
+			break;
+
+		default:
+			throw Common::Exception("NCSStack::pushEmpty(): Illegal type %d", type);
+	}
+}
+
+void NCSStack::pushCopy(uint32 index) {
+	// Copy first, pushing might move the values around
+	const Value value = _values[index];
+
+	addRef(value);
+	pushValue() = value;
+}
+
+int32 NCSStack::popInt() {
+	const int32 value = topInt();
+
+	_stackPtr--;
+	return value;
+}
+
+float NCSStack::popFloat() {
+	const float value = topFloat();
+
+	_stackPtr--;
+	return value;
+}
+
+Object *NCSStack::popObject() {
+	Value &value = top();
+	if (value.type != kTypeObject)
+		throw Common::Exception("Can't get an object value from a non-object variable");
+
+	_stackPtr--;
+	return value.object;
+}
+
+int32 &NCSStack::topInt() {
+	Value &value = top();
+	if (value.type != kTypeInt)
+		throw Common::Exception("Can't get an int value from a non-int variable");
+
+	return value.integer;
+}
+
+int32 &NCSStack::getInt(uint32 index) {
+	Value &value = _values[index];
+	if (value.type != kTypeInt)
+		throw Common::Exception("Can't get an int value from a non-int variable");
+
+	return value.integer;
+}
+
+float &NCSStack::topFloat() {
+	Value &value = top();
+	if (value.type != kTypeFloat)
+		throw Common::Exception("Can't get a float value from a non-float variable");
+
+	return value.floating;
+}
+
+Variable NCSStack::getVariable(uint32 index) const {
+	const Value &value = _values[index];
+
+	switch (value.type) {
+		case kTypeInt:
+			return Variable(value.integer);
+
+		case kTypeFloat:
+			return Variable(value.floating);
+
+		case kTypeString:
+			return Variable(_strings.get(value.string));
+
+		case kTypeObject:
+			return Variable(value.object);
+
+		case kTypeEngineType:
+			return Variable((const EngineType *) getEngineType(value));
+
+		default:
+			break;
+	}
+
+	return Variable();
+}
+
+void NCSStack::copy(uint32 dest, uint32 src) {
+	if (dest == src)
+		return;
+
+	addRef(_values[src]);
+	release(_values[dest]);
+
+	_values[dest] = _values[src];
+}
+
+bool NCSStack::equal(uint32 index1, uint32 index2) const {
+	const Value &value1 = _values[index1];
+	const Value &value2 = _values[index2];
+
+	if (value1.type != value2.type)
+		return false;
+
+	switch (value1.type) {
+		case kTypeVoid:
+			return true;
+
+		case kTypeInt:
+			return value1.integer == value2.integer;
+
+		case kTypeFloat:
+			return value1.floating == value2.floating;
+
+		case kTypeString:
+			return (value1.string == value2.string) ||
+			       (_strings.get(value1.string) == _strings.get(value2.string));
+
+		case kTypeObject:
+			return value1.object == value2.object;
+
+		default:
+			break;
+	}
+
+	return false;
+}
+
+void NCSStack::remove(uint32 count, uint32 keepStart, uint32 keepCount) {
+	if ((int32)count > (_stackPtr + 1))
 		throw Common::Exception("NCSStack: Stack underflow");
 
-	return at(_stackPtr--);
+	const uint32 bottom = _stackPtr + 1 - count;
+
+	uint32 kept = bottom;
+	for (uint32 i = 0; i < count; i++) {
+		Value &value = _values[bottom + i];
+
+		if ((i < keepStart) || (i >= (keepStart + keepCount))) {
+			release(value);
+			continue;
+		}
+
+		// Move the value down, everything below it has already been emptied or moved
+		if (kept != (bottom + i)) {
+			_values[kept] = value;
+
+			value.type    = kTypeVoid;
+			value.integer = 0;
+		}
+
+		kept++;
+	}
+
+	_stackPtr = kept - 1;
 }
 
-void NCSStack::push(const Variable &obj) {
-	if (_stackPtr == 0x7FFFFFFF) // Like this will ever happen :P
-		throw Common::Exception("NCSStack: Stack overflow");
+uint32 NCSStack::addString(const Common::UString &value) {
+	// The value might be one of our strings, which adding would move around
+	if (_strings.isFull()) {
+		const Common::UString copy = value;
+
+		const uint32 string = _strings.add();
+		_strings.get(string) = copy;
+
+		return string;
+	}
 
-	if (_stackPtr == (int32)size() - 1)
-		push_back(obj);
-	else
-		at(_stackPtr + 1) = obj;
+	const uint32 string = _strings.add();
 
-	_stackPtr++;
+	_strings.get(string) = value;
+
+	return string;
 }
 
-Variable &NCSStack::getRelSP(int32 pos) {
-	if ((pos > -4) || ((pos % 4) != 0))
-		throw Common::Exception("NCSStack::get(): Illegal position %d", pos);
+void NCSStack::concatStrings() {
+	if (_stackPtr < 1)
+		throw Common::Exception("NCSStack: Stack underflow");
 
-	int32 stackPos = _stackPtr - ((pos / -4) - 1);
-	if (stackPos < 0)
-		throw Common::Exception("NCSStack::get(): Position %d below the bottom", pos);
+	Value &op1 = _values[_stackPtr - 1];
+	Value &op2 = _values[_stackPtr];
+	if ((op1.type != kTypeString) || (op2.type != kTypeString))
+		throw Common::Exception("Can't get a string value from a non-string variable");
+
+	const uint32 string = _strings.add();
+
+	// Adding might move the strings around, so we can only get references now
+	Common::UString &str = _strings.get(string);
+
+	str  = _strings.get(op1.string);
+	str += _strings.get(op2.string);
+
+	release(op2);
+	release(op1);
+
+	op1.type   = kTypeString;
+	op1.string = string;
 
-	return at(stackPos);
+	_stackPtr--;
 }
 
-void NCSStack::setRelSP(int32 pos, const Variable &obj) {
-	if ((pos > -4) || ((pos % 4) != 0))
-		throw Common::Exception("NCSStack::set(): Illegal position %d", pos);
+const Common::UString &NCSStack::getString(const Value &value) const {
+	if (value.type != kTypeString)
+		throw Common::Exception("Can't get a string value from a non-string variable");
 
-	int32 stackPos = _stackPtr - ((pos / -4) - 1);
-	if (stackPos < 0)
-		throw Common::Exception("NCSStack::set(): Position %d below the bottom", pos);
+	return _strings.get(value.string);
+}
+
+EngineType *NCSStack::getEngineType(const Value &value) const {
+	if (value.type != kTypeEngineType)
+		throw Common::Exception("Can't get an engine-type value from a non-engine-type variable");
+
+	if (value.engineType == kNoEngineType)
+		return 0;
 
-	at(stackPos) = obj;
+	return _engineTypes.get(value.engineType);
 }
 
-Variable &NCSStack::getRelBP(int32 pos) {
+uint32 NCSStack::getRel(int32 ptr, int32 pos) const {
 	if ((pos > -4) || ((pos % 4) != 0))
 		throw Common::Exception("NCSStack::get(): Illegal position %d", pos);
 
-	int32 stackPos = _basePtr - ((pos / -4) - 1);
+	int32 stackPos = ptr - ((pos / -4) - 1);
 	if (stackPos < 0)
 		throw Common::Exception("NCSStack::get(): Position %d below the bottom", pos);
 
-	return at(stackPos);
+	return stackPos;
 }
 
-void NCSStack::setRelBP(int32 pos, const Variable &obj) {
-	if ((pos > -4) || ((pos % 4) != 0))
-		throw Common::Exception("NCSStack::set(): Illegal position %d", pos);
-
-	int32 stackPos = _basePtr - ((pos / -4) - 1);
-	if (stackPos < 0)
-		throw Common::Exception("NCSStack::set(): Position %d below the bottom", pos);
+uint32 NCSStack::getRelSP(int32 pos) const {
+	return getRel(_stackPtr, pos);
+}
 
-	at(stackPos) = obj;
+uint32 NCSStack::getRelBP(int32 pos) const {
+	return getRel(_basePtr, pos);
 }
 
-int32 NCSStack::getStackPtr() {
+int32 NCSStack::getStackPtr() const {
 	return (_stackPtr + 1) * -4;
 }
 
@@ -145,13 +507,19 @@ void NCSStack::setStackPtr(int32 pos) {
 	if ((pos > 0) || ((pos % 4) != 0))
 		throw Common::Exception("NCSStack::setStackPtr(): Illegal position %d", pos);
 
-	_stackPtr = (pos / -4) - 1;
+	const int32 stackPtr = (pos / -4) - 1;
+
+	// Empty everything we're moving the stack pointer over
+	for (int32 i = _stackPtr; i > stackPtr; i--)
+		release(_values[i]);
 
-	if ((int32)size() < (_stackPtr + 1))
-		resize(_stackPtr + 1);
+	_stackPtr = stackPtr;
+
+	if ((int32)_values.size() < (_stackPtr + 1))
+		_values.resize(_stackPtr + 1);
 }
 
-int32 NCSStack::getBasePtr() {
+int32 NCSStack::getBasePtr() const {
 	return (_basePtr + 1) * -4;
 }
 
@@ -168,21 +536,21 @@ void NCSStack::print() const {
 
 	debugC(2, kDebugScripts, ".--- %d ---.", _stackPtr);
 	for (int32 i = _stackPtr; i >= 0; i--) {
-		const Variable &var = at(i);
-
-		if      (var.getType() == kTypeInt)
-			debugC(2, kDebugScripts, "| %d: %d", var.getType(), var.getInt());
-		else if (var.getType() == kTypeFloat)
-			debugC(2, kDebugScripts, "| %d: %f", var.getType(), var.getFloat());
-		else if (var.getType() == kTypeString)
-			debugC(2, kDebugScripts, "| %d: \"%s\"", var.getType(), var.getString().c_str());
-		else if (var.getType() == kTypeObject) {
-			if (!var.getObject())
-				debugC(2, kDebugScripts, "| %d: 0", var.getType());
+		const Value &value = _values[i];
+
+		if      (value.type == kTypeInt)
+			debugC(2, kDebugScripts, "| %d: %d", value.type, value.integer);
+		else if (value.type == kTypeFloat)
+			debugC(2, kDebugScripts, "| %d: %f", value.type, value.floating);
+		else if (value.type == kTypeString)
+			debugC(2, kDebugScripts, "| %d: \"%s\"", value.type, _strings.get(value.string).c_str());
+		else if (value.type == kTypeObject) {
+			if (!value.object)
+				debugC(2, kDebugScripts, "| %d: 0", value.type);
 			else
-				debugC(2, kDebugScripts, "| %d: \"%s\"", var.getType(), var.getObject()->getTag().c_str());
+				debugC(2, kDebugScripts, "| %d: \"%s\"", value.type, value.object->getTag().c_str());
 		} else
-			debugC(2, kDebugScripts, "| %d", var.getType());
+			debugC(2, kDebugScripts, "| %d", value.type);
 	}
 	debugC(2, kDebugScripts, "'--- ---'");
 }
@@ -254,32 +622,115 @@ void NCSFile::setupOpcodes() {
 
 	_opcodes = opcodes;
 	_opcodeListSize = ARRAYSIZE(opcodes);
+
+	static const SpecializedOpcode specializedOpcodes[] = {
+		// o_add
+		{ 0x14, kInstTypeIntInt      , &NCSFile::o_addII },
+		{ 0x14, kInstTypeFloatFloat  , &NCSFile::o_addFF },
+		{ 0x14, kInstTypeIntFloat    , &NCSFile::o_addIF },
+		{ 0x14, kInstTypeFloatInt    , &NCSFile::o_addFI },
+		{ 0x14, kInstTypeStringString, &NCSFile::o_addSS },
+		// o_sub
+		{ 0x15, kInstTypeIntInt      , &NCSFile::o_subII },
+		{ 0x15, kInstTypeFloatFloat  , &NCSFile::o_subFF },
+		{ 0x15, kInstTypeIntFloat    , &NCSFile::o_subIF },
+		{ 0x15, kInstTypeFloatInt    , &NCSFile::o_subFI },
+		// o_mul
+		{ 0x16, kInstTypeIntInt      , &NCSFile::o_mulII },
+		{ 0x16, kInstTypeFloatFloat  , &NCSFile::o_mulFF },
+		{ 0x16, kInstTypeIntFloat    , &NCSFile::o_mulIF },
+		{ 0x16, kInstTypeFloatInt    , &NCSFile::o_mulFI },
+		// o_eq
+		{ 0x0B, kInstTypeIntInt      , &NCSFile::o_eqII  },
+		{ 0x0B, kInstTypeFloatFloat  , &NCSFile::o_eqFF  },
+		// o_neq
+		{ 0x0C, kInstTypeIntInt      , &NCSFile::o_neqII },
+		{ 0x0C, kInstTypeFloatFloat  , &NCSFile::o_neqFF },
+		// o_geq
+		{ 0x0D, kInstTypeIntInt      , &NCSFile::o_geqII },
+		{ 0x0D, kInstTypeFloatFloat  , &NCSFile::o_geqFF },
+		// o_gt
+		{ 0x0E, kInstTypeIntInt      , &NCSFile::o_gtII  },
+		{ 0x0E, kInstTypeFloatFloat  , &NCSFile::o_gtFF  },
+		// o_lt
+		{ 0x0F, kInstTypeIntInt      , &NCSFile::o_ltII  },
+		{ 0x0F, kInstTypeFloatFloat  , &NCSFile::o_ltFF  },
+		// o_leq
+		{ 0x10, kInstTypeIntInt      , &NCSFile::o_leqII },
+		{ 0x10, kInstTypeFloatFloat  , &NCSFile::o_leqFF }
+	};
+
+	_specializedOpcodes = specializedOpcodes;
+	_specializedOpcodeListSize = ARRAYSIZE(specializedOpcodes);
 }
 
 #undef OPCODE
 
-NCSFile::NCSFile(Common::SeekableReadStream *ncs) : _owner(0), _triggerer(0) {
-	_script = ncs;
+NCSFile::OpcodeProc NCSFile::getOpcodeProc(uint8 opcode, InstructionType type) const {
+	if (opcode >= _opcodeListSize)
+		return 0;
+
+	for (uint32 i = 0; i < _specializedOpcodeListSize; i++)
+		if ((_specializedOpcodes[i].opcode == opcode) && (_specializedOpcodes[i].type == type))
+			return _specializedOpcodes[i].proc;
+
+	return _opcodes[opcode].proc;
+}
+
+const uint32 NCSFile::kInvalidJump;
+const uint32 NCSFile::kInvalidString;
+
+NCSFile::ProgramCache NCSFile::_programCache;
+uint32                NCSFile::_programRevision  = 0;
+uint32                NCSFile::_functionRevision = 0;
+Common::Mutex         NCSFile::_programCacheMutex;
+
+NCSFile::EngineFunction::EngineFunction(uint32 i) : id(i), bound(false), inUse(false) {
+}
+
+NCSFile::NCSFile(Common::SeekableReadStream *ncs) : _pc(0), _owner(0), _triggerer(0) {
+	setupOpcodes();
 
 	try {
-		load();
+		load(*ncs);
 	} catch (...) {
-		delete _script;
+		delete ncs;
+		throw;
 	}
+
+	delete ncs;
+
+	reset();
 }
 
-NCSFile::NCSFile(const Common::UString &ncs) : _name(ncs), _script(0),
-	_owner(0), _triggerer(0) {
+NCSFile::NCSFile(const Common::UString &ncs) : _name(ncs), _pc(0), _owner(0), _triggerer(0) {
+	setupOpcodes();
+
+	_program = getCachedProgram(ncs);
+
+	if (!_program) {
+		Common::SeekableReadStream *script = ResMan.getResource(ncs, kFileTypeNCS);
+		if (!script)
+			throw Common::Exception("No such NCS \"%s\"", ncs.c_str());
 
-	_script = ResMan.getResource(ncs, kFileTypeNCS);
-	if (!_script)
-		throw Common::Exception("No such NCS \"%s\"", ncs.c_str());
+		try {
+			load(*script);
+		} catch (...) {
+			delete script;
+			throw;
+		}
+
+		delete script;
 
-	load();
+		// If another thread loaded the same script in the meantime, the last one wins
+		Common::StackLock lock(_programCacheMutex);
+		_programCache[ncs.toLower()] = _program;
+	}
+
+	reset();
 }
 
 NCSFile::~NCSFile() {
-	delete _script;
 }
 
 const Common::UString &NCSFile::getName() const {
@@ -294,8 +745,33 @@ ScriptState NCSFile::getEmptyState() {
 	return state;
 }
 
-void NCSFile::load() {
-	readHeader(*_script);
+void NCSFile::clearCache() {
+	Common::StackLock lock(_programCacheMutex);
+
+	_programCache.clear();
+}
+
+boost::shared_ptr<NCSFile::Program> NCSFile::getCachedProgram(const Common::UString &name) {
+	Common::StackLock lock(_programCacheMutex);
+
+	// The resources changed, so the scripts might have, too.
+	// Likewise, the engine functions the scripts are bound to might be gone.
+	if ((_programRevision != ResMan.getRevision()) || (_functionRevision != FunctionMan.getRevision())) {
+		_programCache.clear();
+
+		_programRevision  = ResMan.getRevision();
+		_functionRevision = FunctionMan.getRevision();
+	}
+
+	ProgramCache::const_iterator program = _programCache.find(name.toLower());
+	if (program == _programCache.end())
+		return boost::shared_ptr<Program>();
+
+	return program->second;
+}
+
+void NCSFile::load(Common::SeekableReadStream &ncs) {
+	readHeader(ncs);
 
 	if (_id != kNCSTag)
 		throw Common::Exception("Try to load non-NCS file");
@@ -303,19 +779,196 @@ void NCSFile::load() {
 	if (_version != kVersion10)
 		throw Common::Exception("Unsupported NCS file version %08X", _version);
 
-	byte lengthOpcode = _script->readByte();
+	byte lengthOpcode = ncs.readByte();
 	if (lengthOpcode != 0x42)
 		throw Common::Exception("Script size opcode != 0x42 (0x%02X)", lengthOpcode);
 
-	uint32 length = _script->readUint32BE();
-	if (length > ((uint32) _script->size()))
-		throw Common::Exception("Script size %d > stream size %d", length, _script->size());
-	if (length < ((uint32) _script->size()))
-		warning("TODO: NCSFile::load(): Script size %d < stream size %d", length, _script->size());
+	uint32 length = ncs.readUint32BE();
+	if (length > ((uint32) ncs.size()))
+		throw Common::Exception("Script size %d > stream size %d", length, ncs.size());
+	if (length < ((uint32) ncs.size()))
+		warning("TODO: NCSFile::load(): Script size %d < stream size %d", length, ncs.size());
 
-	setupOpcodes();
+	_program.reset(new Program);
+	_program->name = _name;
 
-	reset();
+	decode(ncs);
+	resolveJumps();
+}
+
+void NCSFile::decode(Common::SeekableReadStream &ncs) {
+	_program->end = ncs.pos();
+
+	while (ncs.pos() < ncs.size()) {
+		Instruction instr;
+
+		const bool valid = decodeInstruction(ncs, instr);
+
+		// Truncated instruction, the script ends here
+		if (ncs.eos())
+			break;
+
+		if (ncs.err())
+			throw Common::Exception(Common::kReadError);
+
+		_program->instructions.push_back(instr);
+		_program->end = ncs.pos();
+
+		// We don't know where the next instruction starts.
+		// Executing this one will throw.
+		if (!valid)
+			break;
+	}
+}
+
+bool NCSFile::decodeInstruction(Common::SeekableReadStream &ncs, Instruction &instr) {
+	instr.address = ncs.pos();
+
+	instr.opcode = ncs.readByte();
+	instr.type   = (InstructionType) ncs.readByte();
+
+	instr.args[0]  = 0;
+	instr.args[1]  = 0;
+	instr.args[2]  = 0;
+	instr.argFloat = 0.0;
+
+	instr.jump = kInvalidJump;
+	instr.proc = getOpcodeProc(instr.opcode, instr.type);
+
+	switch (instr.opcode) {
+		case 0x01: // o_cpdownsp
+		case 0x03: // o_cptopsp
+		case 0x26: // o_cpdownbp
+		case 0x27: // o_cptopbp
+			instr.args[0] = ncs.readSint32BE();
+			instr.args[1] = ncs.readSint16BE();
+			break;
+
+		case 0x04: // o_const
+			switch (instr.type) {
+				case kInstTypeInt:
+					instr.args[0] = ncs.readSint32BE();
+					break;
+
+				case kInstTypeFloat:
+					instr.argFloat = ncs.readIEEEFloatBE();
+					break;
+
+				case kInstTypeString:
+					instr.args[0] = _program->strings.size();
+					_program->strings.push_back(Common::readStringFixed(ncs, Common::kEncodingASCII, ncs.readUint16BE()));
+					break;
+
+				case kInstTypeObject:
+					instr.args[0] = ncs.readUint32BE();
+					break;
+
+				default:
+					return false;
+			}
+			break;
+
+		case 0x05: // o_action
+			instr.args[0] = ncs.readUint16BE();
+			instr.args[1] = ncs.readByte();
+			instr.args[2] = addFunction(instr.args[0]);
+			break;
+
+		case 0x0B: // o_eq
+		case 0x0C: // o_neq
+			if (instr.type == kInstTypeStructStruct)
+				instr.args[0] = ncs.readUint16BE();
+			break;
+
+		case 0x1B: // o_movsp
+		case 0x1D: // o_jmp
+		case 0x1E: // o_jsr
+		case 0x1F: // o_jz
+		case 0x23: // o_decsp
+		case 0x24: // o_incsp
+		case 0x25: // o_jnz
+		case 0x28: // o_decbp
+		case 0x29: // o_incbp
+			instr.args[0] = ncs.readSint32BE();
+			break;
+
+		case 0x21: // o_destruct
+			instr.args[0] = ncs.readSint16BE();
+			instr.args[1] = ncs.readSint16BE();
+			instr.args[2] = ncs.readSint16BE();
+			break;
+
+		case 0x2C: // o_storestate
+			instr.args[0] = ncs.readUint32BE();
+			instr.args[1] = ncs.readUint32BE();
+			break;
+
+		default:
+			return instr.opcode < _opcodeListSize;
+	}
+
+	return true;
+}
+
+uint32 NCSFile::addFunction(uint32 id) {
+	std::vector<EngineFunction> &functions = _program->functions;
+
+	for (uint32 i = 0; i < functions.size(); i++)
+		if (functions[i].id == id)
+			return i;
+
+	functions.push_back(EngineFunction(id));
+
+	try {
+		bindFunction(functions.back());
+	} catch (...) {
+		// Not a known function. We'll try again should the script actually call it
+	}
+
+	return functions.size() - 1;
+}
+
+void NCSFile::bindFunction(EngineFunction &function) {
+	function.prototype = FunctionMan.createContext(function.id);
+	function.func      = FunctionMan.getFunction(function.id);
+	function.ctx       = function.prototype;
+
+	function.bound = true;
+}
+
+void NCSFile::resolveJumps() {
+	for (std::vector<Instruction>::iterator instr = _program->instructions.begin();
+	     instr != _program->instructions.end(); ++instr) {
+
+		// o_jmp, o_jsr, o_jz, o_jnz
+		if ((instr->opcode == 0x1D) || (instr->opcode == 0x1E) ||
+		    (instr->opcode == 0x1F) || (instr->opcode == 0x25))
+			instr->jump = findInstruction(instr->address + instr->args[0]);
+	}
+}
+
+uint32 NCSFile::findInstruction(uint32 address) const {
+	const std::vector<Instruction> &instructions = _program->instructions;
+
+	if (address == _program->end)
+		return instructions.size();
+
+	// Binary search, the instructions are ordered by address
+	uint32 first = 0;
+	uint32 last  = instructions.size();
+	while (first < last) {
+		const uint32 middle = first + (last - first) / 2;
+
+		if (instructions[middle].address < address)
+			first = middle + 1;
+		else
+			last  = middle;
+	}
+
+	if ((first < instructions.size()) && (instructions[first].address == address))
+		return first;
+
+	return kInvalidJump;
 }
 
 void NCSFile::reset() {
@@ -327,7 +980,9 @@ void NCSFile::reset() {
 	_storedState.setType(kTypeVoid);
 	_return.setType(kTypeVoid);
 
-	_script->seek(13); // 8 byte header + 5 byte program size dummy op
+	_pc = 0;
+
+	_stringConstants.assign(_program->strings.size(), kInvalidString);
 }
 
 const Variable &NCSFile::run(Object *owner, Object *triggerer) {
@@ -340,7 +995,9 @@ const Variable &NCSFile::run(const ScriptState &state, Object *owner, Object *tr
 
 	reset();
 
-	_script->seek(state.offset);
+	_pc = findInstruction(state.offset);
+	if (_pc == kInvalidJump)
+		throw Common::Exception("NCSFile::run(): No instruction at offset %d", state.offset);
 
 	// Push global variables
 	std::vector<class Variable>::const_reverse_iterator var;
@@ -360,18 +1017,29 @@ const Variable &NCSFile::execute(Object *owner, Object *triggerer) {
 	_owner     = owner;
 	_triggerer = triggerer;
 
-	while (!_script->eos() && !_script->err())
-		executeStep();
+	const std::vector<Instruction> &instructions = _program->instructions;
+
+	if (DebugMan.isEnabled(1, kDebugScripts)) {
+		while (_pc < instructions.size())
+			executeStep();
+	} else {
+		// No debug output wanted, so dispatch directly
+		while (_pc < instructions.size()) {
+			const Instruction &instr = instructions[_pc++];
+			if (!instr.proc)
+				throw Common::Exception("NCSFile::execute(): Illegal instruction 0x%02x", instr.opcode);
 
-	if (_script->err())
-		throw Common::Exception(Common::kReadError);
+			(this->*(instr.proc))(instr);
+		}
+	}
 
-	if (!_stack.empty())
-		_return = _stack.top();
+	if (!_stack.empty()) {
+		_return = _stack.getVariable(_stack.getRelSP(-4));
 
-	if (!_stack.empty() && (_stack.top().getType() == kTypeInt))
-		debugC(1, kDebugScripts, "=> Script\"%s\" returns: %d",
-		       _name.c_str(), _stack.top().getInt());
+		if (_return.getType() == kTypeInt)
+			debugC(1, kDebugScripts, "=> Script\"%s\" returns: %d",
+			       _name.c_str(), _return.getInt());
+	}
 
 	_owner     = 0;
 	_triggerer = 0;
@@ -380,91 +1048,94 @@ const Variable &NCSFile::execute(Object *owner, Object *triggerer) {
 }
 
 void NCSFile::executeStep() {
-	byte opcode = _script->readByte();
-	InstructionType type = (InstructionType)_script->readByte();
+	const Instruction &instr = _program->instructions[_pc++];
 
-	if (opcode >= _opcodeListSize)
-		throw Common::Exception("NCSFile::executeStep(): Illegal instruction 0x%02x", opcode);
+	if (!instr.proc)
+		throw Common::Exception("NCSFile::executeStep(): Illegal instruction 0x%02x", instr.opcode);
 
-	debugC(1, kDebugScripts, "NWScript opcode %s [0x%02X]", _opcodes[opcode].desc, opcode);
+	debugC(1, kDebugScripts, "NWScript opcode %s [0x%02X]", _opcodes[instr.opcode].desc, instr.opcode);
 
-	try {
-		(this->*(_opcodes[opcode].proc))(type);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	(this->*(instr.proc))(instr);
 
 	_stack.print();
 	debugC(2, kDebugScripts, "[RETURN: %d]",
 	       _returnOffsets.empty() ? -1 : _returnOffsets.top());
 }
 
-void NCSFile::decompile() {
-	uint32 oldScriptPos = _script->pos();
-	_script->seek(13); // 8 byte header + 5 byte program size dummy op
+void NCSFile::jump(const Instruction &instr) {
+	if (instr.jump == kInvalidJump)
+		throw Common::Exception("NCSFile::jump(): Illegal jump by %d from offset %d",
+		                        instr.args[0], instr.address);
 
-	// TODO
+	_pc = instr.jump;
+}
 
-	_script->seek(oldScriptPos);
+void NCSFile::decompile() {
+	// TODO
 }
 
 // OPCODES!
 
-void NCSFile::o_rsadd(InstructionType type) {
-	switch (type) {
+void NCSFile::o_rsadd(const Instruction &instr) {
+	switch (instr.type) {
 		case kInstTypeInt:
-			_stack.push(kTypeInt);
+			_stack.pushEmpty(kTypeInt);
 			break;
 		case kInstTypeFloat:
-			_stack.push(kTypeFloat);
+			_stack.pushEmpty(kTypeFloat);
 			break;
 		case kInstTypeString:
-			_stack.push(kTypeString);
+			_stack.pushEmpty(kTypeString);
 			break;
 		case kInstTypeObject:
-			_stack.push(kTypeObject);
+			_stack.pushEmpty(kTypeObject);
 			break;
 		case kInstTypeEffect:
-			_stack.push(kTypeEngineType);
+			_stack.pushEmpty(kTypeEngineType);
 			break;
 		case kInstTypeEvent:
-			_stack.push(kTypeEngineType);
+			_stack.pushEmpty(kTypeEngineType);
 			break;
 		case kInstTypeLocation:
-			_stack.push(kTypeEngineType);
+			_stack.pushEmpty(kTypeEngineType);
 			break;
 		case kInstTypeTalent:
-			_stack.push(kTypeEngineType);
+			_stack.pushEmpty(kTypeEngineType);
 			break;
 		default:
-			throw Common::Exception("NCSFile::o_rsadd(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_rsadd(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::o_const(InstructionType type) {
-	switch (type) {
+void NCSFile::o_const(const Instruction &instr) {
+	switch (instr.type) {
 		case kInstTypeInt:
-			_stack.push(_script->readSint32BE());
+			_stack.pushInt(instr.args[0]);
 			break;
 
 		case kInstTypeFloat:
-			_stack.push(_script->readIEEEFloatBE());
+			_stack.pushFloat(instr.argFloat);
 			break;
 
 		case kInstTypeString: {
-			_stack.push(Common::readStringFixed(*_script, Common::kEncodingASCII, _script->readUint16BE()));
+			// Each string constant only goes into the string pool once per run
+			uint32 &string = _stringConstants[instr.args[0]];
+			if (string == kInvalidString)
+				string = _stack.addString(_program->strings[instr.args[0]]);
+
+			_stack.pushString(string);
 			break;
 		}
 
 		case kInstTypeObject: {
-			uint32 objectID = _script->readUint32BE();
+			uint32 objectID = (uint32) instr.args[0];
 
 			if      (objectID == kScriptObjectSelf)
-				_stack.push(_owner);
+				_stack.pushObject(_owner);
 			else if (objectID == kScriptObjectInvalid)
-				_stack.push((Object *) 0);
+				_stack.pushObject(0);
 			else if (objectID == kScriptObjectTypeInvalid)
-				_stack.push((Object *) 0);
+				_stack.pushObject(0);
 			else
 				throw Common::Exception("NCSFile::o_const(): Illegal object ID %d", objectID);
 
@@ -472,13 +1143,11 @@ void NCSFile::o_const(InstructionType type) {
 		}
 
 		default:
-			throw Common::Exception("NCSFile::o_const(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_const(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
-                         uint32 function, uint8 argCount) {
-
+void NCSFile::callEngine(const EngineFunction &function, FunctionContext &ctx, uint8 argCount) {
 	if ((argCount < ctx.getParamMin()) || (argCount > ctx.getParamMax()))
 		throw Common::Exception("NCSFile::callEngine(): Argument count mismatch (%d vs %d - %d)",
 		                        argCount, ctx.getParamMin(), ctx.getParamMax());
@@ -487,46 +1156,75 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 	ctx.setCaller(_owner);
 	ctx.setTriggerer(_triggerer);
 
+	Parameters &params = ctx.getParams();
+
+	/* The context is reused, and both popping an argument and the engine function
+	 * itself may have changed the types of its variables. The prototype knows the
+	 * types the function was declared with. */
+	const Parameters &defaults = function.prototype.getParams();
+
 	ctx.setParamsSpecified(argCount);
 	for (uint8 i = 0; i < argCount; i++) {
-		Variable &param = ctx.getParams()[i];
+		Variable &param = params[i];
+
+		const Type type = defaults[i].getType();
+		if (param.getType() != type)
+			param.setType(type);
 
-		switch (param.getType()) {
+		switch (type) {
 			case kTypeInt:
 			case kTypeFloat:
 			case kTypeString:
 			case kTypeObject:
 			case kTypeEngineType:
-				param = _stack.pop();
+				_stack.pop(param);
 				break;
 
 			case kTypeVector: {
-				float z = _stack.pop().getFloat();
-				float y = _stack.pop().getFloat();
-				float x = _stack.pop().getFloat();
+				float z = _stack.popFloat();
+				float y = _stack.popFloat();
+				float x = _stack.popFloat();
 
 				param.setVector(x, y, z);
 				break;
 			}
 
-			case kTypeScriptState:
-				param.getScriptState() = _storedState.getScriptState();
+			case kTypeScriptState: {
+				// Hand over the stored state without copying its variables
+				ScriptState &state  = param.getScriptState();
+				ScriptState &stored = _storedState.getScriptState();
+
+				state.offset = stored.offset;
+				state.globals.swap(stored.globals);
+				state.locals.swap(stored.locals);
+
 				_storedState.setType(kTypeVoid);
 				break;
+			}
 
 			default:
-				throw Common::Exception("NCSFile::callEngine(): Invalid argument type %d",
-				                        param.getType());
+				throw Common::Exception("NCSFile::callEngine(): Invalid argument type %d", type);
 				break;
 		}
 
 	}
 
+	// Restore the defaults of the parameters not specified
+	for (uint32 i = argCount; i < params.size(); i++)
+		params[i] = defaults[i];
+
+	Variable &retVal = ctx.getReturn();
+
+	const Type returnType = function.prototype.getReturn().getType();
+	if (retVal.getType() != returnType)
+		retVal.setType(returnType);
+
+	ctx.resetReturn();
+
 	debugC(1, kDebugScripts, "NWScript engine function %s (%d)",
-	       ctx.getName().c_str(), function);
-	FunctionMan.call(function, ctx);
+	       ctx.getName().c_str(), function.id);
+	function.func(ctx);
 
-	Variable &retVal = ctx.getReturn();
 	switch (retVal.getType()) {
 		case kTypeVoid:
 			break;
@@ -543,9 +1241,9 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 			float x, y, z;
 			retVal.getVector(x, y, z);
 
-			_stack.push(x);
-			_stack.push(y);
-			_stack.push(z);
+			_stack.pushFloat(x);
+			_stack.pushFloat(y);
+			_stack.pushFloat(z);
 			break;
 		}
 
@@ -556,421 +1254,320 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 	}
 }
 
-void NCSFile::o_action(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_action(): Illegal type %d", type);
+void NCSFile::o_action(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_action(): Illegal type %d", instr.type);
+
+	uint16 routineNumber = instr.args[0];
+	uint8  argCount      = instr.args[1];
 
-	uint16 routineNumber = _script->readUint16BE();
-	uint8  argCount      = _script->readByte();
+	EngineFunction &function = _program->functions[instr.args[2]];
 
-	Aurora::NWScript::FunctionContext ctx = FunctionMan.createContext(routineNumber);
+	/* If the function is still running further up the call chain, or in another
+	 * thread running the same program, we need a fresh context. */
+	bool reuseContext = false;
 
 	try {
-		callEngine(ctx, routineNumber, argCount);
-	} catch (Common::Exception &e) {
-		e.add("Failed running engine function \"%s\" (%d)",
-		      ctx.getName().c_str(), routineNumber);
-		throw;
-	}
-}
+		{
+			Common::StackLock lock(_program->mutex);
 
-void NCSFile::o_logand(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_logand(): Illegal type %d", type);
+			if (!function.bound)
+				bindFunction(function);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg1 && arg2);
-	} catch (Common::Exception &e) {
-		throw;
-	}
-}
+			reuseContext   = !function.inUse;
+			function.inUse = true;
+		}
 
-void NCSFile::o_logor(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_logor(): Illegal type %d", type);
+		if (reuseContext) {
+			callEngine(function, function.ctx, argCount);
+
+			releaseContext(function);
+		} else {
+			FunctionContext ctx = function.prototype;
+
+			callEngine(function, ctx, argCount);
+		}
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg1 || arg2);
 	} catch (Common::Exception &e) {
+		if (reuseContext)
+			releaseContext(function);
+
+		e.add("Failed running engine function \"%s\" (%d)",
+		      function.prototype.getName().c_str(), routineNumber);
 		throw;
 	}
 }
 
-void NCSFile::o_incor(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_incor(): Illegal type %d", type);
+void NCSFile::releaseContext(EngineFunction &function) {
+	Common::StackLock lock(_program->mutex);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg1 | arg2);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	function.inUse = false;
 }
 
-void NCSFile::o_excor(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_excor(): Illegal type %d", type);
+void NCSFile::o_logand(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_logand(): Illegal type %d", instr.type);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg1 ^ arg2);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
+
+	arg2 = arg1 && arg2;
 }
 
-void NCSFile::o_booland(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_booland(): Illegal type %d", type);
+void NCSFile::o_logor(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_logor(): Illegal type %d", instr.type);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg1 && arg2);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
+
+	arg2 = arg1 || arg2;
 }
 
-void NCSFile::o_eq(InstructionType type) {
-	if (type == kInstTypeStructStruct) // TODO!
-		_script->readUint16BE();
+void NCSFile::o_incor(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_incor(): Illegal type %d", instr.type);
 
-	Variable arg1 = _stack.pop();
-	Variable arg2 = _stack.pop();
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
 
-	_stack.push(arg1 == arg2);
+	arg2 = arg1 | arg2;
 }
 
-void NCSFile::o_neq(InstructionType type) {
-	if (type == kInstTypeStructStruct) // TODO!
-		_script->readUint16BE();
+void NCSFile::o_excor(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_excor(): Illegal type %d", instr.type);
 
-	Variable arg1 = _stack.pop();
-	Variable arg2 = _stack.pop();
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
 
-	_stack.push(arg1 != arg2);
+	arg2 = arg1 ^ arg2;
 }
 
-void NCSFile::o_geq(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt:
-			try {
-				int32 arg1 = _stack.pop().getInt();
-				int32 arg2 = _stack.pop().getInt();
-				_stack.push(arg2 >= arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+void NCSFile::o_booland(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_booland(): Illegal type %d", instr.type);
 
-		case kInstTypeFloatFloat:
-			try {
-				float arg1 = _stack.pop().getFloat();
-				float arg2 = _stack.pop().getFloat();
-				_stack.push(arg2 >= arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
 
-		default:
-			throw Common::Exception("NCSFile::o_geq(): Illegal type %d", type);
-	}
+	arg2 = arg1 && arg2;
 }
 
-void NCSFile::o_gt(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt:
-			try {
-				int32 arg1 = _stack.pop().getInt();
-				int32 arg2 = _stack.pop().getInt();
-				_stack.push(arg2 > arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+void NCSFile::o_eq(const Instruction &UNUSED(instr)) {
+	// TODO: kInstTypeStructStruct, comparing instr.args[0] bytes
 
-		case kInstTypeFloatFloat:
-			try {
-				float arg1 = _stack.pop().getFloat();
-				float arg2 = _stack.pop().getFloat();
-				_stack.push(arg2 > arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+	const bool equal = _stack.equal(_stack.getRelSP(-4), _stack.getRelSP(-8));
 
-		default:
-			throw Common::Exception("NCSFile::o_gt(): Illegal type %d", type);
-	}
+	_stack.pop();
+	_stack.pop();
+
+	_stack.pushInt(equal);
 }
 
-void NCSFile::o_lt(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt:
-			try {
-				int32 arg1 = _stack.pop().getInt();
-				int32 arg2 = _stack.pop().getInt();
-				_stack.push(arg2 < arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+void NCSFile::o_neq(const Instruction &UNUSED(instr)) {
+	// TODO: kInstTypeStructStruct, comparing instr.args[0] bytes
 
-		case kInstTypeFloatFloat:
-			try {
-				float arg1 = _stack.pop().getFloat();
-				float arg2 = _stack.pop().getFloat();
-				_stack.push(arg2 < arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+	const bool equal = _stack.equal(_stack.getRelSP(-4), _stack.getRelSP(-8));
 
-		default:
-			throw Common::Exception("NCSFile::o_lt(): Illegal type %d", type);
-	}
+	_stack.pop();
+	_stack.pop();
+
+	_stack.pushInt(!equal);
 }
 
-void NCSFile::o_leq(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt:
-			try {
-				int32 arg1 = _stack.pop().getInt();
-				int32 arg2 = _stack.pop().getInt();
-				_stack.push(arg2 <= arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+void NCSFile::o_geq(const Instruction &instr) {
+	throw Common::Exception("NCSFile::o_geq(): Illegal type %d", instr.type);
+}
 
-		case kInstTypeFloatFloat:
-			try {
-				float arg1 = _stack.pop().getFloat();
-				float arg2 = _stack.pop().getFloat();
-				_stack.push(arg2 <= arg1);
-			} catch (Common::Exception &e) {
-				throw;
-			}
-			break;
+void NCSFile::o_gt(const Instruction &instr) {
+	throw Common::Exception("NCSFile::o_gt(): Illegal type %d", instr.type);
+}
 
-		default:
-			throw Common::Exception("NCSFile::o_leq(): Illegal type %d", type);
-	}
+void NCSFile::o_lt(const Instruction &instr) {
+	throw Common::Exception("NCSFile::o_lt(): Illegal type %d", instr.type);
 }
 
-void NCSFile::o_shleft(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_shleft(): Illegal type %d", type);
+void NCSFile::o_leq(const Instruction &instr) {
+	throw Common::Exception("NCSFile::o_leq(): Illegal type %d", instr.type);
+}
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg2 << arg1);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+void NCSFile::o_shleft(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_shleft(): Illegal type %d", instr.type);
+
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
+
+	arg2 = arg2 << arg1;
 }
 
-void NCSFile::o_shright(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_shright(): Illegal type %d", type);
+void NCSFile::o_shright(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_shright(): Illegal type %d", instr.type);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg2 >> arg1);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
+
+	arg2 = arg2 >> arg1;
 }
 
-void NCSFile::o_ushright(InstructionType type) {
+void NCSFile::o_ushright(const Instruction &instr) {
 	// TODO: Difference between this and o_shright
 
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_ushright(): Illegal type %d", type);
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_ushright(): Illegal type %d", instr.type);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
-		_stack.push(arg2 >> arg1);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
+
+	arg2 = arg2 >> arg1;
 }
 
-void NCSFile::o_mod(InstructionType type) {
-	if (type != kInstTypeIntInt)
-		throw Common::Exception("NCSFile::o_mod(): Illegal type %d", type);
+void NCSFile::o_mod(const Instruction &instr) {
+	if (instr.type != kInstTypeIntInt)
+		throw Common::Exception("NCSFile::o_mod(): Illegal type %d", instr.type);
 
-	try {
-		int32 arg1 = _stack.pop().getInt();
-		int32 arg2 = _stack.pop().getInt();
+	int32  arg1 = _stack.popInt();
+	int32 &arg2 = _stack.topInt();
 
-		if (arg1 == 0)
-			throw Common::Exception("NCSFile::o_mod(): Modulus by zero");
-		else if (arg1 < 0 || arg2 < 0)
-			throw Common::Exception("NCSFile::o_mod(): Modulus by negative number (%d %% %d)", arg2, arg1);
+	if (arg1 == 0)
+		throw Common::Exception("NCSFile::o_mod(): Modulus by zero");
+	else if (arg1 < 0 || arg2 < 0)
+		throw Common::Exception("NCSFile::o_mod(): Modulus by negative number (%d %% %d)", arg2, arg1);
 
-		_stack.push(arg2 % arg1);
-	} catch (Common::Exception &e) {
-		throw;
-	}
+	arg2 = arg2 % arg1;
 }
 
-void NCSFile::o_neg(InstructionType type) {
-	switch (type) {
-		case kInstTypeInt:
-			try {
-				_stack.push(-_stack.pop().getInt());
-			} catch (Common::Exception &e) {
-				throw;
-			}
+void NCSFile::o_neg(const Instruction &instr) {
+	switch (instr.type) {
+		case kInstTypeInt: {
+			int32 &arg = _stack.topInt();
+
+			arg = -arg;
 			break;
+		}
 
-		case kInstTypeFloat:
-			try {
-				_stack.push(-_stack.pop().getFloat());
-			} catch (Common::Exception &e) {
-				throw;
-			}
+		case kInstTypeFloat: {
+			float &arg = _stack.topFloat();
+
+			arg = -arg;
 			break;
+		}
 
 		default:
-			throw Common::Exception("NCSFile::o_neg(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_neg(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::o_comp(InstructionType type) {
-	if (type != kInstTypeInt)
-		throw Common::Exception("NCSFile::o_comp(): Illegal type %d", type);
-
-	try {
-		_stack.push(~_stack.pop().getInt());
-	} catch (Common::Exception &e) {
-		throw;
-	}
-}
+void NCSFile::o_comp(const Instruction &instr) {
+	if (instr.type != kInstTypeInt)
+		throw Common::Exception("NCSFile::o_comp(): Illegal type %d", instr.type);
 
-void NCSFile::o_movsp(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_movsp(): Illegal type %d", type);
+	int32 &arg = _stack.topInt();
 
-	_stack.setStackPtr(_stack.getStackPtr() - _script->readSint32BE());
+	arg = ~arg;
 }
 
-void NCSFile::o_jmp(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_jmp(): Illegal type %d", type);
+void NCSFile::o_movsp(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_movsp(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE();
-	_script->seek(offset - 6, SEEK_CUR);
+	_stack.setStackPtr(_stack.getStackPtr() - instr.args[0]);
 }
 
-void NCSFile::o_jz(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_jz(): Illegal type %d", type);
-
-	int32 offset = _script->readSint32BE();
+void NCSFile::o_jmp(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_jmp(): Illegal type %d", instr.type);
 
-	if (!_stack.pop().getInt())
-		_script->seek(offset - 6, SEEK_CUR);
+	jump(instr);
 }
 
-void NCSFile::o_not(InstructionType type) {
-	if (type != kInstTypeInt)
-		throw Common::Exception("NCSFile::o_not(): Illegal type %d", type);
+void NCSFile::o_jz(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_jz(): Illegal type %d", instr.type);
 
-	_stack.push(!_stack.pop().getInt());
+	if (!_stack.popInt())
+		jump(instr);
 }
 
-void NCSFile::o_decsp(InstructionType type) {
-	if (type != kInstTypeInt)
-		throw Common::Exception("NCSFile::o_decsp(): Illegal type %d", type);
+void NCSFile::o_not(const Instruction &instr) {
+	if (instr.type != kInstTypeInt)
+		throw Common::Exception("NCSFile::o_not(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE();
+	int32 &arg = _stack.topInt();
 
-	_stack.setRelSP(offset, _stack.getRelSP(offset).getInt() - 1);
+	arg = !arg;
 }
 
-void NCSFile::o_incsp(InstructionType type) {
-	if (type != kInstTypeInt)
-		throw Common::Exception("NCSFile::o_incsp(): Illegal type %d", type);
+void NCSFile::o_decsp(const Instruction &instr) {
+	if (instr.type != kInstTypeInt)
+		throw Common::Exception("NCSFile::o_decsp(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE();
-
-	_stack.setRelSP(offset, _stack.getRelSP(offset).getInt() + 1);
+	_stack.getInt(_stack.getRelSP(instr.args[0]))--;
 }
 
-void NCSFile::o_jnz(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_jnz(): Illegal type %d", type);
-
-	int32 offset = _script->readSint32BE();
+void NCSFile::o_incsp(const Instruction &instr) {
+	if (instr.type != kInstTypeInt)
+		throw Common::Exception("NCSFile::o_incsp(): Illegal type %d", instr.type);
 
-	if (_stack.pop().getInt())
-		_script->seek(offset - 6, SEEK_CUR);
+	_stack.getInt(_stack.getRelSP(instr.args[0]))++;
 }
 
-void NCSFile::o_decbp(InstructionType type) {
-	if (type != kInstTypeInt)
-		throw Common::Exception("NCSFile::o_decbp(): Illegal type %d", type);
+void NCSFile::o_jnz(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_jnz(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE();
-
-	_stack.setRelBP(offset, _stack.getRelBP(offset).getInt() - 1);
+	if (_stack.popInt())
+		jump(instr);
 }
 
-void NCSFile::o_incbp(InstructionType type) {
-	if (type != kInstTypeInt)
-		throw Common::Exception("NCSFile::o_incbp(): Illegal type %d", type);
+void NCSFile::o_decbp(const Instruction &instr) {
+	if (instr.type != kInstTypeInt)
+		throw Common::Exception("NCSFile::o_decbp(): Illegal type %d", instr.type);
+
+	_stack.getInt(_stack.getRelBP(instr.args[0]))--;
+}
 
-	int32 offset = _script->readSint32BE();
+void NCSFile::o_incbp(const Instruction &instr) {
+	if (instr.type != kInstTypeInt)
+		throw Common::Exception("NCSFile::o_incbp(): Illegal type %d", instr.type);
 
-	_stack.setRelBP(offset, _stack.getRelBP(offset).getInt() + 1);
+	_stack.getInt(_stack.getRelBP(instr.args[0]))++;
 }
 
-void NCSFile::o_savebp(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_savebp(): Illegal type %d", type);
+void NCSFile::o_savebp(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_savebp(): Illegal type %d", instr.type);
 
-	_stack.push(_stack.getBasePtr());
+	_stack.pushInt(_stack.getBasePtr());
 	_stack.setBasePtr(_stack.getStackPtr());
 }
 
-void NCSFile::o_restorebp(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_restorebp(): Illegal type %d", type);
+void NCSFile::o_restorebp(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_restorebp(): Illegal type %d", instr.type);
 
-	_stack.setBasePtr(_stack.pop().getInt());
+	_stack.setBasePtr(_stack.popInt());
 }
 
-void NCSFile::o_nop(InstructionType UNUSED(type)) {
+void NCSFile::o_nop(const Instruction &UNUSED(instr)) {
 	// Nothing! Yay!
 }
 
-void NCSFile::o_cpdownsp(InstructionType type) {
-	if (type != kInstTypeDirect)
-		throw Common::Exception("NCSFile::o_cpdownsp(): Illegal type %d", type);
+void NCSFile::o_cpdownsp(const Instruction &instr) {
+	if (instr.type != kInstTypeDirect)
+		throw Common::Exception("NCSFile::o_cpdownsp(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = instr.args[0];
+	int16 size   = instr.args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cpdownsp(): Illegal size %d", size);
 
 	int32 startPos = -size;
 	while (size > 0) {
-		_stack.setRelSP(offset, _stack.getRelSP(startPos));
+		_stack.copy(_stack.getRelSP(offset), _stack.getRelSP(startPos));
 
 		startPos += 4;
 		offset   += 4;
@@ -978,318 +1575,212 @@ void NCSFile::o_cpdownsp(InstructionType type) {
 	}
 }
 
-void NCSFile::o_cptopsp(InstructionType type) {
-	if (type != kInstTypeDirect)
-		throw Common::Exception("NCSFile::o_cptopsp(): Illegal type %d", type);
+void NCSFile::o_cptopsp(const Instruction &instr) {
+	if (instr.type != kInstTypeDirect)
+		throw Common::Exception("NCSFile::o_cptopsp(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = instr.args[0];
+	int16 size   = instr.args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cptopsp(): Illegal size %d", size);
 
 	while (size > 0) {
-		_stack.push(_stack.getRelSP(offset));
+		_stack.pushCopy(_stack.getRelSP(offset));
 
 		size -= 4;
 	}
 }
 
-void NCSFile::o_add(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push((int32) (op1.getInt() + op2.getInt()));
-			break;
-		}
-
-		case kInstTypeFloatFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getFloat() + op2.getFloat());
-			break;
-		}
-
-		case kInstTypeIntFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(((float) op1.getInt()) + op2.getFloat());
-			break;
-		}
-
-		case kInstTypeFloatInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getFloat() + ((float) op2.getInt()));
-			break;
-		}
-
-		case kInstTypeStringString: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getString() + op2.getString());
-			break;
-		}
-
+void NCSFile::o_add(const Instruction &instr) {
+	switch (instr.type) {
 		case kInstTypeVectorVector: {
-			Variable op2z = _stack.pop();
-			Variable op2y = _stack.pop();
-			Variable op2x = _stack.pop();
-			Variable op1z = _stack.pop();
-			Variable op1y = _stack.pop();
-			Variable op1x = _stack.pop();
-
-			_stack.push(op1z.getFloat() + op2z.getFloat());
-			_stack.push(op1y.getFloat() + op2y.getFloat());
-			_stack.push(op1x.getFloat() + op2x.getFloat());
+			float op2z = _stack.popFloat();
+			float op2y = _stack.popFloat();
+			float op2x = _stack.popFloat();
+			float op1z = _stack.popFloat();
+			float op1y = _stack.popFloat();
+			float op1x = _stack.popFloat();
+
+			_stack.pushFloat(op1z + op2z);
+			_stack.pushFloat(op1y + op2y);
+			_stack.pushFloat(op1x + op2x);
 			break;
 		}
 
 		default:
-			throw Common::Exception("NCSFile::o_add(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_add(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::o_sub(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push((int32) (op1.getInt() - op2.getInt()));
-			break;
-		}
-
-		case kInstTypeFloatFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getFloat() - op2.getFloat());
-			break;
-		}
-
-		case kInstTypeIntFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(((float) op1.getInt()) - op2.getFloat());
-			break;
-		}
-
-		case kInstTypeFloatInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getFloat() - ((float) op2.getInt()));
-			break;
-		}
-
+void NCSFile::o_sub(const Instruction &instr) {
+	switch (instr.type) {
 		case kInstTypeVectorVector: {
-			Variable op2z = _stack.pop();
-			Variable op2y = _stack.pop();
-			Variable op2x = _stack.pop();
-			Variable op1z = _stack.pop();
-			Variable op1y = _stack.pop();
-			Variable op1x = _stack.pop();
-
-			_stack.push(op1z.getFloat() - op2z.getFloat());
-			_stack.push(op1y.getFloat() - op2y.getFloat());
-			_stack.push(op1x.getFloat() - op2x.getFloat());
+			float op2z = _stack.popFloat();
+			float op2y = _stack.popFloat();
+			float op2x = _stack.popFloat();
+			float op1z = _stack.popFloat();
+			float op1y = _stack.popFloat();
+			float op1x = _stack.popFloat();
+
+			_stack.pushFloat(op1z - op2z);
+			_stack.pushFloat(op1y - op2y);
+			_stack.pushFloat(op1x - op2x);
 			break;
 		}
 
 		default:
-			throw Common::Exception("NCSFile::o_sub(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_sub(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::o_mul(InstructionType type) {
-	switch (type) {
-		case kInstTypeIntInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push((int32) (op1.getInt() * op2.getInt()));
-			break;
-		}
-
-		case kInstTypeFloatFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getFloat() * op2.getFloat());
-			break;
-		}
-
-		case kInstTypeIntFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(((float) op1.getInt()) * op2.getFloat());
-			break;
-		}
-
-		case kInstTypeFloatInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
-
-			_stack.push(op1.getFloat() * ((float) op2.getInt()));
-			break;
-		}
-
+void NCSFile::o_mul(const Instruction &instr) {
+	switch (instr.type) {
 		case kInstTypeVectorFloat: {
-			Variable op2  = _stack.pop();
-			Variable op1z = _stack.pop();
-			Variable op1y = _stack.pop();
-			Variable op1x = _stack.pop();
-
-			_stack.push(op1z.getFloat() * op2.getFloat());
-			_stack.push(op1y.getFloat() * op2.getFloat());
-			_stack.push(op1x.getFloat() * op2.getFloat());
+			float op2  = _stack.popFloat();
+			float op1z = _stack.popFloat();
+			float op1y = _stack.popFloat();
+			float op1x = _stack.popFloat();
+
+			_stack.pushFloat(op1z * op2);
+			_stack.pushFloat(op1y * op2);
+			_stack.pushFloat(op1x * op2);
 			break;
 		}
 
 		case kInstTypeFloatVector: {
-			Variable op2z = _stack.pop();
-			Variable op2y = _stack.pop();
-			Variable op2x = _stack.pop();
-			Variable op1  = _stack.pop();
-
-			_stack.push(op1.getFloat() * op2z.getFloat());
-			_stack.push(op1.getFloat() * op2y.getFloat());
-			_stack.push(op1.getFloat() * op2x.getFloat());
+			float op2z = _stack.popFloat();
+			float op2y = _stack.popFloat();
+			float op2x = _stack.popFloat();
+			float op1  = _stack.popFloat();
+
+			_stack.pushFloat(op1 * op2z);
+			_stack.pushFloat(op1 * op2y);
+			_stack.pushFloat(op1 * op2x);
 			break;
 		}
 
 		default:
-			throw Common::Exception("NCSFile::o_mul(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_mul(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::o_div(InstructionType type) {
-	switch (type) {
+void NCSFile::o_div(const Instruction &instr) {
+	switch (instr.type) {
 		case kInstTypeIntInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
+			int32  op2 = _stack.popInt();
+			int32 &op1 = _stack.topInt();
 
-			if (op2.getInt() == 0)
+			if (op2 == 0)
 				throw Common::Exception("NCSFile::o_div(): Divide by zero");
 
-			if (op1.getInt() == INT32_MIN && op2.getInt() == -1)
+			if (op1 == INT32_MIN && op2 == -1)
 				throw Common::Exception("NCSFile::o_div: Quotient overflow");
 
-			_stack.push((int32) (op1.getInt() / op2.getInt()));
+			op1 = op1 / op2;
 			break;
 		}
 
 		case kInstTypeFloatFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
+			float  op2 = _stack.popFloat();
+			float &op1 = _stack.topFloat();
 
-			if (op2.getFloat() == 0.0f)
+			if (op2 == 0.0f)
 				throw Common::Exception("NCSFile::o_div(): Divide by zero");
 
-			_stack.push(op1.getFloat() / op2.getFloat());
+			op1 = op1 / op2;
 			break;
 		}
 
 		case kInstTypeIntFloat: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
+			float op2 = _stack.popFloat();
+			int32 op1 = _stack.popInt();
 
-			if (op2.getFloat() == 0.0f)
+			if (op2 == 0.0f)
 				throw Common::Exception("NCSFile::o_div(): Divide by zero");
 
-			_stack.push(((float) op1.getInt()) / op2.getFloat());
+			_stack.pushFloat(((float) op1) / op2);
 			break;
 		}
 
 		case kInstTypeFloatInt: {
-			Variable op2 = _stack.pop();
-			Variable op1 = _stack.pop();
+			int32  op2 = _stack.popInt();
+			float &op1 = _stack.topFloat();
 
-			if (op2.getInt() == 0)
+			if (op2 == 0)
 				throw Common::Exception("NCSFile::o_div(): Divide by zero");
 
-			_stack.push(op1.getFloat() / ((float) op2.getInt()));
+			op1 = op1 / ((float) op2);
 			break;
 		}
 
 		case kInstTypeVectorFloat: {
-			Variable op2  = _stack.pop();
-			Variable op1z = _stack.pop();
-			Variable op1y = _stack.pop();
-			Variable op1x = _stack.pop();
+			float op2  = _stack.popFloat();
+			float op1z = _stack.popFloat();
+			float op1y = _stack.popFloat();
+			float op1x = _stack.popFloat();
 
-			if (op2.getFloat() == 0.0f)
+			if (op2 == 0.0f)
 				throw Common::Exception("NCSFile::o_div(): Divide by zero");
 
-			_stack.push(op1z.getFloat() / op2.getFloat());
-			_stack.push(op1y.getFloat() / op2.getFloat());
-			_stack.push(op1x.getFloat() / op2.getFloat());
+			_stack.pushFloat(op1z / op2);
+			_stack.pushFloat(op1y / op2);
+			_stack.pushFloat(op1x / op2);
 			break;
 		}
 
 		case kInstTypeFloatVector: {
-			Variable op2z = _stack.pop();
-			Variable op2y = _stack.pop();
-			Variable op2x = _stack.pop();
-			Variable op1  = _stack.pop();
+			float op2z = _stack.popFloat();
+			float op2y = _stack.popFloat();
+			float op2x = _stack.popFloat();
+			float op1  = _stack.popFloat();
 
-			if (op2x.getFloat() == 0.0f || op2y.getFloat() == 0.0f || op2z.getFloat() == 0.0f)
+			if (op2x == 0.0f || op2y == 0.0f || op2z == 0.0f)
 				throw Common::Exception("NCSFile::o_div(): Divide by zero");
 
-			_stack.push(op1.getFloat() / op2z.getFloat());
-			_stack.push(op1.getFloat() / op2y.getFloat());
-			_stack.push(op1.getFloat() / op2x.getFloat());
+			_stack.pushFloat(op1 / op2z);
+			_stack.pushFloat(op1 / op2y);
+			_stack.pushFloat(op1 / op2x);
 			break;
 		}
 
 		default:
-			throw Common::Exception("NCSFile::o_div(): Illegal type %d", type);
+			throw Common::Exception("NCSFile::o_div(): Illegal type %d", instr.type);
 	}
 }
 
-void NCSFile::o_storestateall(InstructionType type) {
-	uint8  offset = (uint8) type;
+void NCSFile::o_storestateall(const Instruction &instr) {
+	uint8  offset = (uint8) instr.type;
 
 	// TODO: NCSFile::o_storestateall(): See o_storestate.
 	//       Supposedly obsolete. Whether it's used anywhere remains to be seen.
 	warning("TODO: NCSFile::o_storestateall(): %d", offset);
 }
 
-void NCSFile::o_jsr(InstructionType type) {
-	if (type != kInstTypeNone)
-		throw Common::Exception("NCSFile::o_jsr(): Illegal type %d", type);
-
-	int32 offset = _script->readSint32BE();
+void NCSFile::o_jsr(const Instruction &instr) {
+	if (instr.type != kInstTypeNone)
+		throw Common::Exception("NCSFile::o_jsr(): Illegal type %d", instr.type);
 
 	// Push the current script position
-	_returnOffsets.push(_script->pos());
+	_returnOffsets.push(_pc);
 
-	_script->seek(offset - 6, SEEK_CUR);
+	jump(instr);
 }
 
-void NCSFile::o_retn(InstructionType UNUSED(type)) {
-	uint32 returnAddress = _script->size();
+void NCSFile::o_retn(const Instruction &UNUSED(instr)) {
+	uint32 returnAddress = _program->instructions.size();
 	if (!_returnOffsets.empty()) {
 		returnAddress = _returnOffsets.top();
 		_returnOffsets.pop();
 	}
 
-	_script->seek(returnAddress);
+	_pc = returnAddress;
 }
 
-void NCSFile::o_destruct(InstructionType UNUSED(type)) {
-	int16 stackSize        = _script->readSint16BE();
-	int16 dontRemoveOffset = _script->readSint16BE();
-	int16 dontRemoveSize   = _script->readSint16BE();
+void NCSFile::o_destruct(const Instruction &instr) {
+	int16 stackSize        = instr.args[0];
+	int16 dontRemoveOffset = instr.args[1];
+	int16 dontRemoveSize   = instr.args[2];
 
 	if ((stackSize % 4) != 0)
 		throw Common::Exception("NCSFile::o_destruct(): Illegal stack size %d", stackSize);
@@ -1298,37 +1789,28 @@ void NCSFile::o_destruct(InstructionType UNUSED(type)) {
 	if ((dontRemoveSize % 4) != 0)
 		throw Common::Exception("NCSFile::o_destruct(): Illegal size %d", dontRemoveSize);
 
-	std::vector<Variable> tmp;
-	tmp.reserve(dontRemoveSize / 4);
-
-	while (stackSize > 0) {
-
-		if ((stackSize <= (dontRemoveOffset + dontRemoveSize)) &&
-		    (stackSize >   dontRemoveOffset))
-			tmp.push_back(_stack.top());
-
-		_stack.pop();
+	if (stackSize <= 0)
+		return;
 
-		stackSize -= 4;
-	}
+	const int32 keepStart = MAX<int32>(dontRemoveOffset, 0) / 4;
+	const int32 keepEnd   = MAX<int32>(dontRemoveOffset + dontRemoveSize, 0) / 4;
 
-	for (std::vector<Variable>::reverse_iterator t = tmp.rbegin(); t != tmp.rend(); ++t)
-		_stack.push(*t);
+	_stack.remove(stackSize / 4, keepStart, MAX<int32>(keepEnd - keepStart, 0));
 }
 
-void NCSFile::o_cpdownbp(InstructionType type) {
-	if (type != kInstTypeDirect)
-		throw Common::Exception("NCSFile::o_cpdownbp(): Illegal type %d", type);
+void NCSFile::o_cpdownbp(const Instruction &instr) {
+	if (instr.type != kInstTypeDirect)
+		throw Common::Exception("NCSFile::o_cpdownbp(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE() - 4;
-	int16 size   = _script->readSint16BE();
+	int32 offset = instr.args[0] - 4;
+	int16 size   = instr.args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cpdownbp(): Illegal size %d", size);
 
 	int32 startPos = -size;
 	while (size > 0) {
-		_stack.setRelBP(offset, _stack.getRelSP(startPos));
+		_stack.copy(_stack.getRelBP(offset), _stack.getRelSP(startPos));
 
 		startPos += 4;
 		offset   += 4;
@@ -1336,28 +1818,28 @@ void NCSFile::o_cpdownbp(InstructionType type) {
 	}
 }
 
-void NCSFile::o_cptopbp(InstructionType type) {
-	if (type != kInstTypeDirect)
-		throw Common::Exception("NCSFile::o_cptopbp(): Illegal type %d", type);
+void NCSFile::o_cptopbp(const Instruction &instr) {
+	if (instr.type != kInstTypeDirect)
+		throw Common::Exception("NCSFile::o_cptopbp(): Illegal type %d", instr.type);
 
-	int32 offset = _script->readSint32BE() - 4;
-	int16 size   = _script->readSint16BE();
+	int32 offset = instr.args[0] - 4;
+	int16 size   = instr.args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cptopbp(): Illegal size %d", size);
 
 	while (size > 0) {
-		_stack.push(_stack.getRelBP(offset));
+		_stack.pushCopy(_stack.getRelBP(offset));
 
 		size   -= 4;
 		offset += 4;
 	}
 }
 
-void NCSFile::o_storestate(InstructionType type) {
-	uint8  offset = (uint8) type;
-	uint32 sizeBP = _script->readUint32BE();
-	uint32 sizeSP = _script->readUint32BE();
+void NCSFile::o_storestate(const Instruction &instr) {
+	uint8  offset = (uint8) instr.type;
+	uint32 sizeBP = (uint32) instr.args[0];
+	uint32 sizeSP = (uint32) instr.args[1];
 
 	if ((sizeBP % 4) != 0)
 		throw Common::Exception("NCSFile::o_storestate(): Illegal BP size %d", sizeBP);
@@ -1367,16 +1849,181 @@ void NCSFile::o_storestate(InstructionType type) {
 	_storedState.setType(kTypeScriptState);
 	ScriptState &state = _storedState.getScriptState();
 
-	state.offset = _script->pos() - 10 + offset;
+	state.offset = instr.address + offset;
 
 	sizeBP /= 4;
 	sizeSP /= 4;
 
 	for (int32 posBP = -4; sizeBP > 0; sizeBP--, posBP -= 4)
-		state.globals.push_back(_stack.getRelBP(posBP));
+		state.globals.push_back(_stack.getVariable(_stack.getRelBP(posBP)));
 
 	for (int32 posSP = -4; sizeSP > 0; sizeSP--, posSP -= 4)
-		state.locals.push_back(_stack.getRelSP(posSP));
+		state.locals.push_back(_stack.getVariable(_stack.getRelSP(posSP)));
+}
+
+// Specialized opcodes
+
+void NCSFile::o_addII(const Instruction &UNUSED(instr)) {
+	int32 op2 = _stack.popInt();
+
+	_stack.topInt() += op2;
+}
+
+void NCSFile::o_addFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+
+	_stack.topFloat() += op2;
+}
+
+void NCSFile::o_addIF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	int32 op1 = _stack.popInt();
+
+	_stack.pushFloat(((float) op1) + op2);
+}
+
+void NCSFile::o_addFI(const Instruction &UNUSED(instr)) {
+	int32 op2 = _stack.popInt();
+
+	_stack.topFloat() += (float) op2;
+}
+
+void NCSFile::o_addSS(const Instruction &UNUSED(instr)) {
+	_stack.concatStrings();
+}
+
+void NCSFile::o_subII(const Instruction &UNUSED(instr)) {
+	int32 op2 = _stack.popInt();
+
+	_stack.topInt() -= op2;
+}
+
+void NCSFile::o_subFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+
+	_stack.topFloat() -= op2;
+}
+
+void NCSFile::o_subIF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	int32 op1 = _stack.popInt();
+
+	_stack.pushFloat(((float) op1) - op2);
+}
+
+void NCSFile::o_subFI(const Instruction &UNUSED(instr)) {
+	int32 op2 = _stack.popInt();
+
+	_stack.topFloat() -= (float) op2;
+}
+
+void NCSFile::o_mulII(const Instruction &UNUSED(instr)) {
+	int32 op2 = _stack.popInt();
+
+	_stack.topInt() *= op2;
+}
+
+void NCSFile::o_mulFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+
+	_stack.topFloat() *= op2;
+}
+
+void NCSFile::o_mulIF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	int32 op1 = _stack.popInt();
+
+	_stack.pushFloat(((float) op1) * op2);
+}
+
+void NCSFile::o_mulFI(const Instruction &UNUSED(instr)) {
+	int32 op2 = _stack.popInt();
+
+	_stack.topFloat() *= (float) op2;
+}
+
+void NCSFile::o_eqII(const Instruction &UNUSED(instr)) {
+	int32  op2 = _stack.popInt();
+	int32 &op1 = _stack.topInt();
+
+	op1 = op1 == op2;
+}
+
+void NCSFile::o_eqFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	float op1 = _stack.popFloat();
+
+	_stack.pushInt(op1 == op2);
+}
+
+void NCSFile::o_neqII(const Instruction &UNUSED(instr)) {
+	int32  op2 = _stack.popInt();
+	int32 &op1 = _stack.topInt();
+
+	op1 = op1 != op2;
+}
+
+void NCSFile::o_neqFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	float op1 = _stack.popFloat();
+
+	_stack.pushInt(op1 != op2);
+}
+
+void NCSFile::o_geqII(const Instruction &UNUSED(instr)) {
+	int32  op2 = _stack.popInt();
+	int32 &op1 = _stack.topInt();
+
+	op1 = op1 >= op2;
+}
+
+void NCSFile::o_geqFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	float op1 = _stack.popFloat();
+
+	_stack.pushInt(op1 >= op2);
+}
+
+void NCSFile::o_gtII(const Instruction &UNUSED(instr)) {
+	int32  op2 = _stack.popInt();
+	int32 &op1 = _stack.topInt();
+
+	op1 = op1 > op2;
+}
+
+void NCSFile::o_gtFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	float op1 = _stack.popFloat();
+
+	_stack.pushInt(op1 > op2);
+}
+
+void NCSFile::o_ltII(const Instruction &UNUSED(instr)) {
+	int32  op2 = _stack.popInt();
+	int32 &op1 = _stack.topInt();
+
+	op1 = op1 < op2;
+}
+
+void NCSFile::o_ltFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	float op1 = _stack.popFloat();
+
+	_stack.pushInt(op1 < op2);
+}
+
+void NCSFile::o_leqII(const Instruction &UNUSED(instr)) {
+	int32  op2 = _stack.popInt();
+	int32 &op1 = _stack.topInt();
+
+	op1 = op1 <= op2;
+}
+
+void NCSFile::o_leqFF(const Instruction &UNUSED(instr)) {
+	float op2 = _stack.popFloat();
+	float op1 = _stack.popFloat();
+
+	_stack.pushInt(op1 <= op2);
 }
 
 } // End of namespace NWScript
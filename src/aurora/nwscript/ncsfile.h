@@ -27,14 +27,20 @@
 
 #include <vector>
 #include <stack>
+#include <map>
+
+#include <boost/shared_ptr.hpp>
 
 #include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 #include "src/aurora/aurorafile.h"
 
 #include "src/aurora/nwscript/types.h"
 #include "src/aurora/nwscript/variable.h"
+#include "src/aurora/nwscript/functioncontext.h"
 
 namespace Common {
 	class UString;
@@ -45,8 +51,98 @@ namespace Aurora {
 
 namespace NWScript {
 
-class NCSStack : public std::vector<Variable> {
+/** A pool of reference-counted values, whose slots are reused once freed. */
+template<typename T>
+class NCSPool {
+public:
+	/** Add a new entry, with a reference count of 1. */
+	uint32 add() {
+		uint32 index;
+		if (!_free.empty()) {
+			index = _free.back();
+			_free.pop_back();
+		} else {
+			index = _entries.size();
+			_entries.push_back(Entry());
+		}
+
+		_entries[index].refCount = 1;
+		return index;
+	}
+
+	/** Would adding a new entry move the existing ones around? */
+	bool isFull() const {
+		return _free.empty() && (_entries.size() == _entries.capacity());
+	}
+
+	void ref(uint32 index) {
+		_entries[index].refCount++;
+	}
+
+	/** Drop a reference. Returns true if the entry is now unused. */
+	bool unref(uint32 index) {
+		if (--_entries[index].refCount > 0)
+			return false;
+
+		_free.push_back(index);
+		return true;
+	}
+
+	T &get(uint32 index) {
+		return _entries[index].value;
+	}
+
+	const T &get(uint32 index) const {
+		return _entries[index].value;
+	}
+
+	/** Mark all entries as unused, keeping their values around for reuse. */
+	void clear() {
+		_free.clear();
+
+		for (uint32 i = _entries.size(); i > 0; i--) {
+			_entries[i - 1].refCount = 0;
+			_free.push_back(i - 1);
+		}
+	}
+
+private:
+	struct Entry {
+		T value;
+		uint32 refCount;
+
+		Entry() : value(), refCount(0) { }
+	};
+
+	std::vector<Entry>  _entries;
+	std::vector<uint32> _free;
+};
+
+/** The stack of an executing NCS.
+ *
+ *  Values are kept flat and tagged with their type. Strings and engine
+ *  types live in reference-counted pools, so pushing, popping and copying
+ *  values around never needs to allocate.
+ */
+class NCSStack {
 public:
+	/** A value on the stack. */
+	struct Value {
+		Type type;
+
+		union {
+			int32   integer;
+			float   floating;
+			Object *object;
+			uint32  string;     ///< Index into the string pool.
+			uint32  engineType; ///< Index into the engine type pool, or kNoEngineType.
+		};
+
+		Value() : type(kTypeVoid), integer(0) { }
+	};
+
+	static const uint32 kNoEngineType = 0xFFFFFFFF;
+
 	NCSStack();
 	~NCSStack();
 
@@ -54,32 +150,110 @@ public:
 
 	bool empty() const;
 
-	Variable &top();
-	Variable pop();
-	void push(const Variable &obj);
+	/** Push a variable onto the stack. */
+	void push(const Variable &var);
+	/** Pop the top value off the stack into this variable. */
+	void pop(Variable &var);
+	/** Pop the top value off the stack, throwing it away. */
+	void pop();
+
+	void pushInt(int32 value);
+	void pushFloat(float value);
+	void pushObject(Object *value);
+	void pushString(const Common::UString &value);
+	void pushEngineType(const EngineType *value);
+
+	/** Push an already pooled string, adding a reference to it. */
+	void pushString(uint32 string);
+
+	/** Push the default value of this type. */
+	void pushEmpty(Type type);
+
+	/** Push a copy of the value at this index. */
+	void pushCopy(uint32 index);
+
+	int32   popInt();
+	float   popFloat();
+	Object *popObject();
+
+	/** Return the int on top of the stack, to be modified in place. */
+	int32 &topInt();
+	/** Return the float on top of the stack, to be modified in place. */
+	float &topFloat();
+
+	/** Return the int at this index, to be modified in place. */
+	int32 &getInt(uint32 index);
 
-	Variable &getRelSP(int32 pos);
-	void setRelSP(int32 pos, const Variable &obj);
+	Value &top();
+	Value &at(uint32 index);
 
-	Variable &getRelBP(int32 pos);
-	void setRelBP(int32 pos, const Variable &obj);
+	/** Convert the value at this index into a variable. */
+	Variable getVariable(uint32 index) const;
 
-	int32 getStackPtr();
+	/** Copy the value at index src over the value at index dest. */
+	void copy(uint32 dest, uint32 src);
+
+	/** Are the values at these two indices equal? */
+	bool equal(uint32 index1, uint32 index2) const;
+
+	/** Replace the two strings on top of the stack with their concatenation. */
+	void concatStrings();
+
+	/** Remove the top count values, except for keepCount values starting
+	 *  keepStart values from the bottom of that range. */
+	void remove(uint32 count, uint32 keepStart, uint32 keepCount);
+
+	/** Add a string to the pool. The caller holds the only reference. */
+	uint32 addString(const Common::UString &value);
+
+	const Common::UString &getString(const Value &value) const;
+	EngineType *getEngineType(const Value &value) const;
+
+	/** Return the index of the value at this position relative to the stack pointer. */
+	uint32 getRelSP(int32 pos) const;
+	/** Return the index of the value at this position relative to the base pointer. */
+	uint32 getRelBP(int32 pos) const;
+
+	int32 getStackPtr() const;
 	void  setStackPtr(int32 pos);
 
-	int32 getBasePtr();
+	int32 getBasePtr() const;
 	void  setBasePtr(int32 pos);
 
 	void print() const;
 
 private:
+	std::vector<Value> _values;
+
+	NCSPool<Common::UString> _strings;
+	NCSPool<EngineType *>    _engineTypes;
+
 	int32 _stackPtr;
 	int32 _basePtr;
+
+	Value &pushValue();
+
+	/** Add a reference to a value's pooled data. */
+	void addRef(const Value &value);
+	/** Drop a value's pooled data and empty it. */
+	void release(Value &value);
+
+	uint32 getRel(int32 ptr, int32 pos) const;
 };
 
-#define DECLARE_OPCODE(x) void x(InstructionType type)
+#define DECLARE_OPCODE(x) void x(const Instruction &instr)
 
-/** An NCS, BioWare's NWN Compile Script. */
+/** An NCS, BioWare's NWN Compile Script.
+ *
+ *  The bytecode is decoded once into an array of instructions with their
+ *  operands and jump targets already resolved. Scripts loaded by name are
+ *  kept in a cache, so running the same script again doesn't need to read
+ *  and decode it anew.
+ *
+ *  Arithmetic and comparison instructions on ints and floats are bound to
+ *  handlers specialized for their operand types while decoding, and work
+ *  directly on the values on top of the stack.
+ */
 class NCSFile : public AuroraBase {
 public:
 	NCSFile(Common::SeekableReadStream *ncs);
@@ -96,6 +270,9 @@ public:
 
 	static ScriptState getEmptyState();
 
+	/** Forget all cached scripts. */
+	static void clearCache();
+
 private:
 	enum InstructionType {
 		// Unary
@@ -127,10 +304,91 @@ private:
 		kInstTypeFloatVector      = 60
 	};
 
+	struct Instruction;
+
+	typedef void (NCSFile::*OpcodeProc)(const Instruction &instr);
+	struct Opcode {
+		OpcodeProc proc;
+		const char *desc;
+	};
+
+	/** An opcode handler specialized for one instruction type. */
+	struct SpecializedOpcode {
+		uint8           opcode;
+		InstructionType type;
+		OpcodeProc      proc;
+	};
+
+	/** A decoded instruction. */
+	struct Instruction {
+		uint32 address; ///< The instruction's offset within the NCS.
+
+		uint8           opcode;
+		InstructionType type;
+
+		int32 args[3];  ///< The integer operands.
+		float argFloat; ///< The float operand of a float constant.
+
+		/** The instruction index a jump goes to, kInvalidJump if it doesn't point to an instruction. */
+		uint32 jump;
+
+		/** The handler executing this instruction, 0 for illegal instructions. */
+		OpcodeProc proc;
+	};
+
+	/** An engine function called by a script, bound when the script is decoded. */
+	struct EngineFunction {
+		uint32 id;
+
+		bool bound; ///< Was the function found in the function manager?
+		bool inUse; ///< Is the context currently used by a running call? Guarded by the program's mutex.
+
+		Function func;
+
+		FunctionContext prototype; ///< The function's pristine context, with its defaults.
+		FunctionContext ctx;       ///< The context reused by all calls.
+
+		EngineFunction(uint32 i = 0);
+	};
+
+	/** A decoded script, shared between all NCSFiles running it. */
+	struct Program {
+		Common::UString name;
+
+		std::vector<Instruction>     instructions;
+		std::vector<Common::UString> strings;   ///< The string constants.
+		std::vector<EngineFunction>  functions; ///< The engine functions called.
+
+		uint32 end; ///< The offset right behind the last instruction.
+
+		/** Guards binding the engine functions and claiming their contexts.
+		 *
+		 *  The same program might run in several threads at once, for example
+		 *  in scripts fired while areas are loaded in the background.
+		 */
+		Common::Mutex mutex;
+	};
+
+	typedef std::map<Common::UString, boost::shared_ptr<Program> > ProgramCache;
+
+	static const uint32 kInvalidJump   = 0xFFFFFFFF;
+	static const uint32 kInvalidString = 0xFFFFFFFF;
+
+	static ProgramCache  _programCache;      ///< All scripts loaded by name.
+	static uint32        _programRevision;   ///< The resource revision the cache is valid for.
+	static uint32        _functionRevision;  ///< The engine function revision the cache is valid for.
+	static Common::Mutex _programCacheMutex; ///< The mutex guarding the program cache and its revisions.
+
 	Common::UString _name;
 
 	NCSStack _stack;
-	Common::SeekableReadStream *_script;
+
+	boost::shared_ptr<Program> _program;
+
+	uint32 _pc; ///< The index of the next instruction to execute.
+
+	/** The string pool indices of the program's string constants, once they've been pushed. */
+	std::vector<uint32> _stringConstants;
 
 	Variable _return;
 
@@ -141,16 +399,33 @@ private:
 
 	Variable _storedState;
 
-	typedef void (NCSFile::*OpcodeProc)(InstructionType type);
-	struct Opcode {
-		OpcodeProc proc;
-		const char *desc;
-	};
 	const Opcode *_opcodes;
 	uint32 _opcodeListSize;
+
+	const SpecializedOpcode *_specializedOpcodes;
+	uint32 _specializedOpcodeListSize;
+
 	void setupOpcodes();
 
-	void load();
+	/** Find the handler for this instruction, preferring a specialized one. */
+	OpcodeProc getOpcodeProc(uint8 opcode, InstructionType type) const;
+
+	void load(Common::SeekableReadStream &ncs);
+	void decode(Common::SeekableReadStream &ncs);
+	bool decodeInstruction(Common::SeekableReadStream &ncs, Instruction &instr);
+	void resolveJumps();
+
+	/** Find the instruction at this offset. */
+	uint32 findInstruction(uint32 address) const;
+
+	/** Return the index of this engine function within the program, adding it if necessary. */
+	uint32 addFunction(uint32 id);
+	/** Bind the engine function to its implementation. */
+	void bindFunction(EngineFunction &function);
+	/** Mark the function's reusable context as free again. */
+	void releaseContext(EngineFunction &function);
+
+	static boost::shared_ptr<Program> getCachedProgram(const Common::UString &name);
 
 	/** Reset the script for another execution. */
 	void reset();
@@ -160,9 +435,11 @@ private:
 	/** Execute one script step. */
 	void executeStep();
 
+	void jump(const Instruction &instr);
+
 	void decompile(); // TODO
 
-	void callEngine(Aurora::NWScript::FunctionContext &ctx, uint32 function, uint8 argCount);
+	void callEngine(const EngineFunction &function, FunctionContext &ctx, uint8 argCount);
 
 	// Opcode declarations
 	DECLARE_OPCODE(o_nop);
@@ -210,6 +487,33 @@ private:
 	DECLARE_OPCODE(o_savebp);
 	DECLARE_OPCODE(o_restorebp);
 	DECLARE_OPCODE(o_storestate);
+
+	// Opcodes specialized for one instruction type
+	DECLARE_OPCODE(o_addII);
+	DECLARE_OPCODE(o_addFF);
+	DECLARE_OPCODE(o_addIF);
+	DECLARE_OPCODE(o_addFI);
+	DECLARE_OPCODE(o_addSS);
+	DECLARE_OPCODE(o_subII);
+	DECLARE_OPCODE(o_subFF);
+	DECLARE_OPCODE(o_subIF);
+	DECLARE_OPCODE(o_subFI);
+	DECLARE_OPCODE(o_mulII);
+	DECLARE_OPCODE(o_mulFF);
+	DECLARE_OPCODE(o_mulIF);
+	DECLARE_OPCODE(o_mulFI);
+	DECLARE_OPCODE(o_eqII);
+	DECLARE_OPCODE(o_eqFF);
+	DECLARE_OPCODE(o_neqII);
+	DECLARE_OPCODE(o_neqFF);
+	DECLARE_OPCODE(o_geqII);
+	DECLARE_OPCODE(o_geqFF);
+	DECLARE_OPCODE(o_gtII);
+	DECLARE_OPCODE(o_gtFF);
+	DECLARE_OPCODE(o_ltII);
+	DECLARE_OPCODE(o_ltFF);
+	DECLARE_OPCODE(o_leqII);
+	DECLARE_OPCODE(o_leqFF);
 };
 
 #undef DECLARE_OPCODE
@@ -31,7 +31,10 @@ namespace Aurora {
 
 namespace NWScript {
 
-Object::Object() : _id(kObjectIDInvalid), _objectContainer(0) {
+Object::Object() : _id(kObjectIDInvalid), _objectContainer(0), _spatialArea(0), _spatialCell(0) {
+	_spatialPosition[0] = 0.0f;
+	_spatialPosition[1] = 0.0f;
+	_spatialPosition[2] = 0.0f;
 }
 
 Object::~Object() {
@@ -53,6 +56,32 @@ void Object::removeContainer() {
 	_objectContainer->removeObject(*this);
 }
 
+void Object::setSpatialPosition(Object *area, float x, float y, float z) {
+	if (!area) {
+		clearSpatialPosition();
+		return;
+	}
+
+	Object *oldArea = _spatialArea;
+
+	_spatialArea        = area;
+	_spatialPosition[0] = x;
+	_spatialPosition[1] = y;
+	_spatialPosition[2] = z;
+
+	if (_objectContainer)
+		_objectContainer->moveObject(*this, oldArea);
+}
+
+void Object::clearSpatialPosition() {
+	Object *oldArea = _spatialArea;
+
+	_spatialArea = 0;
+
+	if (_objectContainer)
+		_objectContainer->moveObject(*this, oldArea);
+}
+
 } // End of namespace NWScript
 
 } // End of namespace Aurora
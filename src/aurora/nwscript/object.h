@@ -27,6 +27,8 @@
 
 #include <map>
 
+#include <boost/unordered/unordered_map.hpp>
+
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 
@@ -38,7 +40,7 @@ namespace NWScript {
 
 class ObjectContainer;
 
-typedef std::map<uint32, class Object *> ObjectIDMap;
+typedef boost::unordered_map<uint32, class Object *> ObjectIDMap;
 typedef std::multimap<Common::UString, class Object *> ObjectTagMap;
 
 class Object : public VariableContainer {
@@ -57,10 +59,19 @@ protected:
 
 	void removeContainer();
 
+	/** Place the object at this position within this area, for the container's spatial searches. */
+	void setSpatialPosition(Object *area, float x, float y, float z);
+	/** Remove the object from the container's spatial searches. */
+	void clearSpatialPosition();
+
 private:
 	ObjectContainer *_objectContainer;
 	ObjectTagMap::iterator _objectContainerTag;
 
+	Object *_spatialArea;       ///< The area the object is placed in, or 0 if it isn't.
+	float   _spatialPosition[3]; ///< The object's position within that area.
+	uint64  _spatialCell;        ///< The container grid cell the object is sorted into.
+
 	friend class ObjectContainer;
 };
 
@@ -22,6 +22,9 @@
  *  An NWScript object container.
  */
 
+#include <algorithm>
+
+#include "src/common/util.h"
 #include "src/common/error.h"
 
 #include "src/aurora/types.h"
@@ -32,6 +35,13 @@ namespace Aurora {
 
 namespace NWScript {
 
+/** Edge length of a spatial grid cell. This matches the size of an NWN area tile. */
+static const float kSpatialCellSize = 10.0f;
+
+ObjectFilter::~ObjectFilter() {
+}
+
+
 ObjectContainer::SearchContext::SearchContext() : _empty(true), _object(0) {
 }
 
@@ -43,6 +53,22 @@ Object *ObjectContainer::SearchContext::getObject() const {
 }
 
 
+ObjectContainer::SpatialMatch::SpatialMatch(float d, Object *o) : distance(d), object(o) {
+}
+
+bool ObjectContainer::SpatialMatch::operator<(const SpatialMatch &match) const {
+	if (distance != match.distance)
+		return distance < match.distance;
+
+	// Keep the order of equidistant objects stable
+	return object->getID() < match.object->getID();
+}
+
+
+ObjectContainer::SpatialGrid::SpatialGrid() : minX(0), minY(0), maxX(-1), maxY(-1) {
+}
+
+
 ObjectContainer::ObjectContainer() : _currentID(0) {
 }
 
@@ -58,6 +84,10 @@ void ObjectContainer::addObject(Object &obj) {
 
 	obj._objectContainer    = this;
 	obj._objectContainerTag = _objects.insert(std::make_pair(obj.getTag(), &obj));
+
+	_objectIDs.insert(std::make_pair(obj._id, &obj));
+
+	addSpatial(obj);
 }
 
 void ObjectContainer::removeObject(Object &obj) {
@@ -66,6 +96,10 @@ void ObjectContainer::removeObject(Object &obj) {
 	if (!obj._objectContainer)
 		return;
 
+	removeSpatial(obj, obj._spatialArea);
+
+	_objectIDs.erase(obj._id);
+
 	obj._id = kObjectIDInvalid;
 
 	obj._objectContainer = 0;
@@ -120,6 +154,229 @@ Object *ObjectContainer::findObject(const Common::UString &tag) const {
 	return findNextObject(ctx);
 }
 
+Object *ObjectContainer::getObjectByID(uint32 id) const {
+	Common::StackLock lock(_mutex);
+
+	ObjectIDMap::const_iterator object = _objectIDs.find(id);
+	if (object == _objectIDs.end())
+		return 0;
+
+	return object->second;
+}
+
+void ObjectContainer::findNearestObjects(std::vector<Object *> &objects, const Object &area,
+		float x, float y, float z, size_t count, const ObjectFilter *filter) const {
+
+	objects.clear();
+	if (count == 0)
+		return;
+
+	Common::StackLock lock(_mutex);
+
+	const SpatialGrid *grid = getSpatialGrid(area);
+	if (!grid)
+		return;
+
+	const int32 cX = getSpatialCoord(x);
+	const int32 cY = getSpatialCoord(y);
+
+	// The last ring around the center cell that still touches occupied cells
+	const int32 maxRing = MAX(MAX(cX - grid->minX, grid->maxX - cX), MAX(cY - grid->minY, grid->maxY - cY));
+
+	std::vector<SpatialMatch> matches;
+
+	// Walk the grid in rings of cells around the search position
+	for (int32 ring = 0; ring <= maxRing; ring++) {
+		const int32 x1 = MAX(cX - ring, grid->minX), x2 = MIN(cX + ring, grid->maxX);
+		const int32 y1 = MAX(cY - ring, grid->minY), y2 = MIN(cY + ring, grid->maxY);
+
+		for (int32 i = x1; i <= x2; i++) {
+			if ((cY - ring) >= grid->minY)
+				collectCell(matches, *grid, i, cY - ring, x, y, z, -1.0f, filter);
+			if ((ring > 0) && ((cY + ring) <= grid->maxY))
+				collectCell(matches, *grid, i, cY + ring, x, y, z, -1.0f, filter);
+		}
+
+		for (int32 j = MAX(y1, cY - ring + 1); j <= MIN(y2, cY + ring - 1); j++) {
+			if ((cX - ring) >= grid->minX)
+				collectCell(matches, *grid, cX - ring, j, x, y, z, -1.0f, filter);
+			if ((ring > 0) && ((cX + ring) <= grid->maxX))
+				collectCell(matches, *grid, cX + ring, j, x, y, z, -1.0f, filter);
+		}
+
+		if (matches.size() < count)
+			continue;
+
+		// All cells in the next ring are at least this far away
+		const float border = ring * kSpatialCellSize;
+
+		std::nth_element(matches.begin(), matches.begin() + (count - 1), matches.end());
+		if (matches[count - 1].distance <= (border * border))
+			break;
+	}
+
+	copyMatches(objects, matches, count);
+}
+
+Object *ObjectContainer::findNearestObject(const Object &area, float x, float y, float z,
+		size_t nth, const ObjectFilter *filter) const {
+
+	std::vector<Object *> objects;
+	findNearestObjects(objects, area, x, y, z, nth + 1, filter);
+
+	if (objects.size() <= nth)
+		return 0;
+
+	return objects[nth];
+}
+
+void ObjectContainer::findObjectsInRadius(std::vector<Object *> &objects, const Object &area,
+		float x, float y, float z, float radius, const ObjectFilter *filter) const {
+
+	objects.clear();
+	if (radius < 0.0f)
+		return;
+
+	Common::StackLock lock(_mutex);
+
+	const SpatialGrid *grid = getSpatialGrid(area);
+	if (!grid)
+		return;
+
+	const int32 x1 = MAX(getSpatialCoord(x - radius), grid->minX);
+	const int32 x2 = MIN(getSpatialCoord(x + radius), grid->maxX);
+	const int32 y1 = MAX(getSpatialCoord(y - radius), grid->minY);
+	const int32 y2 = MIN(getSpatialCoord(y + radius), grid->maxY);
+
+	std::vector<SpatialMatch> matches;
+	for (int32 j = y1; j <= y2; j++)
+		for (int32 i = x1; i <= x2; i++)
+			collectCell(matches, *grid, i, j, x, y, z, radius * radius, filter);
+
+	copyMatches(objects, matches, matches.size());
+}
+
+void ObjectContainer::moveObject(Object &obj, const Object *oldArea) {
+	Common::StackLock lock(_mutex);
+
+	if (obj._objectContainer != this)
+		return;
+
+	if (obj._spatialArea && (obj._spatialArea == oldArea)) {
+		const uint64 cell = getSpatialCell(getSpatialCoord(obj._spatialPosition[0]),
+		                                   getSpatialCoord(obj._spatialPosition[1]));
+
+		// Still in the same cell, nothing to do
+		if (cell == obj._spatialCell)
+			return;
+	}
+
+	removeSpatial(obj, oldArea);
+	addSpatial(obj);
+}
+
+void ObjectContainer::addSpatial(Object &obj) {
+	if (!obj._spatialArea)
+		return;
+
+	const int32 cellX = getSpatialCoord(obj._spatialPosition[0]);
+	const int32 cellY = getSpatialCoord(obj._spatialPosition[1]);
+
+	SpatialGrid &grid = _spatialGrids[obj._spatialArea];
+
+	if (grid.minX > grid.maxX) {
+		grid.minX = grid.maxX = cellX;
+		grid.minY = grid.maxY = cellY;
+	} else {
+		grid.minX = MIN(grid.minX, cellX);
+		grid.maxX = MAX(grid.maxX, cellX);
+		grid.minY = MIN(grid.minY, cellY);
+		grid.maxY = MAX(grid.maxY, cellY);
+	}
+
+	obj._spatialCell = getSpatialCell(cellX, cellY);
+
+	grid.cells[obj._spatialCell].push_back(&obj);
+}
+
+void ObjectContainer::removeSpatial(Object &obj, const Object *area) {
+	if (!area)
+		return;
+
+	SpatialGridMap::iterator grid = _spatialGrids.find(area);
+	if (grid == _spatialGrids.end())
+		return;
+
+	SpatialCellMap::iterator cell = grid->second.cells.find(obj._spatialCell);
+	if (cell == grid->second.cells.end())
+		return;
+
+	SpatialCell::iterator object = std::find(cell->second.begin(), cell->second.end(), &obj);
+	if (object == cell->second.end())
+		return;
+
+	*object = cell->second.back();
+	cell->second.pop_back();
+
+	if (!cell->second.empty())
+		return;
+
+	grid->second.cells.erase(cell);
+	if (grid->second.cells.empty())
+		_spatialGrids.erase(grid);
+}
+
+const ObjectContainer::SpatialGrid *ObjectContainer::getSpatialGrid(const Object &area) const {
+	SpatialGridMap::const_iterator grid = _spatialGrids.find(&area);
+	if (grid == _spatialGrids.end())
+		return 0;
+
+	return &grid->second;
+}
+
+int32 ObjectContainer::getSpatialCoord(float v) {
+	return (int32) floorf(v / kSpatialCellSize);
+}
+
+uint64 ObjectContainer::getSpatialCell(int32 x, int32 y) {
+	return (((uint64) ((uint32) x)) << 32) | ((uint64) ((uint32) y));
+}
+
+void ObjectContainer::collectCell(std::vector<SpatialMatch> &matches, const SpatialGrid &grid,
+		int32 cellX, int32 cellY, float x, float y, float z, float maxDistance, const ObjectFilter *filter) {
+
+	SpatialCellMap::const_iterator cell = grid.cells.find(getSpatialCell(cellX, cellY));
+	if (cell == grid.cells.end())
+		return;
+
+	for (SpatialCell::const_iterator o = cell->second.begin(); o != cell->second.end(); ++o) {
+		if (filter && !(*filter)(**o))
+			continue;
+
+		const float dX = (*o)->_spatialPosition[0] - x;
+		const float dY = (*o)->_spatialPosition[1] - y;
+		const float dZ = (*o)->_spatialPosition[2] - z;
+
+		const float distance = dX * dX + dY * dY + dZ * dZ;
+		if ((maxDistance >= 0.0f) && (distance > maxDistance))
+			continue;
+
+		matches.push_back(SpatialMatch(distance, *o));
+	}
+}
+
+void ObjectContainer::copyMatches(std::vector<Object *> &objects, std::vector<SpatialMatch> &matches,
+		size_t count) {
+
+	count = MIN(count, matches.size());
+
+	std::partial_sort(matches.begin(), matches.begin() + count, matches.end());
+
+	objects.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		objects.push_back(matches[i].object);
+}
+
 } // End of namespace NWScript
 
 } // End of namespace Aurora
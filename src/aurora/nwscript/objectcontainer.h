@@ -25,6 +25,11 @@
 #ifndef AURORA_NWSCRIPT_OBJECTCONTAINER_H
 #define AURORA_NWSCRIPT_OBJECTCONTAINER_H
 
+#include <vector>
+#include <map>
+
+#include <boost/unordered/unordered_map.hpp>
+
 #include "src/common/mutex.h"
 
 #include "src/aurora/nwscript/object.h"
@@ -33,6 +38,14 @@ namespace Aurora {
 
 namespace NWScript {
 
+/** Decides which objects a spatial search should consider. */
+class ObjectFilter {
+public:
+	virtual ~ObjectFilter();
+
+	virtual bool operator()(const Object &object) const = 0;
+};
+
 class ObjectContainer {
 public:
 	class SearchContext {
@@ -72,12 +85,74 @@ public:
 	/** Find the first best object with this tag, disregarding any other matches. */
 	Object *findObject(const Common::UString &tag) const;
 
+	/** Find the object with this ID. */
+	Object *getObjectByID(uint32 id) const;
+
+	/** Find the count objects within this area nearest to this position, sorted by distance. */
+	void findNearestObjects(std::vector<Object *> &objects, const Object &area,
+	                        float x, float y, float z, size_t count, const ObjectFilter *filter = 0) const;
+	/** Find the nth (0-based) nearest object within this area to this position. */
+	Object *findNearestObject(const Object &area, float x, float y, float z,
+	                          size_t nth = 0, const ObjectFilter *filter = 0) const;
+
+	/** Find all objects within this area in a radius around this position, sorted by distance. */
+	void findObjectsInRadius(std::vector<Object *> &objects, const Object &area,
+	                         float x, float y, float z, float radius, const ObjectFilter *filter = 0) const;
+
 private:
-	Common::Mutex _mutex;
+	/** A candidate in a spatial search. */
+	struct SpatialMatch {
+		float distance; ///< Squared distance to the search position.
+		Object *object;
+
+		SpatialMatch(float d, Object *o);
+
+		bool operator<(const SpatialMatch &match) const;
+	};
+
+	typedef std::vector<Object *> SpatialCell;
+	typedef boost::unordered_map<uint64, SpatialCell> SpatialCellMap;
+
+	/** All placed objects within one area, sorted into a uniform grid over the x/y plane. */
+	struct SpatialGrid {
+		SpatialCellMap cells;
+
+		/** The range of cells ever occupied. */
+		int32 minX, minY, maxX, maxY;
+
+		SpatialGrid();
+	};
+
+	typedef std::map<const Object *, SpatialGrid> SpatialGridMap;
+
+	mutable Common::Mutex _mutex;
 
 	uint32 _currentID;
 
 	ObjectTagMap _objects;
+	ObjectIDMap  _objectIDs;
+
+	SpatialGridMap _spatialGrids;
+
+	/** The object's area or position changed. */
+	void moveObject(Object &obj, const Object *oldArea);
+
+	void addSpatial(Object &obj);
+	void removeSpatial(Object &obj, const Object *area);
+
+	const SpatialGrid *getSpatialGrid(const Object &area) const;
+
+	static int32  getSpatialCoord(float v);
+	static uint64 getSpatialCell(int32 x, int32 y);
+
+	static void collectCell(std::vector<SpatialMatch> &matches, const SpatialGrid &grid,
+	                        int32 cellX, int32 cellY, float x, float y, float z,
+	                        float maxDistance, const ObjectFilter *filter);
+
+	static void copyMatches(std::vector<Object *> &objects, std::vector<SpatialMatch> &matches,
+	                        size_t count);
+
+	friend class Object;
 };
 
 } // End of namespace NWScript
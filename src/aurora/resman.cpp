@@ -22,12 +22,16 @@
  *  The global resource manager for Aurora resources.
  */
 
+#include <algorithm>
+
 #include <boost/algorithm/string.hpp>
 
 #include "src/common/util.h"
 #include "src/common/stream.h"
 #include "src/common/filepath.h"
 #include "src/common/file.h"
+#include "src/common/encoding.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/resman.h"
 #include "src/aurora/util.h"
@@ -54,17 +58,43 @@ static const char *kArchiveGlob[Aurora::kArchiveMAX] = {
 	".*\\.key", ".*\\.bif", ".*\\.(erf|mod|hak|nwm)", ".*\\.rim", ".*\\.zip", ".*\\.exe"
 };
 
-namespace Aurora {
+static const uint32 kIndexCacheID      = MKTAG('X', 'R', 'I', 'C');
+static const uint32 kIndexCacheVersion = 1;
 
-ResourceManager::Resource::Resource() : type(kFileTypeNone), priority(0),
-		source(kSourceNone), archive(0), archiveIndex(0xFFFFFFFF) {
+static void writeCacheString(Common::WriteStream &stream, const Common::UString &str) {
+	const uint32 length = std::strlen(str.c_str());
+
+	stream.writeUint32LE(length);
+	stream.write(str.c_str(), length);
 }
 
+static Common::UString readCacheString(Common::SeekableReadStream &stream) {
+	const uint32 length = stream.readUint32LE();
+	if (length == 0)
+		return "";
+
+	if (length > 0xFFFF)
+		throw Common::Exception("Invalid string length %u", length);
 
-bool ResourceManager::Resource::operator<(const Resource &right) const {
-	return priority < right.priority;
+	return Common::readStringFixed(stream, Common::kEncodingUTF8, length);
 }
 
+namespace Aurora {
+
+const uint32 ResourceManager::kInvalidIndex;
+const uint32 ResourceManager::kDefaultResourceCacheSize;
+
+/** A read-only stream over a buffer shared with the decompressed resource cache. */
+class CachedResourceStream : public Common::MemoryReadStream {
+public:
+	CachedResourceStream(const boost::shared_array<byte> &data, uint32 size) :
+		Common::MemoryReadStream(data.get(), size), _data(data) {
+	}
+
+private:
+	boost::shared_array<byte> _data; ///< Keeps the data alive, even if it's evicted.
+};
+
 
 ResourceManager::ChangeID::ChangeID() : _empty(true) {
 }
@@ -81,7 +111,105 @@ ResourceManager::ChangeID::ChangeID(ChangeSetList::iterator c) : _empty(false),
 }
 
 
-ResourceManager::ResourceManager() : _rimsAreERFs(false), _hashAlgo(Common::kHashFNV64) {
+/** Reads a resource in a worker thread. */
+struct ResourceManager::PrefetchJob : public Common::ThreadPool::Job {
+	const ResourceManager *resMan;
+
+	Common::UString name;
+	FileType        type;
+
+	Resource        resource; ///< The resource to read.
+	Common::UString path;     ///< The path, if the resource is a direct file.
+
+	uint32 generation; ///< The prefetch generation this job belongs to.
+
+	bool done;  ///< Are we finished reading?
+	bool taken; ///< Was the stream already handed out?
+
+	Common::SeekableReadStream *stream;
+
+	PrefetchJob(const ResourceManager &r, const Common::UString &n, FileType t) :
+		resMan(&r), name(n), type(t), generation(r._prefetchGeneration), done(false), taken(false), stream(0) {
+	}
+
+	~PrefetchJob() {
+		delete stream;
+	}
+
+	void run() {
+		resMan->runPrefetch(*this);
+	}
+};
+
+ResourceManager::Prefetch::Prefetch() {
+}
+
+ResourceManager::Prefetch::Prefetch(const boost::shared_ptr<PrefetchJob> &job) : _job(job) {
+}
+
+bool ResourceManager::Prefetch::empty() const {
+	return !_job;
+}
+
+bool ResourceManager::Prefetch::isDone() const {
+	if (!_job)
+		return true;
+
+	Common::StackLock lock(_job->resMan->_prefetchMutex);
+
+	return _job->done;
+}
+
+Common::SeekableReadStream *ResourceManager::Prefetch::take() {
+	if (!_job)
+		return 0;
+
+	boost::shared_ptr<PrefetchJob> job;
+	job.swap(_job);
+
+	const ResourceManager &resMan = *job->resMan;
+
+	resMan._prefetchMutex.lock();
+	Common::SeekableReadStream *stream = resMan.takePrefetch(*job);
+	resMan._prefetchMutex.unlock();
+
+	if (stream)
+		return stream;
+
+	// Not prefetched, so read it the normal way. This also reports any errors
+	return resMan.getResource(job->name, job->type);
+}
+
+bool ResourceManager::Prefetch::takePrefetched(Common::SeekableReadStream *&stream) {
+	stream = 0;
+
+	if (!_job)
+		return true;
+
+	const ResourceManager &resMan = *_job->resMan;
+
+	Common::StackLock lock(resMan._prefetchMutex);
+
+	while (!_job->done)
+		resMan._prefetchDone.wait(100);
+
+	// Cancelled, or already picked up by getResource(): keep the handle for take()
+	if (_job->taken || (_job->generation != resMan._prefetchGeneration))
+		return false;
+
+	stream = resMan.takePrefetch(*_job);
+	_job.reset();
+
+	return true;
+}
+
+
+ResourceManager::ResourceManager() : _rimsAreERFs(false), _mapArchives(false),
+	_hashAlgo(Common::kHashFNV64), _indexCacheChanged(false), _hashCount(0), _revision(0),
+	_prefetchPool(0), _prefetchGeneration(0), _prefetchDone(_prefetchMutex),
+	_resourceCacheBudget(kDefaultResourceCacheSize), _resourceCacheSize(0),
+	_resourceCacheHits(0), _resourceCacheMisses(0), _resourceCacheEvictions(0) {
+
 	_resourceTypeTypes[kResourceImage].push_back(kFileTypeDDS);
 	_resourceTypeTypes[kResourceImage].push_back(kFileTypeTPC);
 	_resourceTypeTypes[kResourceImage].push_back(kFileTypeTXB);
@@ -121,6 +249,8 @@ ResourceManager::~ResourceManager() {
 }
 
 void ResourceManager::clear() {
+	saveIndexCache();
+
 	_rimsAreERFs = false;
 	_hashAlgo    = Common::kHashFNV64;
 
@@ -128,6 +258,9 @@ void ResourceManager::clear() {
 }
 
 void ResourceManager::clearResources() {
+	cancelPrefetches();
+	clearResourceCache();
+
 	_cursorRemap.clear();
 
 	_baseDir.clear();
@@ -138,22 +271,35 @@ void ResourceManager::clearResources() {
 	}
 
 	for (ArchiveList::iterator archive = _archives.begin(); archive != _archives.end(); ++archive)
-		delete *archive;
+		delete archive->archive;
 	_archives.clear();
 
 	_resources.clear();
+	_freeResources.clear();
+
+	_hashTable.clear();
+	_hashCount = 0;
+
+	_strings.clear();
+	_stringMap.clear();
 
 	_typeAliases.clear();
 
 	_changes.clear();
+
+	_revision++;
 }
 
 void ResourceManager::setRIMsAreERFs(bool rimsAreERFs) {
 	_rimsAreERFs = rimsAreERFs;
 }
 
+void ResourceManager::setMapArchives(bool mapArchives) {
+	_mapArchives = mapArchives;
+}
+
 void ResourceManager::setHashAlgo(Common::HashAlgo algo) {
-	if ((algo != _hashAlgo) && !_resources.empty())
+	if ((algo != _hashAlgo) && (_hashCount > 0))
 		throw Common::Exception("ResourceManager::setHashAlgo(): We already have resources!");
 
 	_hashAlgo = algo;
@@ -163,6 +309,175 @@ void ResourceManager::setCursorRemap(const std::vector<Common::UString> &remap)
 	_cursorRemap = remap;
 }
 
+void ResourceManager::setIndexCache(const Common::UString &file) {
+	saveIndexCache();
+
+	_indexCache.clear();
+	_indexCacheChanged = false;
+
+	_indexCacheFile = file;
+
+	loadIndexCache();
+}
+
+void ResourceManager::loadIndexCache() {
+	if (_indexCacheFile.empty() || !Common::FilePath::isRegularFile(_indexCacheFile))
+		return;
+
+	Common::File cache;
+	if (!cache.open(_indexCacheFile)) {
+		warning("Failed to open resource index cache \"%s\"", _indexCacheFile.c_str());
+		return;
+	}
+
+	try {
+		if (cache.readUint32BE() != kIndexCacheID)
+			throw Common::Exception("Not a resource index cache");
+
+		// Silently ignore old caches, they are simply rebuilt
+		if (cache.readUint32LE() != kIndexCacheVersion)
+			return;
+
+		uint32 archiveCount = cache.readUint32LE();
+		while (archiveCount-- > 0) {
+			const Common::UString id = readCacheString(cache);
+
+			CachedArchive &archive = _indexCache[id];
+
+			archive.type     = (ArchiveType) cache.readUint32LE();
+			archive.path     = readCacheString(cache);
+			archive.size     = cache.readUint32LE();
+			archive.time     = cache.readUint64LE();
+			archive.hashAlgo = (Common::HashAlgo) cache.readSint32LE();
+
+			archive.bifs.resize(cache.readUint32LE());
+			for (std::vector<Common::UString>::iterator b = archive.bifs.begin(); b != archive.bifs.end(); ++b)
+				*b = readCacheString(cache);
+
+			uint32 resCount = cache.readUint32LE();
+			while (resCount-- > 0) {
+				archive.resources.push_back(Archive::Resource());
+
+				Archive::Resource &res = archive.resources.back();
+
+				res.name  = readCacheString(cache);
+				res.hash  = cache.readUint64LE();
+				res.type  = (FileType) cache.readSint32LE();
+				res.index = cache.readUint32LE();
+			}
+
+			if (cache.err() || cache.eos())
+				throw Common::Exception(Common::kReadError);
+		}
+
+	} catch (Common::Exception &e) {
+		_indexCache.clear();
+
+		e.add("Failed reading resource index cache \"%s\"", _indexCacheFile.c_str());
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+void ResourceManager::saveIndexCache() {
+	if (_indexCacheFile.empty() || !_indexCacheChanged)
+		return;
+
+	_indexCacheChanged = false;
+
+	// Drop archives that don't exist anymore
+	for (IndexCache::iterator c = _indexCache.begin(); c != _indexCache.end(); ) {
+		if (!Common::FilePath::isRegularFile(c->second.path))
+			_indexCache.erase(c++);
+		else
+			++c;
+	}
+
+	try {
+		// Create the directories in the path, if necessary
+		Common::UString file = Common::FilePath::canonicalize(_indexCacheFile);
+		Common::FilePath::createDirectories(Common::FilePath::getDirectory(file));
+
+		Common::DumpFile cache;
+		if (!cache.open(file))
+			throw Common::Exception(Common::kOpenError);
+
+		cache.writeUint32BE(kIndexCacheID);
+		cache.writeUint32LE(kIndexCacheVersion);
+
+		cache.writeUint32LE(_indexCache.size());
+		for (IndexCache::const_iterator c = _indexCache.begin(); c != _indexCache.end(); ++c) {
+			const CachedArchive &archive = c->second;
+
+			writeCacheString(cache, c->first);
+
+			cache.writeUint32LE(archive.type);
+			writeCacheString(cache, archive.path);
+			cache.writeUint32LE(archive.size);
+			cache.writeUint64LE(archive.time);
+			cache.writeSint32LE(archive.hashAlgo);
+
+			cache.writeUint32LE(archive.bifs.size());
+			for (std::vector<Common::UString>::const_iterator b = archive.bifs.begin(); b != archive.bifs.end(); ++b)
+				writeCacheString(cache, *b);
+
+			cache.writeUint32LE(archive.resources.size());
+			for (Archive::ResourceList::const_iterator r = archive.resources.begin(); r != archive.resources.end(); ++r) {
+				writeCacheString(cache, r->name);
+				cache.writeUint64LE(r->hash);
+				cache.writeSint32LE(r->type);
+				cache.writeUint32LE(r->index);
+			}
+		}
+
+		if (!cache.flush() || cache.err())
+			throw Common::Exception(Common::kWriteError);
+
+		cache.close();
+
+	} catch (Common::Exception &e) {
+		e.add("Failed writing resource index cache \"%s\"", _indexCacheFile.c_str());
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+const ResourceManager::CachedArchive *ResourceManager::getCachedArchive(ArchiveType type,
+		const Common::UString &id) const {
+
+	if (_indexCacheFile.empty())
+		return 0;
+
+	IndexCache::const_iterator c = _indexCache.find(id);
+	if ((c == _indexCache.end()) || (c->second.type != type))
+		return 0;
+
+	// Has the archive changed since we cached it?
+	if ((c->second.size != Common::FilePath::getFileSize(c->second.path)) ||
+	    (c->second.time != Common::FilePath::getModificationTime(c->second.path)))
+		return 0;
+
+	return &c->second;
+}
+
+void ResourceManager::cacheArchive(ArchiveType type, const Common::UString &id,
+		const Common::UString &path, const Archive &archive) {
+
+	if (_indexCacheFile.empty())
+		return;
+
+	CachedArchive &cached = _indexCache[id];
+
+	cached.type     = type;
+	cached.path     = path;
+	cached.size     = Common::FilePath::getFileSize(path);
+	cached.time     = Common::FilePath::getModificationTime(path);
+	cached.hashAlgo = archive.getNameHashAlgo();
+
+	cached.bifs.clear();
+	cached.resources = archive.getResources();
+
+	_indexCacheChanged = true;
+}
+
 void ResourceManager::registerDataBaseDir(const Common::UString &path) {
 	clearResources();
 
@@ -210,7 +525,7 @@ void ResourceManager::addArchiveDir(ArchiveType archive, const Common::UString &
 }
 
 Common::UString ResourceManager::findArchive(const Common::UString &file,
-		const DirectoryList &dirs, const Common::FileList &files) {
+		const DirectoryList &dirs, const Common::FileList &files) const {
 
 	Common::FileList nameMatch;
 	if (!files.getSubList(Common::FilePath::normalize("/" + file, false), true, nameMatch))
@@ -273,42 +588,150 @@ ResourceManager::ChangeID ResourceManager::addArchive(ArchiveType archive,
 	if (archive == kArchiveKEY)
 		return indexKEY(realName, priority);
 
-	if (archive == kArchiveERF) {
-		ERFFile *erf = new ERFFile(realName);
+	if ((archive == kArchiveERF) || (archive == kArchiveRIM) || (archive == kArchiveZIP))
+		return indexArchiveFile(archive, realName, priority);
+
+	if (archive == kArchiveEXE) {
+		PEFile *pe = new PEFile(realName, _cursorRemap);
 
 		ChangeID change = newChangeSet();
 
-		return indexArchive(erf, priority, change);
+		return indexArchive(pe, priority, change);
 	}
 
-	if (archive == kArchiveRIM) {
-		RIMFile *rim = new RIMFile(realName);
+	return ChangeID();
+}
 
-		ChangeID change = newChangeSet();
+/** Reads one archive of a batch in a worker thread. */
+struct ResourceManager::BatchJob : public Common::ThreadPool::Job {
+	const ResourceManager *resMan;
 
-		return indexArchive(rim, priority, change);
+	ArchiveType     type;
+	Common::UString file;
+
+	Archive *archive; ///< The opened ERF, RIM or ZIP.
+
+	std::vector<Common::UString> bifs;     ///< The paths of the KEY's BIFs.
+	std::vector<BIFFile *>       bifFiles; ///< The KEY's BIFs.
+
+	bool failed;
+	Common::Exception error;
+
+	BatchJob(const ResourceManager &r, ArchiveType t, const Common::UString &f) :
+		resMan(&r), type(t), file(f), archive(0), failed(false) {
 	}
 
-	if (archive == kArchiveZIP) {
-		ZIPFile *zip = new ZIPFile(realName);
+	~BatchJob() {
+		delete archive;
 
-		ChangeID change = newChangeSet();
+		for (std::vector<BIFFile *>::iterator b = bifFiles.begin(); b != bifFiles.end(); ++b)
+			delete *b;
+	}
 
-		return indexArchive(zip, priority, change);
+	void run() {
+		try {
+			if (type == kArchiveKEY)
+				resMan->loadKEY(file, bifs, bifFiles);
+			else
+				archive = resMan->openArchive(type, file);
+
+		} catch (Common::Exception &e) {
+			failed = true;
+			error  = e;
+		} catch (std::exception &e) {
+			failed = true;
+			error  = Common::Exception(e);
+		}
 	}
+};
 
-	if (archive == kArchiveEXE) {
-		PEFile *pe = new PEFile(realName, _cursorRemap);
+ResourceManager::BatchArchive::BatchArchive(ArchiveType t, const Common::UString &f, uint32 p, bool o) :
+	type(t), file(f), priority(p), optional(o) {
+}
 
-		ChangeID change = newChangeSet();
+void ResourceManager::addArchives(ArchiveBatch &archives) {
+	std::vector<BatchJob *> jobs;
+	jobs.resize(archives.size(), 0);
 
-		return indexArchive(pe, priority, change);
+	try {
+		// Find the archives that need to be read and aren't in the index cache
+		uint32 jobCount = 0;
+		for (uint32 i = 0; i < archives.size(); i++) {
+			const ArchiveType type = archives[i].type;
+			if ((type != kArchiveKEY) && (type != kArchiveERF) && (type != kArchiveRIM) && (type != kArchiveZIP))
+				continue;
+
+			const Common::UString realName = findArchive(archives[i].file, _archiveDirs[type], _archiveFiles[type]);
+			if (realName.empty())
+				continue;
+
+			std::vector<const CachedArchive *> cachedBIFs;
+			if ((type == kArchiveKEY) ? getCachedKEY(realName, cachedBIFs) : (getCachedArchive(type, realName) != 0))
+				continue;
+
+			jobs[i] = new BatchJob(*this, type, realName);
+			jobCount++;
+		}
+
+		// Read them, in parallel if it's worth it
+		if (jobCount > 1) {
+			Common::ThreadPool pool(MIN(jobCount, Common::ThreadPool::getCPUCount()));
+
+			for (std::vector<BatchJob *>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+				if (*j)
+					pool.addJob(**j);
+
+			pool.wait();
+		} else
+			for (std::vector<BatchJob *>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+				if (*j)
+					(*j)->run();
+
+		// Index them, in order
+		for (uint32 i = 0; i < archives.size(); i++) {
+			BatchArchive &archive = archives[i];
+
+			try {
+				archive.change = indexBatchArchive(archive, jobs[i]);
+			} catch (Common::Exception &e) {
+				if (!archive.optional)
+					throw;
+			}
+
+			delete jobs[i];
+			jobs[i] = 0;
+		}
+
+	} catch (...) {
+		for (std::vector<BatchJob *>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+			delete *j;
+
+		throw;
 	}
+}
 
-	return ChangeID();
+ResourceManager::ChangeID ResourceManager::indexBatchArchive(const BatchArchive &archive, BatchJob *job) {
+	// Not read in advance, either because it's cached or we don't handle it
+	if (!job)
+		return addArchive(archive.type, archive.file, archive.priority);
+
+	if (job->failed)
+		throw job->error;
+
+	if (job->type == kArchiveKEY) {
+		std::vector<BIFFile *> bifFiles;
+		bifFiles.swap(job->bifFiles);
+
+		return indexBIFs(job->file, job->bifs, bifFiles, archive.priority);
+	}
+
+	Archive *preparedArchive = job->archive;
+	job->archive = 0;
+
+	return indexArchiveFile(job->type, job->file, archive.priority, preparedArchive);
 }
 
-void ResourceManager::findBIFs(const KEYFile &key, std::vector<Common::UString> &bifs) {
+void ResourceManager::findBIFs(const KEYFile &key, std::vector<Common::UString> &bifs) const {
 	const KEYFile::BIFList &keyBIFs = key.getBIFs();
 
 	bifs.resize(keyBIFs.size());
@@ -325,7 +748,7 @@ void ResourceManager::findBIFs(const KEYFile &key, std::vector<Common::UString>
 }
 
 void ResourceManager::mergeKEYBIF(const KEYFile &key, std::vector<Common::UString> &bifs,
-		std::vector<BIFFile *> &bifFiles) {
+		std::vector<BIFFile *> &bifFiles) const {
 
 	bifFiles.reserve(bifs.size());
 
@@ -336,77 +759,249 @@ void ResourceManager::mergeKEYBIF(const KEYFile &key, std::vector<Common::UStrin
 
 		uint32 index = 0;
 		for (std::vector<Common::UString>::const_iterator bif = bifs.begin(); bif != bifs.end(); ++index, ++bif) {
-			curBIF = new BIFFile(*bif);
+			curBIF = new BIFFile(*bif, _mapArchives);
 
 			curBIF->mergeKEY(key, index);
 
 			bifFiles.push_back(curBIF);
+			curBIF = 0;
 		}
 
 	} catch (Common::Exception &e) {
 		delete curBIF;
 
+		for (std::vector<BIFFile *>::iterator bifFile = bifFiles.begin(); bifFile != bifFiles.end(); ++bifFile)
+			delete *bifFile;
+		bifFiles.clear();
+
 		e.add("Failed opening needed BIFs");
 		throw;
 	}
 
 }
 
-ResourceManager::ChangeID ResourceManager::indexKEY(const Common::UString &file, uint32 priority) {
+void ResourceManager::loadKEY(const Common::UString &file, std::vector<Common::UString> &bifs,
+		std::vector<BIFFile *> &bifFiles) const {
+
 	KEYFile key(file);
 
 	// Search the correct BIFs
-	std::vector<Common::UString> bifs;
 	findBIFs(key, bifs);
 
-	std::vector<BIFFile *> bifFiles;
 	mergeKEYBIF(key, bifs, bifFiles);
+}
+
+bool ResourceManager::getCachedKEY(const Common::UString &file, std::vector<const CachedArchive *> &bifs) const {
+	// Are the KEY and all its BIFs still the same as the last time we indexed them?
+	const CachedArchive *cachedKEY = getCachedArchive(kArchiveKEY, file);
+	if (!cachedKEY)
+		return false;
+
+	bifs.reserve(cachedKEY->bifs.size());
+
+	for (std::vector<Common::UString>::const_iterator b = cachedKEY->bifs.begin(); b != cachedKEY->bifs.end(); ++b) {
+		const CachedArchive *cachedBIF = getCachedArchive(kArchiveBIF, *b);
+		if (!cachedBIF)
+			return false;
+
+		bifs.push_back(cachedBIF);
+	}
+
+	return true;
+}
+
+ResourceManager::ChangeID ResourceManager::indexKEY(const Common::UString &file, uint32 priority) {
+	std::vector<const CachedArchive *> cachedBIFs;
+	if (getCachedKEY(file, cachedBIFs)) {
+		ChangeID change = newChangeSet();
+
+		for (std::vector<const CachedArchive *>::const_iterator b = cachedBIFs.begin(); b != cachedBIFs.end(); ++b) {
+			const uint32 archiveID = addArchiveSlot(0, kArchiveBIF, (*b)->path, change);
+
+			indexResources((*b)->resources, (*b)->hashAlgo, archiveID, priority, change);
+		}
+
+		return change;
+	}
+
+	std::vector<Common::UString> bifs;
+	std::vector<BIFFile *> bifFiles;
+	loadKEY(file, bifs, bifFiles);
+
+	return indexBIFs(file, bifs, bifFiles, priority);
+}
+
+ResourceManager::ChangeID ResourceManager::indexBIFs(const Common::UString &key,
+		const std::vector<Common::UString> &bifs, std::vector<BIFFile *> &bifFiles, uint32 priority) {
 
 	ChangeID change = newChangeSet();
 
-	for (std::vector<BIFFile *>::iterator bifFile = bifFiles.begin(); bifFile != bifFiles.end(); ++bifFile)
-		indexArchive(*bifFile, priority, change);
+	// Hand the BIFs over to the archive slots first, so that they're cleaned up on errors
+	std::vector<uint32> archiveIDs;
+	archiveIDs.reserve(bifFiles.size());
+
+	for (uint32 i = 0; i < bifFiles.size(); i++)
+		archiveIDs.push_back(addArchiveSlot(bifFiles[i], kArchiveBIF, bifs[i], change));
+
+	std::vector<BIFFile *> indexBIFFiles;
+	indexBIFFiles.swap(bifFiles);
+
+	std::vector<Common::UString> bifIDs;
+	bifIDs.reserve(indexBIFFiles.size());
+
+	for (uint32 i = 0; i < indexBIFFiles.size(); i++) {
+		// The resource list of a BIF depends on the KEY referencing it
+		bifIDs.push_back(key + "|" + bifs[i]);
+
+		cacheArchive(kArchiveBIF, bifIDs.back(), bifs[i], *indexBIFFiles[i]);
+
+		indexResources(indexBIFFiles[i]->getResources(), indexBIFFiles[i]->getNameHashAlgo(),
+		               archiveIDs[i], priority, change);
+
+		indexBIFFiles[i]->clear();
+	}
+
+	if (!_indexCacheFile.empty()) {
+		CachedArchive &cachedKey = _indexCache[key];
+
+		cachedKey.type     = kArchiveKEY;
+		cachedKey.path     = key;
+		cachedKey.size     = Common::FilePath::getFileSize(key);
+		cachedKey.time     = Common::FilePath::getModificationTime(key);
+		cachedKey.hashAlgo = Common::kHashNone;
+		cachedKey.bifs     = bifIDs;
+
+		cachedKey.resources.clear();
+
+		_indexCacheChanged = true;
+	}
 
 	return change;
 }
 
 ResourceManager::ChangeID ResourceManager::indexArchive(Archive *archive, uint32 priority, ChangeID &change) {
-	const Common::HashAlgo hashAlgo = archive->getNameHashAlgo();
+	const uint32 archiveID = addArchiveSlot(archive, kArchiveMAX, "", change);
+
+	indexResources(archive->getResources(), archive->getNameHashAlgo(), archiveID, priority, change);
+
+	archive->clear();
+
+	return change;
+}
+
+ResourceManager::ChangeID ResourceManager::indexArchiveFile(ArchiveType type, const Common::UString &file,
+		uint32 priority, Archive *archive) {
+
+	const CachedArchive *cached = archive ? 0 : getCachedArchive(type, file);
+	if (cached) {
+		ChangeID change = newChangeSet();
+
+		// We know what's in there, so we don't need to open it until a resource is requested
+		const uint32 archiveID = addArchiveSlot(0, type, file, change);
+
+		indexResources(cached->resources, cached->hashAlgo, archiveID, priority, change);
+
+		return change;
+	}
+
+	if (!archive)
+		archive = openArchive(type, file);
+
+	ChangeID change = newChangeSet();
+
+	const uint32 archiveID = addArchiveSlot(archive, type, file, change);
+
+	cacheArchive(type, file, file, *archive);
+
+	indexResources(archive->getResources(), archive->getNameHashAlgo(), archiveID, priority, change);
+
+	archive->clear();
+
+	return change;
+}
+
+uint32 ResourceManager::addArchiveSlot(Archive *archive, ArchiveType type,
+		const Common::UString &path, ChangeID &change) {
+
+	_archiveMutex.lock();
+
+	const uint32 archiveID = _archives.size();
+
+	_archives.push_back(ArchiveSlot());
+
+	_archives.back().archive = archive;
+	_archives.back().type    = type;
+	_archives.back().path    = path;
+
+	_archiveMutex.unlock();
+
+	// Add the information of the new archive to the change set
+	change._change->archives.push_back(archiveID);
+
+	return archiveID;
+}
+
+void ResourceManager::indexResources(const Archive::ResourceList &resources, Common::HashAlgo hashAlgo,
+		uint32 archiveID, uint32 priority, ChangeID &change) {
+
 	if ((hashAlgo != Common::kHashNone) && (hashAlgo != _hashAlgo))
 		throw Common::Exception("ResourceManager::indexArchive(): Archive uses a different name hashing "
 		                        "algorithm than we do (%d vs. %d)", (int) hashAlgo, (int) _hashAlgo);
 
-	_archives.push_back(archive);
+	change._change->resources.reserve(change._change->resources.size() + resources.size());
 
-	// Add the information of the new archive to the change set
-	change._change->archives.push_back(--_archives.end());
-
-	const Archive::ResourceList &resources = archive->getResources();
 	for (Archive::ResourceList::const_iterator resource = resources.begin(); resource != resources.end(); ++resource) {
-		// Build the resource record
-		Resource res;
-		res.priority     = priority;
-		res.source       = kSourceArchive;
-		res.archive      = archive;
-		res.archiveIndex = resource->index;
-		res.name         = resource->name;
-		res.type         = resource->type;
+		FileType type = resource->type;
 
 		// Get the hash or calculate if we have to
-		uint64 hash = (hashAlgo == Common::kHashNone) ? getHash(res.name, res.type) : resource->hash;
+		uint64 hash = (hashAlgo == Common::kHashNone) ? getHash(resource->name, type) : resource->hash;
 
 		// Normalize the file types if we can and recalculate the hash
-		if ((res.name != "") && (res.type != kFileTypeNone))
-			if (normalizeType(res))
-				hash = getHash(res.name, res.type);
+		if ((resource->name != "") && (type != kFileTypeNone))
+			if (normalizeType(type))
+				hash = getHash(resource->name, type);
 
 		// And add it to our list
-		addResource(res, hash, change);
+		addResource(resource->name, type, priority, archiveID, resource->index, hash, change);
 	}
+}
 
-	archive->clear();
+Archive *ResourceManager::openArchive(ArchiveType type, const Common::UString &file) const {
+	switch (type) {
+		case kArchiveBIF:
+			return new BIFFile(file, _mapArchives);
 
-	return change;
+		case kArchiveERF:
+			return new ERFFile(file, false, _mapArchives);
+
+		case kArchiveRIM:
+			return new RIMFile(file, _mapArchives);
+
+		case kArchiveZIP:
+			return new ZIPFile(file, _mapArchives);
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Can't open archive \"%s\" of type %d", file.c_str(), (int) type);
+}
+
+Archive *ResourceManager::getArchive(uint32 archiveID) const {
+	Common::StackLock lock(_archiveMutex);
+
+	if (archiveID >= _archives.size())
+		return 0;
+
+	ArchiveSlot &slot = _archives[archiveID];
+
+	// Open archives that were indexed from the cache on first use
+	if (!slot.archive && !slot.path.empty()) {
+		slot.archive = openArchive(slot.type, slot.path);
+		slot.archive->clear();
+	}
+
+	return slot.archive;
 }
 
 ResourceManager::ChangeID ResourceManager::addResourceDir(const Common::UString &dir,
@@ -443,24 +1038,33 @@ void ResourceManager::undo(ChangeID &change) {
 		// Nothing to do
 		return;
 
-	// Go through all changes in the resource map
-	for (std::list<ResourceChange>::iterator resChange = change._change->resources.begin();
-	     resChange != change._change->resources.end(); ++resChange) {
+	// The archives might be removed, so stop reading from them
+	cancelPrefetches();
 
-		// Remove the resource, and the name list too if it's empty
-		resChange->hashIt->second.erase(resChange->resIt);
-		if (resChange->hashIt->second.empty())
-			_resources.erase(resChange->hashIt);
-	}
+	// Go through all changes in the resource index
+	for (std::vector<uint32>::const_iterator resChange = change._change->resources.begin();
+	     resChange != change._change->resources.end(); ++resChange)
+		removeResource(*resChange);
+
+	// Drop the decompressed resources, the archive IDs might be reused
+	uncacheArchives(change._change->archives);
 
 	// Removing all changes in the archive list
-	for (std::list<ArchiveList::iterator>::iterator archiveChange = change._change->archives.begin();
+	for (std::vector<uint32>::const_iterator archiveChange = change._change->archives.begin();
 	     archiveChange != change._change->archives.end(); ++archiveChange) {
 
-		delete **archiveChange;
-		_archives.erase(*archiveChange);
+		ArchiveSlot &slot = _archives[*archiveChange];
+
+		delete slot.archive;
+
+		slot.archive = 0;
+		slot.path.clear();
 	}
 
+	// Drop the trailing empty archive slots
+	while (!_archives.empty() && !_archives.back().archive && _archives.back().path.empty())
+		_archives.pop_back();
+
 	// Now we can remove the change set from our list of change sets
 	_changes.erase(change._change);
 
@@ -474,22 +1078,26 @@ void ResourceManager::addTypeAlias(FileType alias, FileType realType) {
 }
 
 void ResourceManager::blacklist(const Common::UString &name, FileType type) {
-	ResourceMap::iterator resList = _resources.find(getHash(name, type));
-	if (resList == _resources.end())
+	const uint32 slot = findHashSlot(getHash(name, type));
+	if (slot == kInvalidIndex)
 		return;
 
-	for (ResourceList::iterator res = resList->second.begin(); res != resList->second.end(); ++res)
-		res->priority = 0;
+	for (uint32 r = _hashTable[slot].first; r != kInvalidIndex; r = _resources[r].next)
+		_resources[r].priority = 0;
+
+	_revision++;
 }
 
 void ResourceManager::declareResource(const Common::UString &name, FileType type) {
-	ResourceMap::iterator resList = _resources.find(getHash(name, type));
-	if (resList == _resources.end())
+	const uint32 slot = findHashSlot(getHash(name, type));
+	if (slot == kInvalidIndex)
 		return;
 
-	for (ResourceList::iterator r = resList->second.begin(); r != resList->second.end(); ++r) {
-		r->name = name;
-		r->type = type;
+	const uint32 nameIndex = internString(name);
+
+	for (uint32 r = _hashTable[slot].first; r != kInvalidIndex; r = _resources[r].next) {
+		_resources[r].name = nameIndex;
+		_resources[r].type = type;
 	}
 }
 
@@ -498,11 +1106,7 @@ void ResourceManager::declareResource(const Common::UString &name) {
 }
 
 bool ResourceManager::hasResource(const Common::UString &name, FileType type) const {
-	std::vector<FileType> types;
-
-	types.push_back(type);
-
-	return hasResource(name, types);
+	return getRes(name, type) != 0;
 }
 
 bool ResourceManager::hasResource(const Common::UString &name, ResourceType type) const {
@@ -523,32 +1127,386 @@ bool ResourceManager::hasResource(const Common::UString &name, const std::vector
 }
 
 uint32 ResourceManager::getResourceSize(const Resource &res) const {
-	if (res.source == kSourceArchive) {
-		if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+	if (res.archive != kInvalidIndex) {
+		Archive *archive = getArchive(res.archive);
+		if (!archive || (res.index == kInvalidIndex))
 			return 0xFFFFFFFF;
 
-		return res.archive->getResourceSize(res.archiveIndex);
+		return archive->getResourceSize(res.index);
 	}
 
-	if (res.source == kSourceFile)
-		return Common::FilePath::getFileSize(res.path);
-
-	return 0xFFFFFFFF;
+	return Common::FilePath::getFileSize(_strings[res.index]);
 }
 
 Common::SeekableReadStream *ResourceManager::getArchiveResource(const Resource &res) const {
-	if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+	Archive *archive = getArchive(res.archive);
+	if (!archive || (res.index == kInvalidIndex))
 		throw Common::Exception("Archive resource has no archive");
 
-	return res.archive->getResource(res.archiveIndex);
+	if (!archive->isResourceCompressed(res.index))
+		return archive->getResource(res.index);
+
+	// Did we already decompress it?
+	Common::SeekableReadStream *stream = getCachedResource(res.archive, res.index);
+	if (stream)
+		return stream;
+
+	return cacheResource(res.archive, res.index, archive->getResource(res.index));
 }
 
-Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name, FileType type) const {
-	std::vector<FileType> types;
+Common::SeekableReadStream *ResourceManager::getResourceStream(const Resource &res) const {
+	// Did we already read it in the background?
+	Common::SeekableReadStream *stream = takePrefetch(res);
+	if (stream)
+		return stream;
 
-	types.push_back(type);
+	if (res.archive != kInvalidIndex)
+		return getArchiveResource(res);
 
-	return getResource(name, types);
+	return openResourceFile(_strings[res.index]);
+}
+
+Common::SeekableReadStream *ResourceManager::openResourceFile(const Common::UString &path) const {
+	Common::File *file = new Common::File;
+
+	if (!file->open(path)) {
+		delete file;
+		return 0;
+	}
+
+	return file;
+}
+
+ResourceManager::Prefetch ResourceManager::prefetch(const Common::UString &name, FileType type) {
+	const Resource *res = getRes(name, type);
+
+	boost::shared_ptr<PrefetchJob> job(new PrefetchJob(*this, name, type));
+	if (!res) {
+		// Nothing to read, take() will report that
+		job->done = true;
+		return Prefetch(job);
+	}
+
+	if (!canPrefetch(*res)) {
+		// Can't be read in the background, so read it now, while we may still look at the index
+		try {
+			job->stream = getResourceStream(*res);
+		} catch (...) {
+			// Ignore it here, take() will try again and throw
+		}
+
+		job->done = true;
+		return Prefetch(job);
+	}
+
+	job->resource = *res;
+	if (res->archive == kInvalidIndex)
+		job->path = _strings[res->index];
+
+	Common::StackLock lock(_prefetchMutex);
+
+	// Forget about the finished jobs
+	for (PrefetchQueue::iterator j = _prefetchQueue.begin(); j != _prefetchQueue.end(); ) {
+		if ((*j)->done)
+			j = _prefetchQueue.erase(j);
+		else
+			++j;
+	}
+
+	for (PrefetchMap::iterator p = _prefetches.begin(); p != _prefetches.end(); ) {
+		if (p->second.expired())
+			p = _prefetches.erase(p);
+		else
+			++p;
+	}
+
+	if (!_prefetchPool)
+		_prefetchPool = new Common::ThreadPool(MIN<uint32>(Common::ThreadPool::getCPUCount(), kPrefetchThreads));
+
+	_prefetchQueue.push_back(job);
+	_prefetches[res->hash] = job;
+
+	_prefetchPool->addJob(*job);
+
+	return Prefetch(job);
+}
+
+ResourceManager::Prefetch ResourceManager::prefetch(ResourceType resType,
+		const Common::UString &name, FileType *foundType) {
+
+	assert((resType >= 0) && (resType < kResourceMAX));
+
+	// Try every known file type for that resource type
+	const Resource *res = getRes(name, _resourceTypeTypes[resType]);
+	if (!res)
+		return Prefetch();
+
+	if (foundType)
+		*foundType = res->type;
+
+	return prefetch(name, res->type);
+}
+
+void ResourceManager::prefetch(const std::list<ResourceID> &resources, PrefetchList &prefetches) {
+	prefetches.reserve(prefetches.size() + resources.size());
+
+	for (std::list<ResourceID>::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		prefetches.push_back(prefetch(r->name, r->type));
+}
+
+bool ResourceManager::canPrefetch(const Resource &res) const {
+	if (res.archive == kInvalidIndex)
+		return true;
+
+	Common::StackLock lock(_archiveMutex);
+
+	if (res.archive >= _archives.size())
+		return false;
+
+	// Only these archives can be read from several threads at once
+	const ArchiveType type = _archives[res.archive].type;
+
+	return (type == kArchiveBIF) || (type == kArchiveERF) || (type == kArchiveRIM) || (type == kArchiveZIP);
+}
+
+void ResourceManager::runPrefetch(PrefetchJob &job) const {
+	Common::SeekableReadStream *stream = 0;
+
+	try {
+		Common::SeekableReadStream *res = (job.resource.archive != kInvalidIndex) ?
+			getArchiveResource(job.resource) : openResourceFile(job.path);
+
+		// Pull the whole resource into memory
+		if (res && !dynamic_cast<Common::MemoryReadStream *>(res)) {
+			try {
+				stream = res->readStream(res->size());
+			} catch (...) {
+				delete res;
+				throw;
+			}
+
+			delete res;
+		} else
+			stream = res;
+
+	} catch (...) {
+		// Ignore it here, take() will try again and throw
+	}
+
+	Common::StackLock lock(_prefetchMutex);
+
+	job.stream = stream;
+	job.done   = true;
+
+	_prefetchDone.broadcast();
+}
+
+Common::SeekableReadStream *ResourceManager::takePrefetch(const Resource &res) const {
+	Common::StackLock lock(_prefetchMutex);
+
+	PrefetchMap::iterator p = _prefetches.find(res.hash);
+	if (p == _prefetches.end())
+		return 0;
+
+	boost::shared_ptr<PrefetchJob> job = p->second.lock();
+	_prefetches.erase(p);
+
+	// Make sure it's still the same resource
+	if (!job || (job->resource.archive != res.archive) || (job->resource.index != res.index))
+		return 0;
+
+	return takePrefetch(*job);
+}
+
+Common::SeekableReadStream *ResourceManager::takePrefetch(PrefetchJob &job) const {
+	if (job.taken)
+		return 0;
+
+	while (!job.done)
+		_prefetchDone.wait(100);
+
+	Common::SeekableReadStream *stream = job.stream;
+
+	job.stream = 0;
+	job.taken  = true;
+
+	// The resource index changed since we read it
+	if (job.generation != _prefetchGeneration) {
+		delete stream;
+		return 0;
+	}
+
+	return stream;
+}
+
+void ResourceManager::cancelPrefetches() {
+	// Drop the queued jobs and wait for the running ones to finish
+	delete _prefetchPool;
+	_prefetchPool = 0;
+
+	Common::StackLock lock(_prefetchMutex);
+
+	// Jobs that never ran are finished, too: take() will read them normally
+	for (PrefetchQueue::iterator j = _prefetchQueue.begin(); j != _prefetchQueue.end(); ++j)
+		(*j)->done = true;
+
+	_prefetchQueue.clear();
+	_prefetches.clear();
+
+	_prefetchGeneration++;
+
+	_prefetchDone.broadcast();
+}
+
+void ResourceManager::setResourceCacheSize(uint32 size) {
+	Common::StackLock lock(_resourceCacheMutex);
+
+	_resourceCacheBudget = size;
+
+	evictResources();
+}
+
+ResourceManager::CacheStatistics ResourceManager::getResourceCacheStatistics() const {
+	Common::StackLock lock(_resourceCacheMutex);
+
+	CacheStatistics stats;
+
+	stats.hits      = _resourceCacheHits;
+	stats.misses    = _resourceCacheMisses;
+	stats.evictions = _resourceCacheEvictions;
+
+	stats.resources = _resourceCache.size();
+	stats.size      = _resourceCacheSize;
+	stats.budget    = _resourceCacheBudget;
+
+	return stats;
+}
+
+void ResourceManager::resetResourceCacheStatistics() {
+	Common::StackLock lock(_resourceCacheMutex);
+
+	_resourceCacheHits      = 0;
+	_resourceCacheMisses    = 0;
+	_resourceCacheEvictions = 0;
+}
+
+Common::SeekableReadStream *ResourceManager::getCachedResource(uint32 archive, uint32 index) const {
+	Common::StackLock lock(_resourceCacheMutex);
+
+	if (_resourceCacheBudget == 0)
+		return 0;
+
+	ResourceCacheMap::iterator c = _resourceCacheMap.find((((uint64) archive) << 32) | index);
+	if (c == _resourceCacheMap.end()) {
+		_resourceCacheMisses++;
+		return 0;
+	}
+
+	_resourceCacheHits++;
+
+	// Move it to the front of the LRU list
+	_resourceCache.splice(_resourceCache.begin(), _resourceCache, c->second);
+
+	return new CachedResourceStream(c->second->data, c->second->size);
+}
+
+Common::SeekableReadStream *ResourceManager::cacheResource(uint32 archive, uint32 index,
+		Common::SeekableReadStream *stream) const {
+
+	if (!stream)
+		return 0;
+
+	_resourceCacheMutex.lock();
+	const uint32 budget = _resourceCacheBudget;
+	_resourceCacheMutex.unlock();
+
+	// Don't let a single huge resource flush out everything else
+	const uint32 size = stream->size();
+	if ((size == 0) || (size > (budget / 4)))
+		return stream;
+
+	boost::shared_array<byte> data(new byte[size]);
+
+	try {
+		stream->seek(0);
+		if (stream->read(data.get(), size) != size)
+			throw Common::Exception(Common::kReadError);
+	} catch (...) {
+		delete stream;
+		throw;
+	}
+
+	delete stream;
+
+	Common::StackLock lock(_resourceCacheMutex);
+
+	const uint64 key = (((uint64) archive) << 32) | index;
+
+	// Someone else might have been faster
+	if (_resourceCacheMap.find(key) == _resourceCacheMap.end()) {
+		_resourceCache.push_front(CachedResource());
+
+		_resourceCache.front().key  = key;
+		_resourceCache.front().data = data;
+		_resourceCache.front().size = size;
+
+		_resourceCacheMap.insert(std::make_pair(key, _resourceCache.begin()));
+		_resourceCacheSize += size;
+
+		evictResources();
+	}
+
+	return new CachedResourceStream(data, size);
+}
+
+void ResourceManager::evictResources() const {
+	while ((_resourceCacheSize > _resourceCacheBudget) && !_resourceCache.empty()) {
+		const CachedResource &res = _resourceCache.back();
+
+		_resourceCacheSize -= res.size;
+		_resourceCacheMap.erase(res.key);
+
+		_resourceCache.pop_back();
+
+		_resourceCacheEvictions++;
+	}
+}
+
+void ResourceManager::uncacheArchives(const std::vector<uint32> &archives) {
+	if (archives.empty())
+		return;
+
+	Common::StackLock lock(_resourceCacheMutex);
+
+	ResourceCacheList::iterator c = _resourceCache.begin();
+	while (c != _resourceCache.end()) {
+		if (std::find(archives.begin(), archives.end(), (uint32) (c->key >> 32)) == archives.end()) {
+			++c;
+			continue;
+		}
+
+		_resourceCacheSize -= c->size;
+		_resourceCacheMap.erase(c->key);
+
+		c = _resourceCache.erase(c);
+	}
+}
+
+void ResourceManager::clearResourceCache() {
+	Common::StackLock lock(_resourceCacheMutex);
+
+	_resourceCache.clear();
+	_resourceCacheMap.clear();
+
+	_resourceCacheSize = 0;
+}
+
+Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name, FileType type) const {
+	const Resource *res = getRes(name, type);
+	if (!res)
+		return 0;
+
+	return getResourceStream(*res);
 }
 
 Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name) const {
@@ -566,24 +1524,7 @@ Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &
 	if (foundType)
 		*foundType = res->type;
 
-	if        (res->source == kSourceNone) {
-		throw Common::Exception("Invalid resource source");
-	} else if (res->source == kSourceArchive) {
-		return getArchiveResource(*res);
-	} else if (res->source == kSourceFile) {
-		// Open the file and return it
-
-		Common::File *file = new Common::File;
-
-		if (!file->open(res->path)) {
-			delete file;
-			return 0;
-		}
-
-		return file;
-	}
-
-	return 0;
+	return getResourceStream(*res);
 }
 
 Common::SeekableReadStream *ResourceManager::getResource(ResourceType resType,
@@ -603,26 +1544,27 @@ Common::SeekableReadStream *ResourceManager::getResource(ResourceType resType,
 void ResourceManager::getAvailableResources(FileType type,
 		std::list<ResourceID> &list) const {
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		if (!r->second.empty() && (r->second.front().type == type)) {
-			list.push_back(ResourceID());
+	const std::vector<FileType> types(1, type);
 
-			list.back().name = r->second.front().name;
-			list.back().type = r->second.front().type;
-		}
-	}
+	getAvailableResources(types, list);
 }
 
 void ResourceManager::getAvailableResources(const std::vector<FileType> &types,
 		std::list<ResourceID> &list) const {
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+	for (HashTable::const_iterator s = _hashTable.begin(); s != _hashTable.end(); ++s) {
+		if (s->first == kInvalidIndex)
+			continue;
+
+		const Resource &res = _resources[s->first];
+
 		for (std::vector<FileType>::const_iterator t = types.begin(); t != types.end(); ++t) {
-			if (!r->second.empty() && (r->second.front().type == *t)) {
+			if (res.type == *t) {
 				list.push_back(ResourceID());
 
-				list.back().name = r->second.front().name;
-				list.back().type = r->second.front().type;
+				if (res.name != kInvalidIndex)
+					list.back().name = _strings[res.name];
+				list.back().type = res.type;
 			}
 		}
 
@@ -635,29 +1577,29 @@ void ResourceManager::getAvailableResources(ResourceType type,
 	getAvailableResources(_resourceTypeTypes[type], list);
 }
 
-bool ResourceManager::normalizeType(Resource &resource) {
+bool ResourceManager::normalizeType(FileType &type) {
 	// Resolve the type aliases
-	std::map<FileType, FileType>::const_iterator alias = _typeAliases.find(resource.type);
+	std::map<FileType, FileType>::const_iterator alias = _typeAliases.find(type);
 	if (alias != _typeAliases.end()) {
-		resource.type = alias->second;
+		type = alias->second;
 		return true;
 	}
 
 	// Normalize resource type *sigh*
-	if      (resource.type == kFileTypeQST2)
-		resource.type = kFileTypeQST;
-	else if (resource.type == kFileTypeMDX2)
-		resource.type = kFileTypeMDX;
-	else if (resource.type == kFileTypeTXB2)
-		resource.type = kFileTypeTXB;
-	else if (resource.type == kFileTypeMDB2)
-		resource.type = kFileTypeMDB;
-	else if (resource.type == kFileTypeMDA2)
-		resource.type = kFileTypeMDA;
-	else if (resource.type == kFileTypeSPT2)
-		resource.type = kFileTypeSPT;
-	else if (resource.type == kFileTypeJPG2)
-		resource.type = kFileTypeJPG;
+	if      (type == kFileTypeQST2)
+		type = kFileTypeQST;
+	else if (type == kFileTypeMDX2)
+		type = kFileTypeMDX;
+	else if (type == kFileTypeTXB2)
+		type = kFileTypeTXB;
+	else if (type == kFileTypeMDB2)
+		type = kFileTypeMDB;
+	else if (type == kFileTypeMDA2)
+		type = kFileTypeMDA;
+	else if (type == kFileTypeSPT2)
+		type = kFileTypeSPT;
+	else if (type == kFileTypeJPG2)
+		type = kFileTypeJPG;
 	else
 		return false;
 
@@ -672,17 +1614,115 @@ inline uint64 ResourceManager::getHash(const Common::UString &name) const {
 	return Common::hashString(name.toLower(), _hashAlgo);
 }
 
-void ResourceManager::checkHashCollision(const Resource &resource, ResourceMap::const_iterator resList) {
-	if (resource.name.empty() || resList->second.empty())
+uint32 ResourceManager::internString(const Common::UString &str) {
+	std::pair<StringMap::iterator, bool> result = _stringMap.insert(std::make_pair(str, (uint32) _strings.size()));
+	if (result.second)
+		_strings.push_back(str);
+
+	return result.first->second;
+}
+
+inline uint32 ResourceManager::getHashPosition(uint64 hash) const {
+	// Mix the bits, since the smaller hashes only fill the lower 32 bits
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+
+	return ((uint32) hash) & (_hashTable.size() - 1);
+}
+
+uint32 ResourceManager::findHashSlot(uint64 hash) const {
+	if (_hashTable.empty())
+		return kInvalidIndex;
+
+	const uint32 mask = _hashTable.size() - 1;
+
+	for (uint32 slot = getHashPosition(hash); _hashTable[slot].first != kInvalidIndex; slot = (slot + 1) & mask)
+		if (_hashTable[slot].hash == hash)
+			return slot;
+
+	return kInvalidIndex;
+}
+
+uint32 ResourceManager::addHashSlot(uint64 hash) {
+	// Keep the load factor below 0.7
+	if (((_hashCount + 1) * 10) > (_hashTable.size() * 7))
+		growHashTable();
+
+	const uint32 mask = _hashTable.size() - 1;
+
+	uint32 slot = getHashPosition(hash);
+	while (_hashTable[slot].first != kInvalidIndex) {
+		if (_hashTable[slot].hash == hash)
+			return slot;
+
+		slot = (slot + 1) & mask;
+	}
+
+	_hashTable[slot].hash = hash;
+	_hashCount++;
+
+	return slot;
+}
+
+void ResourceManager::removeHashSlot(uint32 slot) {
+	const uint32 mask = _hashTable.size() - 1;
+
+	_hashTable[slot].first = kInvalidIndex;
+	_hashCount--;
+
+	// Move following entries of the probe sequence back into the hole
+	uint32 hole = slot;
+	for (uint32 next = (slot + 1) & mask; _hashTable[next].first != kInvalidIndex; next = (next + 1) & mask) {
+		const uint32 home = getHashPosition(_hashTable[next].hash);
+
+		// Can the entry legally live in the hole, i.e. is its home not cyclically in (hole, next]?
+		const bool canMove = (hole <= next) ? ((home <= hole) || (home > next)) : ((home <= hole) && (home > next));
+		if (!canMove)
+			continue;
+
+		_hashTable[hole] = _hashTable[next];
+		_hashTable[next].first = kInvalidIndex;
+
+		hole = next;
+	}
+}
+
+void ResourceManager::growHashTable() {
+	HashTable oldTable;
+	oldTable.swap(_hashTable);
+
+	HashSlot empty;
+	empty.hash  = 0;
+	empty.first = kInvalidIndex;
+
+	_hashTable.resize(MAX<size_t>(oldTable.size() * 2, 1024), empty);
+
+	const uint32 mask = _hashTable.size() - 1;
+
+	for (HashTable::const_iterator s = oldTable.begin(); s != oldTable.end(); ++s) {
+		if (s->first == kInvalidIndex)
+			continue;
+
+		uint32 slot = getHashPosition(s->hash);
+		while (_hashTable[slot].first != kInvalidIndex)
+			slot = (slot + 1) & mask;
+
+		_hashTable[slot] = *s;
+	}
+}
+
+void ResourceManager::checkHashCollision(const Common::UString &name, FileType type, uint32 slot) const {
+	if (name.empty())
 		return;
 
-	Common::UString newName = TypeMan.setFileType(resource.name, resource.type).toLower();
+	Common::UString newName = TypeMan.setFileType(name, type).toLower();
 
-	for (ResourceList::const_iterator r = resList->second.begin(); r != resList->second.end(); ++r) {
-		if (r->name.empty())
+	for (uint32 r = _hashTable[slot].first; r != kInvalidIndex; r = _resources[r].next) {
+		if (_resources[r].name == kInvalidIndex)
 			continue;
 
-		Common::UString oldName = TypeMan.setFileType(r->name, r->type).toLower();
+		Common::UString oldName = TypeMan.setFileType(_strings[_resources[r].name], _resources[r].type).toLower();
 		if (oldName != newName) {
 			warning("ResourceManager: Found hash collision: %s (\"%s\" and \"%s\")",
 					Common::formatHash(getHash(oldName)).c_str(), oldName.c_str(), newName.c_str());
@@ -691,55 +1731,97 @@ void ResourceManager::checkHashCollision(const Resource &resource, ResourceMap::
 	}
 }
 
-void ResourceManager::addResource(Resource &resource, uint64 hash, ChangeID &change) {
-	ResourceMap::iterator resList = _resources.find(hash);
-	if (resList == _resources.end()) {
-		// We don't have a resource with this name yet, create a new resource list for it
-
-		std::pair<ResourceMap::iterator, bool> result;
+void ResourceManager::addResource(const Common::UString &name, FileType type, uint32 priority,
+                                  uint32 archive, uint32 index, uint64 hash, ChangeID &change) {
 
-		result = _resources.insert(std::make_pair(hash, ResourceList()));
+	const uint32 slot = addHashSlot(hash);
 
-		resList = result.first;
-	}
+	_revision++;
 
 #ifdef CHECK_HASH_COLLISION
-	checkHashCollision(resource, resList);
+	checkHashCollision(name, type, slot);
 #endif
 
-	// Add the resource to the list and sort by priority
-	resList->second.push_back(resource);
-	resList->second.sort();
+	// Get a free resource entry
+	uint32 resIndex;
+	if (!_freeResources.empty()) {
+		resIndex = _freeResources.back();
+		_freeResources.pop_back();
+	} else {
+		resIndex = _resources.size();
+		_resources.push_back(Resource());
+	}
+
+	Resource &res = _resources[resIndex];
+
+	res.hash     = hash;
+	res.priority = priority;
+	res.name     = name.empty() ? kInvalidIndex : internString(name);
+	res.type     = type;
+	res.archive  = archive;
+	res.index    = index;
+
+	// Sort into the chain. Of equal priorities, the one added last wins
+	uint32 *link = &_hashTable[slot].first;
+	while ((*link != kInvalidIndex) && (_resources[*link].priority > priority))
+		link = &_resources[*link].next;
+
+	res.next = *link;
+	*link    = resIndex;
 
 	// Remember the resource in the change set
-	change._change->resources.push_back(ResourceChange());
-	change._change->resources.back().hashIt = resList;
-	change._change->resources.back().resIt  = --resList->second.end();
+	change._change->resources.push_back(resIndex);
+}
+
+void ResourceManager::removeResource(uint32 resource) {
+	const uint32 slot = findHashSlot(_resources[resource].hash);
+	if (slot == kInvalidIndex)
+		return;
+
+	_revision++;
+
+	// Unlink the resource from its chain
+	uint32 *link = &_hashTable[slot].first;
+	while ((*link != kInvalidIndex) && (*link != resource))
+		link = &_resources[*link].next;
+
+	if (*link == kInvalidIndex)
+		return;
+
+	*link = _resources[resource].next;
+
+	// Remove the whole hash slot if that was the last resource with this hash
+	if (_hashTable[slot].first == kInvalidIndex)
+		removeHashSlot(slot);
+
+	_resources[resource].next = kInvalidIndex;
+	_freeResources.push_back(resource);
 }
 
 void ResourceManager::addResources(const Common::FileList &files, ChangeID &change, uint32 priority) {
 	for (Common::FileList::const_iterator file = files.begin(); file != files.end(); ++file) {
-		Resource res;
-		res.priority = priority;
-		res.source   = kSourceFile;
-		res.path     = *file;
-		res.name     = Common::FilePath::getStem(*file);
-		res.type     = TypeMan.getFileType(*file);
+		const Common::UString name = Common::FilePath::getStem(*file);
 
-		uint64 hash = getHash(res.name, res.type);
-		if (normalizeType(res))
-			hash = getHash(res.name, res.type);
+		FileType type = TypeMan.getFileType(*file);
 
-		addResource(res, hash, change);
+		uint64 hash = getHash(name, type);
+		if (normalizeType(type))
+			hash = getHash(name, type);
+
+		addResource(name, type, priority, kInvalidIndex, internString(*file), hash, change);
 	}
 }
 
 const ResourceManager::Resource *ResourceManager::getRes(uint64 hash) const {
-	ResourceMap::const_iterator r = _resources.find(hash);
-	if ((r == _resources.end()) || r->second.empty() || (r->second.back().priority == 0))
+	const uint32 slot = findHashSlot(hash);
+	if (slot == kInvalidIndex)
+		return 0;
+
+	const Resource &res = _resources[_hashTable[slot].first];
+	if (res.priority == 0)
 		return 0;
 
-	return &r->second.back();
+	return &res;
 }
 
 const ResourceManager::Resource *ResourceManager::getRes(const Common::UString &name,
@@ -755,9 +1837,11 @@ const ResourceManager::Resource *ResourceManager::getRes(const Common::UString &
 }
 
 const ResourceManager::Resource *ResourceManager::getRes(const Common::UString &name, FileType type) const {
-	std::vector<FileType> types(1, type);
+	return getRes(getHash(name, type));
+}
 
-	return getRes(name, types);
+uint32 ResourceManager::getRevision() const {
+	return _revision;
 }
 
 void ResourceManager::dumpResourcesList(const Common::UString &fileName) const {
@@ -769,15 +1853,22 @@ void ResourceManager::dumpResourcesList(const Common::UString &fileName) const {
 	file.writeString("                Name                 |        Hash        |     Size    \n");
 	file.writeString("-------------------------------------|--------------------|-------------\n");
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		if (r->second.empty())
-			continue;
+	// Sort by hash, to keep the list stable
+	std::vector<uint64> hashes;
+	hashes.reserve(_hashCount);
+
+	for (HashTable::const_iterator s = _hashTable.begin(); s != _hashTable.end(); ++s)
+		if (s->first != kInvalidIndex)
+			hashes.push_back(s->hash);
+
+	std::sort(hashes.begin(), hashes.end());
 
-		const Resource &res = r->second.back();
+	for (std::vector<uint64>::const_iterator h = hashes.begin(); h != hashes.end(); ++h) {
+		const Resource &res = _resources[_hashTable[findHashSlot(*h)].first];
 
-		const Common::UString &name = res.name;
+		const Common::UString  name = (res.name != kInvalidIndex) ? _strings[res.name] : "";
 		const Common::UString   ext = TypeMan.setFileType("", res.type);
-		const uint64           hash = r->first;
+		const uint64           hash = *h;
 		const uint32           size = getResourceSize(res);
 
 		const Common::UString line =
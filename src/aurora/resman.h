@@ -30,21 +30,28 @@
 #include <vector>
 #include <map>
 
+#include <boost/unordered/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/shared_array.hpp>
+
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 #include "src/common/singleton.h"
 #include "src/common/filelist.h"
 #include "src/common/hash.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
+#include "src/aurora/archive.h"
 
 namespace Common {
 	class SeekableReadStream;
+	class ThreadPool;
 }
 
 namespace Aurora {
 
-class Archive;
 class KEYFile;
 class BIFFile;
 
@@ -57,62 +64,118 @@ private:
 	typedef std::list<Common::UString> DirectoryList;
 	typedef std::vector<FileType> FileTypeList;
 
-	typedef std::list<Archive *> ArchiveList;
-	typedef ArchiveList::const_iterator ArchiveRef;
+	/** An archive used by the resource manager. */
+	struct ArchiveSlot {
+		/** The archive, 0 if it hasn't been opened yet or was removed. */
+		Archive *archive;
 
-	/** Where a resource can be found. */
-	enum Source {
-		kSourceNone   , ///< Invalid source.
-		kSourceArchive, ///< Within an archive.
-		kSourceFile     ///< A direct file.
+		ArchiveType     type; ///< The archive's type.
+		Common::UString path; ///< The archive's path, empty if it can't be reopened.
 	};
 
-	/** A resource. */
-	struct Resource {
-		Common::UString name; ///< The resource's name.
-		FileType        type; ///< The resource's type.
+	/** All archives, indexed by their ID. */
+	typedef std::vector<ArchiveSlot> ArchiveList;
 
-		uint32 priority; ///< The resource's priority over others with the same name and type.
+	/** The resource list of an archive, as found in the index cache. */
+	struct CachedArchive {
+		ArchiveType     type; ///< The archive's type.
+		Common::UString path; ///< The archive's path.
+
+		uint32 size; ///< The archive's size when it was indexed.
+		uint64 time; ///< The archive's modification time when it was indexed.
+
+		Common::HashAlgo hashAlgo; ///< The archive's name hashing algorithm.
+
+		/** For KEYs, the cache IDs of the BIFs it references. */
+		std::vector<Common::UString> bifs;
 
-		Source source; ///< Where can the resource be found?
+		Archive::ResourceList resources; ///< The archive's resources.
+	};
+
+	/** The index cache, indexed by cache ID. */
+	typedef std::map<Common::UString, CachedArchive> IndexCache;
 
-		// For kSourceArchive
-		Archive *archive;      ///< Pointer to the archive.
-		uint32   archiveIndex; ///< Index into the archive.
+	static const uint32 kInvalidIndex = 0xFFFFFFFF;
 
-		// For kSourceFile
-		Common::UString path; ///< The file's path.
+	/** A resource.
+	 *
+	 *  All resources with the same hash are linked into a chain, ordered by
+	 *  descending priority. Names and paths are interned in the string pool.
+	 */
+	struct Resource {
+		uint64 hash; ///< The resource's hashed name.
+		uint32 next; ///< The next resource with the same hash.
 
-		Resource();
+		uint32 priority; ///< The resource's priority over others with the same name and type.
 
-		bool operator<(const Resource &right) const;
+		uint32   name; ///< The resource's name (string pool index), kInvalidIndex if unknown.
+		FileType type; ///< The resource's type.
+
+		/** The archive the resource is in, kInvalidIndex for a direct file. */
+		uint32 archive;
+		/** Index into the archive, or the file's path (string pool index) for a direct file. */
+		uint32 index;
 	};
 
-	/** List of resources, sorted by priority. */
-	typedef std::list<Resource> ResourceList;
-	/** Map over resources, indexed by their hashed name. */
-	typedef std::map<uint64, ResourceList> ResourceMap;
+	typedef std::vector<Resource> ResourceList;
 
-	/** A change produced by a manager operation. */
-	struct ResourceChange {
-		ResourceMap::iterator  hashIt;
-		ResourceList::iterator resIt;
+	/** A slot in the resource hash table. */
+	struct HashSlot {
+		uint64 hash;  ///< The hashed name.
+		uint32 first; ///< The resource with the highest priority, kInvalidIndex for an empty slot.
 	};
 
+	/** Open addressing (linear probing) hash table over the resources. */
+	typedef std::vector<HashSlot> HashTable;
+
+	typedef boost::unordered_map<Common::UString, uint32, Common::hashUStringCaseSensitive> StringMap;
+
 	/** A set of changes produced by a manager operation. */
 	struct ChangeSet {
-		std::list<ArchiveList::iterator> archives;
-		std::list<ResourceChange>        resources;
+		std::vector<uint32> archives;
+		std::vector<uint32> resources;
 	};
 
 	typedef std::list<ChangeSet> ChangeSetList;
 
+	struct BatchJob;
+	struct PrefetchJob;
+
+	typedef std::list< boost::shared_ptr<PrefetchJob> > PrefetchQueue;
+	typedef boost::unordered_map<uint64, boost::weak_ptr<PrefetchJob> > PrefetchMap;
+
+	/** A decompressed resource, kept in memory for repeated requests. */
+	struct CachedResource {
+		uint64 key; ///< Archive ID and index within the archive.
+
+		boost::shared_array<byte> data; ///< The decompressed data.
+		uint32 size;                    ///< The size of the decompressed data.
+	};
+
+	/** The cached resources, most recently used first. */
+	typedef std::list<CachedResource> ResourceCacheList;
+	typedef boost::unordered_map<uint64, ResourceCacheList::iterator> ResourceCacheMap;
+
 public:
 	struct ResourceID {
 		Common::UString name;
 		FileType type;
 	};
 
+	/** Usage statistics of the decompressed resource cache. */
+	struct CacheStatistics {
+		uint64 hits;      ///< Number of requests served from the cache.
+		uint64 misses;    ///< Number of requests that needed to decompress the resource.
+		uint64 evictions; ///< Number of resources dropped to stay within the budget.
+
+		uint32 resources; ///< Number of currently cached resources.
+		uint32 size;      ///< Memory used by the cached resources, in bytes.
+		uint32 budget;    ///< Maximum memory used by the cached resources, in bytes.
+	};
+
+	/** Default memory budget of the decompressed resource cache, in bytes. */
+	static const uint32 kDefaultResourceCacheSize = 32 * 1024 * 1024;
+
 	/** ID of a set of changes produced by a manager operation. */
 	class ChangeID {
 	public:
@@ -140,12 +203,44 @@ public:
 	/** Are .rim files actually ERF files? */
 	void setRIMsAreERFs(bool rimsAreERFs);
 
+	/** Should archives be mapped into memory instead of being read through files? */
+	void setMapArchives(bool mapArchives);
+
 	/** With which hash algo are/should the names be hashed? */
 	void setHashAlgo(Common::HashAlgo algo);
 
 	/** Set the array used to map cursor ID to cursor names. */
 	void setCursorRemap(const std::vector<Common::UString> &remap);
 
+	/** Use a persistent on-disk index cache.
+	 *
+	 *  When indexing archives that haven't changed since they were cached,
+	 *  their resource lists are taken from the cache and the archives are
+	 *  only opened once a resource is actually requested from them.
+	 *
+	 *  @param file The cache file. An empty string disables the cache.
+	 */
+	void setIndexCache(const Common::UString &file);
+
+	/** Write the index cache back to disk, if it changed. */
+	void saveIndexCache();
+
+	/** Set the memory budget of the decompressed resource cache.
+	 *
+	 *  Resources that need to be decompressed when read from their archive
+	 *  are kept in memory, so that requesting them again is cheap. Once the
+	 *  budget is exceeded, the least recently used resources are dropped.
+	 *
+	 *  @param size The budget in bytes. 0 disables the cache.
+	 */
+	void setResourceCacheSize(uint32 size);
+
+	/** Return the current usage statistics of the decompressed resource cache. */
+	CacheStatistics getResourceCacheStatistics() const;
+
+	/** Reset the hit, miss and eviction counters of the decompressed resource cache. */
+	void resetResourceCacheStatistics();
+
 	/** Register a path to be the base data directory.
 	 *
 	 *  @param path The path to a base data directory.
@@ -182,6 +277,31 @@ public:
 	 */
 	ChangeID addArchive(ArchiveType archive, const Common::UString &file, uint32 priority = 1);
 
+	/** An archive file to be added by addArchives(). */
+	struct BatchArchive {
+		ArchiveType     type;     ///< The type of archive to add.
+		Common::UString file;     ///< The name of the archive file to index.
+		uint32          priority; ///< The priority of the archive's resources.
+		bool            optional; ///< Silently skip the archive if it can't be added?
+
+		ChangeID change; ///< The changes done by adding the archive.
+
+		BatchArchive(ArchiveType t, const Common::UString &f, uint32 p = 1, bool o = false);
+	};
+
+	typedef std::vector<BatchArchive> ArchiveBatch;
+
+	/** Add several archive files and all their resources to the resource manager.
+	 *
+	 *  The archives are opened and read in parallel, and then indexed in the
+	 *  order they were given. The result is the same as calling addArchive()
+	 *  for each of them in turn: if a non-optional archive fails, the archives
+	 *  before it stay added and the exception is passed on.
+	 *
+	 *  @param archives The archives to add. Their change IDs are filled in.
+	 */
+	void addArchives(ArchiveBatch &archives);
+
 	/** Add a directory's contents to the resource manager.
 	 *
 	 *  Relative to the base directory.
@@ -302,6 +422,76 @@ public:
 	Common::SeekableReadStream *getResource(ResourceType resType,
 			const Common::UString &name, FileType *foundType = 0) const;
 
+	/** A handle to a resource that's being read in the background. */
+	class Prefetch {
+	public:
+		Prefetch();
+
+		/** Is this an empty handle, or was the resource already taken? */
+		bool empty() const;
+		/** Has the resource been read completely? */
+		bool isDone() const;
+
+		/** Wait until the resource has been read and take it.
+		 *
+		 *  If the resource couldn't be read in the background, it is read now.
+		 *  Each handle can only be taken once.
+		 *
+		 *  @return The resource stream or 0 if the resource doesn't exist.
+		 */
+		Common::SeekableReadStream *take();
+
+		/** Wait until the resource has been read and take it, without touching the resource index.
+		 *
+		 *  Unlike take(), this never reads the resource itself, so it's safe to call
+		 *  while the index is being changed in another thread.
+		 *
+		 *  @param  stream The resource stream, or 0 if it couldn't be read.
+		 *  @return false if the prefetch was cancelled. The handle is then left alone,
+		 *          so that take() can still read the resource.
+		 */
+		bool takePrefetched(Common::SeekableReadStream *&stream);
+
+	private:
+		boost::shared_ptr<PrefetchJob> _job;
+
+		Prefetch(const boost::shared_ptr<PrefetchJob> &job);
+
+		friend class ResourceManager;
+	};
+
+	typedef std::vector<Prefetch> PrefetchList;
+
+	/** Start reading a resource in the background.
+	 *
+	 *  The resource is read from disk and decompressed on a worker thread.
+	 *  Resources in archives that can't be read from several threads at once
+	 *  are read right away, in the calling thread.
+	 *  As long as the handle is kept, getResource() also picks up the
+	 *  prefetched data, so callers don't need to know about the prefetch.
+	 *
+	 *  @param  name The name (ResRef or path) of the resource.
+	 *  @param  type The resource's type.
+	 *  @return A handle to the prefetched resource.
+	 */
+	Prefetch prefetch(const Common::UString &name, FileType type);
+
+	/** Start reading a resource of this resource type in the background.
+	 *
+	 *  @param  resType   The resource's resource type.
+	 *  @param  name      The name (ResRef) of the resource.
+	 *  @param  foundType If not 0, the actually found file type is stored here.
+	 *  @return A handle to the prefetched resource, or an empty handle if it doesn't exist.
+	 */
+	Prefetch prefetch(ResourceType resType, const Common::UString &name, FileType *foundType = 0);
+
+	/** Start reading several resources in the background.
+	 *
+	 *  @param resources  The resources to read.
+	 *  @param prefetches The handles to the prefetched resources are appended here.
+	 */
+	void prefetch(const std::list<ResourceID> &resources, PrefetchList &prefetches);
+
 	/** Return a list of all available resources of the specified type. */
 	void getAvailableResources(FileType type, std::list<ResourceID> &list) const;
 	/** Return a list of all available resources of the specified type. */
@@ -312,8 +502,17 @@ public:
 	/** Dump a list of all resources into a file. */
 	void dumpResourcesList(const Common::UString &fileName) const;
 
+	/** Return the revision of the resource index.
+	 *
+	 *  The revision changes whenever resources are added, removed or
+	 *  blacklisted, so that anything derived from resources can check
+	 *  whether it's still up-to-date.
+	 */
+	uint32 getRevision() const;
+
 private:
 	bool _rimsAreERFs; ///< Are .rim files actually ERF files?
+	bool _mapArchives; ///< Should archives be mapped into memory?
 
 	Common::HashAlgo _hashAlgo; ///< With which hash algo are/should the names be hashed?
 
@@ -324,35 +523,104 @@ private:
 	DirectoryList    _archiveDirs [kArchiveMAX]; ///< Archive directories.
 	Common::FileList _archiveFiles[kArchiveMAX]; ///< Archive files.
 
-	ArchiveList _archives; ///< List of currently used archives.
+	mutable ArchiveList   _archives;     ///< List of currently used archives.
+	mutable Common::Mutex _archiveMutex; ///< Mutex guarding the archive list.
+
+	Common::UString _indexCacheFile;    ///< The file the index cache is stored in.
+	IndexCache      _indexCache;        ///< The index cache.
+	bool            _indexCacheChanged; ///< Was the index cache modified?
 
 	std::map<FileType, FileType> _typeAliases;
 
-	ResourceMap _resources;
+	ResourceList        _resources;     ///< All resources.
+	std::vector<uint32> _freeResources; ///< Unused entries in the resource list.
+
+	HashTable _hashTable; ///< Resource chains, indexed by hash.
+	uint32    _hashCount; ///< Number of used hash table slots.
+
+	std::vector<Common::UString> _strings;   ///< Pool of interned resource names and paths.
+	StringMap                    _stringMap; ///< String -> index into the string pool.
 
 	ChangeSetList _changes;
 
+	uint32 _revision; ///< Incremented whenever the resource index changes.
+
+	static const uint32 kPrefetchThreads = 4;
+
+	Common::ThreadPool *_prefetchPool;  ///< The worker threads reading prefetched resources.
+	PrefetchQueue       _prefetchQueue; ///< All prefetch jobs that aren't finished yet.
+
+	/** Incremented whenever running prefetches are cancelled. */
+	uint32 _prefetchGeneration;
+
+	mutable PrefetchMap       _prefetches;    ///< Pending prefetches, indexed by hash.
+	mutable Common::Mutex     _prefetchMutex;
+	mutable Common::Condition _prefetchDone;
+
+	uint32 _resourceCacheBudget; ///< Maximum size of the decompressed resource cache.
+
+	mutable ResourceCacheList _resourceCache;    ///< Decompressed resources.
+	mutable ResourceCacheMap  _resourceCacheMap; ///< Decompressed resources, indexed by key.
+	mutable uint32            _resourceCacheSize;
+
+	mutable uint64 _resourceCacheHits;
+	mutable uint64 _resourceCacheMisses;
+	mutable uint64 _resourceCacheEvictions;
+
+	mutable Common::Mutex _resourceCacheMutex;
+
 	FileTypeList _resourceTypeTypes[kResourceMAX]; ///< All valid resource type file types.
 
 
 	void clearResources();
 
 	Common::UString findArchive(const Common::UString &file,
-			const DirectoryList &dirs, const Common::FileList &files);
+			const DirectoryList &dirs, const Common::FileList &files) const;
 
 	ChangeID indexKEY(const Common::UString &file, uint32 priority);
+	ChangeID indexBIFs(const Common::UString &key, const std::vector<Common::UString> &bifs,
+	                   std::vector<BIFFile *> &bifFiles, uint32 priority);
 	ChangeID indexArchive(Archive *archive, uint32 priority, ChangeID &change);
+	ChangeID indexArchiveFile(ArchiveType type, const Common::UString &file, uint32 priority, Archive *archive = 0);
+	ChangeID indexBatchArchive(const BatchArchive &archive, BatchJob *job);
+
+	uint32 addArchiveSlot(Archive *archive, ArchiveType type, const Common::UString &path, ChangeID &change);
+	void indexResources(const Archive::ResourceList &resources, Common::HashAlgo hashAlgo,
+	                    uint32 archiveID, uint32 priority, ChangeID &change);
+
+	Archive *openArchive(ArchiveType type, const Common::UString &file) const;
+	Archive *getArchive(uint32 archiveID) const;
+
+	// Index cache helpers
+	void loadIndexCache();
+	const CachedArchive *getCachedArchive(ArchiveType type, const Common::UString &id) const;
+	void cacheArchive(ArchiveType type, const Common::UString &id,
+	                  const Common::UString &path, const Archive &archive);
 
 	// KEY/BIF loading helpers
-	void findBIFs   (const KEYFile &key, std::vector<Common::UString> &bifs);
-	void mergeKEYBIF(const KEYFile &key, std::vector<Common::UString> &bifs, std::vector<BIFFile *> &bifFiles);
+	void findBIFs   (const KEYFile &key, std::vector<Common::UString> &bifs) const;
+	void mergeKEYBIF(const KEYFile &key, std::vector<Common::UString> &bifs, std::vector<BIFFile *> &bifFiles) const;
+	void loadKEY    (const Common::UString &file, std::vector<Common::UString> &bifs,
+	                 std::vector<BIFFile *> &bifFiles) const;
+	bool getCachedKEY(const Common::UString &file, std::vector<const CachedArchive *> &bifs) const;
 
-	bool normalizeType(Resource &resource);
+	bool normalizeType(FileType &type);
 
 	inline uint64 getHash(const Common::UString &name, FileType type) const;
 	inline uint64 getHash(const Common::UString &name) const;
 
-	void addResource(Resource &resource, uint64 hash, ChangeID &change);
+	uint32 internString(const Common::UString &str);
+
+	// Hash table helpers
+	inline uint32 getHashPosition(uint64 hash) const;
+	uint32 findHashSlot(uint64 hash) const;
+	uint32 addHashSlot(uint64 hash);
+	void removeHashSlot(uint32 slot);
+	void growHashTable();
+
+	void addResource(const Common::UString &name, FileType type, uint32 priority,
+	                 uint32 archive, uint32 index, uint64 hash, ChangeID &change);
+	void removeResource(uint32 resource);
 
 	void addResources(const Common::FileList &files, ChangeID &change, uint32 priority);
 
@@ -361,12 +629,29 @@ private:
 	const Resource *getRes(const Common::UString &name, FileType type) const;
 
 	Common::SeekableReadStream *getArchiveResource(const Resource &res) const;
+	Common::SeekableReadStream *getResourceStream(const Resource &res) const;
+	Common::SeekableReadStream *openResourceFile(const Common::UString &path) const;
+
+	// Prefetch helpers
+	bool canPrefetch(const Resource &res) const;
+	void runPrefetch(PrefetchJob &job) const;
+	Common::SeekableReadStream *takePrefetch(const Resource &res) const;
+	Common::SeekableReadStream *takePrefetch(PrefetchJob &job) const;
+	void cancelPrefetches();
+
+	// Decompressed resource cache helpers
+	Common::SeekableReadStream *getCachedResource(uint32 archive, uint32 index) const;
+	Common::SeekableReadStream *cacheResource(uint32 archive, uint32 index,
+	                                          Common::SeekableReadStream *stream) const;
+	void evictResources() const;
+	void uncacheArchives(const std::vector<uint32> &archives);
+	void clearResourceCache();
 
 	uint32 getResourceSize(const Resource &res) const;
 
 	ChangeID newChangeSet();
 
-	void checkHashCollision(const Resource &resource, ResourceMap::const_iterator resList);
+	void checkHashCollision(const Common::UString &name, FileType type, uint32 slot) const;
 };
 
 } // End of namespace Aurora
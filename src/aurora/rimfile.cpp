@@ -25,6 +25,8 @@
 #include "src/common/stream.h"
 #include "src/common/util.h"
 #include "src/common/encoding.h"
+#include "src/common/mappedfile.h"
+#include "src/common/filepool.h"
 
 #include "src/aurora/rimfile.h"
 #include "src/aurora/error.h"
@@ -34,11 +36,17 @@ static const uint32 kVersion1  = MKTAG('V', '1', '.', '0');
 
 namespace Aurora {
 
-RIMFile::RIMFile(const Common::UString &fileName) : _fileName(fileName) {
+RIMFile::RIMFile(const Common::UString &fileName, bool mapped) : _fileName(fileName) {
 	load();
+
+	if (mapped)
+		map();
+
+	FilePoolMan.open(_fileName);
 }
 
 RIMFile::~RIMFile() {
+	FilePoolMan.close(_fileName);
 }
 
 void RIMFile::clear() {
@@ -118,20 +126,10 @@ Common::SeekableReadStream *RIMFile::getResource(uint32 index) const {
 	if (res.size == 0)
 		return new Common::MemoryReadStream(0, 0);
 
-	Common::File rim;
-	open(rim);
-
-	if (!rim.seek(res.offset))
-		throw Common::Exception(Common::kSeekError);
-
-	Common::SeekableReadStream *resStream = rim.readStream(res.size);
+	if (_mappedFile)
+		return new Common::MappedFileReadStream(_mappedFile, res.offset, res.size);
 
-	if (!resStream || (((uint32) resStream->size()) != res.size)) {
-		delete resStream;
-		throw Common::Exception(Common::kReadError);
-	}
-
-	return resStream;
+	return FilePoolMan.readStream(_fileName, res.offset, res.size);
 }
 
 void RIMFile::open(Common::File &file) const {
@@ -139,4 +137,13 @@ void RIMFile::open(Common::File &file) const {
 		throw Common::Exception(Common::kOpenError);
 }
 
+void RIMFile::map() {
+	_mappedFile.reset(new Common::MappedFile);
+
+	if (!_mappedFile->open(_fileName)) {
+		warning("Failed to map RIM \"%s\" into memory", _fileName.c_str());
+		_mappedFile.reset();
+	}
+}
+
 } // End of namespace Aurora
@@ -27,6 +27,8 @@
 
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 #include "src/common/file.h"
@@ -38,6 +40,7 @@
 namespace Common {
 	class SeekableReadStream;
 	class File;
+	class MappedFile;
 }
 
 namespace Aurora {
@@ -45,7 +48,12 @@ namespace Aurora {
 /** Class to hold resource data of a RIM file. */
 class RIMFile : public Archive, public AuroraBase {
 public:
-	RIMFile(const Common::UString &fileName);
+	/** Open a RIM file.
+	 *
+	 *  @param fileName The name of the RIM file.
+	 *  @param mapped Map the RIM into memory and return zero-copy resource streams?
+	 */
+	RIMFile(const Common::UString &fileName, bool mapped = false);
 	~RIMFile();
 
 	/** Clear the resource list. */
@@ -78,7 +86,11 @@ private:
 	/** The name of the RIM file. */
 	Common::UString _fileName;
 
+	/** The RIM file mapped into memory, if requested. */
+	boost::shared_ptr<Common::MappedFile> _mappedFile;
+
 	void open(Common::File &file) const;
+	void map();
 
 	void load();
 	void readResList(Common::SeekableReadStream &rim, uint32 offset);
@@ -149,6 +149,8 @@ const TalkTable::Entry *TalkTable::getEntry(uint32 strRef) {
 
 	Entry &entry = _entryList[strRef];
 
+	Common::StackLock lock(_mutex);
+
 	readString(entry);
 
 	return &entry;
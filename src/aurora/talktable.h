@@ -29,6 +29,7 @@
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/aurorafile.h"
 
@@ -89,6 +90,9 @@ private:
 
 	EntryList _entryList;
 
+	/** Guards reading the strings, which are only read on first access. */
+	Common::Mutex _mutex;
+
 	void load();
 
 	void readEntryTableV3();
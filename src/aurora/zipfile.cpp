@@ -32,8 +32,8 @@
 
 namespace Aurora {
 
-ZIPFile::ZIPFile(const Common::UString &fileName) : _zipFile(0) {
-	_zipFile = new Common::ZipFile(fileName);
+ZIPFile::ZIPFile(const Common::UString &fileName, bool mapped) : _zipFile(0) {
+	_zipFile = new Common::ZipFile(fileName, mapped);
 
 	load();
 }
@@ -58,6 +58,10 @@ Common::SeekableReadStream *ZIPFile::getResource(uint32 index) const {
 	return _zipFile->getFile(index);
 }
 
+bool ZIPFile::isResourceCompressed(uint32 index) const {
+	return _zipFile->isFileCompressed(index);
+}
+
 void ZIPFile::load() {
 	const Common::ZipFile::FileList &files = _zipFile->getFiles();
 	for (Common::ZipFile::FileList::const_iterator file = files.begin(); file != files.end(); ++file) {
@@ -44,7 +44,13 @@ namespace Aurora {
 /** A class encapsulating ZIP files for resource archive access. */
 class ZIPFile : public Archive {
 public:
-	ZIPFile(const Common::UString &fileName);
+	/** Open a ZIP archive.
+	 *
+	 *  @param fileName The ZIP file to open.
+	 *  @param mapped   Map the whole file into memory, so that uncompressed
+	 *                  resources can be read without copying.
+	 */
+	ZIPFile(const Common::UString &fileName, bool mapped = false);
 	~ZIPFile();
 
 	/** Clear the resource list. */
@@ -59,6 +65,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index) const;
 
+	/** Does the resource need to be decompressed when it's read? */
+	bool isResourceCompressed(uint32 index) const;
+
 private:
 	/** The actual zip file. */
 	Common::ZipFile *_zipFile;
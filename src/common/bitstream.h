@@ -25,7 +25,11 @@
 #ifndef COMMON_BITSTREAM_H
 #define COMMON_BITSTREAM_H
 
+#include <cstring>
+
 #include "src/common/types.h"
+#include "src/common/util.h"
+#include "src/common/endianness.h"
 #include "src/common/error.h"
 #include "src/common/stream.h"
 
@@ -58,6 +62,15 @@ public:
 	/** Read a multi-bit value from the bit stream. */
 	virtual uint32 getBits(uint8 n) = 0;
 
+	/** Read a multi-bit value from the bit stream, without changing the stream position.
+	 *
+	 *  Bits past the end of the stream are read as 0.
+	 */
+	virtual uint32 peekBits(uint8 n) = 0;
+
+	/** Does the bit stream hand out its bits in MSB to LSB order? */
+	virtual bool isMSBFirst() const = 0;
+
 	/** Add a bit to the value x, making it an n-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
@@ -193,6 +206,47 @@ public:
 		return v;
 	}
 
+	/** Read a multi-bit value from the bit stream, without changing the stream position. */
+	uint32 peekBits(uint8 n) {
+		if (n > 32)
+			throw Exception("Too many bits requested to be peeked");
+
+		if (n == 0)
+			return 0;
+
+		// Fast path: all requested bits are still in the current value
+		if ((_inValue != 0) && (n <= (valueBits - _inValue))) {
+			if (isMSB2LSB)
+				return (uint32) (_value >> (64 - n));
+
+			return (uint32) (_value & (0xFFFFFFFFFFFFFFFFULL >> (64 - n)));
+		}
+
+		const uint32 streamPos = _stream->pos();
+		const uint64 value     = _value;
+		const uint8  inValue   = _inValue;
+
+		const uint32 available = MIN<uint32>(n, size() - MIN(pos(), size()));
+
+		uint32 v = (available > 0) ? getBits(available) : 0;
+
+		// Pad the bits past the end of the stream with 0
+		if (isMSB2LSB && (available > 0) && (available < n))
+			v <<= n - available;
+
+		_stream->seek(streamPos);
+
+		_value   = value;
+		_inValue = inValue;
+
+		return v;
+	}
+
+	/** Does the bit stream hand out its bits in MSB to LSB order? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Add a bit to the value x, making it an n-bit value. */
 	void addBit(uint32 &x, uint32 n) {
 		if (isMSB2LSB)
@@ -211,8 +265,24 @@ public:
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+		while (n > 0) {
+			// Check if we need the next value
+			if (_inValue == 0)
+				readValue();
+
+			// Skip as many bits as we can within the current value
+			const uint32 count = MIN<uint32>(n, valueBits - _inValue);
+
+			if (count >= 64)
+				_value = 0;
+			else if (isMSB2LSB)
+				_value <<= count;
+			else
+				_value >>= count;
+
+			_inValue = (_inValue + count) % valueBits;
+			n       -= count;
+		}
 	}
 
 	/** Return the stream position in bits. */
@@ -234,6 +304,214 @@ public:
 	}
 };
 
+/**
+ * A template implementing a fast bit stream over a memory buffer.
+ *
+ * Unlike BitStreamImpl, this class does not derive from BitStream and
+ * has no virtual methods. It copies the data into its own buffer on
+ * construction and then assembles every read out of a 64-bit window
+ * loaded in one go from that buffer, so that getBits(), peekBits() and
+ * skip() are all cheap inline operations.
+ *
+ * The layout parameters are the same as for BitStreamImpl, except that
+ * only 8-, 16- and 32-bit values are supported.
+ */
+template<int valueBits, bool isLE, bool isMSB2LSB>
+class BitStreamMemoryImpl {
+private:
+	/** Padding at the end of the buffer, so that reading the window never overruns it. */
+	static const uint32 kPadding = 8;
+
+	byte  *_data; ///< The data, with kPadding bytes of zeros at the end.
+	uint32 _size; ///< The size of the data in bits.
+	uint32 _pos;  ///< The current position in bits.
+
+	/** Read a single data value. */
+	static inline uint64 readValue(const byte *data) {
+		if (valueBits == 8)
+			return *data;
+
+		if (isLE) {
+			if (valueBits == 16)
+				return READ_LE_UINT16(data);
+			if (valueBits == 32)
+				return READ_LE_UINT32(data);
+		} else {
+			if (valueBits == 16)
+				return READ_BE_UINT16(data);
+			if (valueBits == 32)
+				return READ_BE_UINT32(data);
+		}
+
+		return 0;
+	}
+
+	/** Read 64 bits, starting with the data value at this index.
+	 *
+	 *  For MSB to LSB, the first bit is at the window's MSB, otherwise it's at the LSB.
+	 */
+	inline uint64 readWindow(uint32 index) const {
+		const byte *data = _data + index * (valueBits / 8);
+
+		// Fast paths for layouts that correspond to a simple 64-bit load
+		if ( isMSB2LSB && ((valueBits == 8) || !isLE))
+			return READ_BE_UINT64(data);
+		if (!isMSB2LSB && ((valueBits == 8) ||  isLE))
+			return READ_LE_UINT64(data);
+
+		uint64 window = 0;
+		for (int i = 0; i < (64 / valueBits); i++, data += valueBits / 8) {
+			if (isMSB2LSB)
+				window |= readValue(data) << (64 - (i + 1) * valueBits);
+			else
+				window |= readValue(data) << (i * valueBits);
+		}
+
+		return window;
+	}
+
+	void checkLayout() const {
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
+			throw Exception("BitStreamMemory: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+	}
+
+	/** Copy this data into our own padded buffer. */
+	void setData(const byte *data, uint32 size) {
+		// Only whole data values are readable
+		size &= ~((uint32) ((valueBits >> 3) - 1));
+
+		_data = new byte[size + kPadding];
+		_size = size * 8;
+
+		if (size > 0)
+			std::memcpy(_data, data, size);
+
+		std::memset(_data + size, 0, kPadding);
+	}
+
+public:
+	/** Create a bit stream over a copy of this data. */
+	BitStreamMemoryImpl(const byte *data, uint32 size) : _data(0), _size(0), _pos(0) {
+		checkLayout();
+
+		setData(data, size);
+	}
+
+	/** Create a bit stream over a copy of the whole input data stream. */
+	BitStreamMemoryImpl(SeekableReadStream &stream) : _data(0), _size(0), _pos(0) {
+		checkLayout();
+
+		const uint32 size = stream.size();
+
+		byte *data = new byte[size];
+
+		try {
+			stream.seek(0);
+			if (stream.read(data, size) != size)
+				throw Exception(kReadError);
+
+			setData(data, size);
+
+		} catch (...) {
+			delete[] data;
+			throw;
+		}
+
+		delete[] data;
+	}
+
+	~BitStreamMemoryImpl() {
+		delete[] _data;
+	}
+
+	/** Read a multi-bit value from the bit stream, without changing the stream position.
+	 *
+	 *  Bits past the end of the stream are read as 0.
+	 */
+	inline uint32 peekBits(uint8 n) const {
+		assert(n <= 32);
+
+		// The bits past the end of the stream are the zeroed padding
+		if ((n == 0) || (_pos >= _size))
+			return 0;
+
+		const uint32 index  = _pos / valueBits;
+		const uint32 offset = _pos % valueBits;
+
+		const uint64 window = readWindow(index);
+
+		uint32 v;
+		if (isMSB2LSB)
+			v = (uint32) ((window << offset) >> (64 - n));
+		else
+			v = (uint32) ((window >> offset) & (0xFFFFFFFFFFFFFFFFULL >> (64 - n)));
+
+		return v;
+	}
+
+	/** Skip the specified amount of bits. */
+	inline void skip(uint32 n) {
+		if (n > (_size - _pos))
+			throw Exception("BitStreamMemory::skip(): End of bit stream reached");
+
+		_pos += n;
+	}
+
+	/** Read a multi-bit value from the bit stream. */
+	inline uint32 getBits(uint8 n) {
+		if (n > 32)
+			throw Exception("Too many bits requested to be read");
+
+		const uint32 v = peekBits(n);
+
+		skip(n);
+
+		return v;
+	}
+
+	/** Read a bit from the bit stream. */
+	inline uint32 getBit() {
+		return getBits(1);
+	}
+
+	/** Add a bit to the value x, making it an n-bit value. */
+	inline void addBit(uint32 &x, uint32 n) {
+		if (isMSB2LSB)
+			x = (x << 1) | getBit();
+		else
+			x = (x & ~(1 << n)) | (getBit() << n);
+	}
+
+	/** Does the bit stream hand out its bits in MSB to LSB order? */
+	inline bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
+	/** Rewind the bit stream back to the start. */
+	inline void rewind() {
+		_pos = 0;
+	}
+
+	/** Return the stream position in bits. */
+	inline uint32 pos() const {
+		return _pos;
+	}
+
+	/** Return the stream size in bits. */
+	inline uint32 size() const {
+		return _size;
+	}
+
+	inline bool eos() const {
+		return _pos >= _size;
+	}
+
+private:
+	// Not copyable
+	BitStreamMemoryImpl(const BitStreamMemoryImpl &);
+	BitStreamMemoryImpl &operator=(const BitStreamMemoryImpl &);
+};
+
 // typedefs for various memory layouts.
 
 /** 8-bit data, MSB to LSB. */
@@ -268,6 +546,29 @@ typedef BitStreamImpl<64, false, true > BitStream64BEMSB;
 /** 64-bit big-endian data, LSB to MSB. */
 typedef BitStreamImpl<64, false, false> BitStream64BELSB;
 
+/** 8-bit data in memory, MSB to LSB. */
+typedef BitStreamMemoryImpl<8, false, true > BitStreamMemory8MSB;
+/** 8-bit data in memory, LSB to MSB. */
+typedef BitStreamMemoryImpl<8, false, false> BitStreamMemory8LSB;
+
+/** 16-bit little-endian data in memory, MSB to LSB. */
+typedef BitStreamMemoryImpl<16, true , true > BitStreamMemory16LEMSB;
+/** 16-bit little-endian data in memory, LSB to MSB. */
+typedef BitStreamMemoryImpl<16, true , false> BitStreamMemory16LELSB;
+/** 16-bit big-endian data in memory, MSB to LSB. */
+typedef BitStreamMemoryImpl<16, false, true > BitStreamMemory16BEMSB;
+/** 16-bit big-endian data in memory, LSB to MSB. */
+typedef BitStreamMemoryImpl<16, false, false> BitStreamMemory16BELSB;
+
+/** 32-bit little-endian data in memory, MSB to LSB. */
+typedef BitStreamMemoryImpl<32, true , true > BitStreamMemory32LEMSB;
+/** 32-bit little-endian data in memory, LSB to MSB. */
+typedef BitStreamMemoryImpl<32, true , false> BitStreamMemory32LELSB;
+/** 32-bit big-endian data in memory, MSB to LSB. */
+typedef BitStreamMemoryImpl<32, false, true > BitStreamMemory32BEMSB;
+/** 32-bit big-endian data in memory, LSB to MSB. */
+typedef BitStreamMemoryImpl<32, false, false> BitStreamMemory32BELSB;
+
 } // End of namespace Common
 
 #endif // COMMON_BITSTREAM_H
@@ -56,6 +56,13 @@ public:
 	 */
 	static uint32 getFileSize(const UString &p);
 
+	/** Return a file's last modification time.
+	 *
+	 *  @param  p The file to look up.
+	 *  @return The modification time, as seconds since the epoch, or 0 if not a valid file.
+	 */
+	static uint64 getModificationTime(const UString &p);
+
 	/** Return a file name without its path.
 	 *
 	 *  Example: "/path/to/file.ext" > "file.ext"
@@ -0,0 +1,366 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounded pool of open read-only file handles.
+ */
+
+#include "src/common/system.h"
+
+#if defined(WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+
+#include <cassert>
+#include <cstring>
+
+#include "src/common/filepool.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/stream.h"
+
+DECLARE_SINGLETON(Common::FilePoolManager)
+
+namespace Common {
+
+FilePoolManager::FilePoolManager() : _maxHandles(kDefaultMaxHandles),
+	_hits(0), _misses(0), _opens(0), _evictions(0) {
+}
+
+FilePoolManager::~FilePoolManager() {
+	for (HandleList::iterator h = _handles.begin(); h != _handles.end(); ++h)
+		closeHandle(*h);
+
+	_handles.clear();
+	_handleMap.clear();
+}
+
+void FilePoolManager::setMaxHandles(uint32 maxHandles) {
+	StackLock lock(_mutex);
+
+	_maxHandles = MAX<uint32>(maxHandles, 1);
+
+	evict();
+}
+
+int32 FilePoolManager::size(const UString &fileName) {
+	Handle *handle = acquire(fileName);
+	if (!handle)
+		return -1;
+
+	uint32 fileSize = handle->size;
+
+	release(handle);
+	return fileSize;
+}
+
+uint32 FilePoolManager::read(const UString &fileName, uint32 offset, void *dataPtr, uint32 dataSize) {
+	Handle *handle = acquire(fileName);
+	if (!handle)
+		throw Exception(kOpenError);
+
+	uint32 n = 0;
+	try {
+		n = readHandle(*handle, offset, dataPtr, dataSize);
+	} catch (...) {
+		release(handle);
+		throw;
+	}
+
+	release(handle);
+	return n;
+}
+
+SeekableReadStream *FilePoolManager::readStream(const UString &fileName, uint32 offset, uint32 size) {
+	byte *data = new byte[size];
+
+	try {
+		if (read(fileName, offset, data, size) != size)
+			throw Exception(kReadError);
+	} catch (...) {
+		delete[] data;
+		throw;
+	}
+
+	return new MemoryReadStream(data, size, true);
+}
+
+void FilePoolManager::open(const UString &fileName) {
+	StackLock lock(_mutex);
+
+	_owners[fileName]++;
+}
+
+void FilePoolManager::close(const UString &fileName) {
+	StackLock lock(_mutex);
+
+	// Other owners still read from this file
+	OwnerMap::iterator o = _owners.find(fileName);
+	if ((o != _owners.end()) && (--o->second > 0))
+		return;
+
+	if (o != _owners.end())
+		_owners.erase(o);
+
+	HandleMap::iterator h = _handleMap.find(fileName);
+	if (h == _handleMap.end())
+		return;
+
+	Handle *handle = *h->second;
+
+	_handles.erase(h->second);
+	_handleMap.erase(h);
+
+	// Still in use, the last reader closes it
+	if (handle->users > 0) {
+		handle->orphaned = true;
+		return;
+	}
+
+	closeHandle(handle);
+}
+
+void FilePoolManager::clear() {
+	StackLock lock(_mutex);
+
+	HandleList::iterator h = _handles.begin();
+	while (h != _handles.end()) {
+		if ((*h)->users > 0) {
+			++h;
+			continue;
+		}
+
+		_handleMap.erase((*h)->fileName);
+		closeHandle(*h);
+
+		h = _handles.erase(h);
+	}
+}
+
+FilePoolManager::Statistics FilePoolManager::getStatistics() {
+	StackLock lock(_mutex);
+
+	Statistics stats;
+
+	stats.hits      = _hits;
+	stats.misses    = _misses;
+	stats.opens     = _opens;
+	stats.evictions = _evictions;
+
+	stats.openHandles = _handles.size();
+	stats.maxHandles  = _maxHandles;
+
+	return stats;
+}
+
+void FilePoolManager::resetStatistics() {
+	StackLock lock(_mutex);
+
+	_hits      = 0;
+	_misses    = 0;
+	_opens     = 0;
+	_evictions = 0;
+}
+
+FilePoolManager::Handle *FilePoolManager::acquire(const UString &fileName) {
+	StackLock lock(_mutex);
+
+	HandleMap::iterator h = _handleMap.find(fileName);
+	if (h != _handleMap.end()) {
+		_hits++;
+
+		// Move it to the front of the LRU list
+		_handles.splice(_handles.begin(), _handles, h->second);
+
+		Handle *handle = _handles.front();
+
+		handle->users++;
+		return handle;
+	}
+
+	_misses++;
+
+	Handle *handle = openHandle(fileName);
+	if (!handle)
+		return 0;
+
+	_opens++;
+
+	handle->users++;
+
+	_handles.push_front(handle);
+	_handleMap.insert(std::make_pair(fileName, _handles.begin()));
+
+	evict();
+
+	return handle;
+}
+
+void FilePoolManager::release(Handle *handle) {
+	StackLock lock(_mutex);
+
+	assert(handle->users > 0);
+
+	if ((--handle->users == 0) && handle->orphaned) {
+		closeHandle(handle);
+		return;
+	}
+
+	evict();
+}
+
+void FilePoolManager::evict() {
+	HandleList::iterator h = _handles.end();
+	while ((_handles.size() > _maxHandles) && (h != _handles.begin())) {
+		--h;
+
+		// Can't close a handle someone is still reading from
+		if ((*h)->users > 0)
+			continue;
+
+		_handleMap.erase((*h)->fileName);
+		closeHandle(*h);
+
+		h = _handles.erase(h);
+
+		_evictions++;
+	}
+}
+
+#if defined(WIN32)
+
+FilePoolManager::Handle *FilePoolManager::openHandle(const UString &fileName) {
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+	                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart > 0x7FFFFFFF)) {
+		CloseHandle(file);
+		return 0;
+	}
+
+	Handle *handle = new Handle;
+
+	handle->fileName = fileName;
+	handle->handle   = (void *) file;
+	handle->size     = (uint32) fileSize.QuadPart;
+	handle->users    = 0;
+	handle->orphaned = false;
+
+	return handle;
+}
+
+void FilePoolManager::closeHandle(Handle *handle) {
+	CloseHandle((HANDLE) handle->handle);
+
+	delete handle;
+}
+
+uint32 FilePoolManager::readHandle(Handle &handle, uint32 offset, void *dataPtr, uint32 dataSize) {
+	byte *data = (byte *) dataPtr;
+
+	uint32 n = 0;
+	while (n < dataSize) {
+		OVERLAPPED overlapped;
+		std::memset(&overlapped, 0, sizeof(overlapped));
+
+		overlapped.Offset = offset + n;
+
+		DWORD bytesRead = 0;
+		if (!ReadFile((HANDLE) handle.handle, data + n, dataSize - n, &bytesRead, &overlapped)) {
+			if (GetLastError() == ERROR_HANDLE_EOF)
+				break;
+
+			throw Exception(kReadError);
+		}
+
+		if (bytesRead == 0)
+			break;
+
+		n += bytesRead;
+	}
+
+	return n;
+}
+
+#else
+
+FilePoolManager::Handle *FilePoolManager::openHandle(const UString &fileName) {
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd == -1)
+		return 0;
+
+	struct stat fileStat;
+	if ((fstat(fd, &fileStat) != 0) || ((uint64) fileStat.st_size > 0x7FFFFFFF)) {
+		::close(fd);
+		return 0;
+	}
+
+	Handle *handle = new Handle;
+
+	handle->fileName = fileName;
+	handle->fd       = fd;
+	handle->size     = (uint32) fileStat.st_size;
+	handle->users    = 0;
+	handle->orphaned = false;
+
+	return handle;
+}
+
+void FilePoolManager::closeHandle(Handle *handle) {
+	::close(handle->fd);
+
+	delete handle;
+}
+
+uint32 FilePoolManager::readHandle(Handle &handle, uint32 offset, void *dataPtr, uint32 dataSize) {
+	byte *data = (byte *) dataPtr;
+
+	uint32 n = 0;
+	while (n < dataSize) {
+		ssize_t bytesRead = pread(handle.fd, data + n, dataSize - n, offset + n);
+		if (bytesRead < 0) {
+			if (errno == EINTR)
+				continue;
+
+			throw Exception(kReadError);
+		}
+
+		if (bytesRead == 0)
+			break;
+
+		n += bytesRead;
+	}
+
+	return n;
+}
+
+#endif
+
+} // End of namespace Common
@@ -0,0 +1,164 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounded pool of open read-only file handles.
+ */
+
+#ifndef COMMON_FILEPOOL_H
+#define COMMON_FILEPOOL_H
+
+#include <list>
+#include <map>
+
+#include "src/common/types.h"
+#include "src/common/singleton.h"
+#include "src/common/ustring.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+
+class SeekableReadStream;
+
+/** A pool of open file handles, shared by everything that repeatedly reads
+ *  from the same set of files (like the resource archives).
+ *
+ *  Files are kept open until the pool is full, at which point the least
+ *  recently used idle handle is closed. All reads are positional, i.e. they
+ *  don't move a shared file pointer, so several threads can read from the
+ *  same file at the same time.
+ */
+class FilePoolManager : public Singleton<FilePoolManager> {
+public:
+	/** Usage statistics of the pool. */
+	struct Statistics {
+		uint64 hits;      ///< Number of requests served by an already open handle.
+		uint64 misses;    ///< Number of requests that needed to open a new handle.
+		uint64 opens;     ///< Number of files successfully opened.
+		uint64 evictions; ///< Number of handles closed to make room for new ones.
+
+		uint32 openHandles; ///< Number of currently open handles.
+		uint32 maxHandles;  ///< Maximum number of idle handles kept open.
+	};
+
+	static const uint32 kDefaultMaxHandles = 32;
+
+	FilePoolManager();
+	~FilePoolManager();
+
+	/** Set the maximum number of handles kept open. */
+	void setMaxHandles(uint32 maxHandles);
+
+	/** Return the size of a file, or -1 if it can't be opened. */
+	int32 size(const UString &fileName);
+
+	/** Read data from an absolute offset within a file.
+	 *
+	 *  @param  fileName The file to read from.
+	 *  @param  offset   The offset within the file to start reading at.
+	 *  @param  dataPtr  The buffer to read into.
+	 *  @param  dataSize The number of bytes to read.
+	 *  @return The number of bytes actually read.
+	 */
+	uint32 read(const UString &fileName, uint32 offset, void *dataPtr, uint32 dataSize);
+
+	/** Read a range of a file into a new memory stream.
+	 *
+	 *  Throws an exception if the file can't be opened or the range can't be
+	 *  read completely.
+	 */
+	SeekableReadStream *readStream(const UString &fileName, uint32 offset, uint32 size);
+
+	/** Register an owner of this file, like an archive reading from it.
+	 *
+	 *  Every open() needs to be matched by a close().
+	 */
+	void open(const UString &fileName);
+	/** Unregister an owner of this file.
+	 *
+	 *  Once the last owner is gone, the handle is closed, as soon as nobody's
+	 *  reading from it anymore.
+	 */
+	void close(const UString &fileName);
+
+	/** Close all idle handles. */
+	void clear();
+
+	/** Return the current usage statistics. */
+	Statistics getStatistics();
+
+	/** Reset the hit, miss, open and eviction counters. */
+	void resetStatistics();
+
+private:
+	/** An open file. */
+	struct Handle {
+		UString fileName; ///< The name of the file.
+
+#if defined(WIN32)
+		void *handle;     ///< The Windows file handle.
+#else
+		int fd;           ///< The file descriptor.
+#endif
+
+		uint32 size;      ///< The size of the file.
+		uint32 users;     ///< Number of reads currently in progress.
+		bool orphaned;    ///< Was the handle removed from the pool while in use?
+	};
+
+	typedef std::list<Handle *> HandleList;
+	typedef std::map<UString, HandleList::iterator> HandleMap;
+	typedef std::map<UString, uint32> OwnerMap;
+
+	uint32 _maxHandles;
+
+	HandleList _handles; ///< All pooled handles, most recently used first.
+	HandleMap  _handleMap;
+
+	/** The number of owners of each file, independent of whether its handle is currently open. */
+	OwnerMap _owners;
+
+	uint64 _hits;
+	uint64 _misses;
+	uint64 _opens;
+	uint64 _evictions;
+
+	Mutex _mutex;
+
+	/** Get a handle for this file, opening it if necessary. */
+	Handle *acquire(const UString &fileName);
+	/** Signal that the handle isn't needed anymore. */
+	void release(Handle *handle);
+
+	/** Close idle handles until we're within the limit again. */
+	void evict();
+
+	static Handle *openHandle(const UString &fileName);
+	static void closeHandle(Handle *handle);
+
+	static uint32 readHandle(Handle &handle, uint32 offset, void *dataPtr, uint32 dataSize);
+};
+
+} // End of namespace Common
+
+/** Shortcut for accessing the file pool. */
+#define FilePoolMan Common::FilePoolManager::instance()
+
+#endif // COMMON_FILEPOOL_H
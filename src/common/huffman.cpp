@@ -24,14 +24,22 @@
 
 #include <cassert>
 
+#include <algorithm>
+
 #include "src/common/huffman.h"
 #include "src/common/util.h"
 #include "src/common/error.h"
-#include "src/common/bitstream.h"
 
 namespace Common {
 
-Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
+Huffman::TableEntry::TableEntry() : value(0), length(0) {
+}
+
+Huffman::Code::Code(uint32 c, uint8 l, uint32 i) : code(c), length(l), index(i) {
+}
+
+bool Huffman::Code::operator<(const Code &right) const {
+	return length < right.length;
 }
 
 
@@ -59,41 +67,106 @@ void Huffman::init(uint8 maxLength, uint32 codeCount, const uint32 *codes,
 
 	assert(maxLength <= 32);
 
-	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
 
+	CodeList codeList;
+	codeList.reserve(codeCount);
+
 	for (uint32 i = 0; i < codeCount; i++) {
 		// The symbol. If none were specified, just assume it's identical to the code index
-		uint32 symbol = symbols ? symbols[i] : i;
+		_symbols[i] = symbols ? symbols[i] : i;
 
-		// Put the code and symbol into the correct list
-		_codes[lengths[i] - 1].push_back(Symbol(codes[i], symbol));
-
-		// And put the pointer to the symbol/code struct into the symbol list.
-		_symbols[i] = &_codes[lengths[i] - 1].back();
+		if (lengths[i] > 0)
+			codeList.push_back(Code(codes[i], lengths[i], i));
 	}
+
+	// Shorter codes take precedence, and within one length, the first code does
+	std::stable_sort(codeList.begin(), codeList.end());
+
+	_tableBits = MAX<uint8>(MIN(maxLength, kTableBits), 1);
+
+	buildTable(_tableMSB, _tableBits, codeList, true);
+	buildTable(_tableLSB, _tableBits, codeList, false);
 }
 
 Huffman::~Huffman() {
 }
 
-void Huffman::setSymbols(const uint32 *symbols) {
-	for (uint32 i = 0; i < _symbols.size(); i++)
-		_symbols[i]->symbol = symbols ? *symbols++ : i;
-}
+uint32 Huffman::buildTable(Table &table, uint8 tableBits, const CodeList &codes, bool msbFirst) {
+	const uint32 offset = table.size();
+	const uint32 size   = 1 << tableBits;
+
+	table.resize(offset + size);
+
+	CodeList longCodes;
+
+	// Fill in all codes that fit completely into this table
+	for (CodeList::const_iterator c = codes.begin(); c != codes.end(); ++c) {
+		if (c->length > tableBits) {
+			longCodes.push_back(*c);
+			continue;
+		}
 
-uint32 Huffman::getSymbol(BitStream &bits) const {
-	uint32 code = 0;
+		// All table indices starting with this code resolve to it
+		const uint32 fill = 1 << (tableBits - c->length);
+		for (uint32 i = 0; i < fill; i++) {
+			const uint32 index = msbFirst ? ((c->code << (tableBits - c->length)) | i) :
+			                                (c->code | (i << c->length));
 
-	for (uint32 i = 0; i < _codes.size(); i++) {
-		bits.addBit(code, i);
+			TableEntry &entry = table[offset + (index & (size - 1))];
+			if (entry.length != 0)
+				continue;
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
+			entry.value  = c->index;
+			entry.length = c->length;
+		}
 	}
 
-	throw Exception("Unknown Huffman code");
+	// Group the longer codes by their prefix and put them into subtables
+	while (!longCodes.empty()) {
+		const Code  &first  = longCodes.front();
+		const uint32 prefix = msbFirst ? (first.code >> (first.length - tableBits)) :
+		                                 (first.code & (size - 1));
+
+		CodeList subCodes, otherCodes;
+		uint8 subMaxLength = 0;
+
+		for (CodeList::const_iterator c = longCodes.begin(); c != longCodes.end(); ++c) {
+			const uint32 cPrefix = msbFirst ? (c->code >> (c->length - tableBits)) :
+			                                  (c->code & (size - 1));
+
+			if (cPrefix != prefix) {
+				otherCodes.push_back(*c);
+				continue;
+			}
+
+			const uint8  subLength = c->length - tableBits;
+			const uint32 subCode   = msbFirst ? (c->code & (0xFFFFFFFF >> (32 - subLength))) :
+			                                    (c->code >> tableBits);
+
+			subCodes.push_back(Code(subCode, subLength, c->index));
+			subMaxLength = MAX(subMaxLength, subLength);
+		}
+
+		longCodes.swap(otherCodes);
+
+		// Is this prefix already taken by a shorter code? Then these codes are unreachable
+		if (table[offset + prefix].length != 0)
+			continue;
+
+		const uint8  subBits   = MIN(subMaxLength, kTableBits);
+		const uint32 subOffset = buildTable(table, subBits, subCodes, msbFirst);
+
+		table[offset + prefix].value  = subOffset;
+		table[offset + prefix].length = -((int8) subBits);
+	}
+
+	return offset;
+}
+
+void Huffman::setSymbols(const uint32 *symbols) {
+	for (uint32 i = 0; i < _symbols.size(); i++)
+		_symbols[i] = symbols ? *symbols++ : i;
 }
 
 } // End of namespace Common
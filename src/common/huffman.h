@@ -26,14 +26,12 @@
 #define COMMON_HUFFMAN_H
 
 #include <vector>
-#include <list>
 
 #include "src/common/types.h"
+#include "src/common/error.h"
 
 namespace Common {
 
-class BitStream;
-
 struct HuffmanTable {
 	uint8  maxLength; ///< Maximal code length. If 0, it's searched for.
 	uint32 codeCount; ///< Number of codes.
@@ -43,7 +41,19 @@ struct HuffmanTable {
 	const uint32 *symbols; ///< The symbols, 0 if identical to the codes.
 };
 
-/** Decode a Huffman'd bitstream. */
+/** Decode a Huffman'd bitstream.
+ *
+ *  The codes are resolved using multi-level lookup tables: the first
+ *  kTableBits bits of a code are peeked at once and used as an index
+ *  into the primary table. Codes longer than that are resolved by
+ *  following the primary table entry into a subtable.
+ *
+ *  Since the meaning of the codes depends on the order in which the
+ *  bit stream hands out its bits, tables for both MSB-first and
+ *  LSB-first bit streams are built.
+ *
+ *  Symbols can be read from both a BitStream and a BitStreamMemoryImpl.
+ */
 class Huffman {
 public:
 	/** Construct a Huffman decoder.
@@ -63,30 +73,83 @@ public:
 	void setSymbols(const uint32 *symbols = 0);
 
 	/** Return the next symbol in the bitstream. */
-	uint32 getSymbol(BitStream &bits) const;
+	template<class BitStreamType>
+	uint32 getSymbol(BitStreamType &bits) const;
 
 private:
-	struct Symbol {
-		uint32 code;
-		uint32 symbol;
+	/** Maximum number of bits looked up at once in a single table. */
+	static const uint8 kTableBits = 9;
+
+	/** An entry in a lookup table. */
+	struct TableEntry {
+		/** Code index if length > 0, offset of the subtable if length < 0. */
+		uint32 value;
+		/** Code length if > 0, negated subtable bits if < 0, invalid code if 0. */
+		int8 length;
+
+		TableEntry();
+	};
+
+	/** A code, as seen during the building of a lookup table. */
+	struct Code {
+		uint32 code;   ///< The (remaining) code.
+		uint8  length; ///< The (remaining) length of the code.
+		uint32 index;  ///< The index of the code.
+
+		Code(uint32 c, uint8 l, uint32 i);
 
-		Symbol(uint32 c, uint32 s);
+		bool operator<(const Code &right) const;
 	};
 
-	typedef std::list<Symbol>     CodeList;
-	typedef std::vector<CodeList> CodeLists;
-	typedef std::vector<Symbol *> SymbolList;
+	typedef std::vector<TableEntry> Table;
+	typedef std::vector<Code>       CodeList;
 
-	/** Lists of codes and their symbols, sorted by code length. */
-	CodeLists _codes;
+	/** Number of bits in the primary lookup table. */
+	uint8 _tableBits;
 
-	/** Sorted list of pointers to the symbols. */
-	SymbolList _symbols;
+	/** Lookup tables for bit streams handing out bits MSB to LSB. */
+	Table _tableMSB;
+	/** Lookup tables for bit streams handing out bits LSB to MSB. */
+	Table _tableLSB;
+
+	/** The symbols, in code index order. */
+	std::vector<uint32> _symbols;
 
 	void init(uint8 maxLength, uint32 codeCount, const uint32 *codes,
 	          const uint8 *lengths, const uint32 *symbols);
+
+	/** Build a lookup table (and its subtables) for these codes, returning its offset. */
+	static uint32 buildTable(Table &table, uint8 tableBits, const CodeList &codes, bool msbFirst);
 };
 
+template<class BitStreamType>
+uint32 Huffman::getSymbol(BitStreamType &bits) const {
+	const Table &table = bits.isMSBFirst() ? _tableMSB : _tableLSB;
+
+	uint32 offset    = 0;
+	uint8  tableBits = _tableBits;
+
+	while (true) {
+		const TableEntry &entry = table[offset + bits.peekBits(tableBits)];
+
+		if (entry.length > 0) {
+			bits.skip(entry.length);
+			return _symbols[entry.value];
+		}
+
+		if (entry.length == 0)
+			break;
+
+		// Descend into the subtable
+		bits.skip(tableBits);
+
+		offset    = entry.value;
+		tableBits = -entry.length;
+	}
+
+	throw Exception("Unknown Huffman code");
+}
+
 } // End of namespace Common
 
 #endif // COMMON_HUFFMAN_H
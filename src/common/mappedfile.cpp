@@ -0,0 +1,184 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Read-only memory-mapped files.
+ */
+
+#include "src/common/system.h"
+
+#if defined(WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include "src/common/mappedfile.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+
+namespace Common {
+
+#if defined(WIN32)
+MappedFile::MappedFile() : _data(0), _size(0), _isOpen(false),
+	_fileHandle(INVALID_HANDLE_VALUE), _mappingHandle(0) {
+}
+#else
+MappedFile::MappedFile() : _data(0), _size(0), _isOpen(false) {
+}
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+#if defined(WIN32)
+
+bool MappedFile::open(const UString &fileName) {
+	close();
+
+	_fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+	                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (_fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_fileHandle, &fileSize) || (fileSize.QuadPart > 0xFFFFFFFF)) {
+		close();
+		return false;
+	}
+
+	_size = (uint32) fileSize.QuadPart;
+
+	// Empty files can't be mapped, but are perfectly valid
+	if (_size > 0) {
+		_mappingHandle = CreateFileMappingA(_fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+		if (!_mappingHandle) {
+			close();
+			return false;
+		}
+
+		_data = (const byte *) MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (!_data) {
+			close();
+			return false;
+		}
+	}
+
+	_isOpen = true;
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data)
+		UnmapViewOfFile(_data);
+
+	if (_mappingHandle)
+		CloseHandle(_mappingHandle);
+
+	if (_fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(_fileHandle);
+
+	_data          = 0;
+	_size          = 0;
+	_isOpen        = false;
+	_fileHandle    = INVALID_HANDLE_VALUE;
+	_mappingHandle = 0;
+}
+
+#else
+
+bool MappedFile::open(const UString &fileName) {
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat fileStat;
+	if ((fstat(fd, &fileStat) != 0) || ((uint64) fileStat.st_size > 0xFFFFFFFF)) {
+		::close(fd);
+		return false;
+	}
+
+	_size = (uint32) fileStat.st_size;
+
+	// Empty files can't be mapped, but are perfectly valid
+	if (_size > 0) {
+		void *data = mmap(0, _size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+
+			_size = 0;
+			return false;
+		}
+
+		_data = (const byte *) data;
+	}
+
+	// The mapping stays valid after closing the file descriptor
+	::close(fd);
+
+	_isOpen = true;
+	return true;
+}
+
+void MappedFile::close() {
+	if (_data)
+		munmap(const_cast<byte *>(_data), _size);
+
+	_data   = 0;
+	_size   = 0;
+	_isOpen = false;
+}
+
+#endif
+
+bool MappedFile::isOpen() const {
+	return _isOpen;
+}
+
+uint32 MappedFile::size() const {
+	return _size;
+}
+
+const byte *MappedFile::getData() const {
+	return _data;
+}
+
+
+MappedFileReadStream::MappedFileReadStream(const boost::shared_ptr<MappedFile> &file,
+                                           uint32 offset, uint32 size) :
+	MemoryReadStream(file->getData() + offset, size), _file(file) {
+
+	if (((uint64) offset + size) > file->size())
+		throw Exception("MappedFileReadStream: Range out of bounds (%u + %u > %u)",
+		                offset, size, file->size());
+}
+
+MappedFileReadStream::~MappedFileReadStream() {
+}
+
+} // End of namespace Common
@@ -0,0 +1,91 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Read-only memory-mapped files.
+ */
+
+#ifndef COMMON_MAPPEDFILE_H
+#define COMMON_MAPPEDFILE_H
+
+#include <boost/shared_ptr.hpp>
+
+#include "src/common/types.h"
+#include "src/common/stream.h"
+#include "src/common/noncopyable.h"
+
+namespace Common {
+
+class UString;
+
+/** A file mapped read-only into memory as a whole. */
+class MappedFile : public NonCopyable {
+public:
+	MappedFile();
+	~MappedFile();
+
+	/** Try to map the file with the given fileName into memory.
+	 *
+	 *  @param  fileName the name of the file to map.
+	 *  @return true if the file was mapped successfully, false otherwise.
+	 */
+	bool open(const UString &fileName);
+
+	/** Unmap the file, if mapped. */
+	void close();
+
+	/** Was the file mapped successfully? */
+	bool isOpen() const;
+
+	/** Return the size of the mapped file. */
+	uint32 size() const;
+
+	/** Return the mapped file's data. */
+	const byte *getData() const;
+
+private:
+	const byte *_data; ///< The mapped data.
+	uint32      _size; ///< The size of the mapped data.
+
+	bool _isOpen;
+
+#if defined(WIN32)
+	void *_fileHandle;    ///< The file's handle.
+	void *_mappingHandle; ///< The file mapping object's handle.
+#endif
+};
+
+/** A zero-copy read stream over a part of a memory-mapped file.
+ *
+ *  The stream shares the ownership of the mapping, so the mapped
+ *  file stays valid for as long as the stream exists.
+ */
+class MappedFileReadStream : public MemoryReadStream {
+public:
+	MappedFileReadStream(const boost::shared_ptr<MappedFile> &file, uint32 offset, uint32 size);
+	~MappedFileReadStream();
+
+private:
+	boost::shared_ptr<MappedFile> _file;
+};
+
+} // End of namespace Common
+
+#endif // COMMON_MAPPEDFILE_H
@@ -83,6 +83,7 @@ public:
 
 	bool wait(uint32 timeout = 0);
 	void signal();
+	void broadcast();
 
 private:
 	bool _ownMutex;
@@ -44,9 +44,14 @@ bool Thread::createThread() {
 		// Already running, nothing to do
 		return true;
 
+	// Mark the thread as running already, so that an immediate destroyThread() waits for it
+	_threadRunning = true;
+
 	// Try to create the thread
-	if (!(_thread = SDL_CreateThread(threadHelper, 0, (void *) this)))
+	if (!(_thread = SDL_CreateThread(threadHelper, 0, (void *) this))) {
+		_threadRunning = false;
 		return false;
+	}
 
 	return true;
 }
@@ -0,0 +1,145 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A pool of worker threads.
+ */
+
+#include <SDL_cpuinfo.h>
+
+#include "src/common/threadpool.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+ThreadPool::Job::~Job() {
+}
+
+
+ThreadPool::Worker::Worker(ThreadPool &pool) : _pool(&pool) {
+}
+
+ThreadPool::Worker::~Worker() {
+	destroyThread();
+}
+
+void ThreadPool::Worker::threadMethod() {
+	while (!_killThread) {
+		Job *job = _pool->takeJob();
+		if (job)
+			_pool->runJob(*job);
+	}
+}
+
+
+ThreadPool::ThreadPool(uint32 threadCount) : _pendingJobs(0),
+	_jobAdded(_mutex), _jobsFinished(_mutex) {
+
+	if (threadCount == 0)
+		threadCount = getCPUCount();
+
+	_workers.reserve(threadCount);
+	for (uint32 i = 0; i < threadCount; i++) {
+		Worker *worker = new Worker(*this);
+
+		if (!worker->createThread()) {
+			delete worker;
+			break;
+		}
+
+		_workers.push_back(worker);
+	}
+
+	if (_workers.empty())
+		throw Exception("Failed to create any worker threads");
+}
+
+ThreadPool::~ThreadPool() {
+	_mutex.lock();
+
+	_pendingJobs -= _jobs.size();
+	_jobs.clear();
+
+	_mutex.unlock();
+
+	wait();
+
+	for (std::vector<Worker *>::iterator w = _workers.begin(); w != _workers.end(); ++w)
+		delete *w;
+}
+
+uint32 ThreadPool::getThreadCount() const {
+	return _workers.size();
+}
+
+void ThreadPool::addJob(Job &job) {
+	StackLock lock(_mutex);
+
+	_jobs.push_back(&job);
+	_pendingJobs++;
+
+	_jobAdded.signal();
+}
+
+void ThreadPool::wait() {
+	StackLock lock(_mutex);
+
+	// The timeout guards against a missed signal
+	while (_pendingJobs > 0)
+		_jobsFinished.wait(100);
+}
+
+uint32 ThreadPool::getCPUCount() {
+	return MAX(SDL_GetCPUCount(), 1);
+}
+
+ThreadPool::Job *ThreadPool::takeJob() {
+	StackLock lock(_mutex);
+
+	// Wake up now and then, to check whether the worker should quit
+	if (_jobs.empty())
+		_jobAdded.wait(100);
+
+	if (_jobs.empty())
+		return 0;
+
+	Job *job = _jobs.front();
+	_jobs.pop_front();
+
+	return job;
+}
+
+void ThreadPool::runJob(Job &job) {
+	try {
+		job.run();
+	} catch (Exception &e) {
+		printException(e, "WARNING: ");
+	} catch (...) {
+		warning("ThreadPool::runJob(): Unknown exception in job");
+	}
+
+	StackLock lock(_mutex);
+
+	if (--_pendingJobs == 0)
+		_jobsFinished.signal();
+}
+
+} // End of namespace Common
@@ -0,0 +1,105 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A pool of worker threads.
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include <list>
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/noncopyable.h"
+#include "src/common/thread.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+
+/** A fixed number of worker threads running queued jobs.
+ *
+ *  Jobs are run in the order they were added, but several of them at the
+ *  same time, so they may finish in any order. The jobs are owned by the
+ *  caller, which has to keep them alive until they are finished.
+ */
+class ThreadPool : NonCopyable {
+public:
+	/** A job to be run by the thread pool. */
+	class Job {
+	public:
+		virtual ~Job();
+
+		/** Do the job's work. Called in one of the worker threads. */
+		virtual void run() = 0;
+	};
+
+	/** Create a thread pool.
+	 *
+	 *  @param threadCount The number of worker threads. 0 means one per CPU core.
+	 */
+	ThreadPool(uint32 threadCount = 0);
+	/** Discard all jobs that haven't been started yet and wait for the running ones. */
+	~ThreadPool();
+
+	/** Return the number of worker threads. */
+	uint32 getThreadCount() const;
+
+	/** Queue a job. */
+	void addJob(Job &job);
+
+	/** Wait until all queued jobs are finished. */
+	void wait();
+
+	/** Return the number of CPU cores. */
+	static uint32 getCPUCount();
+
+private:
+	/** A worker thread. */
+	class Worker : public Thread {
+	public:
+		Worker(ThreadPool &pool);
+		~Worker();
+
+	private:
+		ThreadPool *_pool;
+
+		void threadMethod();
+	};
+
+	std::vector<Worker *> _workers;
+
+	std::list<Job *> _jobs; ///< Jobs that haven't been started yet.
+	uint32 _pendingJobs;    ///< Jobs that haven't been finished yet.
+
+	Mutex     _mutex;
+	Condition _jobAdded;
+	Condition _jobsFinished;
+
+	/** Take the next job out of the queue, waiting for one if necessary. */
+	Job *takeJob();
+	/** Run the job and mark it as finished. */
+	void runJob(Job &job);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_THREADPOOL_H
@@ -0,0 +1,439 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A hierarchical timer wheel.
+ */
+
+#ifndef COMMON_TIMERWHEEL_H
+#define COMMON_TIMERWHEEL_H
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "src/common/types.h"
+#include "src/common/util.h"
+#include "src/common/noncopyable.h"
+
+namespace Common {
+
+/** A scheduler for payloads that become due at a certain millisecond timestamp.
+ *
+ *  Inserting, cancelling and expiring a payload are all constant-time operations.
+ *  The first level of the wheel has one slot per millisecond; each of the three
+ *  levels above covers 64 times the range of the one below, so that payloads up
+ *  to about 18 hours into the future are sorted in directly. Payloads further out
+ *  are parked in the last slot and re-sorted when the wheel reaches it.
+ *
+ *  The payloads are stored in a pool that never moves them and that recycles the
+ *  memory of expired payloads. They are moved in and out with their swap() method,
+ *  so they are never copied. Payloads due at the same time expire in the order
+ *  they were inserted.
+ *
+ *  Timestamps are expected to be monotonic, for example EventMan.getTimestamp().
+ */
+template<typename T>
+class TimerWheel : NonCopyable {
+public:
+	/** Identifies an inserted payload. Never 0. */
+	typedef uint64 Handle;
+
+	static const Handle kInvalidHandle = 0;
+
+	TimerWheel() : _time(0), _size(0), _level0Size(0), _sequence(0) {
+		for (uint32 i = 0; i < kListCount; i++)
+			_lists[i].head = _lists[i].tail = kNil;
+	}
+
+	~TimerWheel() {
+	}
+
+	/** Is no payload pending? */
+	bool empty() const {
+		return _size == 0;
+	}
+
+	/** Return the number of pending payloads. */
+	size_t size() const {
+		return _size;
+	}
+
+	/** Remove all pending payloads.
+	 *
+	 *  The pool is kept, so that handles from before never match a payload inserted afterwards.
+	 */
+	void clear() {
+		for (uint32 i = 0; i < kListCount; i++)
+			_lists[i].head = _lists[i].tail = kNil;
+
+		for (uint32 i = 0; i < _nodes.size(); i++) {
+			Node &node = _nodes[i];
+			if (!node.active)
+				continue;
+
+			node.list = node.prev = node.next = kNil;
+			release(i);
+		}
+
+		_level0Size = 0;
+	}
+
+	/** Schedule a payload to become due delay milliseconds after now.
+	 *
+	 *  The payload is moved into the wheel; the variable passed in is left holding
+	 *  a default-constructed value.
+	 */
+	Handle insert(uint32 now, uint32 delay, T &payload) {
+		// With nothing pending, there's nothing to catch up on either
+		if (_size == 0)
+			_time = now;
+
+		uint32 index;
+		if (!_free.empty()) {
+			index = _free.back();
+			_free.pop_back();
+		} else {
+			index = _nodes.size();
+			_nodes.push_back(Node());
+		}
+
+		Node &node = _nodes[index];
+
+		node.payload.swap(payload);
+
+		node.expiry   = now + delay;
+		node.sequence = _sequence++;
+		node.active   = true;
+
+		place(index);
+		_size++;
+
+		return makeHandle(index, node.generation);
+	}
+
+	/** Cancel a payload that hasn't been taken out yet, even if it's already due.
+	 *
+	 *  Returns false if the payload has already been taken out or cancelled.
+	 */
+	bool cancel(Handle handle) {
+		const uint32 index = (uint32) (handle & 0xFFFFFFFF);
+		if ((handle == kInvalidHandle) || (index >= _nodes.size()))
+			return false;
+
+		Node &node = _nodes[index];
+		if (!node.active || (node.generation != (uint32) (handle >> 32)))
+			return false;
+
+		unlink(index);
+		release(index);
+
+		return true;
+	}
+
+	/** Find the timestamp the next payload becomes due at. Returns false if none is pending. */
+	bool getNextDue(uint32 &timestamp) const {
+		if (_size == 0)
+			return false;
+
+		if (_lists[kListDue].head != kNil) {
+			timestamp = _time;
+			return true;
+		}
+
+		uint32 earliest = kNil;
+
+		// A payload in the first level is due exactly at its slot's time
+		for (uint32 i = 1; i < kLevel0Size; i++) {
+			if (_lists[(_time + i) & kLevel0Mask].head != kNil) {
+				earliest = i;
+				break;
+			}
+		}
+
+		/* In the levels above, the next occupied slot holds the earliest payload of that
+		 * level. These can still be due before the ones in the levels below, though. */
+		for (uint32 level = 1; level < kLevelCount; level++) {
+			const uint32 shift = getLevelShift(level);
+			const uint32 base  = getLevelBase(level);
+
+			for (uint32 i = 1; i <= kLevelSize; i++) {
+				uint32 n = _lists[base + (((_time >> shift) + i) & kLevelMask)].head;
+				if (n == kNil)
+					continue;
+
+				for (; n != kNil; n = _nodes[n].next)
+					earliest = MIN(earliest, _nodes[n].expiry - _time);
+
+				break;
+			}
+		}
+
+		timestamp = _time + earliest;
+		return true;
+	}
+
+	/** Take out the next payload that became due at or before now.
+	 *
+	 *  Returns false if no payload is due yet. Payloads inserted while draining the
+	 *  wheel with a delay of 0 become due in the same pass.
+	 */
+	bool popDue(uint32 now, T &payload) {
+		while ((_lists[kListDue].head == kNil) && (_size > 0) && ((int32) (now - _time) > 0)) {
+			// Nothing can expire before the next slot of the second level is pulled down
+			if (_level0Size == 0) {
+				const uint32 skip = MIN<uint32>(kLevel0Mask - (_time & kLevel0Mask), now - _time);
+
+				_time += skip;
+				if (_time == now)
+					break;
+			}
+
+			advance();
+		}
+
+		if (_size == 0)
+			_time = now;
+
+		const uint32 index = _lists[kListDue].head;
+		if (index == kNil)
+			return false;
+
+		unlink(index);
+
+		payload.swap(_nodes[index].payload);
+		release(index);
+
+		return true;
+	}
+
+private:
+	static const uint32 kNil = 0xFFFFFFFF;
+
+	static const uint32 kLevel0Bits = 8;
+	static const uint32 kLevel0Size = 1 << kLevel0Bits;
+	static const uint32 kLevel0Mask = kLevel0Size - 1;
+	static const uint32 kLevelBits  = 6;
+	static const uint32 kLevelSize  = 1 << kLevelBits;
+	static const uint32 kLevelMask  = kLevelSize - 1;
+	static const uint32 kLevelCount = 4;
+
+	/** The farthest into the future a payload can be sorted in directly. */
+	static const uint32 kMaxDelay = (1 << (kLevel0Bits + (kLevelCount - 1) * kLevelBits)) - 1;
+
+	/** All wheel slots, followed by the list of due payloads. */
+	static const uint32 kListCount = kLevel0Size + (kLevelCount - 1) * kLevelSize + 1;
+	static const uint32 kListDue   = kListCount - 1;
+
+	struct Node {
+		T payload;
+
+		uint32 expiry;
+		uint32 sequence;
+		uint32 generation;
+
+		bool active;
+
+		uint32 list;
+		uint32 prev;
+		uint32 next;
+
+		Node() : expiry(0), sequence(0), generation(1), active(false), list(kNil), prev(kNil), next(kNil) {
+		}
+	};
+
+	struct List {
+		uint32 head;
+		uint32 tail;
+	};
+
+	/** Orders payloads that became due at the same time. */
+	struct SequenceSort {
+		const std::deque<Node> *nodes;
+
+		SequenceSort(const std::deque<Node> &n) : nodes(&n) {
+		}
+
+		bool operator()(uint32 a, uint32 b) const {
+			return (int32) ((*nodes)[a].sequence - (*nodes)[b].sequence) < 0;
+		}
+	};
+
+	uint32 _time; ///< The time the wheel has advanced to.
+	size_t _size; ///< The number of pending payloads.
+
+	uint32 _level0Size; ///< The number of payloads in the first level.
+
+	uint32 _sequence; ///< The insertion counter.
+
+	std::deque<Node>    _nodes; ///< The payload pool, growing without moving.
+	std::vector<uint32> _free;  ///< Unused nodes within the pool.
+
+	List _lists[kListCount];
+
+	std::vector<uint32> _expired; ///< Scratch space for ordering the payloads of a slot.
+
+
+	static Handle makeHandle(uint32 index, uint32 generation) {
+		return (((Handle) generation) << 32) | index;
+	}
+
+	static uint32 getLevelShift(uint32 level) {
+		return kLevel0Bits + (level - 1) * kLevelBits;
+	}
+
+	static uint32 getLevelBase(uint32 level) {
+		return kLevel0Size + (level - 1) * kLevelSize;
+	}
+
+	/** Sort a node into the wheel slot matching its expiry time. */
+	void place(uint32 index) {
+		const uint32 expiry = _nodes[index].expiry;
+		const uint32 delay  = expiry - _time;
+
+		if ((delay == 0) || ((int32) delay < 0)) {
+			link(index, kListDue);
+			return;
+		}
+
+		if (delay < kLevel0Size) {
+			link(index, expiry & kLevel0Mask);
+			return;
+		}
+
+		for (uint32 level = 1; level < kLevelCount; level++) {
+			const uint32 shift = getLevelShift(level);
+
+			if ((delay >> shift) < kLevelSize) {
+				link(index, getLevelBase(level) + ((expiry >> shift) & kLevelMask));
+				return;
+			}
+		}
+
+		// Too far into the future: park it in the last slot to be reached
+		const uint32 shift = getLevelShift(kLevelCount - 1);
+
+		link(index, getLevelBase(kLevelCount - 1) + (((_time + kMaxDelay) >> shift) & kLevelMask));
+	}
+
+	/** Re-sort all nodes of a slot of a higher level. */
+	void cascade(uint32 level) {
+		const uint32 list = getLevelBase(level) + ((_time >> getLevelShift(level)) & kLevelMask);
+
+		uint32 index = _lists[list].head;
+
+		_lists[list].head = _lists[list].tail = kNil;
+
+		while (index != kNil) {
+			const uint32 next = _nodes[index].next;
+
+			place(index);
+
+			index = next;
+		}
+	}
+
+	/** Advance the wheel by one millisecond, expiring the payloads that became due. */
+	void advance() {
+		_time++;
+
+		// Whenever a lower level wraps around, pull down the next slot of the level above
+		for (uint32 level = 1; level < kLevelCount; level++) {
+			if ((_time & ((1 << getLevelShift(level)) - 1)) != 0)
+				break;
+
+			cascade(level);
+		}
+
+		const uint32 list = _time & kLevel0Mask;
+		if (_lists[list].head == kNil)
+			return;
+
+		_expired.clear();
+		for (uint32 index = _lists[list].head; index != kNil; index = _nodes[index].next)
+			_expired.push_back(index);
+
+		_lists[list].head = _lists[list].tail = kNil;
+		_level0Size      -= _expired.size();
+
+		// Nodes pulled down from a higher level might have been inserted earlier
+		std::sort(_expired.begin(), _expired.end(), SequenceSort(_nodes));
+
+		for (std::vector<uint32>::const_iterator e = _expired.begin(); e != _expired.end(); ++e)
+			link(*e, kListDue);
+	}
+
+	void link(uint32 index, uint32 list) {
+		Node &node = _nodes[index];
+
+		if (list < kLevel0Size)
+			_level0Size++;
+
+		node.list = list;
+		node.prev = _lists[list].tail;
+		node.next = kNil;
+
+		if (_lists[list].tail != kNil)
+			_nodes[_lists[list].tail].next = index;
+		else
+			_lists[list].head = index;
+
+		_lists[list].tail = index;
+	}
+
+	void unlink(uint32 index) {
+		Node &node = _nodes[index];
+
+		if (node.list < kLevel0Size)
+			_level0Size--;
+
+		if (node.prev != kNil)
+			_nodes[node.prev].next = node.next;
+		else
+			_lists[node.list].head = node.next;
+
+		if (node.next != kNil)
+			_nodes[node.next].prev = node.prev;
+		else
+			_lists[node.list].tail = node.prev;
+
+		node.list = node.prev = node.next = kNil;
+	}
+
+	/** Return a node to the pool. */
+	void release(uint32 index) {
+		Node &node = _nodes[index];
+
+		// Drop whatever the payload still holds
+		T().swap(node.payload);
+
+		node.active = false;
+		node.generation++;
+		if (node.generation == 0)
+			node.generation = 1;
+
+		_free.push_back(index);
+		_size--;
+	}
+};
+
+} // End of namespace Common
+
+#endif // COMMON_TIMERWHEEL_H
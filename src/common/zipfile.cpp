@@ -30,16 +30,26 @@
 #include "src/common/encoding.h"
 #include "src/common/stream.h"
 #include "src/common/file.h"
+#include "src/common/mappedfile.h"
+#include "src/common/filepool.h"
+
+#include <cstring>
 
 #include <zlib.h>
 
 namespace Common {
 
-ZipFile::ZipFile(const UString &fileName) : _fileName(fileName) {
+ZipFile::ZipFile(const UString &fileName, bool mapped) : _fileName(fileName) {
 	load();
+
+	if (mapped)
+		map();
+
+	FilePoolMan.open(_fileName);
 }
 
 ZipFile::~ZipFile() {
+	FilePoolMan.close(_fileName);
 }
 
 void ZipFile::clear() {
@@ -82,7 +92,11 @@ void ZipFile::load() {
 		 File  file;
 		IFile iFile;
 
-		zip.skip(20);
+		zip.skip(6);
+
+		iFile.compMethod = zip.readUint16LE();
+
+		zip.skip(12);
 
 		iFile.size = zip.readUint32LE();
 
@@ -137,11 +151,14 @@ const ZipFile::IFile &ZipFile::getIFile(uint32 index) const {
 	return _iFiles[index];
 }
 
-void ZipFile::getFileProperties(Common::SeekableReadStream &zip, const IFile &file,
-		uint16 &compMethod, uint32 &compSize, uint32 &realSize) const {
+void ZipFile::getFileProperties(const IFile &file, uint16 &compMethod,
+		uint32 &compSize, uint32 &realSize, uint32 &dataOffset) const {
 
-	if (!zip.seek(file.offset))
-		throw Exception(kSeekError);
+	byte header[kLocalHeaderSize];
+	if (readData(file.offset, header, kLocalHeaderSize) != kLocalHeaderSize)
+		throw Exception(kReadError);
+
+	MemoryReadStream zip(header, kLocalHeaderSize);
 
 	uint32 tag = zip.readUint32LE();
 	if (tag != 0x04034B50)
@@ -159,41 +176,79 @@ void ZipFile::getFileProperties(Common::SeekableReadStream &zip, const IFile &fi
 	uint16 nameLength  = zip.readUint16LE();
 	uint16 extraLength = zip.readUint16LE();
 
-	zip.skip(nameLength);
-	zip.skip(extraLength);
+	dataOffset = file.offset + kLocalHeaderSize + nameLength + extraLength;
+}
 
-	if (zip.err())
-		throw Exception(kReadError);
+uint32 ZipFile::readData(uint32 offset, byte *data, uint32 size) const {
+	if (!_mappedFile)
+		return FilePoolMan.read(_fileName, offset, data, size);
+
+	if (offset >= _mappedFile->size())
+		return 0;
+
+	size = MIN<uint32>(size, _mappedFile->size() - offset);
+	std::memcpy(data, _mappedFile->getData() + offset, size);
+
+	return size;
 }
 
 uint32 ZipFile::getFileSize(uint32 index) const {
 	const IFile &file = getIFile(index);
 
-	Common::File zip;
-	open(zip);
-
 	uint16 compMethod;
 	uint32 compSize;
 	uint32 realSize;
+	uint32 dataOffset;
 
-	getFileProperties(zip, file, compMethod, compSize, realSize);
+	getFileProperties(file, compMethod, compSize, realSize, dataOffset);
 
 	return realSize;
 }
 
+bool ZipFile::isFileCompressed(uint32 index) const {
+	return getIFile(index).compMethod != 0;
+}
+
 SeekableReadStream *ZipFile::getFile(uint32 index) const {
 	const IFile &file = getIFile(index);
 
-	Common::File zip;
-	open(zip);
-
 	uint16 compMethod;
 	uint32 compSize;
 	uint32 realSize;
+	uint32 dataOffset;
 
-	getFileProperties(zip, file, compMethod, compSize, realSize);
+	getFileProperties(file, compMethod, compSize, realSize, dataOffset);
 
-	return decompressFile(zip, compMethod, compSize, realSize);
+	if (_mappedFile) {
+		// Uncompressed files are handed out directly from the mapped file
+		if (compMethod == 0)
+			return new MappedFileReadStream(_mappedFile, dataOffset, compSize);
+
+		if (((uint64) dataOffset + compSize) > _mappedFile->size())
+			throw Exception(kReadError);
+
+		return decompressFile(_mappedFile->getData() + dataOffset, compMethod, compSize, realSize);
+	}
+
+	if (compMethod == 0)
+		return FilePoolMan.readStream(_fileName, dataOffset, compSize);
+
+	byte *compressedData = new byte[compSize];
+
+	SeekableReadStream *stream = 0;
+	try {
+		if (readData(dataOffset, compressedData, compSize) != compSize)
+			throw Exception(kReadError);
+
+		stream = decompressFile(compressedData, compMethod, compSize, realSize);
+
+	} catch (...) {
+		delete[] compressedData;
+		throw;
+	}
+
+	delete[] compressedData;
+	return stream;
 }
 
 void ZipFile::open(Common::File &file) const {
@@ -201,13 +256,25 @@ void ZipFile::open(Common::File &file) const {
 		throw Exception(kOpenError);
 }
 
-SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32 method,
+void ZipFile::map() {
+	_mappedFile.reset(new MappedFile);
+
+	if (!_mappedFile->open(_fileName)) {
+		warning("Failed to map ZIP \"%s\" into memory", _fileName.c_str());
+		_mappedFile.reset();
+	}
+}
+
+SeekableReadStream *ZipFile::decompressFile(const byte *compressedData, uint32 method,
 		uint32 compSize, uint32 realSize) {
 
 	if (method == 0) {
 		// Uncompressed
 
-		return zip.readStream(compSize);
+		byte *data = new byte[compSize];
+		std::memcpy(data, compressedData, compSize);
+
+		return new MemoryReadStream(data, compSize, true);
 	}
 
 	if (method != 8)
@@ -216,21 +283,12 @@ SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32 meth
 	// Allocate the decompressed data
 	byte *decompressedData = new byte[realSize];
 
-	// Read in the compressed data
-	byte *compressedData = new byte[compSize];
-	if (zip.read(compressedData, compSize) != compSize) {
-		delete[] decompressedData;
-		delete[] compressedData;
-
-		return 0;
-	}
-
 	z_stream strm;
 	strm.zalloc   = Z_NULL;
 	strm.zfree    = Z_NULL;
 	strm.opaque   = Z_NULL;
 	strm.avail_in = compSize;
-	strm.next_in  = compressedData;
+	strm.next_in  = const_cast<byte *>(compressedData);
 
 	// Negative windows bits means there is no zlib header present in the data.
 	int zResult = inflateInit2(&strm, -MAX_WBITS);
@@ -238,7 +296,6 @@ SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32 meth
 		inflateEnd(&strm);
 
 		delete[] decompressedData;
-		delete[] compressedData;
 		throw Exception("Could not initialize zlib inflate");
 	}
 
@@ -250,12 +307,10 @@ SeekableReadStream *ZipFile::decompressFile(SeekableReadStream &zip, uint32 meth
 		inflateEnd(&strm);
 
 		delete[] decompressedData;
-		delete[] compressedData;
 		throw Exception("Failed to inflate: %d", zResult);
 	}
 
 	inflateEnd(&strm);
-	delete[] compressedData;
 	return new MemoryReadStream(decompressedData, realSize, true);
 }
 
@@ -31,10 +31,13 @@
 #include <list>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 namespace Common {
 
 class SeekableReadStream;
 class File;
+class MappedFile;
 
 /** A class encapsulating ZIP file access. */
 class ZipFile {
@@ -47,7 +50,13 @@ public:
 
 	typedef std::list<File> FileList;
 
-	ZipFile(const UString &fileName);
+	/** Open a ZIP file.
+	 *
+	 *  @param fileName The ZIP file to open.
+	 *  @param mapped   Map the whole file into memory, so that uncompressed
+	 *                  files can be read without copying.
+	 */
+	ZipFile(const UString &fileName, bool mapped = false);
 	~ZipFile();
 
 	/** Clear the file list. */
@@ -62,11 +71,18 @@ public:
 	/** Return a stream of the files's contents. */
 	SeekableReadStream *getFile(uint32 index) const;
 
+	/** Is the file stored compressed? */
+	bool isFileCompressed(uint32 index) const;
+
 private:
+	/** Size of the fixed part of a local file header. */
+	static const uint32 kLocalHeaderSize = 30;
+
 	/** Internal file information. */
 	struct IFile {
-		uint32 offset; ///< The offset of the file within the ZIP.
-		uint32 size;   ///< The file's size.
+		uint32 offset;     ///< The offset of the file within the ZIP.
+		uint32 size;       ///< The file's size.
+		uint16 compMethod; ///< The file's compression method.
 	};
 
 	typedef std::vector<IFile> IFileList;
@@ -80,17 +96,24 @@ private:
 	/** The name of the ZIP file. */
 	UString _fileName;
 
+	/** The ZIP file mapped into memory, if requested. */
+	boost::shared_ptr<MappedFile> _mappedFile;
+
 	void open(Common::File &file) const;
+	void map();
 
 	void load();
 	uint32 findCentralDirectoryEnd(SeekableReadStream &zip);
 
-	static SeekableReadStream *decompressFile(SeekableReadStream &zip, uint32 method,
+	static SeekableReadStream *decompressFile(const byte *compressedData, uint32 method,
 			uint32 compSize, uint32 realSize);
 
 	const IFile &getIFile(uint32 index) const;
-	void getFileProperties(Common::SeekableReadStream &zip, const IFile &file,
-			uint16 &compMethod, uint32 &compSize, uint32 &realSize) const;
+	void getFileProperties(const IFile &file, uint16 &compMethod,
+			uint32 &compSize, uint32 &realSize, uint32 &dataOffset) const;
+
+	/** Read data from the ZIP file, without having to keep it open. */
+	uint32 readData(uint32 offset, byte *data, uint32 size) const;
 };
 
 } // End of namespace Common
@@ -31,6 +31,7 @@
 #include "src/common/filepath.h"
 #include "src/common/readline.h"
 #include "src/common/configman.h"
+#include "src/common/filepool.h"
 
 #include "src/aurora/resman.h"
 
@@ -688,6 +689,10 @@ Console::Console(const Common::UString &font, int fontHeight) : _neverShown(true
 			"Usage: getoption <option>\nPrint the value of a config options");
 	registerCommand("setoption"  , boost::bind(&Console::cmdSetOption  , this, _1),
 			"Usage: setoption <option> <value>\nSet the value of a config option for this session");
+	registerCommand("filepool"   , boost::bind(&Console::cmdFilePool   , this, _1),
+			"Usage: filepool [reset]\nPrint (or reset) the archive file handle pool statistics");
+	registerCommand("rescache"   , boost::bind(&Console::cmdResCache   , this, _1),
+			"Usage: rescache [reset]\nPrint (or reset) the decompressed resource cache statistics");
 
 	_console->setPrompt(kPrompt);
 
@@ -1205,6 +1210,37 @@ void Console::cmdSetOption(const CommandLine &cl) {
 	printf("\"%s\" = \"%s\"", args[0].c_str(), ConfigMan.getString(args[0]).c_str());
 }
 
+void Console::cmdFilePool(const CommandLine &cl) {
+	if (cl.args == "reset") {
+		FilePoolMan.resetStatistics();
+		return;
+	}
+
+	const Common::FilePoolManager::Statistics stats = FilePoolMan.getStatistics();
+
+	printf("%u/%u open file handles", stats.openHandles, stats.maxHandles);
+	printf("%llu hits, %llu misses, %llu opens, %llu evictions",
+	       (unsigned long long) stats.hits , (unsigned long long) stats.misses,
+	       (unsigned long long) stats.opens, (unsigned long long) stats.evictions);
+}
+
+void Console::cmdResCache(const CommandLine &cl) {
+	if (cl.args == "reset") {
+		ResMan.resetResourceCacheStatistics();
+		return;
+	}
+
+	const Aurora::ResourceManager::CacheStatistics stats = ResMan.getResourceCacheStatistics();
+
+	const uint64 requests = stats.hits + stats.misses;
+	const double hitRate  = (requests > 0) ? ((100.0 * stats.hits) / requests) : 0.0;
+
+	printf("%u resources, %u/%u KB", stats.resources, stats.size / 1024, stats.budget / 1024);
+	printf("%llu hits, %llu misses (%.1f%% hit rate), %llu evictions",
+	       (unsigned long long) stats.hits, (unsigned long long) stats.misses, hitRate,
+	       (unsigned long long) stats.evictions);
+}
+
 void Console::printCommandHelp(const Common::UString &cmd) {
 	CommandMap::const_iterator c = _commands.find(cmd);
 	if (c == _commands.end()) {
@@ -277,6 +277,8 @@ private:
 	void cmdSilence    (const CommandLine &cl);
 	void cmdGetOption  (const CommandLine &cl);
 	void cmdSetOption  (const CommandLine &cl);
+	void cmdFilePool   (const CommandLine &cl);
+	void cmdResCache   (const CommandLine &cl);
 
 	void updateHelpArguments();
 
@@ -84,6 +84,26 @@ Graphics::Aurora::Model *loadModelGUI(const Common::UString &resref) {
 	return model;
 }
 
+Graphics::Aurora::Model *loadModelInstance(const Common::UString &resref,
+                                           const Common::UString &texture) {
+	assert(kModelLoader);
+
+	Graphics::Aurora::Model *model = 0;
+
+	try {
+
+		model = kModelLoader->loadInstance(resref, Graphics::Aurora::kModelTypeObject, texture);
+
+	} catch (Common::Exception &e) {
+
+		e.add("Failed to load object model \"%s\"", resref.c_str());
+		Common::printException(e, "WARNING: ");
+
+	}
+
+	return model;
+}
+
 void freeModel(Graphics::Aurora::Model *&model) {
 	assert(kModelLoader);
 
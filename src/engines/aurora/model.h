@@ -42,6 +42,10 @@ Graphics::Aurora::Model *loadModelObject(const Common::UString &resref,
                                          const Common::UString &texture = "");
 Graphics::Aurora::Model *loadModelGUI   (const Common::UString &resref);
 
+/** Load an object model that shares its model data with all other instances of the same model. */
+Graphics::Aurora::Model *loadModelInstance(const Common::UString &resref,
+                                           const Common::UString &texture = "");
+
 void freeModel(Graphics::Aurora::Model *&model);
 
 } // End of namespace Engines
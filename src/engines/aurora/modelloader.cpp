@@ -22,6 +22,8 @@
  *  An abstract Aurora model loader.
  */
 
+#include <boost/shared_ptr.hpp>
+
 #include "src/graphics/aurora/model.h"
 
 #include "src/engines/aurora/modelloader.h"
@@ -36,4 +38,46 @@ void ModelLoader::free(Graphics::Aurora::Model *&model) {
 	model = 0;
 }
 
+Graphics::Aurora::Model *ModelLoader::loadInstance(const Common::UString &resref,
+		Graphics::Aurora::ModelType type, const Common::UString &texture) {
+
+	const Common::UString key = Common::UString::sprintf("%d/%s/%s", (int) type, resref.c_str(), texture.c_str());
+
+	boost::shared_ptr<Graphics::Aurora::Model> prototype = findPrototype(key);
+	if (!prototype) {
+		// Load the model without holding the lock, so that other models can be looked up meanwhile
+		boost::shared_ptr<Graphics::Aurora::Model> loaded(load(resref, type, texture));
+		if (!loaded)
+			return 0;
+
+		Common::StackLock lock(_prototypeMutex);
+
+		// Someone else might have loaded the same model in the meantime
+		prototype = _prototypes[key].lock();
+		if (!prototype) {
+			prototype = loaded;
+
+			_prototypes[key] = prototype;
+		}
+	}
+
+	return new Graphics::Aurora::Model(prototype);
+}
+
+boost::shared_ptr<Graphics::Aurora::Model> ModelLoader::findPrototype(const Common::UString &key) {
+	Common::StackLock lock(_prototypeMutex);
+
+	PrototypeMap::iterator p = _prototypes.find(key);
+	if (p == _prototypes.end())
+		return boost::shared_ptr<Graphics::Aurora::Model>();
+
+	boost::shared_ptr<Graphics::Aurora::Model> prototype = p->second.lock();
+
+	// All instances are gone, so the model data has been freed
+	if (!prototype)
+		_prototypes.erase(p);
+
+	return prototype;
+}
+
 } // End of namespace Engines
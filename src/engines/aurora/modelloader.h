@@ -25,11 +25,14 @@
 #ifndef ENGINES_AURORA_MODELLOADER_H
 #define ENGINES_AURORA_MODELLOADER_H
 
-#include "src/graphics/aurora/types.h"
+#include <map>
+
+#include <boost/weak_ptr.hpp>
 
-namespace Common {
-	class UString;
-}
+#include "src/common/ustring.h"
+#include "src/common/mutex.h"
+
+#include "src/graphics/aurora/types.h"
 
 namespace Engines {
 
@@ -40,6 +43,25 @@ public:
 	virtual Graphics::Aurora::Model *load(const Common::UString &resref,
 			Graphics::Aurora::ModelType type, const Common::UString &texture) = 0;
 	virtual void free(Graphics::Aurora::Model *&model);
+
+	/** Load an instance of a model.
+	 *
+	 *  All instances of the same model share one copy of the model data,
+	 *  which is only loaded once and freed together with the last instance.
+	 */
+	Graphics::Aurora::Model *loadInstance(const Common::UString &resref,
+			Graphics::Aurora::ModelType type, const Common::UString &texture);
+
+private:
+	typedef std::map<Common::UString, boost::weak_ptr<Graphics::Aurora::Model>,
+	                 Common::UString::iless> PrototypeMap;
+
+	/** The shared model data of all instanced models, by type, resref and texture. */
+	PrototypeMap _prototypes;
+
+	Common::Mutex _prototypeMutex;
+
+	boost::shared_ptr<Graphics::Aurora::Model> findPrototype(const Common::UString &key);
 };
 
 } // End of namespace Engines
@@ -63,6 +63,13 @@ bool indexOptionalArchive(Aurora::ArchiveType archive, const Common::UString &fi
 	return true;
 }
 
+void indexArchives(ArchiveBatch &archives) {
+	if (EventMan.quitRequested())
+		return;
+
+	ResMan.addArchives(archives);
+}
+
 void indexMandatoryDirectory(const Common::UString &dir,
 		const char *glob, int depth, uint32 priority,
 		Aurora::ResourceManager::ChangeID *change) {
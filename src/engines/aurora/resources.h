@@ -34,6 +34,9 @@ namespace Common {
 
 namespace Engines {
 
+typedef Aurora::ResourceManager::BatchArchive BatchArchive;
+typedef Aurora::ResourceManager::ArchiveBatch ArchiveBatch;
+
 void indexMandatoryArchive(Aurora::ArchiveType archive, const Common::UString &file,
 		uint32 priority = 10, Aurora::ResourceManager::ChangeID *change = 0);
 
@@ -41,6 +44,13 @@ void indexMandatoryArchive(Aurora::ArchiveType archive, const Common::UString &f
 bool indexOptionalArchive(Aurora::ArchiveType archive, const Common::UString &file,
 		uint32 priority = 10, Aurora::ResourceManager::ChangeID *change = 0);
 
+/** Add several archive files to the resource manager at once.
+ *
+ *  The archives are read in parallel and indexed in order. Optional archives
+ *  that can't be added are skipped, failing mandatory ones error out.
+ */
+void indexArchives(ArchiveBatch &archives);
+
 /** Add a directory to the resource manager, erroring out if it does not exist. */
 void indexMandatoryDirectory(const Common::UString &dir,
 		const char *glob = 0, int depth = -1, uint32 priority = 10,
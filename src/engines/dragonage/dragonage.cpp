@@ -147,52 +147,58 @@ void DragonAgeEngine::init() {
 	ResMan.addArchiveDir(Aurora::kArchiveERF, "modules/single player/data");
 
 	progress.step("Loading core resource files");
-	indexMandatoryArchive(Aurora::kArchiveERF, "2da.erf"               ,  1);
-	indexMandatoryArchive(Aurora::kArchiveERF, "anims.erf"             ,  2);
-	indexMandatoryArchive(Aurora::kArchiveERF, "chargen.gpu.rim"       ,  3);
-	indexMandatoryArchive(Aurora::kArchiveERF, "chargen.rim"           ,  4);
-	indexMandatoryArchive(Aurora::kArchiveERF, "consolescripts.erf"    ,  5);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designerareas.erf"     ,  6);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designercreatures.erf" ,  7);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designercutscenes.erf" ,  8);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designerdialogs.erf"   ,  9);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designeritems.erf"     , 10);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designerplaceables.erf", 11);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designerplots.erf"     , 12);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designerscripts.rim"   , 13);
-	indexMandatoryArchive(Aurora::kArchiveERF, "designertriggers.erf"  , 14);
-	indexMandatoryArchive(Aurora::kArchiveERF, "face.erf"              , 15);
-	indexMandatoryArchive(Aurora::kArchiveERF, "global.rim"            , 16);
-	indexMandatoryArchive(Aurora::kArchiveERF, "globalvfx.rim"         , 17);
-	indexMandatoryArchive(Aurora::kArchiveERF, "gui.erf"               , 18);
-	indexMandatoryArchive(Aurora::kArchiveERF, "guiexport.erf"         , 19);
-	indexMandatoryArchive(Aurora::kArchiveERF, "iterationtests.erf"    , 20);
-	indexMandatoryArchive(Aurora::kArchiveERF, "lightprobedata.erf"    , 21);
-	indexMandatoryArchive(Aurora::kArchiveERF, "materialobjects.erf"   , 22);
-	indexMandatoryArchive(Aurora::kArchiveERF, "materials.erf"         , 23);
-	indexMandatoryArchive(Aurora::kArchiveERF, "misc.erf"              , 24);
-	indexMandatoryArchive(Aurora::kArchiveERF, "modelhierarchies.erf"  , 25);
-	indexMandatoryArchive(Aurora::kArchiveERF, "modelmeshdata.erf"     , 26);
-	indexMandatoryArchive(Aurora::kArchiveERF, "pathfindingpatches.erf", 27);
-	indexMandatoryArchive(Aurora::kArchiveERF, "postprocesseffects.erf", 28);
-	indexMandatoryArchive(Aurora::kArchiveERF, "resmetrics.erf"        , 29);
-	indexMandatoryArchive(Aurora::kArchiveERF, "scripts.erf"           , 30);
-	indexMandatoryArchive(Aurora::kArchiveERF, "shaders.erf"           , 31);
-	indexMandatoryArchive(Aurora::kArchiveERF, "states.erf"            , 32);
-	indexMandatoryArchive(Aurora::kArchiveERF, "subqueuefiles.erf"     , 33);
-	indexMandatoryArchive(Aurora::kArchiveERF, "textures.erf"          , 34);
-	indexMandatoryArchive(Aurora::kArchiveERF, "tints.erf"             , 35);
+	ArchiveBatch coreArchives;
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "2da.erf"               ,  1));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "anims.erf"             ,  2));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "chargen.gpu.rim"       ,  3));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "chargen.rim"           ,  4));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "consolescripts.erf"    ,  5));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designerareas.erf"     ,  6));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designercreatures.erf" ,  7));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designercutscenes.erf" ,  8));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designerdialogs.erf"   ,  9));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designeritems.erf"     , 10));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designerplaceables.erf", 11));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designerplots.erf"     , 12));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designerscripts.rim"   , 13));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "designertriggers.erf"  , 14));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "face.erf"              , 15));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "global.rim"            , 16));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "globalvfx.rim"         , 17));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "gui.erf"               , 18));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "guiexport.erf"         , 19));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "iterationtests.erf"    , 20));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "lightprobedata.erf"    , 21));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "materialobjects.erf"   , 22));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "materials.erf"         , 23));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "misc.erf"              , 24));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "modelhierarchies.erf"  , 25));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "modelmeshdata.erf"     , 26));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "pathfindingpatches.erf", 27));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "postprocesseffects.erf", 28));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "resmetrics.erf"        , 29));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "scripts.erf"           , 30));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "shaders.erf"           , 31));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "states.erf"            , 32));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "subqueuefiles.erf"     , 33));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "textures.erf"          , 34));
+	coreArchives.push_back(BatchArchive(Aurora::kArchiveERF, "tints.erf"             , 35));
+
+	indexArchives(coreArchives);
 
 	progress.step("Loading core ability resource files");
-	indexMandatoryArchive(Aurora::kArchiveERF, "bearform.rim"    , 40);
-	indexMandatoryArchive(Aurora::kArchiveERF, "burningform.rim" , 41);
-	indexMandatoryArchive(Aurora::kArchiveERF, "golemform.rim"   , 42);
-	indexMandatoryArchive(Aurora::kArchiveERF, "mouseform.rim"   , 43);
-	indexMandatoryArchive(Aurora::kArchiveERF, "spiderform.rim"  , 44);
-	indexMandatoryArchive(Aurora::kArchiveERF, "spiritform.rim"  , 45);
-	indexMandatoryArchive(Aurora::kArchiveERF, "summonbear.rim"  , 46);
-	indexMandatoryArchive(Aurora::kArchiveERF, "summonspider.rim", 47);
-	indexMandatoryArchive(Aurora::kArchiveERF, "summonwolf.rim"  , 48);
+	ArchiveBatch abilityArchives;
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "bearform.rim"    , 40));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "burningform.rim" , 41));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "golemform.rim"   , 42));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "mouseform.rim"   , 43));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "spiderform.rim"  , 44));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "spiritform.rim"  , 45));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "summonbear.rim"  , 46));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "summonspider.rim", 47));
+	abilityArchives.push_back(BatchArchive(Aurora::kArchiveERF, "summonwolf.rim"  , 48));
+
+	indexArchives(abilityArchives);
 
 	progress.step("Indexing extra core sound resources");
 	indexMandatoryDirectory("packages/core/audio"          , 0, -1, 100);
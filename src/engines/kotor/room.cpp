@@ -47,7 +47,7 @@ void Room::load(const Common::UString &resRef, float x, float y, float z) {
 	if (resRef == "****")
 		return;
 
-	_model = loadModelObject(resRef);
+	_model = loadModelInstance(resRef);
 	if (!_model)
 		throw Common::Exception("Can't load room model \"%s\"", resRef.c_str());
 
@@ -22,9 +22,12 @@
  *  NWN area.
  */
 
+#include <set>
+
 #include "src/common/util.h"
 #include "src/common/error.h"
 
+#include "src/aurora/resman.h"
 #include "src/aurora/locstring.h"
 #include "src/aurora/gfffile.h"
 #include "src/aurora/2dafile.h"
@@ -71,9 +74,6 @@ Area::Area(Module &module, const Common::UString &resRef) : _module(&module), _l
 	}
 
 	_loaded = true;
-
-	// Tell the module that we exist
-	_module->addObject(*this);
 }
 
 Area::~Area() {
@@ -445,6 +445,22 @@ void Area::unloadTileset() {
 }
 
 void Area::loadTiles() {
+	// Read all tile models in the background, while we're loading them one by one
+	std::set<Common::UString> modelNames;
+	for (std::vector<Tile>::iterator t = _tiles.begin(); t != _tiles.end(); ++t)
+		modelNames.insert(_tileset->getTile(t->tileID).model);
+
+	std::list<Aurora::ResourceManager::ResourceID> models;
+	for (std::set<Common::UString>::const_iterator m = modelNames.begin(); m != modelNames.end(); ++m) {
+		models.push_back(Aurora::ResourceManager::ResourceID());
+
+		models.back().name = *m;
+		models.back().type = Aurora::kFileTypeMDL;
+	}
+
+	Aurora::ResourceManager::PrefetchList prefetches;
+	ResMan.prefetch(models, prefetches);
+
 	for (uint32 y = 0; y < _height; y++) {
 		for (uint32 x = 0; x < _width; x++) {
 			uint32 n = y * _width + x;
@@ -453,7 +469,7 @@ void Area::loadTiles() {
 
 			t.tile = &_tileset->getTile(t.tileID);
 
-			t.model = loadModelObject(t.tile->model);
+			t.model = loadModelInstance(t.tile->model);
 			if (!t.model)
 				throw Common::Exception("Can't load tile model \"%s\"", t.tile->model.c_str());
 
@@ -486,12 +502,19 @@ void Area::unloadTiles() {
 	}
 }
 
+void Area::registerObjects() {
+	// Tell the module that we exist
+	_module->addObject(*this);
+
+	for (ObjectList::iterator o = _objects.begin(); o != _objects.end(); ++o)
+		if (!(*o)->isStatic())
+			_module->addObject(**o);
+}
+
 void Area::loadObject(Engines::NWN::Object &object) {
 	object.setArea(this);
 
 	_objects.push_back(&object);
-	if (!object.isStatic())
-		_module->addObject(object);
 }
 
 void Area::loadWaypoints(const Aurora::GFFList &list) {
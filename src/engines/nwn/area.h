@@ -59,9 +59,17 @@ class Object;
 class Area : public Aurora::NWScript::Object, public Events::Notifyable,
              public ScriptContainer {
 public:
+	/** Load an area.
+	 *
+	 *  This only reads the area and creates its objects. It doesn't touch
+	 *  the module, so several areas can be loaded at the same time.
+	 */
 	Area(Module &module, const Common::UString &resRef);
 	~Area();
 
+	/** Register the area and all its objects with the module. */
+	void registerObjects();
+
 	// General properties
 
 	/** Return the area's resref (resource ID). */
@@ -427,25 +427,32 @@ void Creature::getArmorModels() {
 	}
 }
 
-void Creature::finishPLTs(std::list<Graphics::Aurora::PLTHandle> &plts) {
-	for (std::list<Graphics::Aurora::PLTHandle>::iterator p = plts.begin();
-	     p != plts.end(); ++p) {
-
-		Graphics::Aurora::PLTFile &plt = p->getPLT();
-
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerSkin   , _colorSkin);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerHair   , _colorHair);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerTattoo1, _colorTattoo1);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerTattoo2, _colorTattoo2);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerMetal1, _colorMetal1);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerMetal2, _colorMetal2);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerLeather1, _colorLeather1);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerLeather2, _colorLeather2);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerCloth1, _colorCloth1);
-		plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerCloth2, _colorCloth2);
-
-		plt.rebuild();
+void Creature::finishPLTs() {
+	std::vector<Graphics::Aurora::PLTFile *> plts;
+
+	for (uint i = 0; i < kBodyPartMAX; i++) {
+		for (std::list<Graphics::Aurora::PLTHandle>::iterator p = _bodyParts[i].plts.begin();
+		     p != _bodyParts[i].plts.end(); ++p) {
+
+			Graphics::Aurora::PLTFile &plt = p->getPLT();
+
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerSkin   , _colorSkin);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerHair   , _colorHair);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerTattoo1, _colorTattoo1);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerTattoo2, _colorTattoo2);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerMetal1, _colorMetal1);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerMetal2, _colorMetal2);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerLeather1, _colorLeather1);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerLeather2, _colorLeather2);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerCloth1, _colorCloth1);
+			plt.setLayerColor(Graphics::Aurora::PLTFile::kLayerCloth2, _colorCloth2);
+
+			plts.push_back(&plt);
+		}
 	}
+
+	// All parts share the same colors, so they can share the color lookup, too
+	Graphics::Aurora::PLTFile::rebuild(plts);
 }
 
 void Creature::loadModel() {
@@ -484,10 +491,10 @@ void Creature::loadModel() {
 				part_node->addChild(part_model);
 
 			TextureMan.getNewPLTs(_bodyParts[i].plts);
-
-			finishPLTs(_bodyParts[i].plts);
 		}
 
+		finishPLTs();
+
 	} else
 		_model = loadModelObject(appearance.getString("RACE"));
 
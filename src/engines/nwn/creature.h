@@ -356,8 +356,8 @@ private:
 	void getPartModels(); ///< Construct all body part models' resource names.
 	void getArmorModels(); ///< Populate the armor info for body parts.
 
-	/** Finished those paletted textures. */
-	void finishPLTs(std::list<Graphics::Aurora::PLTHandle> &plts);
+	/** Color and build the paletted textures of all body parts. */
+	void finishPLTs();
 
 	void createTooltip(); ///< Create the tooltip.
 	void showTooltip();   ///< Show the tooltip.
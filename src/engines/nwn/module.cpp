@@ -26,6 +26,8 @@
 #include "src/common/maths.h"
 #include "src/common/error.h"
 #include "src/common/configman.h"
+#include "src/common/threadpool.h"
+#include "src/common/mutex.h"
 
 #include "src/events/events.h"
 
@@ -93,8 +95,21 @@ namespace Engines {
 
 namespace NWN {
 
-bool Module::Action::operator<(const Action &s) const {
-	return timestamp < s.timestamp;
+Module::Action::Action() : type(kActionNone), owner(0), triggerer(0) {
+	state.offset = 0;
+}
+
+void Module::Action::swap(Action &action) {
+	std::swap(type, action.type);
+
+	script.swap(action.script);
+
+	std::swap(state.offset, action.state.offset);
+	state.globals.swap(action.state.globals);
+	state.locals.swap(action.state.locals);
+
+	std::swap(owner    , action.owner);
+	std::swap(triggerer, action.triggerer);
 }
 
 
@@ -415,8 +430,19 @@ void Module::run() {
 
 			_ingameGUI->updatePartyMember(0, *_pc);
 
-			if (!EventMan.quitRequested() && !_exit && !_newArea.empty())
-				EventMan.delay(10);
+			if (!EventMan.quitRequested() && !_exit && !_newArea.empty()) {
+				uint32 delay = 10;
+
+				// Wake up in time for the next delayed action
+				uint32 due;
+				if (_delayedActions.getNextDue(due)) {
+					const uint32 now = EventMan.getTimestamp();
+
+					delay = ((int32) (due - now) <= 0) ? 0 : MIN<uint32>(delay, due - now);
+				}
+
+				EventMan.delay(delay);
+			}
 		}
 
 	} catch (Common::Exception &e) {
@@ -479,17 +505,11 @@ void Module::handleEvents() {
 void Module::handleActions() {
 	uint32 now = EventMan.getTimestamp();
 
-	while (!_delayedActions.empty()) {
-		std::multiset<Action>::iterator action = _delayedActions.begin();
-
-		if (now < action->timestamp)
-			break;
-
-		if (action->type == kActionScript)
-			ScriptContainer::runScript(action->script, action->state,
-			                           action->owner, action->triggerer);
-
-		_delayedActions.erase(action);
+	Action action;
+	while (_delayedActions.popDue(now, action)) {
+		if (action.type == kActionScript)
+			ScriptContainer::runScript(action.script, action.state,
+			                           action.owner, action.triggerer);
 	}
 }
 
@@ -586,26 +606,127 @@ void Module::unloadTexturePack() {
 	_currentTexturePack = -1;
 }
 
+/** Loading one area in a worker thread. */
+class AreaLoadJob : public Common::ThreadPool::Job {
+public:
+	AreaLoadJob(Module &module, const Common::UString &resRef, Common::Semaphore &finishedJobs) :
+		_module(&module), _resRef(resRef), _area(0), _failed(false), _finishedJobs(&finishedJobs) {
+	}
+
+	~AreaLoadJob() {
+		delete _area;
+	}
+
+	void run() {
+		try {
+			_area = new Area(*_module, _resRef);
+		} catch (Common::Exception &e) {
+			_error  = e;
+			_failed = true;
+		} catch (std::exception &e) {
+			_error  = Common::Exception(e);
+			_failed = true;
+		} catch (...) {
+			_error  = Common::Exception("Unknown exception");
+			_failed = true;
+		}
+
+		_finished.unlock();
+		_finishedJobs->unlock();
+	}
+
+	/** Return whether the job has finished, and hasn't been reported as such yet. */
+	bool checkFinished() {
+		return _finished.lockTry();
+	}
+
+	const Common::UString &getResRef() const {
+		return _resRef;
+	}
+
+	/** Take the loaded area, rethrowing the error if loading failed. */
+	Area *takeArea() {
+		if (_failed) {
+			_error.add("Can't load area \"%s\"", _resRef.c_str());
+			throw _error;
+		}
+
+		Area *area = _area;
+		_area = 0;
+
+		return area;
+	}
+
+private:
+	Module *_module;
+	Common::UString _resRef;
+
+	Area *_area;
+
+	Common::Exception _error;
+	bool _failed;
+
+	Common::Semaphore  _finished;     ///< Unlocked once the job has finished.
+	Common::Semaphore *_finishedJobs; ///< Unlocked once for every finished job.
+};
+
 void Module::loadAreas() {
 	status("Loading areas...");
 
 	const std::vector<Common::UString> &areas = _ifo.getAreas();
-	for (uint32 i = 0; i < areas.size(); i++) {
-		status("Loading area \"%s\" (%d / %d)", areas[i].c_str(), i, (int) areas.size() - 1);
 
-		std::pair<AreaMap::iterator, bool> result;
+	for (uint32 i = 0; i < areas.size(); i++)
+		for (uint32 j = 0; j < i; j++)
+			if (areas[i] == areas[j])
+				throw Common::Exception("Area tag collision: \"%s\"", areas[i].c_str());
 
-		result = _areas.insert(std::make_pair(areas[i], (Area *) 0));
-		if (!result.second)
-			throw Common::Exception("Area tag collision: \"%s\"", areas[i].c_str());
+	/* Reading the areas and creating their objects is independent for each
+	 * area, so we do that in parallel. Only registering the areas with the
+	 * module happens here, in the order the areas are listed in the IFO. */
 
-		try {
-			result.first->second = new Area(*this, areas[i].c_str());
-		} catch (Common::Exception &e) {
-			e.add("Can't load area \"%s\"", areas[i].c_str());
-			throw;
+	Common::Semaphore finishedJobs;
+
+	std::vector<AreaLoadJob *> jobs;
+	jobs.reserve(areas.size());
+
+	for (uint32 i = 0; i < areas.size(); i++)
+		jobs.push_back(new AreaLoadJob(*this, areas[i], finishedJobs));
+
+	try {
+		Common::ThreadPool pool(MIN<uint32>(Common::ThreadPool::getCPUCount(), areas.size()));
+
+		for (std::vector<AreaLoadJob *>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+			pool.addJob(**j);
+
+		// Report the progress as the areas finish loading, in whatever order they do
+		for (uint32 loaded = 0; loaded < areas.size(); ) {
+			finishedJobs.lock();
+
+			for (uint32 i = 0; i < areas.size(); i++) {
+				if (!jobs[i]->checkFinished())
+					continue;
+
+				status("Loaded area \"%s\" (%d / %d)", jobs[i]->getResRef().c_str(), loaded, (int) areas.size() - 1);
+				loaded++;
+			}
+		}
+
+		for (uint32 i = 0; i < areas.size(); i++) {
+			Area *area = jobs[i]->takeArea();
+
+			_areas.insert(std::make_pair(areas[i], area));
+			area->registerObjects();
 		}
+
+	} catch (...) {
+		for (std::vector<AreaLoadJob *>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+			delete *j;
+
+		throw;
 	}
+
+	for (std::vector<AreaLoadJob *>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+		delete *j;
 }
 
 void Module::unloadAreas() {
@@ -707,19 +828,21 @@ Area *Module::getCurrentArea() {
 }
 
 void Module::delayScript(const Common::UString &script,
-                         const Aurora::NWScript::ScriptState &state,
+                         Aurora::NWScript::ScriptState &state,
                          Aurora::NWScript::Object *owner,
                          Aurora::NWScript::Object *triggerer, uint32 delay) {
 	Action action;
 
 	action.type      = kActionScript;
 	action.script    = script;
-	action.state     = state;
 	action.owner     = owner;
 	action.triggerer = triggerer;
-	action.timestamp = EventMan.getTimestamp() + delay;
 
-	_delayedActions.insert(action);
+	std::swap(action.state.offset, state.offset);
+	action.state.globals.swap(state.globals);
+	action.state.locals.swap(state.locals);
+
+	_delayedActions.insert(EventMan.getTimestamp(), delay, action);
 }
 
 Common::UString Module::getDescription(const Common::UString &module) {
@@ -30,6 +30,7 @@
 #include <map>
 
 #include "src/common/ustring.h"
+#include "src/common/timerwheel.h"
 
 #include "src/aurora/resman.h"
 #include "src/aurora/ifofile.h"
@@ -116,8 +117,12 @@ public:
 	/** Notify the module that the PC was moved. */
 	void movedPC();
 
+	/** Run a script after a delay.
+	 *
+	 *  The script state is moved into the scheduled action, leaving an empty state behind.
+	 */
 	void delayScript(const Common::UString &script,
-	                 const Aurora::NWScript::ScriptState &state,
+	                 Aurora::NWScript::ScriptState &state,
 	                 Aurora::NWScript::Object *owner, Aurora::NWScript::Object *triggerer,
 	                 uint32 delay);
 
@@ -139,9 +144,9 @@ private:
 		Aurora::NWScript::Object *owner;
 		Aurora::NWScript::Object *triggerer;
 
-		uint32 timestamp;
+		Action();
 
-		bool operator<(const Action &s) const;
+		void swap(Action &action);
 	};
 
 	typedef std::map<Common::UString, Area *> AreaMap;
@@ -176,7 +181,7 @@ private:
 
 	Common::UString _newModule; ///< The module we should change to.
 
-	std::multiset<Action> _delayedActions;
+	Common::TimerWheel<Action> _delayedActions;
 
 
 	void unload(); ///< Unload the whole shebang.
@@ -42,6 +42,7 @@
 
 #include "src/engines/nwn/types.h"
 #include "src/engines/nwn/object.h"
+#include "src/engines/nwn/area.h"
 
 namespace Engines {
 
@@ -131,6 +132,8 @@ Area *Object::getArea() const {
 
 void Object::setArea(Area *area) {
 	_area = area;
+
+	updateSpatialPosition();
 }
 
 Location Object::getLocation() const {
@@ -161,6 +164,17 @@ void Object::setPosition(float x, float y, float z) {
 	_position[0] = x;
 	_position[1] = y;
 	_position[2] = z;
+
+	updateSpatialPosition();
+}
+
+void Object::updateSpatialPosition() {
+	if (!_area) {
+		clearSpatialPosition();
+		return;
+	}
+
+	setSpatialPosition(_area, _position[0], _position[1], _position[2]);
 }
 
 void Object::setOrientation(float x, float y, float z) {
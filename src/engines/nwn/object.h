@@ -185,6 +185,10 @@ protected:
 	void loadSSF();
 	/** Begin a conversation between the triggerer and this object. */
 	bool beginConversation(Object *triggerer);
+
+private:
+	/** Tell the module's object container where we are now. */
+	void updateSpatialPosition();
 };
 
 } // End of namespace NWN
@@ -48,19 +48,20 @@ namespace Engines {
 
 namespace NWN {
 
-ObjectDistanceSort::ObjectDistanceSort(const Object &target) {
-	target.getPosition(xt, yt, zt);
-}
+ObjectSearchFilter::ObjectSearchFilter(const Object *exclude, uint32 types, const Common::UString &tag) :
+	_exclude(exclude), _types(types), _tag(tag) {
 
-bool ObjectDistanceSort::operator()(Object *a, Object *b) {
-	return getDistance(*a) < getDistance(*b);
 }
 
-float ObjectDistanceSort::getDistance(Object &a) {
-	float x, y, z;
-	a.getPosition(x, y, z);
+bool ObjectSearchFilter::operator()(const Aurora::NWScript::Object &object) const {
+	const Object *nwnObject = dynamic_cast<const Object *>(&object);
+	if (!nwnObject || (nwnObject == _exclude))
+		return false;
+
+	if (!(nwnObject->getType() & _types))
+		return false;
 
-	return ABS(x - xt) + ABS(y - yt) + ABS(z - zt);
+	return _tag.empty() || (nwnObject->getTag() == _tag);
 }
 
 
@@ -229,6 +230,16 @@ Object *ScriptFunctions::convertObject(Aurora::NWScript::Object *o) {
 	return object;
 }
 
+Object *ScriptFunctions::findNearestObject(const Object &target, size_t nth, const ObjectSearchFilter &filter) {
+	if (!_module || !target.getArea())
+		return 0;
+
+	float x, y, z;
+	target.getPosition(x, y, z);
+
+	return convertObject(_module->findNearestObject(*target.getArea(), x, y, z, nth, &filter));
+}
+
 Waypoint *ScriptFunctions::convertWaypoint(Aurora::NWScript::Object *o) {
 	Waypoint *waypoint = dynamic_cast<Waypoint *>(o);
 	if (!waypoint || (waypoint->getID() == kObjectIDInvalid))
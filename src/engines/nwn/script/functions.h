@@ -25,6 +25,8 @@
 #ifndef ENGINES_NWN_SCRIPT_FUNCTIONS_H
 #define ENGINES_NWN_SCRIPT_FUNCTIONS_H
 
+#include "src/common/ustring.h"
+
 #include "src/aurora/nwscript/objectcontainer.h"
 
 namespace Aurora {
@@ -50,16 +52,18 @@ class Creature;
 
 class Location;
 
-class ObjectDistanceSort {
+/** Filters the candidates of a nearest object search. */
+class ObjectSearchFilter : public Aurora::NWScript::ObjectFilter {
 public:
-	ObjectDistanceSort(const Object &target);
+	/** Accept objects of these types, with this tag (if not empty), other than exclude. */
+	ObjectSearchFilter(const Object *exclude, uint32 types, const Common::UString &tag = "");
 
-	bool operator()(Object *a, Object *b);
+	bool operator()(const Aurora::NWScript::Object &object) const;
 
 private:
-	float xt, yt, zt;
-
-	float getDistance(Object &a);
+	const Object *_exclude;
+	uint32 _types;
+	Common::UString _tag;
 };
 
 class ScriptFunctions {
@@ -159,6 +163,9 @@ private:
 
 	void jumpTo(Object *object, Area *area, float x, float y, float z);
 
+	/** Find the nth (0-based) nearest object to target within its area. */
+	Object *findNearestObject(const Object &target, size_t nth, const ObjectSearchFilter &filter);
+
 	void random(Aurora::NWScript::FunctionContext &ctx);
 	void printString(Aurora::NWScript::FunctionContext &ctx);
 	void printFloat(Aurora::NWScript::FunctionContext &ctx);
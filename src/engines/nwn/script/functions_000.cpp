@@ -434,7 +434,7 @@ void ScriptFunctions::assignCommand(Aurora::NWScript::FunctionContext &ctx) {
 	if (!object)
 		object = ctx.getCaller();
 
-	const Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
+	Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
 
 	_module->delayScript(script, state, object, ctx.getTriggerer(), 0);
 }
@@ -449,7 +449,7 @@ void ScriptFunctions::delayCommand(Aurora::NWScript::FunctionContext &ctx) {
 
 	uint32 delay = ctx.getParams()[0].getFloat() * 1000;
 
-	const Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
+	Aurora::NWScript::ScriptState &state = ctx.getParams()[1].getScriptState();
 
 	_module->delayScript(script, state, ctx.getCaller(), ctx.getTriggerer(), delay);
 }
@@ -695,25 +695,7 @@ void ScriptFunctions::getNearestCreature(Aurora::NWScript::FunctionContext &ctx)
 	int crit3Value = ctx.getParams()[7].getInt();
 	*/
 
-	if (!_module->findObjectInit(_objSearchContext))
-		return;
-
-	std::list<Object *> creatures;
-	while (_module->findNextObject(_objSearchContext)) {
-		Creature *creature = convertCreature(_objSearchContext.getObject());
-
-		if (creature && (creature != target) && (creature->getArea() == target->getArea()))
-			creatures.push_back(creature);
-	}
-
-	creatures.sort(ObjectDistanceSort(*target));
-
-	std::list<Object *>::iterator it = creatures.begin();
-	for (int n = 0; (n < nth) && (it != creatures.end()); ++n)
-		++it;
-
-	if (it != creatures.end())
-		ctx.getReturn() = *it;
+	ctx.getReturn() = findNearestObject(*target, MAX(nth, 0), ObjectSearchFilter(target, kObjectTypeCreature));
 }
 
 void ScriptFunctions::actionSpeakString(Aurora::NWScript::FunctionContext &ctx) {
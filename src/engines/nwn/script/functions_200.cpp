@@ -620,29 +620,10 @@ void ScriptFunctions::getNearestObject(Aurora::NWScript::FunctionContext &ctx) {
 	if (!target)
 		return;
 
-	ObjectType type = (ObjectType) ctx.getParams()[0].getInt();
-	int nth = ctx.getParams()[2].getInt() - 1;
-
-	if (!_module->findObjectInit(_objSearchContext))
-		return;
-
-	std::list<Object *> objects;
-	while (_module->findNextObject(_objSearchContext)) {
-		Object *object = convertObject(_objSearchContext.getObject());
-
-		if (object && (object != target) && (object->getType() == type) &&
-		    (object->getArea() == target->getArea()))
-			objects.push_back(object);
-	}
-
-	objects.sort(ObjectDistanceSort(*target));
-
-	std::list<Object *>::iterator it = objects.begin();
-	for (int n = 0; (n < nth) && (it != objects.end()); ++n)
-		++it;
+	uint32 types = (uint32) ctx.getParams()[0].getInt();
+	int    nth   = ctx.getParams()[2].getInt() - 1;
 
-	if (it != objects.end())
-		ctx.getReturn() = *it;
+	ctx.getReturn() = findNearestObject(*target, MAX(nth, 0), ObjectSearchFilter(target, types));
 }
 
 void ScriptFunctions::getNearestObjectToLocation(Aurora::NWScript::FunctionContext &UNUSED(ctx)) {
@@ -666,25 +647,7 @@ void ScriptFunctions::getNearestObjectByTag(Aurora::NWScript::FunctionContext &c
 
 	int nth = ctx.getParams()[2].getInt() - 1;
 
-	if (!_module->findObjectInit(_objSearchContext, tag))
-		return;
-
-	std::list<Object *> objects;
-	while (_module->findNextObject(_objSearchContext)) {
-		Object *object = convertObject(_objSearchContext.getObject());
-
-		if (object && (object != target) && (object->getArea() == target->getArea()))
-			objects.push_back(object);
-	}
-
-	objects.sort(ObjectDistanceSort(*target));
-
-	std::list<Object *>::iterator it = objects.begin();
-	for (int n = 0; (n < nth) && (it != objects.end()); ++n)
-		++it;
-
-	if (it != objects.end())
-		ctx.getReturn() = *it;
+	ctx.getReturn() = findNearestObject(*target, MAX(nth, 0), ObjectSearchFilter(target, kObjectTypeAll, tag));
 }
 
 void ScriptFunctions::intToFloat(Aurora::NWScript::FunctionContext &ctx) {
@@ -1069,7 +1032,7 @@ void ScriptFunctions::actionDoCommand(Aurora::NWScript::FunctionContext &ctx) {
 	if (script.empty())
 		throw Common::Exception("ScriptFunctions::actionDoCommand(): Script needed");
 
-	const Aurora::NWScript::ScriptState &state = ctx.getParams()[0].getScriptState();
+	Aurora::NWScript::ScriptState &state = ctx.getParams()[0].getScriptState();
 
 	_module->delayScript(script, state, ctx.getCaller(), ctx.getTriggerer(), 0);
 }
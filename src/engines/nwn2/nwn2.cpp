@@ -205,98 +205,110 @@ void NWN2Engine::initResources(LoadProgress &progress) {
 
 	progress.step("Loading main resource files");
 
-	indexMandatoryArchive(Aurora::kArchiveZIP, "2da.zip"           ,  1);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "actors.zip"        ,  2);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "animtags.zip"      ,  3);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "convo.zip"         ,  4);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "ini.zip"           ,  5);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "lod-merged.zip"    ,  6);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "music.zip"         ,  7);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "nwn2_materials.zip",  8);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "nwn2_models.zip"   ,  9);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "nwn2_vfx.zip"      , 10);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "prefabs.zip"       , 11);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "scripts.zip"       , 12);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "sounds.zip"        , 13);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "soundsets.zip"     , 14);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "speedtree.zip"     , 15);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "templates.zip"     , 16);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "vo.zip"            , 17);
-	indexMandatoryArchive(Aurora::kArchiveZIP, "walkmesh.zip"      , 18);
+	ArchiveBatch mainArchives;
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "2da.zip"           ,  1));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "actors.zip"        ,  2));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "animtags.zip"      ,  3));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "convo.zip"         ,  4));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "ini.zip"           ,  5));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged.zip"    ,  6));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "music.zip"         ,  7));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials.zip",  8));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models.zip"   ,  9));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_vfx.zip"      , 10));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "prefabs.zip"       , 11));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "scripts.zip"       , 12));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "sounds.zip"        , 13));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "soundsets.zip"     , 14));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "speedtree.zip"     , 15));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "templates.zip"     , 16));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "vo.zip"            , 17));
+	mainArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "walkmesh.zip"      , 18));
+
+	indexArchives(mainArchives);
 
 	progress.step("Loading expansion 1 resource files");
 
 	// Expansion 1: Mask of the Betrayer (MotB)
-	indexOptionalArchive(Aurora::kArchiveZIP, "2da_x1.zip"           , 20);
-	indexOptionalArchive(Aurora::kArchiveZIP, "actors_x1.zip"        , 21);
-	indexOptionalArchive(Aurora::kArchiveZIP, "animtags_x1.zip"      , 22);
-	indexOptionalArchive(Aurora::kArchiveZIP, "convo_x1.zip"         , 23);
-	indexOptionalArchive(Aurora::kArchiveZIP, "ini_x1.zip"           , 24);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_x1.zip"    , 25);
-	indexOptionalArchive(Aurora::kArchiveZIP, "music_x1.zip"         , 26);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_x1.zip", 27);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_x1.zip"   , 28);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_vfx_x1.zip"      , 29);
-	indexOptionalArchive(Aurora::kArchiveZIP, "prefabs_x1.zip"       , 30);
-	indexOptionalArchive(Aurora::kArchiveZIP, "scripts_x1.zip"       , 31);
-	indexOptionalArchive(Aurora::kArchiveZIP, "soundsets_x1.zip"     , 32);
-	indexOptionalArchive(Aurora::kArchiveZIP, "sounds_x1.zip"        , 33);
-	indexOptionalArchive(Aurora::kArchiveZIP, "speedtree_x1.zip"     , 34);
-	indexOptionalArchive(Aurora::kArchiveZIP, "templates_x1.zip"     , 35);
-	indexOptionalArchive(Aurora::kArchiveZIP, "vo_x1.zip"            , 36);
-	indexOptionalArchive(Aurora::kArchiveZIP, "walkmesh_x1.zip"      , 37);
+	ArchiveBatch x1Archives;
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "2da_x1.zip"           , 20, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "actors_x1.zip"        , 21, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "animtags_x1.zip"      , 22, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "convo_x1.zip"         , 23, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "ini_x1.zip"           , 24, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_x1.zip"    , 25, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "music_x1.zip"         , 26, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_x1.zip", 27, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_x1.zip"   , 28, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_vfx_x1.zip"      , 29, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "prefabs_x1.zip"       , 30, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "scripts_x1.zip"       , 31, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "soundsets_x1.zip"     , 32, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "sounds_x1.zip"        , 33, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "speedtree_x1.zip"     , 34, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "templates_x1.zip"     , 35, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "vo_x1.zip"            , 36, true));
+	x1Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "walkmesh_x1.zip"      , 37, true));
+
+	indexArchives(x1Archives);
 
 	progress.step("Loading expansion 2 resource files");
 
 	// Expansion 2: Storm of Zehir (SoZ)
-	indexOptionalArchive(Aurora::kArchiveZIP, "2da_x2.zip"           , 40);
-	indexOptionalArchive(Aurora::kArchiveZIP, "actors_x2.zip"        , 41);
-	indexOptionalArchive(Aurora::kArchiveZIP, "animtags_x2.zip"      , 42);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_x2.zip"    , 43);
-	indexOptionalArchive(Aurora::kArchiveZIP, "music_x2.zip"         , 44);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_x2.zip", 45);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_x2.zip"   , 46);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_vfx_x2.zip"      , 47);
-	indexOptionalArchive(Aurora::kArchiveZIP, "prefabs_x2.zip"       , 48);
-	indexOptionalArchive(Aurora::kArchiveZIP, "scripts_x2.zip"       , 49);
-	indexOptionalArchive(Aurora::kArchiveZIP, "soundsets_x2.zip"     , 50);
-	indexOptionalArchive(Aurora::kArchiveZIP, "sounds_x2.zip"        , 51);
-	indexOptionalArchive(Aurora::kArchiveZIP, "speedtree_x2.zip"     , 52);
-	indexOptionalArchive(Aurora::kArchiveZIP, "templates_x2.zip"     , 53);
-	indexOptionalArchive(Aurora::kArchiveZIP, "vo_x2.zip"            , 54);
+	ArchiveBatch x2Archives;
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "2da_x2.zip"           , 40, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "actors_x2.zip"        , 41, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "animtags_x2.zip"      , 42, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_x2.zip"    , 43, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "music_x2.zip"         , 44, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_x2.zip", 45, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_x2.zip"   , 46, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_vfx_x2.zip"      , 47, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "prefabs_x2.zip"       , 48, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "scripts_x2.zip"       , 49, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "soundsets_x2.zip"     , 50, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "sounds_x2.zip"        , 51, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "speedtree_x2.zip"     , 52, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "templates_x2.zip"     , 53, true));
+	x2Archives.push_back(BatchArchive(Aurora::kArchiveZIP, "vo_x2.zip"            , 54, true));
+
+	indexArchives(x2Archives);
 
 	progress.step("Loading patch resource files");
 
-	indexOptionalArchive(Aurora::kArchiveZIP, "actors_v103x1.zip"         , 60);
-	indexOptionalArchive(Aurora::kArchiveZIP, "actors_v106.zip"           , 61);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_v101.zip"       , 62);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_v107.zip"       , 63);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_v121.zip"       , 64);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_x1_v121.zip"    , 65);
-	indexOptionalArchive(Aurora::kArchiveZIP, "lod-merged_x2_v121.zip"    , 66);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v103x1.zip" , 67);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v104.zip"   , 68);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v106.zip"   , 69);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v107.zip"   , 70);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v110.zip"   , 71);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v112.zip"   , 72);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_v121.zip"   , 73);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_x1_v113.zip", 74);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_materials_x1_v121.zip", 75);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v103x1.zip"    , 76);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v104.zip"      , 77);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v105.zip"      , 78);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v106.zip"      , 79);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v107.zip"      , 70);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v112.zip"      , 81);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_v121.zip"      , 82);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_x1_v121.zip"   , 83);
-	indexOptionalArchive(Aurora::kArchiveZIP, "nwn2_models_x2_v121.zip"   , 84);
-	indexOptionalArchive(Aurora::kArchiveZIP, "templates_v112.zip"        , 85);
-	indexOptionalArchive(Aurora::kArchiveZIP, "templates_v122.zip"        , 86);
-	indexOptionalArchive(Aurora::kArchiveZIP, "templates_x1_v122.zip"     , 87);
-	indexOptionalArchive(Aurora::kArchiveZIP, "vo_103x1.zip"              , 88);
-	indexOptionalArchive(Aurora::kArchiveZIP, "vo_106.zip"                , 89);
+	ArchiveBatch patchArchives;
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "actors_v103x1.zip"         , 60, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "actors_v106.zip"           , 61, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_v101.zip"       , 62, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_v107.zip"       , 63, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_v121.zip"       , 64, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_x1_v121.zip"    , 65, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "lod-merged_x2_v121.zip"    , 66, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v103x1.zip" , 67, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v104.zip"   , 68, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v106.zip"   , 69, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v107.zip"   , 70, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v110.zip"   , 71, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v112.zip"   , 72, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_v121.zip"   , 73, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_x1_v113.zip", 74, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_materials_x1_v121.zip", 75, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v103x1.zip"    , 76, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v104.zip"      , 77, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v105.zip"      , 78, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v106.zip"      , 79, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v107.zip"      , 70, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v112.zip"      , 81, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_v121.zip"      , 82, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_x1_v121.zip"   , 83, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "nwn2_models_x2_v121.zip"   , 84, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "templates_v112.zip"        , 85, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "templates_v122.zip"        , 86, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "templates_x1_v122.zip"     , 87, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "vo_103x1.zip"              , 88, true));
+	patchArchives.push_back(BatchArchive(Aurora::kArchiveZIP, "vo_106.zip"                , 89, true));
+
+	indexArchives(patchArchives);
 
 	progress.step("Indexing extra sound resources");
 	indexMandatoryDirectory("ambient"   , 0,  0, 100);
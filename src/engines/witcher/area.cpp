@@ -283,7 +283,7 @@ void Area::loadAreaModel() {
 	if (_modelName.empty())
 		return;
 
-	_model = loadModelObject(_modelName);
+	_model = loadModelInstance(_modelName);
 	if (!_model)
 		throw Common::Exception("Can't load area geometry model \"%s\"", _modelName.c_str());
 
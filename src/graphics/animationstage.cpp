@@ -0,0 +1,86 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Advancing the animations of renderables in parallel.
+ */
+
+#include "src/common/util.h"
+
+#include "src/graphics/animationstage.h"
+#include "src/graphics/renderable.h"
+
+namespace Graphics {
+
+/** Don't bother the worker threads with fewer renderables per batch than that. */
+static const uint32 kMinBatchSize = 8;
+
+AnimationStage::AnimationStage(uint32 threadCount) : _pool(threadCount) {
+	_batches.resize(_pool.getThreadCount());
+}
+
+AnimationStage::~AnimationStage() {
+}
+
+void AnimationStage::advanceTime(const std::vector<Renderable *> &renderables, float dt) {
+	if (renderables.empty())
+		return;
+
+	const uint32 count      = renderables.size();
+	const uint32 batchCount = MIN<uint32>(_batches.size(), (count + kMinBatchSize - 1) / kMinBatchSize);
+
+	// Not worth it, just do it ourselves
+	if (batchCount <= 1) {
+		for (std::vector<Renderable *>::const_iterator r = renderables.begin(); r != renderables.end(); ++r)
+			(*r)->advanceTime(dt);
+
+		return;
+	}
+
+	for (uint32 i = 0; i < batchCount; i++) {
+		const uint32 start = ( i      * count) / batchCount;
+		const uint32 end   = ((i + 1) * count) / batchCount;
+
+		_batches[i].renderables = &renderables[start];
+		_batches[i].count       = end - start;
+		_batches[i].dt          = dt;
+
+		_pool.addJob(_batches[i]);
+	}
+
+	_pool.wait();
+}
+
+void AnimationStage::advanceTime(const std::list<Queueable *> &renderables, float dt) {
+	_renderables.clear();
+	_renderables.reserve(renderables.size());
+
+	for (std::list<Queueable *>::const_iterator r = renderables.begin(); r != renderables.end(); ++r)
+		_renderables.push_back(static_cast<Renderable *>(*r));
+
+	advanceTime(_renderables, dt);
+}
+
+void AnimationStage::Batch::run() {
+	for (uint32 i = 0; i < count; i++)
+		renderables[i]->advanceTime(dt);
+}
+
+} // End of namespace Graphics
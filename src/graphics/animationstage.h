@@ -0,0 +1,83 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Advancing the animations of renderables in parallel.
+ */
+
+#ifndef GRAPHICS_ANIMATIONSTAGE_H
+#define GRAPHICS_ANIMATIONSTAGE_H
+
+#include <vector>
+#include <list>
+
+#include "src/common/types.h"
+#include "src/common/noncopyable.h"
+#include "src/common/threadpool.h"
+
+namespace Graphics {
+
+class Queueable;
+class Renderable;
+
+/** Advancing the time, i.e. the animations, of renderables.
+ *
+ *  The renderables are split into batches, one per worker thread. Each
+ *  renderable is only touched by one worker, so the renderables have to
+ *  keep their animation state to themselves. This doesn't use OpenGL,
+ *  so it works without a GL context.
+ */
+class AnimationStage : Common::NonCopyable {
+public:
+	/** Create an animation stage.
+	 *
+	 *  @param threadCount The number of worker threads. 0 means one per CPU core.
+	 */
+	AnimationStage(uint32 threadCount = 0);
+	~AnimationStage();
+
+	/** Advance the time of all these renderables, returning once they're all done. */
+	void advanceTime(const std::vector<Renderable *> &renderables, float dt);
+	/** Advance the time of all these renderables, returning once they're all done. */
+	void advanceTime(const std::list<Queueable *> &renderables, float dt);
+
+private:
+	/** Renderables advanced by one worker thread. */
+	class Batch : public Common::ThreadPool::Job {
+	public:
+		Renderable * const *renderables;
+		uint32 count;
+
+		float dt;
+
+		void run();
+	};
+
+	Common::ThreadPool _pool;
+
+	std::vector<Batch> _batches;
+
+	/** The renderables of the current frame, kept to avoid reallocating every frame. */
+	std::vector<Renderable *> _renderables;
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_ANIMATIONSTAGE_H
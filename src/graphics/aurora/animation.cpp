@@ -68,16 +68,25 @@ void Animation::setTransTime(float transtime) {
 	_transtime = transtime;
 }
 
-void Animation::update(Model *model, float lastFrame, float nextFrame) {
+void Animation::bind(Model &model, std::vector<ModelNode *> &targets) const {
+	targets.clear();
+	targets.reserve(nodeList.size());
+
+	for (NodeList::const_iterator n = nodeList.begin(); n != nodeList.end(); ++n)
+		targets.push_back((*n)->getNodeData() ? model.getNode((*n)->getName()) : 0);
+}
+
+void Animation::update(const std::vector<ModelNode *> &targets, float scale,
+                       float lastFrame, float nextFrame) const {
 	// TODO: Also need to fire off associated events
 	//       for event in _events event->fire()
 
+	assert(targets.size() == nodeList.size());
 
-	float scale = model->getAnimationScale(_name);
-	for (NodeList::iterator n = nodeList.begin();
-	     n != nodeList.end(); ++n) {
-		(*n)->update(model, lastFrame, nextFrame, scale);
-	}
+	std::vector<ModelNode *>::const_iterator t = targets.begin();
+	for (NodeList::const_iterator n = nodeList.begin(); n != nodeList.end(); ++n, ++t)
+		if (*t)
+			(*n)->update(**t, lastFrame, nextFrame, scale);
 }
 
 void Animation::addAnimNode(AnimNode *node) {
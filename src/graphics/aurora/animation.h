@@ -48,6 +48,7 @@ namespace Graphics {
 namespace Aurora {
 
 class AnimNode;
+class ModelNode;
 
 class Animation {
 public:
@@ -76,7 +77,15 @@ public:
 	float getLength() const;
 	void setTransTime(float transtime);
 
-	void update(Model *model, float lastFrame, float nextFrame);
+	/** Find the nodes in the model that this animation's nodes animate.
+	 *
+	 *  The nodes are returned in the order of the animation's nodes, with 0
+	 *  for nodes that don't exist in the model.
+	 */
+	void bind(Model &model, std::vector<ModelNode *> &targets) const;
+
+	/** Update the model nodes found by bind(). */
+	void update(const std::vector<ModelNode *> &targets, float scale, float lastFrame, float nextFrame) const;
 	void addAnimNode(AnimNode *node);
 };
 
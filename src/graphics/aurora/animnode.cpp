@@ -62,12 +62,12 @@ const Common::UString &AnimNode::getName() const {
 	return _name;
 }
 
-void AnimNode::update(Model *model, float UNUSED(lastFrame), float nextFrame, float scale) {
-	if (!_nodedata)
-		return;
+const ModelNode *AnimNode::getNodeData() const {
+	return _nodedata;
+}
 
-	ModelNode *target = model->getNode(_name);
-	if (!target)
+void AnimNode::update(ModelNode &target, float UNUSED(lastFrame), float nextFrame, float scale) const {
+	if (!_nodedata)
 		return;
 
 	// Determine the corresponding keyframes
@@ -78,8 +78,7 @@ void AnimNode::update(Model *model, float UNUSED(lastFrame), float nextFrame, fl
 	_nodedata->interpolateOrientation(nextFrame, oX, oY, oZ, oA);
 
 	// Update the position/orientation of corresponding modelnode
-	target->setPosition(posX * scale, posY * scale, posZ * scale);
-	target->setOrientation(oX, oY, oZ, oA);
+	target.setPose(posX * scale, posY * scale, posZ * scale, oX, oY, oZ, oA);
 }
 
 } // End of namespace Aurora
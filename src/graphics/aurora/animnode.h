@@ -51,8 +51,11 @@ public:
 	/** Get the node's name. */
 	const Common::UString &getName() const;
 
-	/** Update the model properties interpolating between frames */
-	void update(Model *model, float lastFrame, float nextFrame, float scale);
+	/** Return the model node holding this node's keyframes. */
+	const ModelNode *getNodeData() const;
+
+	/** Update the target model node, interpolating between frames. */
+	void update(ModelNode &target, float lastFrame, float nextFrame, float scale) const;
 protected:
 	// Animation *_animation; ///< The animation this node belongs to.
 
@@ -0,0 +1,133 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Keyframes of model node animations.
+ */
+
+#include <cassert>
+
+#include "src/common/util.h"
+#include "src/common/maths.h"
+
+#include "src/graphics/aurora/keyframes.h"
+
+namespace Graphics {
+
+namespace Aurora {
+
+/** Find the keyframe to interpolate from: the last one not after this time. */
+template<typename T>
+static uint32 findKeyFrame(const std::vector<T> &frames, float time) {
+	uint32 first = 0, last = frames.size();
+
+	// Binary search for the first frame after this time
+	while (first < last) {
+		const uint32 middle = first + (last - first) / 2;
+
+		if (frames[middle].time <= time)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	return (first > 0) ? (first - 1) : 0;
+}
+
+void interpolatePosition(const std::vector<PositionKeyFrame> &frames, float time,
+                         float &x, float &y, float &z) {
+
+	assert(!frames.empty());
+
+	const uint32 lastFrame = findKeyFrame(frames, time);
+
+	const PositionKeyFrame &last = frames[lastFrame];
+	if (lastFrame + 1 >= frames.size() || last.time >= time) {
+		x = last.x;
+		y = last.y;
+		z = last.z;
+		return;
+	}
+
+	const PositionKeyFrame &next = frames[lastFrame + 1];
+
+	const float f = (time - last.time) / (next.time - last.time);
+	x = f * next.x + (1.0f - f) * last.x;
+	y = f * next.y + (1.0f - f) * last.y;
+	z = f * next.z + (1.0f - f) * last.z;
+}
+
+void interpolateOrientation(const std::vector<QuaternionKeyFrame> &frames, float time,
+                            float &x, float &y, float &z, float &a) {
+
+	assert(!frames.empty());
+
+	const uint32 lastFrame = findKeyFrame(frames, time);
+
+	const QuaternionKeyFrame &last = frames[lastFrame];
+	if (lastFrame + 1 >= frames.size() || last.time >= time) {
+		x = last.x;
+		y = last.y;
+		z = last.z;
+		a = Common::rad2deg(acos(CLIP(last.q, -1.0f, 1.0f)) * 2.0);
+		return;
+	}
+
+	const QuaternionKeyFrame &next = frames[lastFrame + 1];
+
+	const float f = (time - last.time) / (next.time - last.time);
+
+	// Spherical linear interpolation, along the shorter arc
+	float cosTheta = last.x * next.x + last.y * next.y + last.z * next.z + last.q * next.q;
+	const float sign = (cosTheta < 0.0f) ? -1.0f : 1.0f;
+	cosTheta *= sign;
+
+	// Orientations very close together are linearly interpolated, for numerical stability
+	float fLast = 1.0f - f, fNext = f;
+	if (cosTheta < 0.9995f) {
+		const float theta    = acosf(cosTheta);
+		const float sinTheta = sinf(theta);
+
+		fLast = sinf((1.0f - f) * theta) / sinTheta;
+		fNext = sinf(f * theta) / sinTheta;
+	}
+
+	fNext *= sign;
+
+	x = fLast * last.x + fNext * next.x;
+	y = fLast * last.y + fNext * next.y;
+	z = fLast * last.z + fNext * next.z;
+
+	float q = fLast * last.q + fNext * next.q;
+
+	const float length = sqrtf(x * x + y * y + z * z + q * q);
+	if (length > 0.0f) {
+		x /= length;
+		y /= length;
+		z /= length;
+		q /= length;
+	}
+
+	a = Common::rad2deg(acos(CLIP(q, -1.0f, 1.0f)) * 2.0);
+}
+
+} // End of namespace Aurora
+
+} // End of namespace Graphics
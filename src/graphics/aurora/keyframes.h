@@ -0,0 +1,69 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Keyframes of model node animations.
+ */
+
+#ifndef GRAPHICS_AURORA_KEYFRAMES_H
+#define GRAPHICS_AURORA_KEYFRAMES_H
+
+#include <vector>
+
+namespace Graphics {
+
+namespace Aurora {
+
+struct PositionKeyFrame {
+	float time;
+	float x;
+	float y;
+	float z;
+};
+
+struct QuaternionKeyFrame {
+	float time;
+	float x;
+	float y;
+	float z;
+	float q;
+};
+
+/** Linearly interpolate the position at this time.
+ *
+ *  The keyframes have to be sorted by time. Times outside of the keyframes
+ *  clamp to the first or last keyframe.
+ */
+void interpolatePosition(const std::vector<PositionKeyFrame> &frames, float time,
+                         float &x, float &y, float &z);
+
+/** Spherically interpolate the orientation at this time, as an axis and an angle in degrees.
+ *
+ *  The keyframes have to be sorted by time. Times outside of the keyframes
+ *  clamp to the first or last keyframe.
+ */
+void interpolateOrientation(const std::vector<QuaternionKeyFrame> &frames, float time,
+                            float &x, float &y, float &z, float &a);
+
+} // End of namespace Aurora
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_AURORA_KEYFRAMES_H
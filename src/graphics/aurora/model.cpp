@@ -22,11 +22,14 @@
  *  A 3D model of an object.
  */
 
+#include <cstring>
+
 #include <SDL_timer.h>
 
 #include "src/common/stream.h"
 #include "src/common/debug.h"
 
+#include "src/graphics/graphics.h"
 #include "src/graphics/camera.h"
 
 #include "src/graphics/aurora/model.h"
@@ -45,7 +48,7 @@ namespace Aurora {
 
 Model::Model(ModelType type) : Renderable((RenderableType) type),
 	_type(type), _supermodel(0), _currentState(0),
-	_currentAnimation(0), _nextAnimation(0), _drawBound(false) {
+	_currentAnimation(0), _nextAnimation(0), _hasPendingPosition(false), _drawBound(false) {
 
 	_position[0] = 0.0; _position[1] = 0.0; _position[2] = 0.0;
 	_rotation[0] = 0.0; _rotation[1] = 0.0; _rotation[2] = 0.0;
@@ -58,17 +61,88 @@ Model::Model(ModelType type) : Renderable((RenderableType) type),
 
 	_loopAnimation = 0;
 
+	_animationBinding.animation = 0;
+	_animationBinding.state     = 0;
+	_animationBinding.scale     = 1.0f;
+
 	_boundRenderable = new Shader::ShaderRenderable();
 	_boundRenderable->setSurface(SurfaceMan.getSurface("defaultSurface"));
 	_boundRenderable->setMaterial(MaterialMan.getMaterial("defaultWhite"));
 	_boundRenderable->setMesh(MeshMan.getMesh("defaultWireBox"));
 }
 
+Model::Model(const boost::shared_ptr<Model> &prototype) :
+	Renderable((RenderableType) prototype->_type), _type(prototype->_type),
+	_fileName(prototype->_fileName), _name(prototype->_name),
+	_superModelName(prototype->_superModelName), _supermodel(prototype->_supermodel),
+	_currentState(0), _animationMap(prototype->_animationMap),
+	_currentAnimation(0), _nextAnimation(0), _loopAnimation(0),
+	_animationScale(prototype->_animationScale), _defaultAnimations(prototype->_defaultAnimations),
+	_hasPendingPosition(false), _prototype(prototype), _drawBound(false), _elapsedTime(0.0) {
+
+	assert(_prototype);
+
+	_position[0] = 0.0; _position[1] = 0.0; _position[2] = 0.0;
+	_rotation[0] = 0.0; _rotation[1] = 0.0; _rotation[2] = 0.0;
+
+	memcpy(_modelScale, prototype->_modelScale, 3 * sizeof(float));
+
+	_animationBinding.animation = 0;
+	_animationBinding.state     = 0;
+	_animationBinding.scale     = 1.0f;
+
+	// Clone all nodes of all states, recreating the node hierarchy
+
+	std::map<const ModelNode *, ModelNode *> instances;
+
+	for (StateList::const_iterator s = prototype->_stateList.begin(); s != prototype->_stateList.end(); ++s) {
+		State *state = new State;
+		state->name = (*s)->name;
+
+		_stateList.push_back(state);
+		_stateMap.insert(std::make_pair(state->name, state));
+
+		for (NodeList::const_iterator n = (*s)->nodeList.begin(); n != (*s)->nodeList.end(); ++n) {
+			ModelNode *node = new ModelNode(*this, **n);
+
+			instances.insert(std::make_pair(*n, node));
+
+			state->nodeList.push_back(node);
+			state->nodeMap.insert(std::make_pair(node->getName(), node));
+		}
+
+		for (NodeList::const_iterator n = (*s)->rootNodes.begin(); n != (*s)->rootNodes.end(); ++n)
+			state->rootNodes.push_back(instances[*n]);
+	}
+
+	for (std::map<const ModelNode *, ModelNode *>::iterator i = instances.begin(); i != instances.end(); ++i) {
+		if (i->first->_parent)
+			i->second->_parent = instances[i->first->_parent];
+
+		for (std::list<ModelNode *>::const_iterator c = i->first->_children.begin();
+		     c != i->first->_children.end(); ++c) {
+
+			std::map<const ModelNode *, ModelNode *>::iterator child = instances.find(*c);
+			if (child != instances.end())
+				i->second->_children.push_back(child->second);
+		}
+	}
+
+	_boundRenderable = new Shader::ShaderRenderable();
+	_boundRenderable->setSurface(SurfaceMan.getSurface("defaultSurface"));
+	_boundRenderable->setMaterial(MaterialMan.getMaterial("defaultWhite"));
+	_boundRenderable->setMesh(MeshMan.getMesh("defaultWireBox"));
+
+	finalize();
+}
+
 Model::~Model() {
 	hide();
 
-	for (AnimationMap::iterator a = _animationMap.begin(); a != _animationMap.end(); ++a)
-		delete a->second;
+	// The animations of an instance belong to its prototype
+	if (!_prototype)
+		for (AnimationMap::iterator a = _animationMap.begin(); a != _animationMap.end(); ++a)
+			delete a->second;
 
 	for (StateList::iterator s = _stateList.begin(); s != _stateList.end(); ++s) {
 		for (NodeList::iterator n = (*s)->nodeList.begin(); n != (*s)->nodeList.end(); ++n)
@@ -124,6 +198,16 @@ bool Model::isIn(float x1, float y1, float z1, float x2, float y2, float z2) con
 	return _absoluteBoundBox.isIn(x1, y1, z1, x2, y2, z2);
 }
 
+bool Model::getWorldBound(float *min, float *max) const {
+	if ((_type == kModelTypeGUIFront) || _absoluteBoundBox.empty())
+		return false;
+
+	_absoluteBoundBox.getMin(min[0], min[1], min[2]);
+	_absoluteBoundBox.getMax(max[0], max[1], max[2]);
+
+	return true;
+}
+
 float Model::getWidth() const {
 	return _boundBox.getWidth() * _modelScale[0];
 }
@@ -169,51 +253,91 @@ Animation *Model::selectDefaultAnimation() const {
 }
 
 void Model::getPosition(float &x, float &y, float &z) const {
+	GfxMan.lockPending();
+
 	x = _position[0] * _modelScale[0];
 	y = _position[1] * _modelScale[1];
 	z = _position[2] * _modelScale[2];
+
+	GfxMan.unlockPending();
 }
 
 void Model::getRotation(float &x, float &y, float &z) const {
+	GfxMan.lockPending();
+
 	x = _rotation[0];
 	y = _rotation[1];
 	z = _rotation[2];
+
+	GfxMan.unlockPending();
 }
 
 void Model::getAbsolutePosition(float &x, float &y, float &z) const {
-	x = _absolutePosition.getX();
-	y = _absolutePosition.getY();
-	z = _absolutePosition.getZ();
+	/* _absolutePosition is the transformation of the last frame rendered, and the
+	 * main thread changes it while applying the pending state. Instead, build the
+	 * transformation out of the position and rotation last set. */
+
+	GfxMan.lockPending();
+
+	Common::TransformationMatrix position;
+	createTransformation(_position, _rotation, position);
+
+	GfxMan.unlockPending();
+
+	position.getPosition(x, y, z);
 }
 
 void Model::setPosition(float x, float y, float z) {
-	lockFrameIfVisible();
+	const bool pending = beginChange();
 
 	_position[0] = x / _modelScale[0];
 	_position[1] = y / _modelScale[1];
 	_position[2] = z / _modelScale[2];
 
-	createAbsolutePosition();
-	calculateDistance();
-
-	resort();
+	updatePosition(pending);
 
-	unlockFrameIfVisible();
+	endChange(pending);
 }
 
 void Model::setRotation(float x, float y, float z) {
-	lockFrameIfVisible();
+	const bool pending = beginChange();
 
 	_rotation[0] = x;
 	_rotation[1] = y;
 	_rotation[2] = z;
 
-	createAbsolutePosition();
+	updatePosition(pending);
+
+	endChange(pending);
+}
+
+void Model::updatePosition(bool pending) {
+	if (pending) {
+		memcpy(_pendingPosition, _position, 3 * sizeof(float));
+		memcpy(_pendingRotation, _rotation, 3 * sizeof(float));
+
+		_hasPendingPosition = true;
+	} else
+		applyPosition(_position, _rotation);
+}
+
+void Model::applyPosition(const float *position, const float *rotation) {
+	createAbsolutePosition(position, rotation);
 	calculateDistance();
 
 	resort();
+}
+
+void Model::applyPending() {
+	if (_hasPendingPosition)
+		applyPosition(_pendingPosition, _pendingRotation);
 
-	unlockFrameIfVisible();
+	_hasPendingPosition = false;
+
+	for (std::vector<ModelNode *>::iterator n = _pendingNodes.begin(); n != _pendingNodes.end(); ++n)
+		(*n)->applyPending();
+
+	_pendingNodes.clear();
 }
 
 void Model::move(float x, float y, float z) {
@@ -229,30 +353,48 @@ void Model::rotate(float x, float y, float z) {
 }
 
 void Model::getTooltipAnchor(float &x, float &y, float &z) const {
-	Common::TransformationMatrix pos = _absolutePosition;
+	// Like getAbsolutePosition(), use the position and rotation last set
+	GfxMan.lockPending();
+
+	Common::TransformationMatrix pos;
+	createTransformation(_position, _rotation, pos);
+
+	GfxMan.unlockPending();
 
-	pos.translate(0.0, 0.0, _absoluteBoundBox.getHeight() + 0.5);
+	Common::BoundingBox bound = _boundBox;
+	bound.transform(pos);
+	bound.absolutize();
+
+	pos.translate(0.0, 0.0, bound.getHeight() + 0.5);
 
 	pos.getPosition(x, y, z);
 }
 
-void Model::createAbsolutePosition() {
-	_absolutePosition.loadIdentity();
+void Model::createTransformation(const float *position, const float *rotation,
+                                 Common::TransformationMatrix &transformation) const {
+
+	transformation.loadIdentity();
 
-	_absolutePosition.scale(_modelScale[0], _modelScale[1], _modelScale[2]);
+	transformation.scale(_modelScale[0], _modelScale[1], _modelScale[2]);
 
 	if (_type == kModelTypeObject)
-		_absolutePosition.rotate(90.0, -1.0, 0.0, 0.0);
+		transformation.rotate(90.0, -1.0, 0.0, 0.0);
 
-	_absolutePosition.translate(_position[0], _position[1], _position[2]);
+	transformation.translate(position[0], position[1], position[2]);
 
-	_absolutePosition.rotate( _rotation[0], 1.0, 0.0, 0.0);
-	_absolutePosition.rotate( _rotation[1], 0.0, 1.0, 0.0);
-	_absolutePosition.rotate(-_rotation[2], 0.0, 0.0, 1.0);
+	transformation.rotate( rotation[0], 1.0, 0.0, 0.0);
+	transformation.rotate( rotation[1], 0.0, 1.0, 0.0);
+	transformation.rotate(-rotation[2], 0.0, 0.0, 1.0);
+}
+
+void Model::createAbsolutePosition(const float *position, const float *rotation) {
+	createTransformation(position, rotation, _absolutePosition);
 
 	_absoluteBoundBox = _boundBox;
 	_absoluteBoundBox.transform(_absolutePosition);
 	_absoluteBoundBox.absolutize();
+
+	updateWorldBound();
 }
 
 const std::list<Common::UString> &Model::getStates() const {
@@ -383,7 +525,8 @@ float Model::getAnimationScale(const Common::UString &anim) {
 
 void Model::calculateDistance() {
 	if (_type == kModelTypeGUIFront) {
-		_distance = _position[2];
+		// Only the scale comes before the translation
+		_distance = _absolutePosition.getZ() / _modelScale[2];
 		return;
 	}
 
@@ -449,8 +592,35 @@ void Model::manageAnimations(float dt) {
 	}
 
 	// Update the animation, if we have any
-	if (_currentAnimation)
-		_currentAnimation->update(this, lastFrame, nextFrame);
+	if (!_currentAnimation)
+		return;
+
+	if ((_animationBinding.animation != _currentAnimation) || (_animationBinding.state != _currentState))
+		bindAnimation();
+
+	_currentAnimation->update(_animationBinding.targets, _animationBinding.scale, lastFrame, nextFrame);
+
+	// The order of the nodes depends on their positions, so it has to be restored once afterwards
+	if (_currentState)
+		for (NodeList::iterator n = _currentState->rootNodes.begin(); n != _currentState->rootNodes.end(); ++n)
+			(*n)->orderChildren();
+}
+
+void Model::bindAnimation() {
+	_animationBinding.animation = _currentAnimation;
+	_animationBinding.state     = _currentState;
+	_animationBinding.scale     = getAnimationScale(_currentAnimation->getName());
+
+	_currentAnimation->bind(*this, _animationBinding.targets);
+
+	/* Only animate our own nodes. Nodes found in the supermodel are shared
+	 * with all other models using it, and they aren't rendered as part of
+	 * this model anyway. And since models are animated in parallel, writing
+	 * into them would race with the other models. */
+	for (std::vector<ModelNode *>::iterator t = _animationBinding.targets.begin();
+	     t != _animationBinding.targets.end(); ++t)
+		if (*t && ((*t)->_model != this))
+			*t = 0;
 }
 
 void Model::render(RenderPass pass) {
@@ -464,17 +634,7 @@ void Model::render(RenderPass pass) {
 	}
 
 	// Apply our global model transformation
-	glScalef(_modelScale[0], _modelScale[1], _modelScale[2]);
-
-	if (_type == kModelTypeObject)
-		// Aurora world objects have a rotated axis
-		glRotatef(90.0, -1.0, 0.0, 0.0);
-
-	glTranslatef(_position[0], _position[1], _position[2]);
-
-	glRotatef( _rotation[0], 1.0, 0.0, 0.0);
-	glRotatef( _rotation[1], 0.0, 1.0, 0.0);
-	glRotatef(-_rotation[2], 0.0, 0.0, 1.0);
+	glMultMatrixf(_absolutePosition.get());
 
 
 	// Draw the bounding box, if requested
@@ -570,6 +730,8 @@ void Model::finalize() {
 	createStateNamesList();
 	setState();
 
+	// The transformation used for rendering has to include the model scale from the start
+	createAbsolutePosition(_position, _rotation);
 	createBound();
 
 	// Order all node children lists
@@ -615,6 +777,8 @@ void Model::createBound() {
 	_absoluteBoundBox = _boundBox;
 	_absoluteBoundBox.transform(_absolutePosition);
 	_absoluteBoundBox.absolutize();
+
+	updateWorldBound();
 }
 
 void Model::readValue(Common::SeekableReadStream &stream, uint32 &value) {
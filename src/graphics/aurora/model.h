@@ -29,6 +29,8 @@
 #include <list>
 #include <map>
 
+#include <boost/shared_ptr.hpp>
+
 #include "src/common/ustring.h"
 #include "src/common/transmatrix.h"
 #include "src/common/boundingbox.h"
@@ -55,6 +57,13 @@ class Animation;
 class Model : public GLContainer, public Renderable {
 public:
 	Model(ModelType type = kModelTypeObject);
+	/** Create an instance of a model.
+	 *
+	 *  The instance has its own position, state and animations, but shares
+	 *  the geometry and the animation data with the prototype model. The
+	 *  prototype is kept alive until all its instances are gone.
+	 */
+	Model(const boost::shared_ptr<Model> &prototype);
 	~Model();
 
 	ModelType getType() const; ///< Return the model's type.
@@ -85,7 +94,10 @@ public:
 	/** Get the current rotation of the model. */
 	void getRotation(float &x, float &y, float &z) const;
 
-	/** Get the position of the node after translate/rotate. */
+	/** Get the position of the model after translate/rotate.
+	 *
+	 *  This is the position last set, even if it hasn't been rendered yet.
+	 */
 	void getAbsolutePosition(float &x, float &y, float &z) const;
 
 	/** Set the current position of the model. */
@@ -98,7 +110,7 @@ public:
 	/** Rotate the model, relative to its current rotation. */
 	void rotate(float x, float y, float z);
 
-	/** Get the point where the feedback tooltip is anchored. */
+	/** Get the point where the feedback tooltip is anchored, following the position last set. */
 	void getTooltipAnchor(float &x, float &y, float &z) const;
 
 	// States
@@ -145,6 +157,7 @@ public:
 	void calculateDistance();
 	void render(RenderPass pass);
 	void advanceTime(float dt);
+	bool getWorldBound(float *min, float *max) const;
 
 
 protected:
@@ -208,6 +221,16 @@ protected:
 	float _rotation[3]; ///< Model's rotation.
 	float _center  [3]; ///< Model's center.
 
+	/** Position and rotation waiting to be applied before the next frame. */
+	float _pendingPosition[3];
+	float _pendingRotation[3];
+
+	bool _hasPendingPosition; ///< Are the pending position and rotation waiting?
+
+	/** The nodes with changes waiting to be applied before the next frame. */
+	std::vector<ModelNode *> _pendingNodes;
+
+	/** The model's transformation, as applied when rendering. */
 	Common::TransformationMatrix _absolutePosition;
 
 	/** The model's bounding box. */
@@ -234,16 +257,44 @@ protected:
 	Shader::ShaderRenderable *_boundRenderable;
 
 private:
+	/** The model this model is an instance of, owning the geometry and animations. */
+	boost::shared_ptr<Model> _prototype;
+
+	/** The model nodes an animation is applied to. */
+	struct AnimationBinding {
+		Animation *animation; ///< The bound animation.
+		State     *state;     ///< The state the nodes were found in.
+		float      scale;     ///< The scale of the animation in this model.
+
+		std::vector<ModelNode *> targets; ///< The animated nodes, by animation node.
+	};
+
 	bool _drawBound;
 	float _elapsedTime; ///< Track animation duration
 
+	/** The nodes the current animation is applied to. */
+	AnimationBinding _animationBinding;
+
 	void createStateNamesList(); ///< Create the list of all state names.
 	void createBound();          ///< Create the model's bounding box.
 
-	void createAbsolutePosition();
+	void createAbsolutePosition(const float *position, const float *rotation);
+
+	/** Build the model's transformation out of this position and rotation. */
+	void createTransformation(const float *position, const float *rotation,
+	                          Common::TransformationMatrix &transformation) const;
+
+	/** The position or rotation changed, with the pending state locked. */
+	void updatePosition(bool pending);
+	/** Move the model to this position and rotation. */
+	void applyPosition(const float *position, const float *rotation);
+
+	void applyPending();
 
 	void doDrawBound();
 	void manageAnimations(float dt);
+	/** Find the nodes the current animation is applied to. */
+	void bindAnimation();
 
 	Animation *selectDefaultAnimation() const;
 
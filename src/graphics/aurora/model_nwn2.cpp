@@ -466,21 +466,23 @@ bool ModelNode_NWN2::loadSkin(Model_NWN2::ParserContext &ctx) {
 }
 
 void ModelNode_NWN2::setTint(const float tint[3][4]) {
-	lockFrameIfVisible();
-
 	memcpy(_tint, tint, 3 * 4 * sizeof(float));
 
-	removeTint();
-	createTint();
+	// Create the tinted texture before swapping it in, so that the next frame doesn't have to wait for it
+	std::vector<TextureHandle> textures;
+	getTextures(textures);
+
+	removeTint(textures);
+	createTint(textures);
 
-	unlockFrameIfVisible();
+	swapTextures(textures);
 }
 
-void ModelNode_NWN2::removeTint() {
+void ModelNode_NWN2::removeTint(std::vector<TextureHandle> &textures) {
 	if (_tintedMapIndex < 0)
 		return;
 
-	_textures.erase(_textures.begin() + _tintedMapIndex);
+	textures.erase(textures.begin() + _tintedMapIndex);
 
 	_tintedMapIndex = -1;
 }
@@ -494,7 +496,7 @@ void ModelNode_NWN2::removeTint() {
  *
  * TODO: We really need to do this in shaders in the future.
  */
-void ModelNode_NWN2::createTint() {
+void ModelNode_NWN2::createTint(std::vector<TextureHandle> &textures) {
 	if (_tintMap.empty())
 		return;
 
@@ -543,8 +545,8 @@ void ModelNode_NWN2::createTint() {
 	// And add the new texture to the TextureManager
 	TextureHandle tintedTexture = TextureMan.add(new Texture(tintedMap));
 
-	_textures.push_back(tintedTexture);
-	_tintedMapIndex = _textures.size() - 1;
+	textures.push_back(tintedTexture);
+	_tintedMapIndex = textures.size() - 1;
 }
 
 } // End of namespace Aurora
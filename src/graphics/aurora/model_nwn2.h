@@ -100,8 +100,8 @@ private:
 
 	float _tint[3][4];
 
-	void removeTint();
-	void createTint();
+	void removeTint(std::vector<TextureHandle> &textures);
+	void createTint(std::vector<TextureHandle> &textures);
 };
 
 } // End of namespace Aurora
@@ -25,10 +25,12 @@
 #include "src/common/util.h"
 #include "src/common/maths.h"
 
+#include "src/graphics/graphics.h"
 #include "src/graphics/camera.h"
 
 #include "src/graphics/images/txi.h"
 
+#include "src/graphics/aurora/keyframes.h"
 #include "src/graphics/aurora/modelnode.h"
 #include "src/graphics/aurora/model.h"
 #include "src/graphics/aurora/texture.h"
@@ -105,8 +107,8 @@ static void DisableVertexAttrib(const VertexAttrib &va) {
 }
 
 ModelNode::ModelNode(Model &model) :
-	_model(&model), _parent(0), _level(0),
-	_isTransparent(false), _render(false), _hasTransparencyHint(false) {
+	_model(&model), _parent(0), _level(0), _sharedGeometry(0),
+	_isTransparent(false), _render(false), _hasTransparencyHint(false), _pendingChanges(0) {
 
 	_position[0] = 0.0; _position[1] = 0.0; _position[2] = 0.0;
 	_rotation[0] = 0.0; _rotation[1] = 0.0; _rotation[2] = 0.0;
@@ -117,6 +119,36 @@ ModelNode::ModelNode(Model &model) :
 	_orientation[3] = 0.0;
 }
 
+ModelNode::ModelNode(Model &model, const ModelNode &prototype) :
+	_model(&model), _parent(0), _level(prototype._level), _name(prototype._name),
+	_sharedGeometry(prototype._sharedGeometry ? prototype._sharedGeometry : &prototype),
+	_absolutePosition(prototype._absolutePosition), _shininess(prototype._shininess),
+	_textures(prototype._textures), _isTransparent(prototype._isTransparent),
+	_dangly(prototype._dangly), _period(prototype._period), _tightness(prototype._tightness),
+	_displacement(prototype._displacement), _showdispl(prototype._showdispl),
+	_displtype(prototype._displtype), _constraints(prototype._constraints),
+	_tilefade(prototype._tilefade), _scale(prototype._scale), _render(prototype._render),
+	_shadow(prototype._shadow), _beaming(prototype._beaming), _inheritcolor(prototype._inheritcolor),
+	_rotatetexture(prototype._rotatetexture), _alpha(prototype._alpha),
+	_hasTransparencyHint(prototype._hasTransparencyHint), _transparencyHint(prototype._transparencyHint),
+	_boundBox(prototype._boundBox), _absoluteBoundBox(prototype._absoluteBoundBox),
+	_pendingChanges(0) {
+
+	/* The keyframes aren't copied: animations only ever read them
+	 * out of the nodes of the model they were loaded with. */
+
+	memcpy(_center     , prototype._center     , 3 * sizeof(float));
+	memcpy(_position   , prototype._position   , 3 * sizeof(float));
+	memcpy(_rotation   , prototype._rotation   , 3 * sizeof(float));
+	memcpy(_orientation, prototype._orientation, 4 * sizeof(float));
+
+	memcpy(_wirecolor, prototype._wirecolor, 3 * sizeof(float));
+	memcpy(_ambient  , prototype._ambient  , 3 * sizeof(float));
+	memcpy(_diffuse  , prototype._diffuse  , 3 * sizeof(float));
+	memcpy(_specular , prototype._specular , 3 * sizeof(float));
+	memcpy(_selfIllum, prototype._selfIllum, 3 * sizeof(float));
+}
+
 ModelNode::~ModelNode() {
 	// dtor
 }
@@ -164,22 +196,41 @@ bool ModelNode::isInFrontOf(const ModelNode &node) const {
 }
 
 void ModelNode::getPosition(float &x, float &y, float &z) const {
-	x = _position[0] * _model->_modelScale[0];
-	y = _position[1] * _model->_modelScale[1];
-	z = _position[2] * _model->_modelScale[2];
+	GfxMan.lockPending();
+
+	// Changes that haven't been applied yet are already the node's position for the caller
+	const float *position = (_pendingChanges & kPendingPosition) ? _pendingPosition : _position;
+
+	x = position[0] * _model->_modelScale[0];
+	y = position[1] * _model->_modelScale[1];
+	z = position[2] * _model->_modelScale[2];
+
+	GfxMan.unlockPending();
 }
 
 void ModelNode::getRotation(float &x, float &y, float &z) const {
-	x = _rotation[0];
-	y = _rotation[1];
-	z = _rotation[2];
+	GfxMan.lockPending();
+
+	const float *rotation = (_pendingChanges & kPendingRotation) ? _pendingRotation : _rotation;
+
+	x = rotation[0];
+	y = rotation[1];
+	z = rotation[2];
+
+	GfxMan.unlockPending();
 }
 
 void ModelNode::getOrientation(float &x, float &y, float &z, float &a) const {
-	x = _orientation[0];
-	y = _orientation[1];
-	z = _orientation[2];
-	a = _orientation[3];
+	GfxMan.lockPending();
+
+	const float *orientation = (_pendingChanges & kPendingOrientation) ? _pendingOrientation : _orientation;
+
+	x = orientation[0];
+	y = orientation[1];
+	z = orientation[2];
+	a = orientation[3];
+
+	GfxMan.unlockPending();
 }
 
 void ModelNode::getAbsolutePosition(float &x, float &y, float &z) const {
@@ -189,37 +240,51 @@ void ModelNode::getAbsolutePosition(float &x, float &y, float &z) const {
 }
 
 void ModelNode::setPosition(float x, float y, float z) {
-	lockFrameIfVisible();
+	const bool pending = _model->beginChange();
 
-	_position[0] = x / _model->_modelScale[0];
-	_position[1] = y / _model->_modelScale[1];
-	_position[2] = z / _model->_modelScale[2];
+	float *position = pending ? _pendingPosition : _position;
 
-	if (_parent)
+	position[0] = x / _model->_modelScale[0];
+	position[1] = y / _model->_modelScale[1];
+	position[2] = z / _model->_modelScale[2];
+
+	if (pending)
+		queueChange(kPendingPosition);
+	else if (_parent)
 		_parent->orderChildren();
 
-	unlockFrameIfVisible();
+	_model->endChange(pending);
 }
 
 void ModelNode::setRotation(float x, float y, float z) {
-	lockFrameIfVisible();
+	const bool pending = _model->beginChange();
+
+	float *rotation = pending ? _pendingRotation : _rotation;
+
+	rotation[0] = x;
+	rotation[1] = y;
+	rotation[2] = z;
 
-	_rotation[0] = x;
-	_rotation[1] = y;
-	_rotation[2] = z;
+	if (pending)
+		queueChange(kPendingRotation);
 
-	unlockFrameIfVisible();
+	_model->endChange(pending);
 }
 
 void ModelNode::setOrientation(float x, float y, float z, float a) {
-	lockFrameIfVisible();
+	const bool pending = _model->beginChange();
 
-	_orientation[0] = x;
-	_orientation[1] = y;
-	_orientation[2] = z;
-	_orientation[3] = a;
+	float *orientation = pending ? _pendingOrientation : _orientation;
 
-	unlockFrameIfVisible();
+	orientation[0] = x;
+	orientation[1] = y;
+	orientation[2] = z;
+	orientation[3] = a;
+
+	if (pending)
+		queueChange(kPendingOrientation);
+
+	_model->endChange(pending);
 }
 
 void ModelNode::move(float x, float y, float z) {
@@ -230,7 +295,10 @@ void ModelNode::move(float x, float y, float z) {
 }
 
 void ModelNode::rotate(float x, float y, float z) {
-	setRotation(_rotation[0] + x, _rotation[1] + y, _rotation[2] + z);
+	float curX, curY, curZ;
+	getRotation(curX, curY, curZ);
+
+	setRotation(curX + x, curY + y, curZ + z);
 }
 
 void ModelNode::inheritPosition(ModelNode &node) const {
@@ -253,6 +321,8 @@ void ModelNode::inheritGeometry(ModelNode &node) const {
 	node._vertexBuffer  = _vertexBuffer;
 	node._indexBuffer   = _indexBuffer;
 
+	node._sharedGeometry = _sharedGeometry;
+
 	memcpy(node._center, _center, 3 * sizeof(float));
 	node._boundBox = _boundBox;
 }
@@ -323,44 +393,122 @@ void ModelNode::addChild(Model *model) {
 }
 
 void ModelNode::setInvisible(bool invisible) {
-	_render = !invisible;
+	const bool pending = _model->beginChange();
+
+	if (pending) {
+		_pendingRender = !invisible;
+		queueChange(kPendingRender);
+	} else
+		_render = !invisible;
+
+	_model->endChange(pending);
 }
 
 void ModelNode::setTextures(const std::vector<Common::UString> &textures) {
-	lockFrameIfVisible();
+	// Slots without a new texture keep their current one
+	std::vector<TextureHandle> handles;
+	getTextures(handles);
+
+	// Load the textures before locking, so that the next frame doesn't have to wait for that
+	bool isTransparent = false;
+
+	// Assert that this node should be rendered, unless there are no textures to render with
+	const bool render = loadTextures(textures, handles, isTransparent);
+
+	// Swap them in; the replaced textures are only released after unlocking
+	const bool pending = _model->beginChange();
+
+	if (pending) {
+		_pendingTextures.swap(handles);
+		_pendingTransparent = isTransparent;
+		_pendingRender      = render;
+
+		queueChange(kPendingTextures | kPendingTransparent | kPendingRender);
+	} else {
+		_textures.swap(handles);
+		_isTransparent = isTransparent;
+		_render        = render;
+	}
+
+	_model->endChange(pending);
+}
+
+void ModelNode::getTextures(std::vector<TextureHandle> &textures) const {
+	GfxMan.lockPending();
+
+	textures = (_pendingChanges & kPendingTextures) ? _pendingTextures : _textures;
+
+	GfxMan.unlockPending();
+}
+
+void ModelNode::swapTextures(std::vector<TextureHandle> &textures) {
+	const bool pending = _model->beginChange();
+
+	if (pending) {
+		_pendingTextures.swap(textures);
+		queueChange(kPendingTextures);
+	} else
+		_textures.swap(textures);
+
+	_model->endChange(pending);
+}
+
+void ModelNode::queueChange(uint32 change) {
+	if (_pendingChanges == 0)
+		_model->_pendingNodes.push_back(this);
+
+	_pendingChanges |= change;
+}
 
-	// Assert that this node should be rendered and try to load the textures.
-	// NOTE: loadTextures() will automatically disable rendering of the node
-	//       again when texture loading fails.
-	_render = true;
-	loadTextures(textures);
+void ModelNode::applyPending() {
+	if (_pendingChanges & kPendingPosition) {
+		memcpy(_position, _pendingPosition, 3 * sizeof(float));
 
-	unlockFrameIfVisible();
+		if (_parent)
+			_parent->orderChildren();
+	}
+
+	if (_pendingChanges & kPendingRotation)
+		memcpy(_rotation, _pendingRotation, 3 * sizeof(float));
+	if (_pendingChanges & kPendingOrientation)
+		memcpy(_orientation, _pendingOrientation, 4 * sizeof(float));
+
+	if (_pendingChanges & kPendingTextures)
+		_textures.swap(_pendingTextures);
+	if (_pendingChanges & kPendingTransparent)
+		_isTransparent = _pendingTransparent;
+
+	if (_pendingChanges & kPendingRender)
+		_render = _pendingRender;
+
+	_pendingChanges = 0;
 }
 
 void ModelNode::loadTextures(const std::vector<Common::UString> &textures) {
+	// If the node has no actual texture, we just assume
+	// that the geometry shouldn't be rendered.
+	if (!loadTextures(textures, _textures, _isTransparent))
+		_render = false;
+}
+
+bool ModelNode::loadTextures(const std::vector<Common::UString> &textures,
+                             std::vector<TextureHandle> &handles, bool &isTransparent) const {
+
 	bool hasTexture = false;
 
-	_textures.resize(textures.size());
+	handles.resize(textures.size());
 
 	bool hasAlpha = true;
 	bool isDecal  = true;
 
+	// Request all textures first, so that they are decoded in parallel
 	for (uint t = 0; t != textures.size(); t++) {
 
 		try {
 
 			if (!textures[t].empty() && (textures[t] != "NULL")) {
-				_textures[t] = TextureMan.get(textures[t]);
+				handles[t] = TextureMan.get(textures[t]);
 				hasTexture = true;
-
-				if (!_textures[t].getTexture().hasAlpha())
-					hasAlpha = false;
-				if (_textures[t].getTexture().getTXI().getFeatures().alphaMean == 1.0)
-					hasAlpha = false;
-
-				if (!_textures[t].getTexture().getTXI().getFeatures().decal)
-					isDecal = false;
 			}
 
 		} catch (...) {
@@ -369,18 +517,28 @@ void ModelNode::loadTextures(const std::vector<Common::UString> &textures) {
 
 	}
 
+	for (uint t = 0; t != handles.size(); t++) {
+		if (handles[t].empty())
+			continue;
+
+		if (!handles[t].getTexture().hasAlpha())
+			hasAlpha = false;
+		if (handles[t].getTexture().getTXI().getFeatures().alphaMean == 1.0)
+			hasAlpha = false;
+
+		if (!handles[t].getTexture().getTXI().getFeatures().decal)
+			isDecal = false;
+	}
+
 	if (_hasTransparencyHint) {
-		_isTransparent = _transparencyHint;
+		isTransparent = _transparencyHint;
 		if (isDecal)
-			_isTransparent = true;
+			isTransparent = true;
 	} else {
-		_isTransparent = hasAlpha;
+		isTransparent = hasAlpha;
 	}
 
-	// If the node has no actual texture, we just assume
-	// that the geometry shouldn't be rendered.
-	if (!hasTexture)
-		_render = false;
+	return hasTexture;
 }
 
 void ModelNode::createBound() {
@@ -459,12 +617,15 @@ void ModelNode::renderGeometry() {
 
 	// Render the node's faces
 
-	const VertexDecl &vertexDecl = _vertexBuffer.getVertexDecl();
+	const ModelNode &geometry = _sharedGeometry ? *_sharedGeometry : *this;
+
+	const VertexDecl &vertexDecl = geometry._vertexBuffer.getVertexDecl();
 
 	for (uint32 i = 0; i < vertexDecl.size(); i++)
 		EnableVertexAttrib(vertexDecl[i]);
 
-	glDrawElements(GL_TRIANGLES, _indexBuffer.getCount(), _indexBuffer.getType(), _indexBuffer.getData());
+	const IndexBuffer &indices = geometry._indexBuffer;
+	glDrawElements(GL_TRIANGLES, indices.getCount(), indices.getType(), indices.getData());
 
 	for (uint32 i = 0; i < vertexDecl.size(); i++)
 		DisableVertexAttrib(vertexDecl[i]);
@@ -489,7 +650,9 @@ void ModelNode::render(RenderPass pass) {
 
 	// Render the node's geometry
 
-	bool shouldRender = _render && (_indexBuffer.getCount() > 0);
+	const ModelNode &geometry = _sharedGeometry ? *_sharedGeometry : *this;
+
+	bool shouldRender = _render && (geometry._indexBuffer.getCount() > 0);
 	if (((pass == kRenderPassOpaque)      &&  _isTransparent) ||
 	    ((pass == kRenderPassTransparent) && !_isTransparent))
 		shouldRender = false;
@@ -506,87 +669,46 @@ void ModelNode::render(RenderPass pass) {
 	}
 }
 
-void ModelNode::lockFrame() {
-	_model->lockFrame();
-}
-
-void ModelNode::unlockFrame() {
-	_model->unlockFrame();
-}
-
-void ModelNode::lockFrameIfVisible() {
-	_model->lockFrameIfVisible();
-}
-
-void ModelNode::unlockFrameIfVisible() {
-	_model->unlockFrameIfVisible();
-}
-
 void ModelNode::interpolatePosition(float time, float &x, float &y, float &z) const {
 	// If less than 2 keyframes, don't interpolate, just return the only position
 	if (_positionFrames.size() < 2) {
-		getPosition(x, y, z);
-		return;
-	}
-
-	uint32 lastFrame = 0;
-	for (uint32 i = 0; i < _positionFrames.size(); i++) {
-		const PositionKeyFrame &pos = _positionFrames[i];
-		if (pos.time >= time)
-			break;
-
-		lastFrame = i;
-	}
-
-	const PositionKeyFrame &last = _positionFrames[lastFrame];
-	if (lastFrame + 1 >= _positionFrames.size() || last.time == time) {
-		x = last.x;
-		y = last.y;
-		z = last.z;
+		x = _position[0] * _model->_modelScale[0];
+		y = _position[1] * _model->_modelScale[1];
+		z = _position[2] * _model->_modelScale[2];
 		return;
 	}
 
-	const PositionKeyFrame &next = _positionFrames[lastFrame + 1];
-
-	const float f = (time - last.time) / (next.time - last.time);
-	x = f * next.x + (1.0f - f) * last.x;
-	y = f * next.y + (1.0f - f) * last.y;
-	z = f * next.z + (1.0f - f) * last.z;
+	Aurora::interpolatePosition(_positionFrames, time, x, y, z);
 }
 
 void ModelNode::interpolateOrientation(float time, float &x, float &y, float &z, float &a) const {
 	// If less than 2 keyframes, don't interpolate just return the only orientation
 	if (_orientationFrames.size() < 2) {
-		getOrientation(x, y, z, a);
+		x = _orientation[0];
+		y = _orientation[1];
+		z = _orientation[2];
+		a = _orientation[3];
 		return;
 	}
 
-	uint32 lastFrame = 0;
-	for (uint32 i = 0; i < _orientationFrames.size(); i++) {
-		const QuaternionKeyFrame &pos = _orientationFrames[i];
-		if (pos.time >= time)
-			break;
-
-		lastFrame = i;
-	}
+	Aurora::interpolateOrientation(_orientationFrames, time, x, y, z, a);
+}
 
-	const QuaternionKeyFrame &last = _orientationFrames[lastFrame];
-	if (lastFrame + 1 >= _orientationFrames.size() || last.time == time) {
-		x = last.x;
-		y = last.y;
-		z = last.z;
-		a = Common::rad2deg(acos(last.q) * 2.0);
-	}
+void ModelNode::setPose(float x, float y, float z, float oX, float oY, float oZ, float oA) {
+	/* Animations run on the animation stage's worker threads, while other
+	 * threads may read the node's position and orientation at the same time. */
+	GfxMan.lockPending();
 
-	const QuaternionKeyFrame &next = _orientationFrames[lastFrame + 1];
+	_position[0] = x / _model->_modelScale[0];
+	_position[1] = y / _model->_modelScale[1];
+	_position[2] = z / _model->_modelScale[2];
 
-	const float f = (time - last.time) / (next.time - last.time);
-	x = f * next.x + (1.0f - f) * last.x;
-	y = f * next.y + (1.0f - f) * last.y;
-	z = f * next.z + (1.0f - f) * last.z;
+	_orientation[0] = oX;
+	_orientation[1] = oY;
+	_orientation[2] = oZ;
+	_orientation[3] = oA;
 
-	const float q = f * next.q + (1.0f - f) * last.q;
-	a = Common::rad2deg(acos(q) * 2.0);
+	GfxMan.unlockPending();
 }
 
 } // End of namespace Aurora
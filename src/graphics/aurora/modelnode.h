@@ -38,6 +38,7 @@
 
 #include "src/graphics/aurora/types.h"
 #include "src/graphics/aurora/textureman.h"
+#include "src/graphics/aurora/keyframes.h"
 
 namespace Graphics {
 
@@ -45,24 +46,11 @@ namespace Aurora {
 
 class Model;
 
-struct PositionKeyFrame {
-	float time;
-	float x;
-	float y;
-	float z;
-};
-
-struct QuaternionKeyFrame {
-	float time;
-	float x;
-	float y;
-	float z;
-	float q;
-};
-
 class ModelNode {
 public:
 	ModelNode(Model &model);
+	/** Create an instance of a node, sharing the prototype node's geometry. */
+	ModelNode(Model &model, const ModelNode &prototype);
 	virtual ~ModelNode();
 
 	/** Get the node's name. */
@@ -118,6 +106,9 @@ protected:
 	VertexBuffer _vertexBuffer; ///< Node geometry vertex buffer.
 	IndexBuffer _indexBuffer;   ///< Node geometry index buffer.
 
+	/** The node whose geometry this instance node renders, instead of its own. */
+	const ModelNode *_sharedGeometry;
+
 	float _center     [3]; ///< The node's center.
 	float _position   [3]; ///< Position of the node.
 	float _rotation   [3]; ///< Node rotation.
@@ -173,19 +164,47 @@ protected:
 
 	// Loading helpers
 	void loadTextures(const std::vector<Common::UString> &textures);
+	/** Load these textures, returning whether the node has any texture at all. */
+	bool loadTextures(const std::vector<Common::UString> &textures,
+	                  std::vector<TextureHandle> &handles, bool &isTransparent) const;
 	void createBound();
 	void createCenter();
 
 	void render(RenderPass pass);
 
-	void lockFrame();
-	void unlockFrame();
-
-	void lockFrameIfVisible();
-	void unlockFrameIfVisible();
+	/** Get the node's textures, including changes that haven't been applied yet. */
+	void getTextures(std::vector<TextureHandle> &textures) const;
+	/** Replace the node's textures, returning the replaced ones in textures. */
+	void swapTextures(std::vector<TextureHandle> &textures);
 
 
 private:
+	/** Changes to the node, waiting for the model's pending state to be applied. */
+	enum PendingChange {
+		kPendingPosition    = 1 << 0,
+		kPendingRotation    = 1 << 1,
+		kPendingOrientation = 1 << 2,
+		kPendingRender      = 1 << 3,
+		kPendingTextures    = 1 << 4,
+		kPendingTransparent = 1 << 5
+	};
+
+	uint32 _pendingChanges; ///< The PendingChange flags of the changes waiting.
+
+	float _pendingPosition   [3];
+	float _pendingRotation   [3];
+	float _pendingOrientation[4];
+
+	bool _pendingRender;
+	bool _pendingTransparent;
+
+	std::vector<TextureHandle> _pendingTextures;
+
+	/** Queue a change with the model. The model's pending state has to be locked. */
+	void queueChange(uint32 change);
+	/** Apply the changes waiting. */
+	void applyPending();
+
 	const Common::BoundingBox &getAbsoluteBound() const;
 	void createAbsoluteBound(Common::BoundingBox parentPosition);
 
@@ -193,6 +212,11 @@ private:
 
 	void renderGeometry();
 
+	/** Set the animated position and orientation, without locking the frame or reordering.
+	 *
+	 *  Locks the pending scene changes, which guard the values against concurrent reads. */
+	void setPose(float x, float y, float z, float oX, float oY, float oZ, float oA);
+
 
 public:
 	// General helpers
@@ -216,6 +240,7 @@ public:
 	void interpolateOrientation(float time, float &x, float &y, float &z, float &a) const;
 
 	friend class Model;
+	friend class AnimNode;
 };
 
 } // End of namespace Aurora
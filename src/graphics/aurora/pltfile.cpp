@@ -22,6 +22,9 @@
  *  BioWare's Packed Layered Texture.
  */
 
+#include <cstring>
+
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/stream.h"
 
@@ -52,8 +55,11 @@ static const char *kPalettes[PLTFile::kLayerMAX] = {
 	"pal_tattoo01"
 };
 
-PLTFile::PLTFile(const Common::UString &fileName) : _name(fileName),
-	_dataImage(0), _dataLayers(0) {
+Common::Mutex         PLTFile::_paletteMutex;
+PLTFile::PaletteCache PLTFile::_paletteCache;
+uint32                PLTFile::_paletteRevision = 0;
+
+PLTFile::PLTFile(const Common::UString &fileName) : _name(fileName), _dataIndices(0) {
 
 	assert(!_name.empty());
 
@@ -68,18 +74,13 @@ PLTFile::~PLTFile() {
 }
 
 void PLTFile::clear() {
-	delete[] _dataImage;
-	delete[] _dataLayers;
+	delete[] _dataIndices;
 
-	_dataImage = _dataLayers = 0;
+	_dataIndices = 0;
 }
 
 bool PLTFile::reload() {
-	delete _dataImage;
-	delete _dataLayers;
-
-	_dataImage  = 0;
-	_dataLayers = 0;
+	clear();
 
 	load();
 	rebuild();
@@ -140,15 +141,25 @@ void PLTFile::readHeader(Common::SeekableReadStream &plt) {
 void PLTFile::readData(Common::SeekableReadStream &plt) {
 	uint32 size = _width * _height;
 
-	_dataImage  = new uint8[size];
-	_dataLayers = new uint8[size];
+	byte *data = new byte[2 * size];
+
+	try {
+		if (plt.read(data, 2 * size) != (2 * size))
+			throw Common::Exception(Common::kReadError);
+
+		_dataIndices = new uint16[size];
+
+		// Pairs of image value and layer, combined into an index into the color table
+		const byte *pixel = data;
+		for (uint32 i = 0; i < size; i++, pixel += 2)
+			_dataIndices[i] = (MIN<uint8>(pixel[1], kLayerMAX - 1) << 8) | pixel[0];
 
-	uint8 *image = _dataImage;
-	uint8 *layer = _dataLayers;
-	while (size-- > 0) {
-		*image++ = plt.readByte();
-		*layer++ = MIN<uint8>(plt.readByte(), kLayerMAX - 1);
+	} catch (...) {
+		delete[] data;
+		throw;
 	}
+
+	delete[] data;
 }
 
 void PLTFile::setLayerColor(Layer layer, uint8 color) {
@@ -161,56 +172,72 @@ void PLTFile::rebuild() {
 	if (_texture.empty())
 		return;
 
-	PLTImage *t = new PLTImage(*this);
+	uint32 table[256 * kLayerMAX];
+	getColorTable(table);
 
-	_texture.getTexture().reload(t);
+	_texture.getTexture().reload(new PLTImage(*this, table));
 }
 
-TextureHandle PLTFile::getTexture() const {
-	return _texture;
-}
+void PLTFile::rebuild(const std::vector<PLTFile *> &plts) {
+	std::vector<const PLTFile *> tableColors;
+	std::vector<uint32>          tables;
 
+	for (std::vector<PLTFile *>::const_iterator p = plts.begin(); p != plts.end(); ++p) {
+		PLTFile &plt = **p;
+		if (plt._texture.empty())
+			continue;
 
-PLTImage::PLTImage(const PLTFile &parent) {
-	_compressed = false;
-	_hasAlpha   = true;
+		// Look for an earlier PLT with the same colors
+		size_t table = 0;
+		while ((table < tableColors.size()) &&
+		       memcmp(tableColors[table]->_colors, plt._colors, sizeof(plt._colors)))
+			table++;
 
-	_format    = kPixelFormatBGRA;
-	_formatRaw = kPixelFormatRGBA8;
-	_dataType  = kPixelDataType8;
+		if (table == tableColors.size()) {
+			tableColors.push_back(&plt);
+			tables.resize(tables.size() + 256 * kLayerMAX);
 
-	create(parent);
-}
+			plt.getColorTable(&tables[table * 256 * kLayerMAX]);
+		}
 
-PLTImage::~PLTImage() {
+		plt._texture.getTexture().reload(new PLTImage(plt, &tables[table * 256 * kLayerMAX]));
+	}
 }
 
-void PLTImage::create(const PLTFile &parent) {
-	_mipMaps.push_back(new MipMap);
-
-	_mipMaps[0]->width  = parent._width;
-	_mipMaps[0]->height = parent._height;
-	_mipMaps[0]->size   = _mipMaps[0]->width * _mipMaps[0]->height * 4;
-	_mipMaps[0]->data   = new byte[_mipMaps[0]->size];
+void PLTFile::getColorTable(uint32 *table) const {
+	Common::StackLock lock(_paletteMutex);
 
-	byte rows[4 * 256 * PLTFile::kLayerMAX];
-	getColorRows(parent, rows);
+	for (uint i = 0; i < kLayerMAX; i++, table += 256) {
+		const Palette *palette = getPalette(kPalettes[i]);
 
-	uint32 pixels = parent._width * parent._height;
-	const byte *image = parent._dataImage;
-	const byte *layer = parent._dataLayers;
-	      byte *dst   = _mipMaps[0]->data;
+		if (!palette || (_colors[i] >= palette->height)) {
+			memset(table, 0, 256 * sizeof(uint32));
+			continue;
+		}
 
-	for (uint32 i = 0; i < pixels; i++, image++, layer++, dst += 4)
-		memcpy(dst, rows + (*layer * 4 * 256) + (*image * 4), 4);
+		memcpy(table, &palette->colors[_colors[i] * 256], 256 * sizeof(uint32));
+	}
 }
 
-void PLTImage::getColorRows(const PLTFile &parent, byte *rows) {
-	for (uint i = 0; i < PLTFile::kLayerMAX; i++, rows += 4 * 256) {
+const PLTFile::Palette *PLTFile::getPalette(const Common::UString &name) {
+	// The resources changed, so the palettes might have, too
+	if (_paletteRevision != ResMan.getRevision()) {
+		_paletteCache.clear();
+
+		_paletteRevision = ResMan.getRevision();
+	}
+
+	PaletteCache::iterator cached = _paletteCache.find(name);
+	if (cached == _paletteCache.end()) {
+		cached = _paletteCache.insert(std::make_pair(name, Palette())).first;
+
+		Palette &palette = cached->second;
+		palette.height = 0;
+
 		Common::SeekableReadStream *tgaFile = 0;
 
 		try {
-			tgaFile = ResMan.getResource(kPalettes[i], ::Aurora::kFileTypeTGA);
+			tgaFile = ResMan.getResource(name, ::Aurora::kFileTypeTGA);
 			if (!tgaFile)
 				throw std::exception();
 
@@ -218,24 +245,67 @@ void PLTImage::getColorRows(const PLTFile &parent, byte *rows) {
 			if (tga.getFormat() != kPixelFormatBGRA)
 				throw std::exception();
 
-			const MipMap &mipMap = tga.getMipMap(0);
+			const ImageDecoder::MipMap &mipMap = tga.getMipMap(0);
 			if (mipMap.width != 256)
 				throw std::exception();
 
-			uint8 row = parent._colors[i];
-			if (row >= mipMap.height)
-				throw std::exception();
+			palette.colors.resize(mipMap.height * 256);
 
-			row = mipMap.height - 1 - row;
+			// The image is stored upside down, with the first color row at the bottom
+			for (int i = 0; i < mipMap.height; i++)
+				memcpy(&palette.colors[i * 256], mipMap.data + ((mipMap.height - 1 - i) * 4 * 256), 4 * 256);
 
-			memcpy(rows, mipMap.data + (row * 4 * 256), 4 * 256);
+			palette.height = mipMap.height;
 
 		} catch (...) {
-			memset(rows, 0, 4 * 256);
+			// Remember that this palette is broken, so that all layers using it stay black
+			palette.colors.clear();
 		}
 
 		delete tgaFile;
 	}
+
+	if (cached->second.height == 0)
+		return 0;
+
+	return &cached->second;
+}
+
+TextureHandle PLTFile::getTexture() const {
+	return _texture;
+}
+
+
+PLTImage::PLTImage(const PLTFile &parent, const uint32 *table) {
+	_compressed = false;
+	_hasAlpha   = true;
+
+	_format    = kPixelFormatBGRA;
+	_formatRaw = kPixelFormatRGBA8;
+	_dataType  = kPixelDataType8;
+
+	create(parent, table);
+}
+
+PLTImage::~PLTImage() {
+}
+
+void PLTImage::create(const PLTFile &parent, const uint32 *table) {
+	_mipMaps.push_back(new MipMap);
+
+	_mipMaps[0]->width  = parent._width;
+	_mipMaps[0]->height = parent._height;
+	_mipMaps[0]->size   = _mipMaps[0]->width * _mipMaps[0]->height * 4;
+	_mipMaps[0]->data   = new byte[_mipMaps[0]->size];
+
+	const uint32  pixels  = parent._width * parent._height;
+	const uint16 *indices = parent._dataIndices;
+	      uint32 *dst     = reinterpret_cast<uint32 *>(_mipMaps[0]->data);
+
+	/* A straight gather out of the color table. The table entries are copied
+	 * verbatim, so this works independently of the host's endianness. */
+	for (uint32 i = 0; i < pixels; i++)
+		dst[i] = table[indices[i]];
 }
 
 } // End of namespace Aurora
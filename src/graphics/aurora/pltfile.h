@@ -25,7 +25,11 @@
 #ifndef GRAPHICS_AURORA_PLTFILE_H
 #define GRAPHICS_AURORA_PLTFILE_H
 
+#include <vector>
+#include <map>
+
 #include "src/common/ustring.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/aurorafile.h"
 
@@ -62,19 +66,37 @@ public:
 	void setLayerColor(Layer layer, uint8 color);
 	void rebuild();
 
+	/** Rebuild several PLTs in one go.
+	 *
+	 *  PLTs with the same layer colors share their color lookup table.
+	 */
+	static void rebuild(const std::vector<PLTFile *> &plts);
+
 private:
+	/** A decoded palette image. */
+	struct Palette {
+		uint32 height;
+		std::vector<uint32> colors; ///< 256 BGRA colors per row, already in layer color order.
+	};
+
+	typedef std::map<Common::UString, Palette> PaletteCache;
+
 	Common::UString _name;
 
 	uint32 _width;
 	uint32 _height;
 
-	uint8 *_dataImage;
-	uint8 *_dataLayers;
+	/** Index into the color lookup table for each pixel: layer * 256 + image value. */
+	uint16 *_dataIndices;
 
 	uint8 _colors[kLayerMAX];
 
 	TextureHandle _texture;
 
+	static Common::Mutex _paletteMutex;
+	static PaletteCache  _paletteCache;
+	static uint32        _paletteRevision;
+
 
 	TextureHandle getTexture() const;
 
@@ -84,6 +106,11 @@ private:
 
 	void clear();
 
+	/** Fill the color lookup table for this PLT's current layer colors. */
+	void getColorTable(uint32 *table) const;
+
+	static const Palette *getPalette(const Common::UString &name);
+
 
 	friend class PLTImage;
 	friend class TextureManager;
@@ -94,10 +121,9 @@ public:
 	~PLTImage();
 
 private:
-	PLTImage(const PLTFile &parent);
+	PLTImage(const PLTFile &parent, const uint32 *table);
 
-	void create(const PLTFile &parent);
-	void getColorRows(const PLTFile &parent, byte *rows);
+	void create(const PLTFile &parent, const uint32 *table);
 
 	friend class PLTFile;
 };
@@ -28,6 +28,7 @@
 #include "src/common/stream.h"
 
 #include "src/graphics/aurora/texture.h"
+#include "src/graphics/aurora/textureman.h"
 
 #include "src/graphics/types.h"
 #include "src/graphics/graphics.h"
@@ -50,7 +51,9 @@ namespace Graphics {
 namespace Aurora {
 
 Texture::Texture(const Common::UString &name) :
-	_type(::Aurora::kFileTypeNone), _image(0), _txi(0), _width(0), _height(0) {
+	_type(::Aurora::kFileTypeNone), _image(0), _txi(0), _width(0), _height(0),
+	_hasAlpha(false), _decoding(false), _streamed(false), _evicted(false), _resident(false),
+	_size(0), _lastUsed(0) {
 
 	_txi = new TXI();
 
@@ -67,7 +70,9 @@ Texture::Texture(const Common::UString &name) :
 }
 
 Texture::Texture(ImageDecoder *image, const TXI *txi) :
-	_type(::Aurora::kFileTypeNone), _image(0), _txi(0), _width(0), _height(0) {
+	_type(::Aurora::kFileTypeNone), _image(0), _txi(0), _width(0), _height(0),
+	_hasAlpha(false), _decoding(false), _streamed(false), _evicted(false), _resident(false),
+	_size(0), _lastUsed(0) {
 
 	if (txi)
 		_txi = new TXI(*txi);
@@ -87,6 +92,9 @@ Texture::Texture(ImageDecoder *image, const TXI *txi) :
 }
 
 Texture::~Texture() {
+	if (_resident)
+		TextureMan.removeResident(*this);
+
 	removeFromQueue(kQueueNewTexture);
 	removeFromQueue(kQueueTexture);
 
@@ -98,18 +106,21 @@ Texture::~Texture() {
 }
 
 uint32 Texture::getWidth() const {
+	waitDecode();
+
 	return _width;
 }
 
 uint32 Texture::getHeight() const {
+	waitDecode();
+
 	return _height;
 }
 
 bool Texture::hasAlpha() const {
-	if (!_image)
-		return false;
+	waitDecode();
 
-	return _image->hasAlpha();
+	return _hasAlpha;
 }
 
 ImageDecoder *Texture::loadImage(const Common::UString &name, ::Aurora::FileType *type) {
@@ -121,23 +132,29 @@ ImageDecoder *Texture::loadImage(const Common::UString &name, ::Aurora::FileType
 	if (type)
 		*type = iType;
 
+	return loadImage(img, iType);
+}
+
+ImageDecoder *Texture::loadImage(Common::SeekableReadStream *img, ::Aurora::FileType type) {
+	assert(img);
+
 	ImageDecoder *image = 0;
 
 	try {
 
 		// Loading the different image formats
-		if      (iType == ::Aurora::kFileTypeTGA)
+		if      (type == ::Aurora::kFileTypeTGA)
 			image = new TGA(*img);
-		else if (iType == ::Aurora::kFileTypeDDS)
+		else if (type == ::Aurora::kFileTypeDDS)
 			image = new DDS(*img);
-		else if (iType == ::Aurora::kFileTypeTPC)
+		else if (type == ::Aurora::kFileTypeTPC)
 			image = new TPC(*img);
-		else if (iType == ::Aurora::kFileTypeTXB)
+		else if (type == ::Aurora::kFileTypeTXB)
 			image = new TXB(*img);
-		else if (iType == ::Aurora::kFileTypeSBM)
+		else if (type == ::Aurora::kFileTypeSBM)
 			image = new SBM(*img);
 		else
-			throw Common::Exception("Unsupported image resource type %d", (int) iType);
+			throw Common::Exception("Unsupported image resource type %d", (int) type);
 
 	} catch (...) {
 		delete img;
@@ -167,42 +184,60 @@ void Texture::loadTXI(Common::SeekableReadStream *stream) {
 		return;
 
 	delete _txi;
-	_txi = 0;
+	_txi = readTXI(stream);
+}
+
+TXI *Texture::readTXI(Common::SeekableReadStream *stream) {
+	assert(stream);
+
+	TXI *txi = 0;
 
 	try {
-		_txi = new TXI(*stream);
+		txi = new TXI(*stream);
 	} catch (Common::Exception &e) {
 		e.add("Failed loading TXI");
 		Common::printException(e);
 
-		_txi = new TXI();
+		txi = new TXI();
 	}
 
 	delete stream;
+	return txi;
 }
 
 void Texture::loadImage() {
 	if (!_image) {
-		_width  = 0;
-		_height = 0;
+		_width    = 0;
+		_height   = 0;
+		_hasAlpha = false;
 		return;
 	}
 
-	if (_image->getMipMapCount() < 1)
-		throw Common::Exception("Texture has no images");
-
-	// Decompress
-	if (GfxMan.needManualDeS3TC())
-		_image->decompress();
+	prepareImage(*_image);
 
 	// Set dimensions
 	_width  = _image->getMipMap(0).width;
 	_height = _image->getMipMap(0).height;
 
+	_hasAlpha = _image->hasAlpha();
+
 	// If we've still got no TXI, look if the image provides TXI data
 	loadTXI(_image->getTXI());
 }
 
+void Texture::prepareImage(ImageDecoder &image) {
+	if (image.getMipMapCount() < 1)
+		throw Common::Exception("Texture has no images");
+
+	// Decompress
+	if (GfxMan.needManualDeS3TC())
+		image.decompress();
+}
+
+void Texture::waitDecode() const {
+	TextureMan.waitForDecode(*this);
+}
+
 void Texture::doDestroy() {
 	if (_textureID == 0)
 		return;
@@ -277,19 +312,26 @@ void Texture::doRebuild() {
 
 	}
 
+	TextureMan.addResident(*this);
 }
 
 const TXI &Texture::getTXI() const {
+	waitDecode();
+
 	return *_txi;
 }
 
 const ImageDecoder &Texture::getImage() const {
+	waitDecode();
+
 	assert(_image);
 
 	return *_image;
 }
 
 bool Texture::reload(ImageDecoder *image, const TXI *txi) {
+	waitDecode();
+
 	removeFromQueue(kQueueNewTexture);
 	removeFromQueue(kQueueTexture);
 
@@ -318,6 +360,8 @@ bool Texture::reload(const Common::UString &name) {
 		// Yeah, we don't know the resource name, so we can't reload the texture
 		return false;
 
+	waitDecode();
+
 	removeFromQueue(kQueueNewTexture);
 	removeFromQueue(kQueueTexture);
 
@@ -335,6 +379,8 @@ bool Texture::reload(const Common::UString &name) {
 }
 
 bool Texture::dumpTGA(const Common::UString &fileName) const {
+	waitDecode();
+
 	if (!_image)
 		return false;
 
@@ -25,6 +25,8 @@
 #ifndef GRAPHICS_AURORA_TEXTURE_H
 #define GRAPHICS_AURORA_TEXTURE_H
 
+#include <list>
+
 #include "src/common/ustring.h"
 
 #include "src/graphics/types.h"
@@ -72,6 +74,8 @@ public:
 
 	/** Load a texture image resource. */
 	static ImageDecoder *loadImage(const Common::UString &name, ::Aurora::FileType *type = 0);
+	/** Load a texture image of this type out of a stream, taking over the stream. */
+	static ImageDecoder *loadImage(Common::SeekableReadStream *stream, ::Aurora::FileType type);
 
 protected:
 	// GLContainer
@@ -89,12 +93,34 @@ private:
 	uint32 _width;
 	uint32 _height;
 
+	bool _hasAlpha;
+
+	/** Is the image still being decoded in the background? Guarded by the TextureManager. */
+	bool _decoding;
+
+	// Residency information, managed by the TextureManager
+	bool   _streamed; ///< Can the image be evicted and read from its resource again?
+	bool   _evicted;  ///< Was the image evicted to keep within the texture memory budget?
+	bool   _resident; ///< Is the texture in the TextureManager's list of uploaded textures?
+	uint32 _size;     ///< Estimated size of the uploaded texture, in bytes.
+	uint32 _lastUsed; ///< Timestamp of when the texture was last bound.
+
+	std::list<Texture *>::iterator _residentPos;
+
 	void load(const Common::UString &name);
 	void load(ImageDecoder *image);
 
 	void loadTXI(Common::SeekableReadStream *stream);
 	void loadImage();
 
+	/** Wait until the background decoding of this texture is finished. */
+	void waitDecode() const;
+
+	/** Read a TXI out of a stream, taking over the stream. */
+	static TXI *readTXI(Common::SeekableReadStream *stream);
+	/** Make sure the image is usable as a texture and decompress it if necessary. */
+	static void prepareImage(ImageDecoder &image);
+
 	friend class TextureManager;
 };
 
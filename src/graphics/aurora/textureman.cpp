@@ -22,9 +22,14 @@
  *  The Aurora texture manager.
  */
 
+#include <vector>
+#include <algorithm>
+
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/uuid.h"
+#include "src/common/stream.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/resman.h"
 
@@ -33,8 +38,12 @@
 #include "src/graphics/aurora/pltfile.h"
 
 #include "src/graphics/graphics.h"
+#include "src/graphics/queueman.h"
+#include "src/graphics/images/decoder.h"
+#include "src/graphics/images/txi.h"
 
 #include "src/events/requests.h"
+#include "src/events/events.h"
 
 DECLARE_SINGLETON(Graphics::Aurora::TextureManager)
 
@@ -150,16 +159,67 @@ PLTFile &PLTHandle::getPLT() const {
 }
 
 
-TextureManager::TextureManager() {
+/** Reads and decodes a texture in a worker thread. */
+struct TextureManager::DecodeJob : public Common::ThreadPool::Job {
+	Texture *texture; ///< The texture to decode into, 0 if it was destroyed.
+
+	Common::UString    name;
+	::Aurora::FileType type;
+
+	::Aurora::ResourceManager::Prefetch image; ///< The image resource.
+	::Aurora::ResourceManager::Prefetch txi;   ///< The TXI resource, if there is one.
+
+	bool running; ///< Is a worker thread decoding the texture right now?
+	bool done;    ///< Are we finished?
+
+	DecodeJob(Texture &t, const Common::UString &n, ::Aurora::FileType ty) :
+		texture(&t), name(n), type(ty), running(false), done(false) {
+	}
+
+	void run() {
+		TextureMan.runDecode(*this);
+	}
+};
+
+
+/** Estimate the memory an uploaded image takes up. */
+static uint32 getUploadSize(const ImageDecoder &image) {
+	uint32 size = 0;
+	for (uint32 i = 0; i < image.getMipMapCount(); i++)
+		size += image.getMipMap(i).size;
+
+	// OpenGL generates the mip maps on its own, adding another third
+	if (image.getMipMapCount() == 1)
+		size += size / 3;
+
+	return size;
+}
+
+
+TextureManager::TextureManager() : _decodePool(0),
+	_texturesQueued(0), _texturesDecoding(0), _texturesUploaded(0),
+	_residentSize(0), _textureBudget(kDefaultTextureBudget), _textureEvictions(0), _textureRestreams(0),
+	_decodeDone(_decodeMutex) {
 }
 
 TextureManager::~TextureManager() {
 	clear();
+
+	// Forget about the textures we don't own
+	Common::StackLock lock(_decodeMutex);
+
+	for (std::list<Texture *>::iterator t = _resident.begin(); t != _resident.end(); ++t)
+		(*t)->_resident = false;
+
+	_resident.clear();
+	_residentSize = 0;
 }
 
 void TextureManager::clear() {
 	Common::StackLock lock(_mutex);
 
+	cancelDecodes();
+
 	_newPLTs.clear();
 
 	for (PLTList::iterator p = _plts.begin(); p != _plts.end(); ++p)
@@ -213,7 +273,7 @@ TextureHandle TextureManager::get(const Common::UString &name) {
 	if (texture == _textures.end()) {
 		std::pair<TextureMap::iterator, bool> result;
 
-		ManagedTexture *t = new ManagedTexture(name);
+		ManagedTexture *t = new ManagedTexture(name, createTexture(name));
 
 		result = _textures.insert(std::make_pair(name, t));
 
@@ -250,6 +310,8 @@ void TextureManager::release(TextureHandle &texture) {
 
 	if (!texture._empty && (texture._it != _textures.end())) {
 		if (--texture._it->second->referenceCount == 0) {
+			cancelDecode(*texture._it->second->texture);
+
 			delete texture._it->second;
 			_textures.erase(texture._it);
 		}
@@ -276,6 +338,8 @@ void TextureManager::release(PLTHandle &plt) {
 void TextureManager::reloadAll() {
 	Common::StackLock lock(_mutex);
 
+	waitForDecodes();
+
 	GfxMan.lockFrame();
 
 	TextureMap::iterator texture;
@@ -294,6 +358,352 @@ void TextureManager::reloadAll() {
 	GfxMan.unlockFrame();
 }
 
+Texture *TextureManager::createTexture(const Common::UString &name) {
+	::Aurora::FileType type = ::Aurora::kFileTypeNone;
+
+	// Look up the resources now, but read them in the background
+	::Aurora::ResourceManager::Prefetch image = ResMan.prefetch(::Aurora::kResourceImage, name, &type);
+	if (image.empty())
+		throw Common::Exception("No such image resource \"%s\"", name.c_str());
+
+	// An empty placeholder, until the image is decoded
+	Texture *texture = new Texture(0);
+	texture->removeFromQueue(kQueueNewTexture);
+
+	texture->_name     = name;
+	texture->_type     = type;
+	texture->_streamed = true;
+
+	DecodeJob *job = new DecodeJob(*texture, name, type);
+
+	job->image = image;
+
+	queueDecode(job);
+
+	return texture;
+}
+
+void TextureManager::queueDecode(DecodeJob *job) {
+	// The decode workers can't look up anything in the resource index, so do it here
+	if (ResMan.hasResource(job->name, ::Aurora::kFileTypeTXI))
+		job->txi = ResMan.prefetch(job->name, ::Aurora::kFileTypeTXI);
+
+	Common::StackLock lock(_decodeMutex);
+
+	// Forget about the finished jobs
+	for (DecodeJobList::iterator j = _decodeJobs.begin(); j != _decodeJobs.end(); ) {
+		if ((*j)->done) {
+			delete *j;
+			j = _decodeJobs.erase(j);
+		} else
+			++j;
+	}
+
+	if (!_decodePool)
+		_decodePool = new Common::ThreadPool(MIN<uint32>(Common::ThreadPool::getCPUCount(), kDecodeThreads));
+
+	job->texture->_decoding = true;
+	_texturesQueued++;
+
+	_decodeJobs.push_back(job);
+	_decodePool->addJob(*job);
+}
+
+void TextureManager::runDecode(DecodeJob &job) {
+	_decodeMutex.lock();
+
+	_texturesQueued--;
+
+	Texture *texture = job.texture;
+	if (!texture) {
+		// The texture was destroyed before we even started
+		job.done = true;
+
+		_decodeDone.broadcast();
+		_decodeMutex.unlock();
+		return;
+	}
+
+	job.running = true;
+	_texturesDecoding++;
+
+	_decodeMutex.unlock();
+
+	ImageDecoder *image = 0;
+	TXI *txi = 0;
+
+	/* We can't look anything up in the resource index here, since it might be changed
+	 * in the meantime. If the prefetches were cancelled, because the index did change,
+	 * the texture is read again once it's used, like an evicted one. */
+	bool cancelled = false;
+
+	Common::SeekableReadStream *img = 0, *txiStream = 0;
+
+	try {
+		if (!job.image.takePrefetched(img) || !job.txi.takePrefetched(txiStream))
+			cancelled = true;
+
+		if (!cancelled) {
+			if (!img)
+				throw Common::Exception("No such image resource \"%s\"", job.name.c_str());
+
+			// This takes over the stream, even if it throws
+			Common::SeekableReadStream *imageStream = img;
+			img = 0;
+
+			image = Texture::loadImage(imageStream, job.type);
+
+			Texture::prepareImage(*image);
+
+			// TXI data within the image overrides a TXI resource
+			Common::SeekableReadStream *imageTXI = image->getTXI();
+			if (imageTXI) {
+				delete txiStream;
+				txiStream = imageTXI;
+			}
+
+			txi = txiStream ? Texture::readTXI(txiStream) : new TXI();
+			txiStream = 0;
+		}
+
+	} catch (Common::Exception &e) {
+		delete image;
+		image = 0;
+
+		e.add("Failed loading texture \"%s\"", job.name.c_str());
+		Common::printException(e, "WARNING: ");
+	}
+
+	delete img;
+	delete txiStream;
+
+	if (image) {
+		// Hand the image over, making sure the context isn't rebuilt in the meantime
+		QueueMan.lockQueue(kQueueGLContainer);
+		_decodeMutex.lock();
+
+		if (txi) {
+			delete texture->_txi;
+			texture->_txi = txi;
+		}
+
+		delete texture->_image;
+
+		texture->_image    = image;
+		texture->_width    = image->getMipMap(0).width;
+		texture->_height   = image->getMipMap(0).height;
+		texture->_hasAlpha = image->hasAlpha();
+
+		_decodeMutex.unlock();
+		QueueMan.unlockQueue(kQueueGLContainer);
+
+		// The main thread uploads it on the next frame
+		texture->addToQueue(kQueueNewTexture);
+	}
+
+	Common::StackLock lock(_decodeMutex);
+
+	if (cancelled)
+		texture->_evicted = true;
+
+	texture->_decoding = false;
+
+	job.running = false;
+	job.done    = true;
+
+	_texturesDecoding--;
+
+	_decodeDone.broadcast();
+}
+
+void TextureManager::cancelDecode(const Texture &texture) {
+	Common::StackLock lock(_decodeMutex);
+
+	if (!texture._decoding)
+		return;
+
+	for (DecodeJobList::iterator j = _decodeJobs.begin(); j != _decodeJobs.end(); ++j) {
+		DecodeJob &job = **j;
+		if (job.texture != &texture)
+			continue;
+
+		// Wait for the worker thread to let go of the texture
+		while (job.running)
+			_decodeDone.wait(100);
+
+		job.texture = 0;
+	}
+}
+
+void TextureManager::cancelDecodes() {
+	// Drop the queued jobs and wait for the running ones to finish
+	delete _decodePool;
+	_decodePool = 0;
+
+	Common::StackLock lock(_decodeMutex);
+
+	for (DecodeJobList::iterator j = _decodeJobs.begin(); j != _decodeJobs.end(); ++j) {
+		if (!(*j)->done && (*j)->texture)
+			(*j)->texture->_decoding = false;
+
+		delete *j;
+	}
+
+	_decodeJobs.clear();
+
+	_texturesQueued   = 0;
+	_texturesDecoding = 0;
+
+	_decodeDone.broadcast();
+}
+
+void TextureManager::waitForDecode(const Texture &texture) const {
+	Common::StackLock lock(_decodeMutex);
+
+	while (texture._decoding)
+		_decodeDone.wait(100);
+}
+
+void TextureManager::waitForDecodes() {
+	Common::StackLock lock(_decodeMutex);
+
+	while ((_texturesQueued > 0) || (_texturesDecoding > 0))
+		_decodeDone.wait(100);
+}
+
+bool TextureManager::isDecoding(const Texture &texture) const {
+	Common::StackLock lock(_decodeMutex);
+
+	return texture._decoding;
+}
+
+void TextureManager::addResident(Texture &texture) {
+	assert(texture._image);
+
+	const uint32 now = EventMan.getTimestamp();
+
+	Common::StackLock lock(_decodeMutex);
+
+	_texturesUploaded++;
+
+	if (texture._resident) {
+		_residentSize -= texture._size;
+	} else {
+		texture._residentPos = _resident.insert(_resident.end(), &texture);
+		texture._resident    = true;
+	}
+
+	texture._size     = getUploadSize(*texture._image);
+	texture._lastUsed = now;
+
+	_residentSize += texture._size;
+
+	evictTextures(now);
+}
+
+void TextureManager::removeResident(Texture &texture) {
+	Common::StackLock lock(_decodeMutex);
+
+	if (!texture._resident)
+		return;
+
+	_resident.erase(texture._residentPos);
+	_residentSize -= texture._size;
+
+	texture._resident = false;
+	texture._size     = 0;
+}
+
+void TextureManager::evictTextures(uint32 now) {
+	if ((_textureBudget == 0) || (_residentSize <= _textureBudget))
+		return;
+
+	// Only textures we can read again that weren't used just now
+	std::vector<Texture *> candidates;
+	for (std::list<Texture *>::iterator t = _resident.begin(); t != _resident.end(); ++t)
+		if ((*t)->_streamed && !(*t)->_decoding && ((now - (*t)->_lastUsed) >= kEvictionDelay))
+			candidates.push_back(*t);
+
+	std::sort(candidates.begin(), candidates.end(), &TextureManager::isLessRecentlyUsed);
+
+	for (std::vector<Texture *>::iterator t = candidates.begin(); t != candidates.end(); ++t) {
+		if (_residentSize <= _textureBudget)
+			break;
+
+		evictTexture(**t);
+	}
+}
+
+bool TextureManager::isLessRecentlyUsed(const Texture *a, const Texture *b) {
+	return a->_lastUsed < b->_lastUsed;
+}
+
+void TextureManager::evictTexture(Texture &texture) {
+	// Drop the OpenGL texture and the image data, but keep everything else around
+	texture.destroy();
+
+	delete texture._image;
+	texture._image = 0;
+
+	_resident.erase(texture._residentPos);
+	_residentSize -= texture._size;
+
+	texture._resident = false;
+	texture._size     = 0;
+	texture._evicted  = true;
+
+	_textureEvictions++;
+}
+
+void TextureManager::restream(Texture &texture) {
+	texture._evicted = false;
+
+	_decodeMutex.lock();
+	_textureRestreams++;
+	_decodeMutex.unlock();
+
+	// Look up the image here, like for a new texture, and only read it in the background
+	DecodeJob *job = new DecodeJob(texture, texture._name, texture._type);
+
+	job->image = ResMan.prefetch(texture._name, texture._type);
+
+	queueDecode(job);
+}
+
+void TextureManager::setTextureBudget(uint32 size) {
+	Common::StackLock lock(_decodeMutex);
+
+	// Textures are only evicted in the main thread, so this takes effect with the next upload
+	_textureBudget = size;
+}
+
+TextureManager::ResidencyStatistics TextureManager::getResidencyStatistics() const {
+	Common::StackLock lock(_decodeMutex);
+
+	ResidencyStatistics stats;
+
+	stats.evictions = _textureEvictions;
+	stats.restreams = _textureRestreams;
+
+	stats.textures = _resident.size();
+	stats.size     = _residentSize;
+	stats.budget   = _textureBudget;
+
+	return stats;
+}
+
+TextureManager::DecodeStatistics TextureManager::getDecodeStatistics() const {
+	Common::StackLock lock(_decodeMutex);
+
+	DecodeStatistics stats;
+
+	stats.queued   = _texturesQueued;
+	stats.decoding = _texturesDecoding;
+	stats.uploaded = _texturesUploaded;
+
+	return stats;
+}
+
 void TextureManager::getNewPLTs(std::list<PLTHandle> &plts) {
 	for (std::list<PLTHandle>::const_iterator p = _newPLTs.begin(); p != _newPLTs.end(); ++p)
 		plts.push_back(*p);
@@ -320,8 +730,17 @@ void TextureManager::set(const TextureHandle &handle) {
 		return;
 	}
 
-	TextureID id = handle._it->second->texture->getID();
-	if (id == 0)
+	Texture &texture = *handle._it->second->texture;
+
+	texture._lastUsed = EventMan.getTimestamp();
+
+	// Read an evicted texture again, it's an empty placeholder until then
+	if (texture._evicted)
+		restream(texture);
+
+	// Textures still being decoded are empty placeholders for now
+	TextureID id = texture.getID();
+	if ((id == 0) && !isDecoding(texture))
 		warning("Empty texture ID for texture \"%s\"", handle._it->first.c_str());
 
 	glBindTexture(GL_TEXTURE_2D, id);
@@ -35,6 +35,10 @@
 #include "src/common/mutex.h"
 #include "src/common/ustring.h"
 
+namespace Common {
+	class ThreadPool;
+}
+
 namespace Graphics {
 
 namespace Aurora {
@@ -116,6 +120,26 @@ private:
 /** The global Aurora texture manager. */
 class TextureManager : public Common::Singleton<TextureManager> {
 public:
+	/** Statistics about the background texture decoding. */
+	struct DecodeStatistics {
+		uint32 queued;   ///< Textures waiting to be decoded.
+		uint32 decoding; ///< Textures being decoded right now.
+		uint64 uploaded; ///< Textures uploaded to OpenGL so far.
+	};
+
+	/** Statistics about the textures kept in memory. */
+	struct ResidencyStatistics {
+		uint64 evictions; ///< Number of textures evicted to stay within the budget.
+		uint64 restreams; ///< Number of evicted textures that had to be read again.
+
+		uint32 textures; ///< Number of currently uploaded textures.
+		uint64 size;     ///< Estimated memory used by the uploaded textures, in bytes.
+		uint32 budget;   ///< Memory budget for the uploaded textures, in bytes.
+	};
+
+	/** Default texture memory budget, in bytes. */
+	static const uint32 kDefaultTextureBudget = 1024 * 1024 * 1024;
+
 	TextureManager();
 	~TextureManager();
 
@@ -123,12 +147,38 @@ public:
 
 
 	TextureHandle add(Texture *texture, Common::UString name = "");
+
+	/** Get a texture image resource.
+	 *
+	 *  New textures are read and decoded in the background. Until they are
+	 *  finished, they are empty placeholders, and any query of their
+	 *  properties waits for the decoding.
+	 */
 	TextureHandle get(const Common::UString &name);
 
 
 	void reloadAll();
 
 
+	/** Wait until all textures are decoded. */
+	void waitForDecodes();
+
+	DecodeStatistics getDecodeStatistics() const;
+
+
+	/** Set the memory budget for uploaded textures.
+	 *
+	 *  Once the budget is exceeded, the least recently used textures that
+	 *  were read from a resource are evicted. They are read again in the
+	 *  background as soon as they are used again.
+	 *
+	 *  @param size The budget in bytes. 0 disables the eviction.
+	 */
+	void setTextureBudget(uint32 size);
+
+	ResidencyStatistics getResidencyStatistics() const;
+
+
 	void getNewPLTs(std::list<PLTHandle> &plts);
 	void clearNewPLTs();
 
@@ -142,6 +192,15 @@ public:
 
 
 private:
+	struct DecodeJob;
+
+	typedef std::list<DecodeJob *> DecodeJobList;
+
+	static const uint32 kDecodeThreads = 4;
+
+	/** Textures used within this many milliseconds are never evicted. */
+	static const uint32 kEvictionDelay = 2000;
+
 	TextureMap _textures;
 	PLTList    _plts;
 
@@ -149,6 +208,44 @@ private:
 
 	Common::Mutex _mutex;
 
+	Common::ThreadPool *_decodePool; ///< The worker threads decoding textures.
+	DecodeJobList       _decodeJobs; ///< All decode jobs that aren't finished yet.
+
+	uint32 _texturesQueued;
+	uint32 _texturesDecoding;
+	uint64 _texturesUploaded;
+
+	std::list<Texture *> _resident; ///< All uploaded textures.
+
+	uint64 _residentSize;  ///< Estimated memory used by the uploaded textures.
+	uint32 _textureBudget; ///< Maximum memory used by the uploaded textures.
+
+	uint64 _textureEvictions;
+	uint64 _textureRestreams;
+
+	/** Guards the decoding and the residency information. */
+	mutable Common::Mutex     _decodeMutex;
+	mutable Common::Condition _decodeDone;
+
+	Texture *createTexture(const Common::UString &name);
+	void queueDecode(DecodeJob *job);
+
+	void runDecode(DecodeJob &job);
+	void cancelDecode(const Texture &texture);
+	void cancelDecodes();
+
+	void waitForDecode(const Texture &texture) const;
+	bool isDecoding(const Texture &texture) const;
+
+	void addResident(Texture &texture);
+	void removeResident(Texture &texture);
+
+	void evictTextures(uint32 now);
+	void evictTexture(Texture &texture);
+	void restream(Texture &texture);
+
+	static bool isLessRecentlyUsed(const Texture *a, const Texture *b);
+
 	void release(TextureMap::iterator &i);
 	void release(PLTList::iterator &i);
 
@@ -157,6 +254,7 @@ private:
 	void release(TextureHandle &texture);
 	void release(PLTHandle &plt);
 
+	friend class Texture;
 	friend class PLTHandle;
 	friend class TextureHandle;
 };
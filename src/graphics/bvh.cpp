@@ -0,0 +1,484 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounding volume hierarchy over renderables.
+ */
+
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+
+#include "src/common/util.h"
+
+#include "src/graphics/bvh.h"
+#include "src/graphics/frustum.h"
+
+namespace Graphics {
+
+/** How much larger than the renderable's box a leaf box is, on all sides. */
+static const float kMargin = 0.5f;
+
+/** Half the surface area of a box, the cost of visiting it. */
+static float getCost(const float *min, const float *max) {
+	const float x = max[0] - min[0];
+	const float y = max[1] - min[1];
+	const float z = max[2] - min[2];
+
+	return x * y + y * z + z * x;
+}
+
+/** Half the surface area of the box around two boxes. */
+static float getCombinedCost(const float *minA, const float *maxA, const float *minB, const float *maxB) {
+	float min[3], max[3];
+	for (int i = 0; i < 3; i++) {
+		min[i] = MIN(minA[i], minB[i]);
+		max[i] = MAX(maxA[i], maxB[i]);
+	}
+
+	return getCost(min, max);
+}
+
+static bool contains(const float *outerMin, const float *outerMax, const float *min, const float *max) {
+	for (int i = 0; i < 3; i++)
+		if ((min[i] < outerMin[i]) || (max[i] > outerMax[i]))
+			return false;
+
+	return true;
+}
+
+
+bool BVH::Hit::operator<(const Hit &hit) const {
+	return distance < hit.distance;
+}
+
+
+bool BVH::Node::isLeaf() const {
+	return child1 == kNullNode;
+}
+
+
+BVH::BVH() : _root(kNullNode), _freeList(kNullNode), _count(0) {
+}
+
+BVH::~BVH() {
+}
+
+void BVH::clear() {
+	_nodes.clear();
+
+	_root     = kNullNode;
+	_freeList = kNullNode;
+	_count    = 0;
+}
+
+uint32 BVH::getCount() const {
+	return _count;
+}
+
+uint32 BVH::insert(Renderable *object, const float *min, const float *max) {
+	const int32 leaf = allocateNode();
+
+	Node &node = _nodes[leaf];
+	for (int i = 0; i < 3; i++) {
+		node.min[i] = min[i] - kMargin;
+		node.max[i] = max[i] + kMargin;
+	}
+
+	node.object = object;
+	node.height = 0;
+
+	insertLeaf(leaf);
+	_count++;
+
+	return (uint32) leaf;
+}
+
+void BVH::move(uint32 proxy, const float *min, const float *max) {
+	assert((proxy < _nodes.size()) && _nodes[proxy].isLeaf());
+
+	Node &node = _nodes[proxy];
+
+	// Still within the enlarged box, nothing to do
+	if (contains(node.min, node.max, min, max))
+		return;
+
+	removeLeaf(proxy);
+
+	for (int i = 0; i < 3; i++) {
+		node.min[i] = min[i] - kMargin;
+		node.max[i] = max[i] + kMargin;
+	}
+
+	insertLeaf(proxy);
+}
+
+void BVH::remove(uint32 proxy) {
+	assert((proxy < _nodes.size()) && _nodes[proxy].isLeaf());
+
+	removeLeaf(proxy);
+	freeNode(proxy);
+
+	_count--;
+}
+
+void BVH::query(const Frustum &frustum, std::vector<Renderable *> &objects) const {
+	objects.clear();
+
+	if (_root == kNullNode)
+		return;
+
+	std::vector<int32> stack;
+	stack.reserve(64);
+
+	stack.push_back(_root);
+	while (!stack.empty()) {
+		const Node &node = _nodes[stack.back()];
+		stack.pop_back();
+
+		if (!frustum.isIn(node.min, node.max))
+			continue;
+
+		if (node.isLeaf()) {
+			objects.push_back(node.object);
+			continue;
+		}
+
+		stack.push_back(node.child1);
+		stack.push_back(node.child2);
+	}
+}
+
+void BVH::raycast(const float *start, const float *end, std::vector<Hit> &hits) const {
+	hits.clear();
+
+	if (_root == kNullNode)
+		return;
+
+	std::vector<int32> stack;
+	stack.reserve(64);
+
+	stack.push_back(_root);
+	while (!stack.empty()) {
+		const Node &node = _nodes[stack.back()];
+		stack.pop_back();
+
+		float distance;
+		if (!intersect(start, end, node.min, node.max, distance))
+			continue;
+
+		if (node.isLeaf()) {
+			hits.push_back(Hit());
+
+			hits.back().distance = distance;
+			hits.back().object   = node.object;
+			continue;
+		}
+
+		stack.push_back(node.child1);
+		stack.push_back(node.child2);
+	}
+
+	std::sort(hits.begin(), hits.end());
+}
+
+bool BVH::intersect(const float *start, const float *end,
+                    const float *min, const float *max, float &distance) {
+
+	// Slab test: clip the line against the three pairs of planes enclosing the box
+
+	float tMin = 0.0f, tMax = 1.0f;
+
+	for (int i = 0; i < 3; i++) {
+		const float direction = end[i] - start[i];
+
+		if (fabsf(direction) < 1e-8f) {
+			// Parallel to the slab, so it has to start within it
+			if ((start[i] < min[i]) || (start[i] > max[i]))
+				return false;
+
+			continue;
+		}
+
+		float t1 = (min[i] - start[i]) / direction;
+		float t2 = (max[i] - start[i]) / direction;
+		if (t1 > t2)
+			SWAP(t1, t2);
+
+		tMin = MAX(tMin, t1);
+		tMax = MIN(tMax, t2);
+
+		if (tMin > tMax)
+			return false;
+	}
+
+	distance = tMin;
+	return true;
+}
+
+int32 BVH::allocateNode() {
+	int32 node = _freeList;
+
+	if (node != kNullNode)
+		_freeList = _nodes[node].parent;
+	else {
+		node = _nodes.size();
+		_nodes.push_back(Node());
+	}
+
+	Node &n = _nodes[node];
+
+	n.object = 0;
+	n.parent = kNullNode;
+	n.child1 = kNullNode;
+	n.child2 = kNullNode;
+	n.height = 0;
+
+	return node;
+}
+
+void BVH::freeNode(int32 node) {
+	_nodes[node].object = 0;
+	_nodes[node].parent = _freeList;
+	_nodes[node].height = -1;
+
+	_freeList = node;
+}
+
+void BVH::insertLeaf(int32 leaf) {
+	if (_root == kNullNode) {
+		_root = leaf;
+		_nodes[_root].parent = kNullNode;
+		return;
+	}
+
+	const float *leafMin = _nodes[leaf].min;
+	const float *leafMax = _nodes[leaf].max;
+
+	// Descend to the sibling that grows the tree the least
+	int32 index = _root;
+	while (!_nodes[index].isLeaf()) {
+		const Node &node = _nodes[index];
+
+		const float cost         = getCost(node.min, node.max);
+		const float combinedCost = getCombinedCost(node.min, node.max, leafMin, leafMax);
+
+		// Cost of creating a new parent for this node and the new leaf
+		const float newParentCost = 2.0f * combinedCost;
+		// Minimum cost of pushing the leaf further down the tree
+		const float inheritanceCost = 2.0f * (combinedCost - cost);
+
+		float childCost[2];
+		const int32 children[2] = { node.child1, node.child2 };
+		for (int i = 0; i < 2; i++) {
+			const Node &child = _nodes[children[i]];
+
+			childCost[i] = getCombinedCost(child.min, child.max, leafMin, leafMax) + inheritanceCost;
+			if (!child.isLeaf())
+				childCost[i] -= getCost(child.min, child.max);
+		}
+
+		if ((newParentCost < childCost[0]) && (newParentCost < childCost[1]))
+			break;
+
+		index = (childCost[0] < childCost[1]) ? children[0] : children[1];
+	}
+
+	const int32 sibling   = index;
+	const int32 oldParent = _nodes[sibling].parent;
+	const int32 newParent = allocateNode();
+
+	_nodes[newParent].parent = oldParent;
+	_nodes[newParent].child1 = sibling;
+	_nodes[newParent].child2 = leaf;
+	_nodes[newParent].height = _nodes[sibling].height + 1;
+	combine(newParent, sibling, leaf);
+
+	if (oldParent != kNullNode)
+		replaceChild(oldParent, sibling, newParent);
+	else
+		_root = newParent;
+
+	_nodes[sibling].parent = newParent;
+	_nodes[leaf   ].parent = newParent;
+
+	refit(oldParent);
+}
+
+void BVH::removeLeaf(int32 leaf) {
+	if (leaf == _root) {
+		_root = kNullNode;
+		return;
+	}
+
+	const int32 parent      = _nodes[leaf].parent;
+	const int32 grandParent = _nodes[parent].parent;
+	const int32 sibling     = (_nodes[parent].child1 == leaf) ? _nodes[parent].child2 : _nodes[parent].child1;
+
+	// The sibling takes the place of the parent
+	if (grandParent != kNullNode)
+		replaceChild(grandParent, parent, sibling);
+	else
+		_root = sibling;
+
+	_nodes[sibling].parent = grandParent;
+	_nodes[leaf   ].parent = kNullNode;
+
+	freeNode(parent);
+
+	refit(grandParent);
+}
+
+void BVH::refit(int32 index) {
+	while (index != kNullNode) {
+		index = balance(index);
+
+		Node &node = _nodes[index];
+
+		node.height = 1 + MAX(_nodes[node.child1].height, _nodes[node.child2].height);
+		combine(index, node.child1, node.child2);
+
+		index = node.parent;
+	}
+}
+
+int32 BVH::balance(int32 iA) {
+	Node *a = &_nodes[iA];
+	if (a->isLeaf() || (a->height < 2))
+		return iA;
+
+	const int32 iB = a->child1;
+	const int32 iC = a->child2;
+
+	Node *b = &_nodes[iB];
+	Node *c = &_nodes[iC];
+
+	const int32 imbalance = c->height - b->height;
+
+	if (imbalance > 1) {
+		// Rotate C up, to A's place
+
+		const int32 iF = c->child1;
+		const int32 iG = c->child2;
+
+		Node *f = &_nodes[iF];
+		Node *g = &_nodes[iG];
+
+		c->child1 = iA;
+		c->parent = a->parent;
+		a->parent = iC;
+
+		if (c->parent != kNullNode)
+			replaceChild(c->parent, iA, iC);
+		else
+			_root = iC;
+
+		// The taller of C's children stays with C, the other one goes to A
+		if (f->height > g->height) {
+			c->child2 = iF;
+			a->child2 = iG;
+			g->parent = iA;
+
+			combine(iA, iB, iG);
+			combine(iC, iA, iF);
+
+			a->height = 1 + MAX(b->height, g->height);
+			c->height = 1 + MAX(a->height, f->height);
+		} else {
+			c->child2 = iG;
+			a->child2 = iF;
+			f->parent = iA;
+
+			combine(iA, iB, iF);
+			combine(iC, iA, iG);
+
+			a->height = 1 + MAX(b->height, f->height);
+			c->height = 1 + MAX(a->height, g->height);
+		}
+
+		return iC;
+	}
+
+	if (imbalance < -1) {
+		// Rotate B up, to A's place
+
+		const int32 iD = b->child1;
+		const int32 iE = b->child2;
+
+		Node *d = &_nodes[iD];
+		Node *e = &_nodes[iE];
+
+		b->child1 = iA;
+		b->parent = a->parent;
+		a->parent = iB;
+
+		if (b->parent != kNullNode)
+			replaceChild(b->parent, iA, iB);
+		else
+			_root = iB;
+
+		// The taller of B's children stays with B, the other one goes to A
+		if (d->height > e->height) {
+			b->child2 = iD;
+			a->child1 = iE;
+			e->parent = iA;
+
+			combine(iA, iC, iE);
+			combine(iB, iA, iD);
+
+			a->height = 1 + MAX(c->height, e->height);
+			b->height = 1 + MAX(a->height, d->height);
+		} else {
+			b->child2 = iE;
+			a->child1 = iD;
+			d->parent = iA;
+
+			combine(iA, iC, iD);
+			combine(iB, iA, iE);
+
+			a->height = 1 + MAX(c->height, d->height);
+			b->height = 1 + MAX(a->height, e->height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void BVH::replaceChild(int32 parent, int32 oldChild, int32 newChild) {
+	Node &node = _nodes[parent];
+
+	if (node.child1 == oldChild)
+		node.child1 = newChild;
+	else
+		node.child2 = newChild;
+}
+
+void BVH::combine(int32 node, int32 a, int32 b) {
+	Node &n = _nodes[node];
+
+	for (int i = 0; i < 3; i++) {
+		n.min[i] = MIN(_nodes[a].min[i], _nodes[b].min[i]);
+		n.max[i] = MAX(_nodes[a].max[i], _nodes[b].max[i]);
+	}
+}
+
+} // End of namespace Graphics
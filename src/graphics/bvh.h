@@ -0,0 +1,132 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounding volume hierarchy over renderables.
+ */
+
+#ifndef GRAPHICS_BVH_H
+#define GRAPHICS_BVH_H
+
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/noncopyable.h"
+
+namespace Graphics {
+
+class Renderable;
+class Frustum;
+
+/** A dynamic bounding volume hierarchy, a binary tree of axis-aligned boxes.
+ *
+ *  Each renderable is a leaf, inserted at the place where it grows the tree's
+ *  boxes the least. The tree is kept balanced by rotating nodes on the way back
+ *  up. A leaf's box is slightly larger than the renderable's, so that small
+ *  movements don't need to touch the tree at all.
+ */
+class BVH : Common::NonCopyable {
+public:
+	static const uint32 kInvalidProxy = 0xFFFFFFFF;
+
+	/** A renderable hit by a ray. */
+	struct Hit {
+		float distance; ///< Where the ray enters the box, from 0.0 (start) to 1.0 (end).
+		Renderable *object;
+
+		bool operator<(const Hit &hit) const;
+	};
+
+	BVH();
+	~BVH();
+
+	void clear();
+
+	/** Return the number of renderables within the hierarchy. */
+	uint32 getCount() const;
+
+	/** Insert a renderable with this bounding box, returning its proxy handle. */
+	uint32 insert(Renderable *object, const float *min, const float *max);
+	/** Move a renderable to a new bounding box. */
+	void move(uint32 proxy, const float *min, const float *max);
+	/** Remove a renderable. */
+	void remove(uint32 proxy);
+
+	/** Find all renderables whose bounding boxes are at least partially within the frustum. */
+	void query(const Frustum &frustum, std::vector<Renderable *> &objects) const;
+
+	/** Find all renderables whose bounding boxes the line from start to end intersects.
+	 *
+	 *  The hits are sorted by distance, nearest first. Since the boxes within
+	 *  the hierarchy are slightly enlarged, the distances are approximate.
+	 */
+	void raycast(const float *start, const float *end, std::vector<Hit> &hits) const;
+
+	/** Does the line from start to end intersect with this box?
+	 *
+	 *  @param distance Where the line enters the box, from 0.0 (start) to 1.0 (end).
+	 */
+	static bool intersect(const float *start, const float *end,
+	                      const float *min, const float *max, float &distance);
+
+private:
+	static const int32 kNullNode = -1;
+
+	struct Node {
+		float min[3];
+		float max[3];
+
+		Renderable *object; ///< The renderable, if this is a leaf.
+
+		int32 parent; ///< The parent node, or the next free node.
+		int32 child1;
+		int32 child2;
+
+		int32 height; ///< 0 for leaves, -1 for free nodes.
+
+		bool isLeaf() const;
+	};
+
+	std::vector<Node> _nodes;
+
+	int32 _root;
+	int32 _freeList;
+
+	uint32 _count;
+
+	int32 allocateNode();
+	void freeNode(int32 node);
+
+	void insertLeaf(int32 leaf);
+	void removeLeaf(int32 leaf);
+
+	/** Rotate the node's children if they're imbalanced, returning the node now at its place. */
+	int32 balance(int32 node);
+	/** Recalculate the heights and boxes from this node up to the root, balancing on the way. */
+	void refit(int32 node);
+
+	void replaceChild(int32 parent, int32 oldChild, int32 newChild);
+
+	void combine(int32 node, int32 a, int32 b);
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_BVH_H
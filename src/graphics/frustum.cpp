@@ -0,0 +1,83 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A view frustum, for culling.
+ */
+
+#include <cmath>
+
+#include "src/graphics/frustum.h"
+
+namespace Graphics {
+
+Frustum::Frustum() {
+	// Start out with planes that don't cull anything
+	for (int i = 0; i < 6; i++) {
+		_planes[i][0] = 0.0f;
+		_planes[i][1] = 0.0f;
+		_planes[i][2] = 0.0f;
+		_planes[i][3] = 1.0f;
+	}
+}
+
+Frustum::~Frustum() {
+}
+
+void Frustum::set(const Common::TransformationMatrix &matrix) {
+	/* The planes are the sums and differences of the last row of the matrix
+	 * and the other three rows: left, right, bottom, top, near, far. */
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 4; j++) {
+			_planes[i * 2 + 0][j] = matrix(3, j) + matrix(i, j);
+			_planes[i * 2 + 1][j] = matrix(3, j) - matrix(i, j);
+		}
+	}
+
+	for (int i = 0; i < 6; i++) {
+		const float length = sqrtf(_planes[i][0] * _planes[i][0] +
+		                           _planes[i][1] * _planes[i][1] +
+		                           _planes[i][2] * _planes[i][2]);
+
+		if (length > 0.0f)
+			for (int j = 0; j < 4; j++)
+				_planes[i][j] /= length;
+	}
+}
+
+bool Frustum::isIn(const float *min, const float *max) const {
+	for (int i = 0; i < 6; i++) {
+		const float *plane = _planes[i];
+
+		// The corner of the box the furthest along the plane normal
+		const float x = (plane[0] >= 0.0f) ? max[0] : min[0];
+		const float y = (plane[1] >= 0.0f) ? max[1] : min[1];
+		const float z = (plane[2] >= 0.0f) ? max[2] : min[2];
+
+		// If even that one is behind the plane, the whole box is outside
+		if ((plane[0] * x + plane[1] * y + plane[2] * z + plane[3]) < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,51 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A view frustum, for culling.
+ */
+
+#ifndef GRAPHICS_FRUSTUM_H
+#define GRAPHICS_FRUSTUM_H
+
+#include "src/common/transmatrix.h"
+
+namespace Graphics {
+
+/** The six planes enclosing the visible part of the world. */
+class Frustum {
+public:
+	Frustum();
+	~Frustum();
+
+	/** Extract the planes out of a combined projection and modelview matrix. */
+	void set(const Common::TransformationMatrix &matrix);
+
+	/** Is an axis-aligned box at least partially within the frustum? */
+	bool isIn(const float *min, const float *max) const;
+
+private:
+	/** The planes, as a, b, c and d in a * x + b * y + c * z + d >= 0, pointing inwards. */
+	float _planes[6][4];
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_FRUSTUM_H
@@ -22,12 +22,15 @@
  *  The global graphics manager.
  */
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 
 #include "src/common/version.h"
 #include "src/common/util.h"
 #include "src/common/maths.h"
 #include "src/common/error.h"
+#include "src/common/debug.h"
 #include "src/common/file.h"
 #include "src/common/configman.h"
 #include "src/common/threads.h"
@@ -43,6 +46,8 @@
 #include "src/graphics/icon.h"
 #include "src/graphics/cursor.h"
 #include "src/graphics/fpscounter.h"
+#include "src/graphics/animationstage.h"
+#include "src/graphics/frustum.h"
 #include "src/graphics/queueman.h"
 #include "src/graphics/glcontainer.h"
 #include "src/graphics/renderable.h"
@@ -62,7 +67,7 @@ namespace Graphics {
 
 PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D;
 
-GraphicsManager::GraphicsManager() {
+GraphicsManager::GraphicsManager() : _frameEnd(_frameMutex) {
 	_ready = false;
 
 	_needManualDeS3TC        = false;
@@ -87,7 +92,18 @@ GraphicsManager::GraphicsManager() {
 
 	_fpsCounter = new FPSCounter(3);
 
-	_frameLock.store(0);
+	_animationStage = 0;
+
+	_cullFrame = 0;
+
+	_frameLock      = 0;
+	_frameRendering = false;
+
+	_frameStatsStart   = 0;
+	_frameStatsFrames  = 0;
+	_frameStatsSkipped = 0;
+	_frameWaitMain     = 0;
+	_frameWaitOther    = 0;
 
 	_cursor = 0;
 	_cursorState = kCursorStateStay;
@@ -148,6 +164,8 @@ void GraphicsManager::init() {
 	MaterialMan.init();
 	MeshMan.init();
 
+	_animationStage = new AnimationStage;
+
 	_ready = true;
 }
 
@@ -159,6 +177,9 @@ void GraphicsManager::deinit() {
 
 	QueueMan.clearAllQueues();
 
+	delete _animationStage;
+	_animationStage = 0;
+
 	MeshMan.deinit();
 	MaterialMan.deinit();
 	SurfaceMan.deinit();
@@ -633,18 +654,69 @@ bool GraphicsManager::unproject(float x, float y,
 }
 
 void GraphicsManager::lockFrame() {
-	uint32 lock = _frameLock.fetch_add(1, boost::memory_order_acquire);
-	if (Common::isMainThread() || EventMan.quitRequested() || (lock > 0))
-		return;
+	const uint64 start = SDL_GetPerformanceCounter();
 
-	_frameEndSignal.store(false, boost::memory_order_release);
-	while (!_frameEndSignal.load(boost::memory_order_acquire));
+	Common::StackLock lock(_frameMutex);
+
+	// The main thread renders the frames itself, so there's never one in progress there
+	if (!Common::isMainThread())
+		while (_frameRendering)
+			_frameEnd.wait();
+
+	_frameLock++;
+
+	if (!Common::isMainThread())
+		_frameWaitOther += SDL_GetPerformanceCounter() - start;
 }
 
 void GraphicsManager::unlockFrame() {
-	uint32 lock = _frameLock.fetch_sub(1, boost::memory_order_release);
+	Common::StackLock lock(_frameMutex);
+
+	assert(_frameLock != 0);
+
+	_frameLock--;
+}
+
+void GraphicsManager::lockPending() {
+	_pendingMutex.lock();
+}
+
+void GraphicsManager::unlockPending() {
+	_pendingMutex.unlock();
+}
+
+void GraphicsManager::queuePending(Renderable &renderable) {
+	if (renderable._pending)
+		return;
+
+	renderable._pending = true;
+	_pending.push_back(&renderable);
+}
+
+void GraphicsManager::flushPending(Renderable &renderable) {
+	Common::StackLock lock(_pendingMutex);
+
+	if (!renderable._pending)
+		return;
+
+	std::vector<Renderable *>::iterator r = std::find(_pending.begin(), _pending.end(), &renderable);
+	assert(r != _pending.end());
+
+	_pending.erase(r);
 
-	assert(lock != 0);
+	renderable._pending = false;
+	renderable.applyPending();
+}
+
+void GraphicsManager::applyPending() {
+	Common::StackLock lock(_pendingMutex);
+
+	for (std::vector<Renderable *>::iterator r = _pending.begin(); r != _pending.end(); ++r) {
+		(*r)->_pending = false;
+		(*r)->applyPending();
+	}
+
+	_pending.clear();
 }
 
 void GraphicsManager::recalculateObjectDistances() {
@@ -675,6 +747,41 @@ uint32 GraphicsManager::createRenderableID() {
 	return ++_renderableID;
 }
 
+void GraphicsManager::updateWorldBound(Renderable &object) {
+	float min[3], max[3];
+	const bool hasBound = object.getWorldBound(min, max);
+
+	Common::StackLock lock(_worldBoundMutex);
+
+	// Hidden objects have left the hierarchy for good; the renderable might be about to be deleted
+	if (!object.isVisible())
+		return;
+
+	if (!hasBound) {
+		// Objects without a bounding box are never culled
+		if (object._boundProxy != BVH::kInvalidProxy)
+			_worldBound.remove(object._boundProxy);
+
+		object._boundProxy = BVH::kInvalidProxy;
+		return;
+	}
+
+	if (object._boundProxy == BVH::kInvalidProxy)
+		object._boundProxy = _worldBound.insert(&object, min, max);
+	else
+		_worldBound.move(object._boundProxy, min, max);
+}
+
+void GraphicsManager::removeWorldBound(Renderable &object) {
+	Common::StackLock lock(_worldBoundMutex);
+
+	if (object._boundProxy == BVH::kInvalidProxy)
+		return;
+
+	_worldBound.remove(object._boundProxy);
+	object._boundProxy = BVH::kInvalidProxy;
+}
+
 void GraphicsManager::abandon(TextureID *ids, uint32 count) {
 	if (count == 0)
 		return;
@@ -763,22 +870,59 @@ Renderable *GraphicsManager::getWorldObjectAt(float x, float y) const {
 	if (!unproject(x, y, x1, y1, z1, x2, y2, z2))
 		return 0;
 
+	const float start[3] = { x1, y1, z1 };
+	const float end  [3] = { x2, y2, z2 };
+
 	Renderable *object = 0;
 
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
 
-	for (std::list<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
-		Renderable &r = static_cast<Renderable &>(**o);
+	_worldBoundMutex.lock();
+
+	std::vector<BVH::Hit> hits;
+	_worldBound.raycast(start, end, hits);
+
+	/* The hits are sorted by their distance to the enlarged boxes in the hierarchy,
+	 * which is never further away than the distance to the object's real box. So
+	 * once we're past the nearest real hit, nothing nearer can follow. */
 
+	float nearest = 2.0f;
+	for (std::vector<BVH::Hit>::const_iterator h = hits.begin(); h != hits.end(); ++h) {
+		if (h->distance >= nearest)
+			break;
+
+		Renderable &r = *h->object;
 		if (!r.isClickable())
 			// Object isn't clickable, don't check
 			continue;
 
-		// If the line intersects with the object, return it
-		if (r.isIn(x1, y1, z1, x2, y2, z2)) {
-			object = &r;
-			break;
+		float min[3], max[3], distance;
+		if (!r.getWorldBound(min, max) || !BVH::intersect(start, end, min, max, distance))
+			continue;
+
+		if (distance < nearest) {
+			nearest = distance;
+			object  = &r;
+		}
+	}
+
+	_worldBoundMutex.unlock();
+
+	if (!object) {
+		// Objects without a bounding box aren't in the hierarchy, so check them directly
+
+		const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+		for (std::list<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
+			Renderable &r = static_cast<Renderable &>(**o);
+
+			if ((r._boundProxy != BVH::kInvalidProxy) || !r.isClickable())
+				continue;
+
+			// If the line intersects with the object, return it
+			if (r.isIn(x1, y1, z1, x2, y2, z2)) {
+				object = &r;
+				break;
+			}
 		}
 	}
 
@@ -851,6 +995,30 @@ bool GraphicsManager::playVideo() {
 	return true;
 }
 
+void GraphicsManager::cullWorld(const std::list<Queueable *> &objects) {
+	_cullFrame++;
+
+	Frustum frustum;
+	frustum.set(_projection * _modelview);
+
+	Common::StackLock lock(_worldBoundMutex);
+
+	// Mark all objects within the view frustum
+	_worldBound.query(frustum, _inView);
+
+	for (std::vector<Renderable *>::iterator o = _inView.begin(); o != _inView.end(); ++o)
+		(*o)->_cullFrame = _cullFrame;
+
+	// Draw the marked objects and those we don't know the bounds of, from back to front
+	_drawList.clear();
+	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin(); o != objects.rend(); ++o) {
+		Renderable *object = static_cast<Renderable *>(*o);
+
+		if ((object->_boundProxy == BVH::kInvalidProxy) || (object->_cullFrame == _cullFrame))
+			_drawList.push_back(object);
+	}
+}
+
 bool GraphicsManager::renderWorld() {
 	if (QueueMan.isQueueEmpty(kQueueVisibleWorldObject))
 		return false;
@@ -901,27 +1069,23 @@ bool GraphicsManager::renderWorld() {
 
 	// If game paused, skip the advanceTime loop below
 
-	// Advance time for animation queues
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
-	     o != objects.rend(); ++o) {
-		static_cast<Renderable *>(*o)->advanceTime(elapsedTime);
-	}
+	// Advance time for animation queues, on all cores, before rendering the results
+	_animationStage->advanceTime(objects, elapsedTime);
 
-	// Draw opaque objects
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
-	     o != objects.rend(); ++o) {
+	// Only draw what's within the view
+	cullWorld(objects);
 
+	// Draw opaque objects
+	for (std::vector<Renderable *>::const_iterator o = _drawList.begin(); o != _drawList.end(); ++o) {
 		glPushMatrix();
-		static_cast<Renderable *>(*o)->render(kRenderPassOpaque);
+		(*o)->render(kRenderPassOpaque);
 		glPopMatrix();
 	}
 
 	// Draw transparent objects
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
-	     o != objects.rend(); ++o) {
-
+	for (std::vector<Renderable *>::const_iterator o = _drawList.begin(); o != _drawList.end(); ++o) {
 		glPushMatrix();
-		static_cast<Renderable *>(*o)->render(kRenderPassTransparent);
+		(*o)->render(kRenderPassTransparent);
 		glPopMatrix();
 	}
 
@@ -995,31 +1159,79 @@ void GraphicsManager::endScene() {
 		glDisable(GL_MULTISAMPLE_ARB);
 }
 
+bool GraphicsManager::startFrame() {
+	const uint64 start = SDL_GetPerformanceCounter();
+
+	Common::StackLock lock(_frameMutex);
+
+	_frameWaitMain += SDL_GetPerformanceCounter() - start;
+
+	if (_frameLock > 0) {
+		_frameStatsSkipped++;
+		return false;
+	}
+
+	_frameRendering = true;
+	return true;
+}
+
+void GraphicsManager::finishFrame() {
+	Common::StackLock lock(_frameMutex);
+
+	_frameRendering = false;
+	_frameEnd.broadcast();
+
+	_frameStatsFrames++;
+}
+
+void GraphicsManager::printFrameStats() {
+	const uint32 now = EventMan.getTimestamp();
+	if (_frameStatsStart == 0)
+		_frameStatsStart = now;
+
+	if ((now - _frameStatsStart) < 1000)
+		return;
+
+	Common::StackLock lock(_frameMutex);
+
+	const uint32 frames    = MAX<uint32>(_frameStatsFrames + _frameStatsSkipped, 1);
+	const double frequency = SDL_GetPerformanceFrequency() / 1000.0;
+
+	debugC(2, Common::kDebugGraphics, "Frame lock: %u frames, %u skipped; waited %.3fms per frame in the main thread, "
+	       "%.3fms per frame in other threads", _frameStatsFrames, _frameStatsSkipped,
+	       (_frameWaitMain / frequency) / frames, (_frameWaitOther / frequency) / frames);
+
+	_frameStatsStart   = now;
+	_frameStatsFrames  = 0;
+	_frameStatsSkipped = 0;
+	_frameWaitMain     = 0;
+	_frameWaitOther    = 0;
+}
+
 void GraphicsManager::renderScene() {
 	Common::enforceMainThread();
 
 	cleanupAbandoned();
 
-	if (_frameLock.load(boost::memory_order_acquire) > 0) {
-		_frameEndSignal.store(true, boost::memory_order_release);
+	printFrameStats();
 
+	if (!startFrame())
 		return;
-	}
+
+	// Changes made by other threads since the last frame
+	applyPending();
 
 	beginScene();
 
-	if (playVideo()) {
-		endScene();
-		return;
+	if (!playVideo()) {
+		renderWorld();
+		renderGUIFront();
+		renderCursor();
 	}
 
-	renderWorld();
-	renderGUIFront();
-	renderCursor();
-
 	endScene();
 
-	_frameEndSignal.store(true, boost::memory_order_release);
+	finishFrame();
 }
 
 const Common::TransformationMatrix &GraphicsManager::getProjectionMatrix() const {
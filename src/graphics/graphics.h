@@ -25,12 +25,11 @@
 #ifndef GRAPHICS_GRAPHICS_H
 #define GRAPHICS_GRAPHICS_H
 
-#include "src/common/atomic.h"
-
 #include <vector>
 #include <list>
 
 #include "src/graphics/types.h"
+#include "src/graphics/bvh.h"
 
 #include "src/common/types.h"
 #include "src/common/singleton.h"
@@ -42,8 +41,10 @@
 namespace Graphics {
 
 class FPSCounter;
+class AnimationStage;
 class Cursor;
 class Renderable;
+class Queueable;
 
 /** The graphics manager. */
 class GraphicsManager : public Common::Singleton<GraphicsManager> {
@@ -134,14 +135,40 @@ public:
 	/** Recalculate all object distances to the camera and resort the objebts. */
 	void recalculateObjectDistances();
 
-	/** Lock the frame mutex. */
+	/** Lock the frame mutex.
+	 *
+	 *  When called from outside the main thread, this blocks until the frame
+	 *  currently being rendered is finished. No new frame is started until
+	 *  the frame mutex is unlocked again.
+	 */
 	void lockFrame();
 	/** Unlock the frame mutex. */
 	void unlockFrame();
 
+	/** Lock the pending scene changes. */
+	void lockPending();
+	/** Unlock the pending scene changes. */
+	void unlockPending();
+
+	/** Apply this renderable's pending changes before the next frame.
+	 *
+	 *  The pending scene changes have to be locked.
+	 */
+	void queuePending(Renderable &renderable);
+	/** Apply this renderable's pending changes now, if there are any. */
+	void flushPending(Renderable &renderable);
+
 	/** Create a new unique renderable ID. */
 	uint32 createRenderableID();
 
+	/** Add a visible world object to the culling hierarchy, or update its bounding box there.
+	 *
+	 *  Objects that aren't visible (anymore) are ignored.
+	 */
+	void updateWorldBound(Renderable &object);
+	/** Remove a world object from the culling hierarchy. */
+	void removeWorldBound(Renderable &object);
+
 	/** Abandon these textures. */
 	void abandon(TextureID *ids, uint32 count);
 	/** Abandon these lists. */
@@ -196,13 +223,36 @@ private:
 
 	FPSCounter *_fpsCounter; ///< Counts the current frames per seconds value.
 	uint32 _lastSampled; ///< Timestamp used to advance animations.
+
+	AnimationStage *_animationStage; ///< Advances the animations of all visible world objects.
+
+	BVH                   _worldBound;      ///< The bounding boxes of all visible world objects.
+	mutable Common::Mutex _worldBoundMutex; ///< The mutex guarding the world bounding box hierarchy.
+
+	uint32 _cullFrame; ///< The number of frames culled so far.
+
+	std::vector<Renderable *> _inView;   ///< World objects within the view frustum.
+	std::vector<Renderable *> _drawList; ///< World objects to draw this frame, from back to front.
+
 	Common::TransformationMatrix _projection;    ///< Our projection matrix.
 	Common::TransformationMatrix _projectionInv; ///< The inverse of our projection matrix.
 	Common::TransformationMatrix _modelview;     ///< Our base modelview matrix (i.e camera view).
 	Common::TransformationMatrix _modelviewInv;  ///< The inverse of our modelview matrix.
 
-	boost::atomic<uint32> _frameLock;
-	boost::atomic<bool>   _frameEndSignal;
+	uint32 _frameLock;      ///< How often the frame mutex is currently locked.
+	bool   _frameRendering; ///< Is the main thread currently rendering a frame?
+
+	Common::Mutex     _frameMutex; ///< The mutex guarding the frame lock.
+	Common::Condition _frameEnd;   ///< Signalled when the main thread finished a frame.
+
+	uint32 _frameStatsStart;   ///< Timestamp the current frame lock statistics started.
+	uint32 _frameStatsFrames;  ///< Frames rendered since then.
+	uint32 _frameStatsSkipped; ///< Frames skipped since then, because the frame mutex was locked.
+	uint64 _frameWaitMain;     ///< Time the main thread waited for the frame mutex since then.
+	uint64 _frameWaitOther;    ///< Time the other threads waited for the frame mutex since then.
+
+	std::vector<Renderable *> _pending;      ///< Renderables with pending changes.
+	Common::Mutex             _pendingMutex; ///< The mutex guarding the pending scene changes.
 
 	Common::Mutex _cursorMutex;    ///< A mutex locked for the cursor.
 
@@ -247,8 +297,21 @@ private:
 
 	void buildNewTextures();
 
+	/** Claim the next frame for rendering, unless the frame mutex is locked. */
+	bool startFrame();
+	/** Mark the frame as finished, waking up threads waiting for it. */
+	void finishFrame();
+	/** Print the frame lock statistics, once a second. */
+	void printFrameStats();
+
+	/** Apply all pending scene changes. */
+	void applyPending();
+
 	void beginScene();
 	bool playVideo();
+	/** Collect the world objects within the view frustum into the draw list. */
+	void cullWorld(const std::list<Queueable *> &objects);
+
 	bool renderWorld();
 	bool renderGUIFront();
 	bool renderCursor();
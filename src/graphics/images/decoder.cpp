@@ -25,6 +25,8 @@
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/stream.h"
+#include "src/common/threads.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/graphics.h"
 
@@ -34,6 +36,39 @@
 
 namespace Graphics {
 
+/** Decompress images with more pixels than that on several threads. */
+static const uint32 kParallelDecompressPixels = 512 * 512;
+/** The number of block rows each thread decompresses in one go. */
+static const uint32 kParallelDecompressBlockRows = 32;
+
+/** Decompresses a band of block rows of a DXTn mip map. */
+struct DecompressJob : public Common::ThreadPool::Job {
+	PixelFormatRaw format;
+
+	byte *dest;
+	const byte *src;
+	uint32 srcSize;
+
+	uint32 width;
+	uint32 height;
+
+	void run() {
+		decompressDXT(format, dest, src, srcSize, width, height);
+	}
+
+	static void decompressDXT(PixelFormatRaw format, byte *dest, const byte *src, uint32 srcSize,
+	                          uint32 width, uint32 height) {
+
+		if      (format == kPixelFormatDXT1)
+			decompressDXT1(dest, src, srcSize, width, height, width * 4);
+		else if (format == kPixelFormatDXT3)
+			decompressDXT3(dest, src, srcSize, width, height, width * 4);
+		else if (format == kPixelFormatDXT5)
+			decompressDXT5(dest, src, srcSize, width, height, width * 4);
+	}
+};
+
+
 ImageDecoder::MipMap::MipMap(const ImageDecoder *i) : width(0), height(0), size(0), data(0), image(i) {
 }
 
@@ -175,28 +210,86 @@ void ImageDecoder::decompress(MipMap &out, const MipMap &in, PixelFormatRaw form
 	out.size   = out.width * out.height * 4;
 	out.data   = new byte[out.size];
 
-	Common::MemoryReadStream *stream = new Common::MemoryReadStream(in.data, in.size);
-
-	if      (format == kPixelFormatDXT1)
-		decompressDXT1(out.data, *stream, out.width, out.height, out.width * 4);
-	else if (format == kPixelFormatDXT3)
-		decompressDXT3(out.data, *stream, out.width, out.height, out.width * 4);
-	else if (format == kPixelFormatDXT5)
-		decompressDXT5(out.data, *stream, out.width, out.height, out.width * 4);
-
-	delete stream;
+	DecompressJob::decompressDXT(format, out.data, in.data, in.size, out.width, out.height);
 }
 
 void ImageDecoder::decompress() {
 	if (!_compressed)
 		return;
 
-	for (std::vector<MipMap *>::iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
-		MipMap decompressed(this);
+	if ((_formatRaw != kPixelFormatDXT1) &&
+	    (_formatRaw != kPixelFormatDXT3) &&
+	    (_formatRaw != kPixelFormatDXT5))
+		throw Common::Exception("Unknown compressed format %d", _formatRaw);
+
+	const uint32 blockSize = (_formatRaw == kPixelFormatDXT1) ? 8 : 16;
+
+	std::vector<MipMap *>      decompressed;
+	std::vector<DecompressJob> jobs;
+
+	uint32 pixels = 0;
+
+	try {
+		for (std::vector<MipMap *>::iterator m = _mipMaps.begin(); m != _mipMaps.end(); ++m) {
+			MipMap &in = **m;
 
-		decompress(decompressed, **m, _formatRaw);
+			decompressed.push_back(new MipMap(this));
+
+			MipMap &out = *decompressed.back();
+
+			out.width  = in.width;
+			out.height = in.height;
+			out.size   = out.width * out.height * 4;
+			out.data   = new byte[out.size];
+
+			pixels += out.width * out.height;
+
+			/* Split the mip map into bands of whole block rows. Since the blocks are written
+			 * bottom row first, each band ends up in its own stretch of pixel rows. */
+			const uint32 blockRowSize = ((out.width + 3) / 4) * blockSize;
+			const uint32 blockRows    = (out.height + 3) / 4;
+
+			for (uint32 row = 0; row < blockRows; row += kParallelDecompressBlockRows) {
+				const uint32 rows = MIN(blockRows - row, kParallelDecompressBlockRows);
+
+				const uint32 srcOffset = MIN(row * blockRowSize, in.size);
+
+				DecompressJob job;
+
+				job.format  = _formatRaw;
+				job.dest    = out.data + row * 4 * out.width * 4;
+				job.src     = in.data + srcOffset;
+				job.srcSize = MIN(rows * blockRowSize, in.size - srcOffset);
+				job.width   = out.width;
+				job.height  = MIN<uint32>(out.height - row * 4, rows * 4);
+
+				jobs.push_back(job);
+			}
+		}
+
+		/* Images decoded in the background already run on one of several workers,
+		 * so only spread out the ones decoded on the main thread. */
+		if ((pixels >= kParallelDecompressPixels) && (jobs.size() > 1) && Common::isMainThread()) {
+			Common::ThreadPool pool(MIN<uint32>(jobs.size(), Common::ThreadPool::getCPUCount()));
+
+			for (std::vector<DecompressJob>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+				pool.addJob(*j);
+
+			pool.wait();
+		} else
+			for (std::vector<DecompressJob>::iterator j = jobs.begin(); j != jobs.end(); ++j)
+				j->run();
+
+	} catch (...) {
+		for (std::vector<MipMap *>::iterator m = decompressed.begin(); m != decompressed.end(); ++m)
+			delete *m;
+
+		throw;
+	}
 
-		decompressed.swap(**m);
+	for (uint32 i = 0; i < _mipMaps.size(); i++) {
+		decompressed[i]->swap(*_mipMaps[i]);
+		delete decompressed[i];
 	}
 
 	_format     = kPixelFormatRGBA;
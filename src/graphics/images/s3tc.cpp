@@ -22,175 +22,247 @@
  *  Manual S3TC DXTn decompression methods.
  */
 
+#include <cstring>
+
 #include "src/common/util.h"
-#include "src/common/stream.h"
+#include "src/common/endianness.h"
 
 #include "src/graphics/images/s3tc.h"
 
 namespace Graphics {
 
-static uint32 convert565To8888(uint16 color) {
+/* The interpolation weights of the color palette. The values (and the rounding
+ * towards zero) match what our old floating point decoder produced, which in
+ * turn matches the textures we've dumped so far, so we keep them bit for bit.
+ * They're stored as fixed point numbers with 25 fractional bits, which is enough
+ * to hold these floats exactly. */
+static const int64 kWeightThird     = (int64) (0.333333f * 33554432.0f);
+static const int64 kWeightTwoThirds = (int64) (0.666666f * 33554432.0f);
+static const int64 kWeightHalf      = (int64) (0.5f      * 33554432.0f);
+
+/** Decoded colors of a DXTn block, as RGBA values already in output byte order. */
+struct DXTColors {
+	uint32 color[4];
+};
+
+static inline uint32 convert565To8888(uint16 color) {
 	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | 0xFF;
 }
 
-static uint32 interpolate32(double weight, uint32 color_0, uint32 color_1) {
-	byte r[3], g[3], b[3], a[3];
-	r[0] = color_0 >> 24;
-	r[1] = color_1 >> 24;
-	r[2] = (byte)((1.0f - weight) * (double)r[0] + weight * (double)r[1]);
-	g[0] = (color_0 >> 16) & 0xFF;
-	g[1] = (color_1 >> 16) & 0xFF;
-	g[2] = (byte)((1.0f - weight) * (double)g[0] + weight * (double)g[1]);
-	b[0] = (color_0 >> 8) & 0xFF;
-	b[1] = (color_1 >> 8) & 0xFF;
-	b[2] = (byte)((1.0f - weight) * (double)b[0] + weight * (double)b[1]);
-	a[0] = color_0 & 0xFF;
-	a[1] = color_1 & 0xFF;
-	a[2] = (byte)((1.0f - weight) * (double)a[0] + weight * (double)a[1]);
-	return r[2] << 24 | g[2] << 16 | b[2] << 8 | a[2];
-}
+static inline uint32 interpolate(int64 weight, uint32 color_0, uint32 color_1) {
+	uint32 color = 0;
 
-struct DXT1Texel {
-	uint16 color_0;
-	uint16 color_1;
-	uint32 pixels;
-};
+	for (int shift = 0; shift < 32; shift += 8) {
+		const int64 c0 = (color_0 >> shift) & 0xFF;
+		const int64 c1 = (color_1 >> shift) & 0xFF;
 
-#define READ_DXT1_TEXEL(x) \
-	x.color_0 = src.readUint16LE(); \
-	x.color_1 = src.readUint16LE(); \
-	x.pixels = src.readUint32BE()
+		color |= ((uint32) (c0 + (((c1 - c0) * weight) >> 25))) << shift;
+	}
 
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
-	for (int32 ty = height; ty > 0; ty -= 4) {
-		for (uint32 tx = 0; tx < width; tx += 4) {
-			DXT1Texel tex;
-			READ_DXT1_TEXEL(tex);
-			uint32 blended[4];
+	return color;
+}
 
-			blended[0] = convert565To8888(tex.color_0);
-			blended[1] = convert565To8888(tex.color_1);
+/** Read the two colors of a color block and interpolate the other two. */
+static inline void readColors(const byte *block, DXTColors &colors, bool dxt1) {
+	const uint16 color_0 = READ_LE_UINT16(block);
+	const uint16 color_1 = READ_LE_UINT16(block + 2);
 
-			if (tex.color_0 > tex.color_1) {
-				blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-				blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-			} else {
-				blended[2] = interpolate32(0.5f, blended[0], blended[1]);
-				blended[3] = 0;
-			}
+	uint32 color[4];
 
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
+	if (dxt1) {
+		color[0] = convert565To8888(color_0);
+		color[1] = convert565To8888(color_1);
 
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					WRITE_BE_UINT32(dest + (height - 1 - (ty - blockHeight + y)) * pitch + (tx + x) * 4, blended[cpx & 3]);
-					cpx >>= 2;
-				}
-			}
+		if (color_0 > color_1) {
+			color[2] = interpolate(kWeightThird    , color[0], color[1]);
+			color[3] = interpolate(kWeightTwoThirds, color[0], color[1]);
+		} else {
+			color[2] = interpolate(kWeightHalf, color[0], color[1]);
+			color[3] = 0;
 		}
+
+	} else {
+		// DXT3 and DXT5 always use the 4-color mode, and get their alpha elsewhere
+		color[0] = convert565To8888(color_0) & 0xFFFFFF00;
+		color[1] = convert565To8888(color_1) & 0xFFFFFF00;
+		color[2] = interpolate(kWeightThird    , color[0], color[1]);
+		color[3] = interpolate(kWeightTwoThirds, color[0], color[1]);
 	}
+
+	for (int i = 0; i < 4; i++)
+		colors.color[i] = TO_BE_32(color[i]);
 }
 
-struct DXT23Texel : public DXT1Texel {
-	uint16 alpha[4];
+/** The extent of a 4x4 block that's decoded and written.
+ *
+ *  Images smaller than a block only decode as many columns and rows as the
+ *  image has, consuming the color indices pixel by pixel. That's not quite the
+ *  DXTn layout, but it's what we've always done, and the data seems to agree.
+ *  Blocks cut off at the right or top border of larger images decode the full
+ *  block and are only clipped when writing them out. */
+struct DXTBlockSize {
+	uint32 columns; ///< Number of decoded columns.
+	uint32 rows;    ///< Number of decoded rows.
+
+	uint32 width;   ///< Number of columns within the image.
+	uint32 height;  ///< Number of rows within the image.
+
+	DXTBlockSize(uint32 imageWidth, uint32 imageHeight, uint32 tx, uint32 ty) :
+		columns(MIN<uint32>(imageWidth, 4)), rows(MIN<uint32>(imageHeight, 4)),
+		width(MIN<uint32>(imageWidth - tx, 4)), height(MIN<uint32>(ty, 4)) {
+	}
+
+	bool isFull() const {
+		return (width == 4) && (height == 4);
+	}
 };
 
-#define READ_DXT3_TEXEL(x) \
-	x.alpha[0] = src.readUint16LE(); \
-	x.alpha[1] = src.readUint16LE(); \
-	x.alpha[2] = src.readUint16LE(); \
-	x.alpha[3] = src.readUint16LE(); \
-	READ_DXT1_TEXEL(x)
+/** Fill in the color part of a decoded block's pixels. */
+static inline void decodeColors(uint32 *pixels, const byte *indices, const DXTColors &colors,
+                                const DXTBlockSize &size) {
+
+	uint32 cpx = READ_BE_UINT32(indices);
+
+	if ((size.columns == 4) && (size.rows == 4)) {
+		for (uint32 i = 0; i < 16; i++, cpx >>= 2)
+			pixels[i] = colors.color[cpx & 3];
+
+		return;
+	}
+
+	for (uint32 y = 0; y < size.rows; y++)
+		for (uint32 x = 0; x < size.columns; x++, cpx >>= 2)
+			pixels[y * 4 + x] = colors.color[cpx & 3];
+}
+
+/** Write a decoded 4x4 block, clipped to the image. */
+static inline void writeBlock(byte *dest, uint32 pitch, uint32 height, uint32 tx, uint32 ty,
+                              const DXTBlockSize &size, const uint32 *pixels) {
+
+	if (size.isFull()) {
+		byte *row = dest + (height - ty) * pitch + tx * 4;
+
+		for (uint32 y = 0; y < 4; y++, row += pitch)
+			memcpy(row, pixels + (3 - y) * 4, 4 * 4);
+
+		return;
+	}
+
+	// The last rows of the block are the first ones in the image
+	for (uint32 y = 0; y < size.rows; y++) {
+		const uint32 row = height - 1 - (ty - size.rows + y);
+		if (row >= height)
+			continue;
+
+		memcpy(dest + row * pitch + tx * 4, pixels + y * 4, size.width * 4);
+	}
+}
+
+/** Return the next compressed block, or an empty one if the data ran out. */
+static inline const byte *getBlock(const byte *&src, const byte *srcEnd, uint32 blockSize) {
+	static const byte kEmptyBlock[16] = { 0 };
+
+	const byte *block = src;
+
+	src += blockSize;
+	if (src > srcEnd)
+		return kEmptyBlock;
+
+	return block;
+}
+
+void decompressDXT1(byte *dest, const byte *src, uint32 srcSize, uint32 width, uint32 height, uint32 pitch) {
+	const byte *srcEnd = src + srcSize;
 
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
 	for (int32 ty = height; ty > 0; ty -= 4) {
 		for (uint32 tx = 0; tx < width; tx += 4) {
-			DXT23Texel tex;
-			uint32 blended[4];
-			READ_DXT3_TEXEL(tex);
-
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					uint32 alpha = (tex.alpha[y] >> (x * 4)) & 0xF;
-					WRITE_BE_UINT32(dest + (height - 1 - (ty - blockHeight + y)) * pitch + (tx + x) * 4, blended[cpx & 3] | alpha << 4);
-					cpx >>= 2;
-				}
-			}
+			const byte *block = getBlock(src, srcEnd, 8);
+
+			const DXTBlockSize size(width, height, tx, ty);
+
+			DXTColors colors;
+			readColors(block, colors, true);
+
+			uint32 pixels[16];
+			decodeColors(pixels, block + 4, colors, size);
+
+			writeBlock(dest, pitch, height, tx, ty, size, pixels);
 		}
 	}
 }
 
-struct DXT45Texel : public DXT1Texel {
-	byte alpha_0;
-	byte alpha_1;
-	uint64 alphabl;
-};
+void decompressDXT3(byte *dest, const byte *src, uint32 srcSize, uint32 width, uint32 height, uint32 pitch) {
+	const byte *srcEnd = src + srcSize;
+
+	for (int32 ty = height; ty > 0; ty -= 4) {
+		for (uint32 tx = 0; tx < width; tx += 4) {
+			const byte *block = getBlock(src, srcEnd, 16);
+
+			const DXTBlockSize size(width, height, tx, ty);
+
+			DXTColors colors;
+			readColors(block + 8, colors, false);
+
+			uint32 pixels[16];
+			decodeColors(pixels, block + 12, colors, size);
 
-static uint64 readUint48LE(Common::SeekableReadStream &src) {
-	uint64 output = src.readUint32LE();
-	return output | ((uint64)src.readUint16LE() << 32);
+			for (uint32 y = 0; y < size.rows; y++) {
+				const uint16 alpha = READ_LE_UINT16(block + 2 * y);
+
+				for (uint32 x = 0; x < size.columns; x++)
+					pixels[y * 4 + x] |= TO_BE_32(((alpha >> (x * 4)) & 0xF) << 4);
+			}
+
+			writeBlock(dest, pitch, height, tx, ty, size, pixels);
+		}
+	}
 }
 
-#define READ_DXT5_TEXEL(x) \
-	x.alpha_0 = src.readByte(); \
-	x.alpha_1 = src.readByte(); \
-	x.alphabl = readUint48LE(src); \
-	READ_DXT1_TEXEL(x)
+void decompressDXT5(byte *dest, const byte *src, uint32 srcSize, uint32 width, uint32 height, uint32 pitch) {
+	const byte *srcEnd = src + srcSize;
 
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch) {
 	for (int32 ty = height; ty > 0; ty -= 4) {
 		for (uint32 tx = 0; tx < width; tx += 4) {
-			uint32 blended[4];
-			byte alphab[8];
-			DXT45Texel tex;
-			READ_DXT5_TEXEL(tex);
-
-			alphab[0] = tex.alpha_0;
-			alphab[1] = tex.alpha_1;
-
-			if (tex.alpha_0 > tex.alpha_1) {
-				alphab[2] = (byte)((6.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[3] = (byte)((5.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[4] = (byte)((4.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[5] = (byte)((3.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[6] = (byte)((2.0f * (double)alphab[0] + 5.0f * (double)alphab[1] + 3.0f) / 7.0f);
-				alphab[7] = (byte)((1.0f * (double)alphab[0] + 6.0f * (double)alphab[1] + 3.0f) / 7.0f);
+			const byte *block = getBlock(src, srcEnd, 16);
+
+			const uint32 alpha_0 = block[0];
+			const uint32 alpha_1 = block[1];
+
+			uint32 alphab[8];
+
+			alphab[0] = alpha_0;
+			alphab[1] = alpha_1;
+
+			if (alpha_0 > alpha_1) {
+				for (uint32 i = 1; i < 7; i++)
+					alphab[i + 1] = ((7 - i) * alpha_0 + i * alpha_1 + 3) / 7;
 			} else {
-				alphab[2] = (byte)((4.0f * (double)alphab[0] + 1.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[3] = (byte)((3.0f * (double)alphab[0] + 2.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[4] = (byte)((2.0f * (double)alphab[0] + 3.0f * (double)alphab[1] + 2.0f) / 5.0f);
-				alphab[5] = (byte)((1.0f * (double)alphab[0] + 4.0f * (double)alphab[1] + 2.0f) / 5.0f);
+				for (uint32 i = 1; i < 5; i++)
+					alphab[i + 1] = ((5 - i) * alpha_0 + i * alpha_1 + 2) / 5;
+
 				alphab[6] = 0;
 				alphab[7] = 255;
 			}
 
-			blended[0] = convert565To8888(tex.color_0) & 0xFFFFFF00;
-			blended[1] = convert565To8888(tex.color_1) & 0xFFFFFF00;
-			blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
-			blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
-
-			uint32 cpx = tex.pixels;
-			uint32 blockWidth = MIN<uint32>(width, 4);
-			uint32 blockHeight = MIN<uint32>(height, 4);
-
-			for (byte y = 0; y < blockHeight; ++y) {
-				for (byte x = 0; x < blockWidth; ++x) {
-					uint32 alpha = alphab[(tex.alphabl >> (3 * (4 * (3 - y) + x))) & 7];
-					WRITE_BE_UINT32(dest + (height - 1 - (ty - blockHeight + y)) * pitch + (tx + x) * 4, blended[cpx & 3] | alpha);
-					cpx >>= 2;
-				}
-			}
+			for (uint32 i = 0; i < 8; i++)
+				alphab[i] = TO_BE_32(alphab[i]);
+
+			const uint64 alphabl = ((uint64) READ_LE_UINT32(block + 2)) |
+			                       ((uint64) READ_LE_UINT16(block + 6) << 32);
+
+			const DXTBlockSize size(width, height, tx, ty);
+
+			DXTColors colors;
+			readColors(block + 8, colors, false);
+
+			uint32 pixels[16];
+			decodeColors(pixels, block + 12, colors, size);
+
+			for (uint32 y = 0; y < size.rows; y++)
+				for (uint32 x = 0; x < size.columns; x++)
+					pixels[y * 4 + x] |= alphab[(alphabl >> (3 * (4 * (3 - y) + x))) & 7];
+
+			writeBlock(dest, pitch, height, tx, ty, size, pixels);
 		}
 	}
 }
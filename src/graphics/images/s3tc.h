@@ -27,15 +27,17 @@
 
 #include "src/common/types.h"
 
-namespace Common {
-	class SeekableReadStream;
-}
-
 namespace Graphics {
 
-void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
-void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
-void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
+/* Decompress DXTn data into RGBA8 pixels.
+ *
+ * The source is read directly out of memory; data missing at the end is
+ * treated as all-zero blocks. Images consisting of whole rows of blocks
+ * can be split into horizontal bands decompressed independently. */
+
+void decompressDXT1(byte *dest, const byte *src, uint32 srcSize, uint32 width, uint32 height, uint32 pitch);
+void decompressDXT3(byte *dest, const byte *src, uint32 srcSize, uint32 width, uint32 height, uint32 pitch);
+void decompressDXT5(byte *dest, const byte *src, uint32 srcSize, uint32 width, uint32 height, uint32 pitch);
 
 } // End of namespace Graphics
 
@@ -24,14 +24,17 @@
 
 #include "src/common/system.h"
 #include "src/common/error.h"
+#include "src/common/threads.h"
 
 #include "src/graphics/renderable.h"
 #include "src/graphics/types.h"
 #include "src/graphics/graphics.h"
+#include "src/graphics/bvh.h"
 
 namespace Graphics {
 
-Renderable::Renderable(RenderableType type) : _clickable(false), _distance(0.0) {
+Renderable::Renderable(RenderableType type) : _clickable(false), _distance(0.0),
+	_boundProxy(BVH::kInvalidProxy), _cullFrame(0), _pending(false) {
 	if        (type == kRenderableTypeVideo) {
 		_queueExists  = kQueueVideo;
 		_queueVisible = kQueueVisibleVideo;
@@ -101,10 +104,19 @@ void Renderable::show() {
 	sortQueue(_queueVisible);
 
 	unlockQueue(_queueVisible);
+
+	updateWorldBound();
 }
 
 void Renderable::hide() {
 	removeFromQueue(_queueVisible);
+
+	/* No need to wait for the next frame anymore. This also waits for the main thread
+	 * if it's applying our pending state right now, so that it can't put us back into
+	 * the culling hierarchy after we left it. */
+	GfxMan.flushPending(*this);
+
+	GfxMan.removeWorldBound(*this);
 }
 
 bool Renderable::isIn(float UNUSED(x), float UNUSED(y)) const {
@@ -121,6 +133,18 @@ bool Renderable::isIn(float UNUSED(x1), float UNUSED(y1), float UNUSED(z1),
 	return false;
 }
 
+bool Renderable::getWorldBound(float *UNUSED(min), float *UNUSED(max)) const {
+	return false;
+}
+
+void Renderable::updateWorldBound() {
+	if ((_queueVisible == kQueueVisibleWorldObject) && isVisible())
+		GfxMan.updateWorldBound(*this);
+}
+
+void Renderable::applyPending() {
+}
+
 void Renderable::lockFrame() {
 	GfxMan.lockFrame();
 }
@@ -139,4 +163,17 @@ void Renderable::unlockFrameIfVisible() {
 		GfxMan.unlockFrame();
 }
 
+bool Renderable::beginChange() {
+	GfxMan.lockPending();
+
+	return _pending || (!Common::isMainThread() && isVisible());
+}
+
+void Renderable::endChange(bool pending) {
+	if (pending)
+		GfxMan.queuePending(*this);
+
+	GfxMan.unlockPending();
+}
+
 } // End of namespace Graphics
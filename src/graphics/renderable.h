@@ -77,6 +77,15 @@ public:
 	/** Does the line from x1.y1.z1 to x2.y2.z2 intersect with the object? */
 	virtual bool isIn(float x1, float y1, float z1, float x2, float y2, float z2) const;
 
+	/** Get the object's axis-aligned bounding box in world space.
+	 *
+	 *  World objects with a bounding box are culled against the view frustum.
+	 *  Objects without one are always rendered.
+	 *
+	 *  @return false if the object has no bounding box.
+	 */
+	virtual bool getWorldBound(float *min, float *max) const;
+
 protected:
 	QueueType _queueExists;
 	QueueType _queueVisible;
@@ -90,11 +99,37 @@ protected:
 
 	void resort();
 
+	/** The object's world bounding box changed. */
+	void updateWorldBound();
+
 	void lockFrame();
 	void unlockFrame();
 
 	void lockFrameIfVisible();
 	void unlockFrameIfVisible();
+
+	/** Start changing state the main thread reads while rendering.
+	 *
+	 *  A visible object can't be changed from outside the main thread while a
+	 *  frame might be rendered. Instead, the changes go into a pending state,
+	 *  which the main thread applies before the next frame.
+	 *
+	 *  @return true if the changes have to go into the pending state.
+	 */
+	bool beginChange();
+	/** Finish changing state, queueing the pending state if it was changed. */
+	void endChange(bool pending);
+
+	/** Apply the pending state. */
+	virtual void applyPending();
+
+private:
+	uint32 _boundProxy; ///< The object's handle within the world's culling hierarchy.
+	uint32 _cullFrame;  ///< The last frame the object was found within the view.
+
+	bool _pending; ///< Is the pending state waiting to be applied?
+
+	friend class GraphicsManager;
 };
 
 } // End of namespace Graphics
@@ -211,9 +211,8 @@ void Bink::processData() {
 				//                  Number of samples in bytes
 				audio.sampleCount = _bink->readUint32LE() / (2 * audio.channels);
 
-				audio.bits =
-					new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-					    audioPacketStart + 4, audioPacketEnd), true);
+				Common::SeekableSubReadStream audioPacketStream(_bink, audioPacketStart + 4, audioPacketEnd);
+				audio.bits = new Common::BitStreamMemory32LELSB(audioPacketStream);
 
 				audioPacket(audio);
 
@@ -230,9 +229,8 @@ void Bink::processData() {
 	uint32 videoPacketStart = _bink->pos();
 	uint32 videoPacketEnd   = _bink->pos() + frameSize;
 
-	frame.bits =
-		new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-		    videoPacketStart, videoPacketEnd), true);
+	Common::SeekableSubReadStream videoPacketStream(_bink, videoPacketStart, videoPacketEnd);
+	frame.bits = new Common::BitStreamMemory32LELSB(videoPacketStream);
 
 	videoPacket(frame);
 
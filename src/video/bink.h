@@ -31,12 +31,12 @@
 #include <vector>
 
 #include "src/common/types.h"
+#include "src/common/bitstream.h"
 
 #include "src/video/decoder.h"
 
 namespace Common {
 	class SeekableReadStream;
-	class BitStream;
 	class Huffman;
 
 	class RDFT;
@@ -129,7 +129,7 @@ private:
 
 		uint32 sampleCount;
 
-		Common::BitStream *bits;
+		Common::BitStreamMemory32LELSB *bits;
 
 		bool first;
 
@@ -162,7 +162,7 @@ private:
 		uint32 offset;
 		uint32 size;
 
-		Common::BitStream *bits;
+		Common::BitStreamMemory32LELSB *bits;
 
 		VideoFrame();
 		~VideoFrame();
@@ -91,7 +91,7 @@ void XMVWMV2Codec::CBP::decode(uint32 cbp, const CBP &topLeft, const CBP &top,
 }
 
 
-XMVWMV2Codec::DecodeContext::DecodeContext(Common::BitStream &b) : bits(b),
+XMVWMV2Codec::DecodeContext::DecodeContext(Common::BitStreamMemory32LEMSB &b) : bits(b),
 	hasACPerMacroBlock(false), hasACPrediction(false),
 	acRLERunLength(0), acRLELevelLength(0) {
 
@@ -314,8 +314,8 @@ void XMVWMV2Codec::init() {
 void XMVWMV2Codec::decodeFrame(Graphics::Surface &surface,
                                Common::SeekableReadStream &dataStream) {
 
-	Common::BitStream32LEMSB bits(dataStream);
-	DecodeContext            ctx(bits);
+	Common::BitStreamMemory32LEMSB bits(dataStream);
+	DecodeContext                  ctx(bits);
 
 	initDecodeContext(ctx);
 
@@ -804,7 +804,7 @@ void XMVWMV2Codec::IDCTCol(int32 *b) {
 	b[8 * 7] = (a0 + a2 - a1 - a5 + (1 << 13)) >> 14;
 }
 
-uint8 XMVWMV2Codec::getTrit(Common::BitStream &bits) {
+uint8 XMVWMV2Codec::getTrit(Common::BitStreamMemory32LEMSB &bits) {
 	// 0 -> 0;  10 -> 1;  11 -> 2
 
 	uint8 n = bits.getBit();
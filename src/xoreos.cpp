@@ -35,6 +35,7 @@
 #include "src/common/threads.h"
 #include "src/common/debugman.h"
 #include "src/common/configman.h"
+#include "src/common/filepool.h"
 
 #include "src/aurora/resman.h"
 #include "src/aurora/2dareg.h"
@@ -210,6 +211,14 @@ void initConfig() {
 
 	ConfigMan.setBool(Common::kConfigRealmDefault, "skipvideos", false);
 
+	ConfigMan.setBool(Common::kConfigRealmDefault, "mmaparchives", false);
+	ConfigMan.setInt (Common::kConfigRealmDefault, "filehandles" , Common::FilePoolManager::kDefaultMaxHandles);
+	ConfigMan.setBool(Common::kConfigRealmDefault, "indexcache"  , true);
+
+	// Size of the decompressed resource cache, in MB
+	ConfigMan.setInt (Common::kConfigRealmDefault, "resourcecache",
+	                  Aurora::ResourceManager::kDefaultResourceCacheSize / (1024 * 1024));
+
 	// Populate the new config with the defaults
 	if (newConfig) {
 		ConfigMan.setDefaults();
@@ -244,6 +253,21 @@ void init() {
 	// Init threading system
 	Common::initThreads();
 
+	// Configure resource archive access
+	ResMan.setMapArchives(ConfigMan.getBool("mmaparchives", false));
+	FilePoolMan.setMaxHandles(ConfigMan.getInt("filehandles", Common::FilePoolManager::kDefaultMaxHandles));
+
+	if (ConfigMan.getBool("indexcache", true))
+		ResMan.setIndexCache(Common::FilePath::getUserDataDirectory() + "/resindex.cache");
+
+	const int resourceCache = ConfigMan.getInt("resourcecache",
+			Aurora::ResourceManager::kDefaultResourceCacheSize / (1024 * 1024));
+	ResMan.setResourceCacheSize(CLIP(resourceCache, 0, 4095) * 1024U * 1024U);
+
+	const int textureBudget = ConfigMan.getInt("texturebudget",
+			Graphics::Aurora::TextureManager::kDefaultTextureBudget / (1024 * 1024));
+	TextureMan.setTextureBudget(CLIP(textureBudget, 0, 4095) * 1024U * 1024U);
+
 	// Init subsystems
 	GfxMan.init();
 	status("Graphics subsystem initialized");
@@ -274,6 +298,8 @@ void deinit() {
 	Aurora::ResourceManager::destroy();
 	Aurora::FileTypeManager::destroy();
 
+	Common::FilePoolManager::destroy();
+
 	Engines::EngineManager::destroy();
 
 	Events::EventsManager::destroy();
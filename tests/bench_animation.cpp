@@ -0,0 +1,241 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for the evaluation of model animation keyframes.
+ *
+ *  Interpolates the positions and orientations of many animated nodes
+ *  over a whole animation. For comparison, the same keyframes are also
+ *  evaluated with the previous linear keyframe search.
+ *
+ *  Usage: bench_animation [scale]
+ */
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/maths.h"
+
+#include "src/graphics/aurora/keyframes.h"
+
+#include "tests/benchmark.h"
+
+using Graphics::Aurora::PositionKeyFrame;
+using Graphics::Aurora::QuaternionKeyFrame;
+
+static const uint32 kNodeCount      = 64;
+static const uint32 kKeyFrameCount  = 90;
+static const float  kFrameRate      = 30.0f;
+static const float  kAnimationSpeed = 60.0f;
+
+/** The keyframes of one animated node. */
+struct Node {
+	std::vector<PositionKeyFrame>   positions;
+	std::vector<QuaternionKeyFrame> orientations;
+};
+
+/** Create random keyframes, one per frame. */
+static void createNode(Node &node, Test::Random &random) {
+	node.positions.resize(kKeyFrameCount);
+	node.orientations.resize(kKeyFrameCount);
+
+	for (uint32 i = 0; i < kKeyFrameCount; i++) {
+		const float time = i / kFrameRate;
+
+		PositionKeyFrame &pos = node.positions[i];
+
+		pos.time = time;
+		pos.x    = random.next(2000) / 1000.0f - 1.0f;
+		pos.y    = random.next(2000) / 1000.0f - 1.0f;
+		pos.z    = random.next(2000) / 1000.0f - 1.0f;
+
+		QuaternionKeyFrame &ori = node.orientations[i];
+
+		ori.time = time;
+		ori.x    = random.next(2000) / 1000.0f - 1.0f;
+		ori.y    = random.next(2000) / 1000.0f - 1.0f;
+		ori.z    = random.next(2000) / 1000.0f - 1.0f;
+		ori.q    = random.next(2000) / 1000.0f - 1.0f;
+
+		const float length = std::sqrt(ori.x * ori.x + ori.y * ori.y + ori.z * ori.z + ori.q * ori.q);
+
+		ori.x /= length;
+		ori.y /= length;
+		ori.z /= length;
+		ori.q /= length;
+	}
+}
+
+/** The previous position interpolation, scanning all keyframes linearly. */
+static void interpolatePositionLinear(const std::vector<PositionKeyFrame> &frames, float time,
+                                      float &x, float &y, float &z) {
+
+	uint32 lastFrame = 0;
+	for (uint32 i = 0; i < frames.size(); i++) {
+		if (frames[i].time >= time)
+			break;
+
+		lastFrame = i;
+	}
+
+	const PositionKeyFrame &last = frames[lastFrame];
+	if (lastFrame + 1 >= frames.size() || last.time == time) {
+		x = last.x;
+		y = last.y;
+		z = last.z;
+		return;
+	}
+
+	const PositionKeyFrame &next = frames[lastFrame + 1];
+
+	const float f = (time - last.time) / (next.time - last.time);
+	x = f * next.x + (1.0f - f) * last.x;
+	y = f * next.y + (1.0f - f) * last.y;
+	z = f * next.z + (1.0f - f) * last.z;
+}
+
+/** The previous orientation interpolation, scanning all keyframes linearly. */
+static void interpolateOrientationLinear(const std::vector<QuaternionKeyFrame> &frames, float time,
+                                         float &x, float &y, float &z, float &a) {
+
+	uint32 lastFrame = 0;
+	for (uint32 i = 0; i < frames.size(); i++) {
+		if (frames[i].time >= time)
+			break;
+
+		lastFrame = i;
+	}
+
+	const QuaternionKeyFrame &last = frames[lastFrame];
+	if (lastFrame + 1 >= frames.size() || last.time == time) {
+		x = last.x;
+		y = last.y;
+		z = last.z;
+		a = Common::rad2deg(acos(last.q) * 2.0);
+		return;
+	}
+
+	const QuaternionKeyFrame &next = frames[lastFrame + 1];
+
+	const float f = (time - last.time) / (next.time - last.time);
+	x = f * next.x + (1.0f - f) * last.x;
+	y = f * next.y + (1.0f - f) * last.y;
+	z = f * next.z + (1.0f - f) * last.z;
+
+	const float q = f * next.q + (1.0f - f) * last.q;
+	a = Common::rad2deg(acos(q) * 2.0);
+}
+
+int main(int argc, char **argv) {
+	try {
+		const double scale = Test::getScale(argc, argv);
+
+		const uint32 frameCount = 20000 * scale;
+		const float  length     = (kKeyFrameCount - 1) / kFrameRate;
+
+		std::printf("Animation: %u nodes with %u keyframes each, evaluated at %u times\n",
+		            kNodeCount, kKeyFrameCount, frameCount);
+
+		Test::Random random;
+
+		std::vector<Node> nodes(kNodeCount);
+		for (uint32 i = 0; i < kNodeCount; i++)
+			createNode(nodes[i], random);
+
+		// Sample the animation as it's played, wrapping around at the end
+		std::vector<float> times(frameCount);
+		for (uint32 i = 0; i < frameCount; i++)
+			times[i] = std::fmod(i / kAnimationSpeed, length);
+
+		std::vector<float> positions(3 * kNodeCount * frameCount);
+		std::vector<float> positionsLinear(3 * kNodeCount * frameCount);
+
+		std::vector<float> angles(kNodeCount * frameCount);
+		std::vector<float> anglesLinear(kNodeCount * frameCount);
+
+		Test::Stopwatch watch;
+
+		for (uint32 i = 0; i < frameCount; i++) {
+			for (uint32 n = 0; n < kNodeCount; n++) {
+				float *pos = &positionsLinear[3 * (i * kNodeCount + n)];
+
+				interpolatePositionLinear(nodes[n].positions, times[i], pos[0], pos[1], pos[2]);
+			}
+		}
+
+		Test::printTime("Positions, linear search", watch.getMilliseconds());
+
+		watch.restart();
+
+		for (uint32 i = 0; i < frameCount; i++) {
+			for (uint32 n = 0; n < kNodeCount; n++) {
+				float *pos = &positions[3 * (i * kNodeCount + n)];
+
+				Graphics::Aurora::interpolatePosition(nodes[n].positions, times[i], pos[0], pos[1], pos[2]);
+			}
+		}
+
+		Test::printTime("Positions, binary search", watch.getMilliseconds());
+
+		watch.restart();
+
+		for (uint32 i = 0; i < frameCount; i++) {
+			for (uint32 n = 0; n < kNodeCount; n++) {
+				float x, y, z;
+
+				interpolateOrientationLinear(nodes[n].orientations, times[i], x, y, z, anglesLinear[i * kNodeCount + n]);
+			}
+		}
+
+		Test::printTime("Orientations, linear search and interpolation", watch.getMilliseconds());
+
+		watch.restart();
+
+		for (uint32 i = 0; i < frameCount; i++) {
+			for (uint32 n = 0; n < kNodeCount; n++) {
+				float x, y, z;
+
+				Graphics::Aurora::interpolateOrientation(nodes[n].orientations, times[i], x, y, z, angles[i * kNodeCount + n]);
+			}
+		}
+
+		Test::printTime("Orientations, binary search and slerp", watch.getMilliseconds());
+
+		// The positions must match
+		for (uint32 i = 0; i < positions.size(); i++)
+			if (std::fabs(positions[i] - positionsLinear[i]) > 1e-5f)
+				throw Common::Exception("Interpolated positions don't match (%f vs. %f)",
+				                        positions[i], positionsLinear[i]);
+
+		// The orientations are interpolated differently now, but must still be valid rotations
+		for (uint32 i = 0; i < angles.size(); i++)
+			if (!(angles[i] >= 0.0f) || !(angles[i] <= 360.0f))
+				throw Common::Exception("Invalid interpolated orientation angle %f", angles[i]);
+
+	} catch (Common::Exception &e) {
+		Common::printException(e);
+		return 1;
+	}
+
+	return 0;
+}
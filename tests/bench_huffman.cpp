@@ -0,0 +1,250 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for Common::Huffman.
+ *
+ *  Decodes a stream of symbols with a skewed distribution, using both the
+ *  virtual bit streams and the memory bit streams. For comparison, the same
+ *  stream is decoded with the previous bit-by-bit list search.
+ *
+ *  Usage: bench_huffman [scale]
+ */
+
+#include <cstdio>
+#include <list>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/stream.h"
+#include "src/common/bitstream.h"
+#include "src/common/huffman.h"
+
+#include "tests/benchmark.h"
+
+static const uint32 kSymbolCount = 512;
+
+/** A code, with the Zipf-like weight of its symbol. */
+struct Code {
+	uint32 weight;
+	uint32 code;
+	uint8  length;
+};
+
+/** Create canonical Huffman codes for symbols with a Zipf-like distribution. */
+static void createCodes(std::vector<Code> &codes) {
+	codes.resize(kSymbolCount);
+
+	// Build the Huffman tree, remembering each node's parent
+	typedef std::pair<uint64, uint32> Node;
+	std::priority_queue<Node, std::vector<Node>, std::greater<Node> > queue;
+
+	std::vector<uint32> parents(2 * kSymbolCount, 0);
+
+	for (uint32 i = 0; i < kSymbolCount; i++) {
+		codes[i].weight = 1000000 / (i + 1);
+
+		queue.push(Node(codes[i].weight, i));
+	}
+
+	uint32 nextNode = kSymbolCount;
+	while (queue.size() > 1) {
+		Node a = queue.top();
+		queue.pop();
+		Node b = queue.top();
+		queue.pop();
+
+		parents[a.second] = parents[b.second] = nextNode;
+		queue.push(Node(a.first + b.first, nextNode++));
+	}
+
+	const uint32 root = nextNode - 1;
+
+	for (uint32 i = 0; i < kSymbolCount; i++) {
+		codes[i].length = 0;
+		for (uint32 n = i; n != root; n = parents[n])
+			codes[i].length++;
+	}
+
+	// Assign canonical codes, shortest first
+	uint32 code = 0;
+	for (uint8 length = 1; length <= 32; length++) {
+		for (uint32 i = 0; i < kSymbolCount; i++)
+			if (codes[i].length == length)
+				codes[i].code = code++;
+
+		code <<= 1;
+	}
+}
+
+/** Encode random symbols MSB-first, returning the symbols. */
+static void encode(const std::vector<Code> &codes, uint32 count,
+                   std::vector<uint32> &symbols, std::vector<byte> &data) {
+
+	std::vector<uint32> cumulative(kSymbolCount);
+
+	uint32 total = 0;
+	for (uint32 i = 0; i < kSymbolCount; i++)
+		cumulative[i] = (total += codes[i].weight);
+
+	Test::Random random;
+
+	symbols.resize(count);
+	data.clear();
+
+	uint64 bits = 0;
+	uint32 bitCount = 0;
+
+	for (uint32 i = 0; i < count; i++) {
+		const uint32 value = random.next(total);
+
+		symbols[i] = std::upper_bound(cumulative.begin(), cumulative.end(), value) - cumulative.begin();
+
+		const Code &code = codes[symbols[i]];
+
+		bits = (bits << code.length) | code.code;
+		bitCount += code.length;
+
+		while (bitCount >= 8) {
+			data.push_back((bits >> (bitCount - 8)) & 0xFF);
+			bitCount -= 8;
+		}
+	}
+
+	if (bitCount > 0)
+		data.push_back((bits << (8 - bitCount)) & 0xFF);
+
+	// Padding, so that peeking past the last code doesn't run out of data
+	data.resize(data.size() + 8, 0);
+}
+
+/** The previous decoder: a linear search through the codes of each length, bit by bit. */
+class ReferenceHuffman {
+public:
+	ReferenceHuffman(const std::vector<Code> &codes) : _codes(32) {
+		for (uint32 i = 0; i < codes.size(); i++)
+			_codes[codes[i].length - 1].push_back(std::make_pair(codes[i].code, i));
+	}
+
+	uint32 getSymbol(Common::BitStream &bits) const {
+		uint32 code = 0;
+
+		for (uint32 i = 0; i < _codes.size(); i++) {
+			bits.addBit(code, i);
+
+			for (CodeList::const_iterator c = _codes[i].begin(); c != _codes[i].end(); ++c)
+				if (code == c->first)
+					return c->second;
+		}
+
+		throw Common::Exception("Unknown Huffman code");
+	}
+
+private:
+	typedef std::list< std::pair<uint32, uint32> > CodeList;
+
+	std::vector<CodeList> _codes;
+};
+
+template<class Decoder, class BitStreamType>
+static bool decode(const Decoder &huffman, BitStreamType &bits, const std::vector<uint32> &symbols) {
+	bool correct = true;
+
+	for (uint32 i = 0; i < symbols.size(); i++)
+		if (huffman.getSymbol(bits) != symbols[i])
+			correct = false;
+
+	return correct;
+}
+
+int main(int argc, char **argv) {
+	try {
+		const uint32 count = 4000000 * Test::getScale(argc, argv);
+
+		std::vector<Code> codes;
+		createCodes(codes);
+
+		std::vector<uint32> symbols;
+		std::vector<byte>   data;
+		encode(codes, count, symbols, data);
+
+		std::vector<uint32> huffmanCodes(kSymbolCount);
+		std::vector<uint8>  huffmanLengths(kSymbolCount);
+		uint8 maxLength = 0;
+
+		for (uint32 i = 0; i < kSymbolCount; i++) {
+			huffmanCodes  [i] = codes[i].code;
+			huffmanLengths[i] = codes[i].length;
+
+			maxLength = MAX(maxLength, codes[i].length);
+		}
+
+		std::printf("Huffman: %u symbols, %u codes of up to %u bits, %u bytes\n",
+		            count, kSymbolCount, maxLength, (uint) data.size());
+
+		bool correct = true;
+		Test::Stopwatch watch;
+
+		{
+			ReferenceHuffman huffman(codes);
+
+			Common::MemoryReadStream stream(&data[0], data.size());
+			Common::BitStream8MSB bits(stream);
+
+			watch.restart();
+			correct = decode(huffman, bits, symbols) && correct;
+			Test::printTime("Bit by bit search (previous)", watch.getMilliseconds());
+		}
+
+		Common::Huffman huffman(maxLength, kSymbolCount, &huffmanCodes[0], &huffmanLengths[0]);
+
+		{
+			Common::MemoryReadStream stream(&data[0], data.size());
+			Common::BitStream8MSB bits(stream);
+
+			watch.restart();
+			correct = decode(huffman, bits, symbols) && correct;
+			Test::printTime("Lookup tables, BitStream8MSB", watch.getMilliseconds());
+		}
+
+		{
+			Common::BitStreamMemory8MSB bits(&data[0], data.size());
+
+			watch.restart();
+			correct = decode(huffman, bits, symbols) && correct;
+			Test::printTime("Lookup tables, BitStreamMemory8MSB", watch.getMilliseconds());
+		}
+
+		if (!correct) {
+			std::fprintf(stderr, "Decoded symbols don't match\n");
+			return 1;
+		}
+
+	} catch (Common::Exception &e) {
+		Common::printException(e);
+		return 1;
+	}
+
+	return 0;
+}
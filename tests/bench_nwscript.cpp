@@ -0,0 +1,293 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for the NWScript virtual machine.
+ *
+ *  Runs hand-assembled bytecode: an integer loop, and a loop that
+ *  concatenates strings.
+ *
+ *  Usage: bench_nwscript [scale]
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <map>
+#include <string>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/stream.h"
+
+#include "src/aurora/nwscript/variable.h"
+#include "src/aurora/nwscript/ncsfile.h"
+
+#include "tests/benchmark.h"
+
+/** A tiny NCS assembler. */
+class Assembler {
+public:
+	Assembler() {
+		// Header, and the script size instruction, to be filled in later
+		writeUint32(MKTAG('N', 'C', 'S', ' '));
+		writeUint32(MKTAG('V', '1', '.', '0'));
+
+		_data.push_back(0x42);
+		writeUint32(0);
+	}
+
+	void label(const char *name) {
+		_labels[name] = _data.size();
+	}
+
+	/** Finish the script, returning a stream of it. */
+	Common::SeekableReadStream *finish() {
+		for (std::vector<Fixup>::const_iterator f = _fixups.begin(); f != _fixups.end(); ++f) {
+			const uint32 offset = _labels[f->label] - f->address;
+
+			for (int i = 0; i < 4; i++)
+				_data[f->address + 2 + i] = (offset >> (24 - 8 * i)) & 0xFF;
+		}
+
+		const uint32 size = _data.size();
+		for (int i = 0; i < 4; i++)
+			_data[9 + i] = (size >> (24 - 8 * i)) & 0xFF;
+
+		byte *data = new byte[size];
+		std::memcpy(data, &_data[0], size);
+
+		return new Common::MemoryReadStream(data, size, true);
+	}
+
+	void rsadd(uint8 type) {
+		op(0x02, type);
+	}
+
+	void cptopsp(int32 offset) {
+		op(0x03, 0x01);
+		writeUint32(offset);
+		writeUint16(4);
+	}
+
+	void cpdownsp(int32 offset) {
+		op(0x01, 0x01);
+		writeUint32(offset);
+		writeUint16(4);
+	}
+
+	void consti(int32 value) {
+		op(0x04, 0x03);
+		writeUint32(value);
+	}
+
+	void consts(const char *value) {
+		op(0x04, 0x05);
+
+		const uint16 length = std::strlen(value);
+
+		writeUint16(length);
+		_data.insert(_data.end(), value, value + length);
+	}
+
+	void add(uint8 type) {
+		op(0x14, type);
+	}
+
+	void lt(uint8 type) {
+		op(0x0F, type);
+	}
+
+	void movsp(int32 offset) {
+		op(0x1B, 0x00);
+		writeUint32(offset);
+	}
+
+	void incisp(int32 offset) {
+		op(0x24, 0x03);
+		writeUint32(offset);
+	}
+
+	void jmp(const char *target) {
+		jump(0x1D, target);
+	}
+
+	void jz(const char *target) {
+		jump(0x1F, target);
+	}
+
+	void retn() {
+		op(0x20, 0x00);
+	}
+
+private:
+	struct Fixup {
+		uint32 address;
+		const char *label;
+	};
+
+	std::vector<byte> _data;
+
+	std::map<std::string, uint32> _labels;
+	std::vector<Fixup> _fixups;
+
+	void op(uint8 opcode, uint8 type) {
+		_data.push_back(opcode);
+		_data.push_back(type);
+	}
+
+	void jump(uint8 opcode, const char *target) {
+		Fixup fixup;
+
+		fixup.address = _data.size();
+		fixup.label   = target;
+
+		_fixups.push_back(fixup);
+
+		op(opcode, 0x00);
+		writeUint32(0);
+	}
+
+	void writeUint16(uint16 value) {
+		_data.push_back(value >> 8);
+		_data.push_back(value & 0xFF);
+	}
+
+	void writeUint32(uint32 value) {
+		writeUint16(value >> 16);
+		writeUint16(value & 0xFFFF);
+	}
+};
+
+static const uint8 kTypeInt          = 0x03;
+static const uint8 kTypeString       = 0x05;
+static const uint8 kTypeIntInt       = 0x20;
+static const uint8 kTypeStringString = 0x23;
+
+/** Start a loop over i from 0 to count, with i on the top of the stack. */
+static void beginLoop(Assembler &ncs, int32 count) {
+	ncs.rsadd(kTypeInt);      // i
+
+	ncs.label("loop");
+	ncs.cptopsp(-4);          // i
+	ncs.consti(count);
+	ncs.lt(kTypeIntInt);
+	ncs.jz("end");
+}
+
+/** End the loop, removing i and the other locals above the result from the stack. */
+static void endLoop(Assembler &ncs, int32 locals) {
+	ncs.incisp(-4);           // i++
+	ncs.jmp("loop");
+
+	ncs.label("end");
+	ncs.movsp(-4 * (locals + 1));
+	ncs.retn();
+}
+
+/** int sum = 0; for (int i = 0; i < count; i++) sum = sum + i; return sum; */
+static Common::SeekableReadStream *createIntLoop(int32 count) {
+	Assembler ncs;
+
+	ncs.rsadd(kTypeInt);      // sum
+
+	beginLoop(ncs, count);
+
+	ncs.cptopsp(-8);          // sum
+	ncs.cptopsp(-8);          // i
+	ncs.add(kTypeIntInt);
+	ncs.cpdownsp(-12);        // sum = sum + i
+	ncs.movsp(-4);
+
+	endLoop(ncs, 0);
+
+	return ncs.finish();
+}
+
+/** string s = "foo"; string t; for (int i = 0; i < count; i++) t = s + "bar"; return t; */
+static Common::SeekableReadStream *createStringLoop(int32 count) {
+	Assembler ncs;
+
+	ncs.rsadd(kTypeString);   // t
+	ncs.consts("foo");        // s
+
+	beginLoop(ncs, count);
+
+	ncs.cptopsp(-8);          // s
+	ncs.consts("bar");
+	ncs.add(kTypeStringString);
+	ncs.cpdownsp(-16);        // t = s + "bar"
+	ncs.movsp(-4);
+
+	endLoop(ncs, 1);
+
+	return ncs.finish();
+}
+
+/** The number of instructions run per loop iteration, and outside the loop. */
+static const uint32 kIntLoopInstructions      = 11;
+static const uint32 kIntLoopSetupInstructions = 8;
+
+int main(int argc, char **argv) {
+	try {
+		const double scale = Test::getScale(argc, argv);
+
+		const int32 intCount    = 2000000 * scale;
+		const int32 stringCount = 1000000 * scale;
+
+		std::printf("NWScript VM: %u instructions in the integer loop, %d string concatenations\n",
+		            kIntLoopInstructions * intCount + kIntLoopSetupInstructions, stringCount);
+
+		Test::Stopwatch watch;
+
+		{
+			Aurora::NWScript::NCSFile script(createIntLoop(intCount));
+
+			int32 sum = 0;
+			for (int32 i = 0; i < intCount; i++)
+				sum = (int32) ((uint32) sum + (uint32) i);
+
+			watch.restart();
+			const Aurora::NWScript::Variable &result = script.run();
+			Test::printTime("Integer loop", watch.getMilliseconds());
+
+			if (result.getInt() != sum)
+				throw Common::Exception("Integer loop returned %d instead of %d", result.getInt(), sum);
+		}
+
+		{
+			Aurora::NWScript::NCSFile script(createStringLoop(stringCount));
+
+			watch.restart();
+			const Aurora::NWScript::Variable &result = script.run();
+			Test::printTime("String concatenation loop", watch.getMilliseconds());
+
+			if (result.getString() != "foobar")
+				throw Common::Exception("String loop returned \"%s\"", result.getString().c_str());
+		}
+
+	} catch (Common::Exception &e) {
+		Common::printException(e);
+		return 1;
+	}
+
+	return 0;
+}
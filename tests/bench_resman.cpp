@@ -0,0 +1,259 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Benchmark for the resource manager's index.
+ *
+ *  Writes an ERF archive with a large number of empty resources into a
+ *  temporary directory, indexes it and looks up random resources. For
+ *  comparison, the same lookups are done on a map of lists of full
+ *  resource records, the way the index was organized before.
+ *
+ *  Usage: bench_resman [scale]
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/strutil.h"
+#include "src/common/hash.h"
+#include "src/common/file.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/util.h"
+#include "src/aurora/resman.h"
+
+#include "tests/benchmark.h"
+
+static const Aurora::FileType kTypes[] = {
+	Aurora::kFileTypeMDL, Aurora::kFileTypeTGA, Aurora::kFileTypeTXI,
+	Aurora::kFileTypeUTC, Aurora::kFileType2DA, Aurora::kFileTypeNSS
+};
+
+static const uint32 kTypeCount = ARRAYSIZE(kTypes);
+
+static Common::UString getName(const char *prefix, uint32 i) {
+	return Common::UString::sprintf("%s%07u", prefix, i);
+}
+
+/** Write an ERF V1.0 with kTypeCount empty resources per name. */
+static void writeERF(const Common::UString &fileName, uint32 nameCount) {
+	Common::DumpFile erf;
+	if (!erf.open(fileName))
+		throw Common::Exception("Can't create \"%s\"", fileName.c_str());
+
+	const uint32 resCount   = nameCount * kTypeCount;
+	const uint32 offKeyList = 160;
+	const uint32 offResList = offKeyList + resCount * 24;
+	const uint32 offData    = offResList + resCount * 8;
+
+	erf.writeUint32BE(MKTAG('E', 'R', 'F', ' '));
+	erf.writeUint32BE(MKTAG('V', '1', '.', '0'));
+	erf.writeUint32LE(0);          // Number of languages
+	erf.writeUint32LE(0);          // Size of the description
+	erf.writeUint32LE(resCount);
+	erf.writeUint32LE(offKeyList); // Offset to the (empty) description
+	erf.writeUint32LE(offKeyList);
+	erf.writeUint32LE(offResList);
+	erf.writeUint32LE(0);          // Build year
+	erf.writeUint32LE(0);          // Build day
+	erf.writeUint32LE(0xFFFFFFFF); // Description StrRef
+
+	byte reserved[116];
+	std::memset(reserved, 0, sizeof(reserved));
+	erf.write(reserved, sizeof(reserved));
+
+	for (uint32 i = 0; i < nameCount; i++) {
+		char name[16];
+		std::memset(name, 0, sizeof(name));
+		std::strncpy(name, getName("res", i).c_str(), sizeof(name));
+
+		for (uint32 t = 0; t < kTypeCount; t++) {
+			erf.write(name, sizeof(name));
+			erf.writeUint32LE(i * kTypeCount + t);
+			erf.writeUint16LE(kTypes[t]);
+			erf.writeUint16LE(0);
+		}
+	}
+
+	for (uint32 i = 0; i < resCount; i++) {
+		erf.writeUint32LE(offData);
+		erf.writeUint32LE(0);
+	}
+
+	if (!erf.flush() || erf.err())
+		throw Common::Exception(Common::kWriteError);
+}
+
+/** The previous index: a map over the hashes, holding lists of full resource records. */
+class ReferenceIndex {
+public:
+	void add(const Common::UString &name, Aurora::FileType type, uint32 index) {
+		Resource res;
+
+		res.name         = name;
+		res.type         = type;
+		res.priority     = 1;
+		res.archive      = 0;
+		res.archiveIndex = index;
+
+		ResourceList &list = _resources[getHash(name, type)];
+
+		list.push_back(res);
+		list.sort();
+	}
+
+	bool has(const Common::UString &name, Aurora::FileType type) const {
+		ResourceMap::const_iterator r = _resources.find(getHash(name, type));
+		if ((r == _resources.end()) || r->second.empty())
+			return false;
+
+		return r->second.back().priority > 0;
+	}
+
+private:
+	struct Resource {
+		Common::UString name;
+		Aurora::FileType type;
+
+		uint32 priority;
+
+		void  *archive;
+		uint32 archiveIndex;
+
+		Common::UString path;
+
+		bool operator<(const Resource &right) const {
+			return priority < right.priority;
+		}
+	};
+
+	typedef std::list<Resource> ResourceList;
+	typedef std::map<uint64, ResourceList> ResourceMap;
+
+	ResourceMap _resources;
+
+	static uint64 getHash(const Common::UString &name, Aurora::FileType type) {
+		return Common::hashString(TypeMan.setFileType(name, type).toLower(), Common::kHashFNV64);
+	}
+};
+
+int main(int argc, char **argv) {
+	boost::filesystem::path directory;
+
+	try {
+		const double scale = Test::getScale(argc, argv);
+
+		const uint32 nameCount   = 100000 * scale;
+		const uint32 lookupCount = 1000000 * scale;
+
+		directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+		boost::filesystem::create_directories(directory);
+
+		const Common::UString erfFile = Common::UString(directory.string().c_str()) + "/bench.erf";
+
+		writeERF(erfFile, nameCount);
+
+		std::printf("Resource manager: %u resources, %u lookups\n", nameCount * kTypeCount, lookupCount);
+
+		// Every tenth lookup is for a resource that doesn't exist
+		std::vector<Common::UString>  names(lookupCount);
+		std::vector<Aurora::FileType> types(lookupCount);
+
+		Test::Random random;
+
+		uint32 expectedHits = 0;
+		for (uint32 i = 0; i < lookupCount; i++) {
+			const bool miss = (i % 10) == 9;
+
+			names[i] = getName(miss ? "mis" : "res", random.next(nameCount));
+			types[i] = kTypes[random.next(kTypeCount)];
+
+			if (!miss)
+				expectedHits++;
+		}
+
+		Test::Stopwatch watch;
+
+		{
+			ReferenceIndex index;
+
+			watch.restart();
+			for (uint32 i = 0; i < nameCount; i++)
+				for (uint32 t = 0; t < kTypeCount; t++)
+					index.add(getName("res", i), kTypes[t], i * kTypeCount + t);
+			Test::printTime("Index, map of lists (previous)", watch.getMilliseconds());
+
+			uint32 hits = 0;
+
+			watch.restart();
+			for (uint32 i = 0; i < lookupCount; i++)
+				if (index.has(names[i], types[i]))
+					hits++;
+			Test::printTime("Lookups, map of lists (previous)", watch.getMilliseconds());
+
+			if (hits != expectedHits)
+				throw Common::Exception("Reference index found %u resources instead of %u", hits, expectedHits);
+		}
+
+		ResMan.registerDataBaseDir(directory.string().c_str());
+
+		watch.restart();
+		Aurora::ResourceManager::ChangeID change = ResMan.addArchive(Aurora::kArchiveERF, "bench.erf");
+		Test::printTime("Index, hash table (includes reading the ERF)", watch.getMilliseconds());
+
+		uint32 hits = 0;
+
+		watch.restart();
+		for (uint32 i = 0; i < lookupCount; i++)
+			if (ResMan.hasResource(names[i], types[i]))
+				hits++;
+		Test::printTime("Lookups, hash table", watch.getMilliseconds());
+
+		if (hits != expectedHits)
+			throw Common::Exception("Resource manager found %u resources instead of %u", hits, expectedHits);
+
+		watch.restart();
+		ResMan.undo(change);
+		Test::printTime("Removal, hash table", watch.getMilliseconds());
+
+		if (ResMan.hasResource(names[0], types[0]))
+			throw Common::Exception("Resources still found after removing the archive");
+
+	} catch (Common::Exception &e) {
+		Common::printException(e);
+
+		boost::filesystem::remove_all(directory);
+		return 1;
+	}
+
+	ResMan.clear();
+	boost::filesystem::remove_all(directory);
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Minimal helpers for the benchmarks.
+ */
+
+#ifndef TESTS_BENCHMARK_H
+#define TESTS_BENCHMARK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <SDL_timer.h>
+
+#include "src/common/types.h"
+
+namespace Test {
+
+/** Measures wall clock time. */
+class Stopwatch {
+public:
+	Stopwatch() : _start(SDL_GetPerformanceCounter()) {
+	}
+
+	/** Restart the measurement. */
+	void restart() {
+		_start = SDL_GetPerformanceCounter();
+	}
+
+	/** Return the time since the start of the measurement, in milliseconds. */
+	double getMilliseconds() const {
+		return (SDL_GetPerformanceCounter() - _start) * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+private:
+	uint64 _start;
+};
+
+/** A small, fast and reproducible pseudo-random number generator. */
+class Random {
+public:
+	Random(uint32 seed = 0x12345678) : _state(seed) {
+	}
+
+	uint32 next() {
+		_state = _state * 1664525 + 1013904223;
+
+		return _state >> 8;
+	}
+
+	/** Return a number from 0 to max - 1. */
+	uint32 next(uint32 max) {
+		return next() % max;
+	}
+
+private:
+	uint32 _state;
+};
+
+/** Return the problem size scale given on the command line, or 1. */
+inline double getScale(int argc, char **argv) {
+	if (argc < 2)
+		return 1.0;
+
+	const double scale = std::atof(argv[1]);
+
+	return (scale > 0.0) ? scale : 1.0;
+}
+
+/** Print the time a benchmark run took. */
+inline void printTime(const char *name, double milliseconds) {
+	std::printf("  %-48s %10.2f ms\n", name, milliseconds);
+}
+
+} // End of namespace Test
+
+#endif // TESTS_BENCHMARK_H
@@ -0,0 +1,134 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for Graphics::AnimationStage.
+ */
+
+#include <vector>
+#include <list>
+
+#include "src/common/util.h"
+
+#include "src/graphics/animationstage.h"
+#include "src/graphics/renderable.h"
+#include "src/graphics/queueable.h"
+
+#include "tests/unittest.h"
+
+/** A renderable that only counts how often its time was advanced. */
+class TestRenderable : public Graphics::Renderable {
+public:
+	uint32 advanced;
+	float time;
+
+	TestRenderable() : Graphics::Renderable(Graphics::kRenderableTypeObject), advanced(0), time(0.0f) {
+	}
+
+	void calculateDistance() {
+	}
+
+	void render(Graphics::RenderPass UNUSED(pass)) {
+	}
+
+	void advanceTime(float dt) {
+		advanced++;
+		time += dt;
+	}
+};
+
+static void createRenderables(std::vector<TestRenderable *> &objects, uint32 count) {
+	objects.resize(count);
+	for (uint32 i = 0; i < count; i++)
+		objects[i] = new TestRenderable;
+}
+
+static void destroyRenderables(std::vector<TestRenderable *> &objects) {
+	for (std::vector<TestRenderable *>::iterator o = objects.begin(); o != objects.end(); ++o)
+		delete *o;
+
+	objects.clear();
+}
+
+/** Was every renderable advanced exactly this many times? */
+static void checkAdvanced(const std::vector<TestRenderable *> &objects, uint32 advanced, float time) {
+	for (std::vector<TestRenderable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
+		CHECK((*o)->advanced == advanced);
+		CHECK(((*o)->time > (time - 0.001f)) && ((*o)->time < (time + 0.001f)));
+	}
+}
+
+static void testVector(Graphics::AnimationStage &stage, uint32 count) {
+	std::vector<TestRenderable *> objects;
+	createRenderables(objects, count);
+
+	std::vector<Graphics::Renderable *> renderables(objects.begin(), objects.end());
+
+	stage.advanceTime(renderables, 0.5f);
+	checkAdvanced(objects, 1, 0.5f);
+
+	stage.advanceTime(renderables, 0.25f);
+	checkAdvanced(objects, 2, 0.75f);
+
+	destroyRenderables(objects);
+}
+
+static void testList(Graphics::AnimationStage &stage, uint32 count) {
+	std::vector<TestRenderable *> objects;
+	createRenderables(objects, count);
+
+	std::list<Graphics::Queueable *> renderables(objects.begin(), objects.end());
+
+	stage.advanceTime(renderables, 0.5f);
+	checkAdvanced(objects, 1, 0.5f);
+
+	// Fewer renderables than the last time
+	if (!renderables.empty())
+		renderables.pop_front();
+
+	stage.advanceTime(renderables, 0.25f);
+
+	if (!objects.empty()) {
+		CHECK(objects[0]->advanced == 1);
+
+		std::vector<TestRenderable *> rest(objects.begin() + 1, objects.end());
+		checkAdvanced(rest, 2, 0.75f);
+	}
+
+	destroyRenderables(objects);
+}
+
+int main() {
+	// Around the number of renderables that are worth splitting into batches, and many more
+	static const uint32 kCounts[] = { 0, 1, 7, 8, 9, 16, 17, 31, 33, 100, 1000 };
+
+	Graphics::AnimationStage single(1);
+	Graphics::AnimationStage multi(4);
+
+	for (uint32 i = 0; i < ARRAYSIZE(kCounts); i++) {
+		testVector(single, kCounts[i]);
+		testVector(multi , kCounts[i]);
+
+		testList(single, kCounts[i]);
+		testList(multi , kCounts[i]);
+	}
+
+	return Test::getResult("test_animationstage");
+}
@@ -0,0 +1,313 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for Graphics::BVH.
+ */
+
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include "src/common/transmatrix.h"
+
+#include "src/graphics/bvh.h"
+#include "src/graphics/frustum.h"
+
+#include "tests/unittest.h"
+#include "tests/benchmark.h"
+
+static const uint32 kObjectCount = 500;
+
+/** A box within the hierarchy, and whether it's still there. */
+struct Box {
+	float min[3];
+	float max[3];
+
+	uint32 proxy;
+	bool inserted;
+};
+
+/** The hierarchy never looks at the renderables themselves, so we hand it
+ *  distinct fake pointers, one for each box, and map them back to indices. */
+static Graphics::Renderable *getObject(uint32 i) {
+	return reinterpret_cast<Graphics::Renderable *>((uintptr_t) (i + 1) * 16);
+}
+
+static uint32 getIndex(Graphics::Renderable *object) {
+	return (uint32) (reinterpret_cast<uintptr_t>(object) / 16) - 1;
+}
+
+static float randomFloat(Test::Random &random, float min, float max) {
+	return min + (max - min) * (random.next(10001) / 10000.0f);
+}
+
+static void randomBox(Test::Random &random, Box &box) {
+	for (int i = 0; i < 3; i++) {
+		const float center = randomFloat(random, -100.0f, 100.0f);
+		const float size   = randomFloat(random,    0.1f,   5.0f);
+
+		box.min[i] = center - size;
+		box.max[i] = center + size;
+	}
+}
+
+/** Does the query result contain every box within the frustum, and nothing that was removed? */
+static void checkQuery(const Graphics::BVH &bvh, const std::vector<Box> &boxes,
+                       const Graphics::Frustum &frustum) {
+
+	std::vector<Graphics::Renderable *> objects;
+	bvh.query(frustum, objects);
+
+	std::set<uint32> found;
+	for (std::vector<Graphics::Renderable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
+		const uint32 index = getIndex(*o);
+
+		CHECK(index < boxes.size());
+		if (index >= boxes.size())
+			continue;
+
+		CHECK(boxes[index].inserted);
+		CHECK(found.insert(index).second);
+	}
+
+	for (uint32 i = 0; i < boxes.size(); i++)
+		if (boxes[i].inserted && frustum.isIn(boxes[i].min, boxes[i].max))
+			CHECK(found.find(i) != found.end());
+}
+
+/** Does the raycast find every box on the line, nothing that was removed, and in order? */
+static void checkRaycast(const Graphics::BVH &bvh, const std::vector<Box> &boxes,
+                         const float *start, const float *end) {
+
+	std::vector<Graphics::BVH::Hit> hits;
+	bvh.raycast(start, end, hits);
+
+	std::set<uint32> found;
+	for (uint32 i = 0; i < hits.size(); i++) {
+		const uint32 index = getIndex(hits[i].object);
+
+		CHECK(index < boxes.size());
+		if (index >= boxes.size())
+			continue;
+
+		CHECK(boxes[index].inserted);
+		CHECK(found.insert(index).second);
+
+		CHECK((hits[i].distance >= 0.0f) && (hits[i].distance <= 1.0f));
+		if (i > 0)
+			CHECK(hits[i - 1].distance <= hits[i].distance);
+	}
+
+	for (uint32 i = 0; i < boxes.size(); i++) {
+		float distance;
+
+		if (boxes[i].inserted && Graphics::BVH::intersect(start, end, boxes[i].min, boxes[i].max, distance))
+			CHECK(found.find(i) != found.end());
+	}
+}
+
+static void checkAll(const Graphics::BVH &bvh, const std::vector<Box> &boxes) {
+	Common::TransformationMatrix perspective;
+	perspective.perspective(60.0f, 4.0f / 3.0f, 1.0f, 100.0f);
+
+	Common::TransformationMatrix ortho;
+	ortho.ortho(-50.0f, 50.0f, -20.0f, 20.0f, -100.0f, 100.0f);
+
+	Common::TransformationMatrix turned;
+	turned.perspective(60.0f, 4.0f / 3.0f, 1.0f, 100.0f);
+	turned.rotate(135.0f, 0.0f, 1.0f, 0.0f);
+	turned.translate(20.0f, -10.0f, 30.0f);
+
+	Graphics::Frustum frustum;
+
+	frustum.set(perspective);
+	checkQuery(bvh, boxes, frustum);
+	frustum.set(ortho);
+	checkQuery(bvh, boxes, frustum);
+	frustum.set(turned);
+	checkQuery(bvh, boxes, frustum);
+
+	const float start1[3] = { -150.0f, 0.0f,    0.0f }, end1[3] = { 150.0f,  0.0f,  0.0f };
+	const float start2[3] = {  -90.0f, 80.0f, -70.0f }, end2[3] = {  95.0f, -85.0f, 60.0f };
+	const float start3[3] = {    0.0f, 0.0f,    0.0f }, end3[3] = {   0.0f,  0.0f,  0.0f };
+
+	checkRaycast(bvh, boxes, start1, end1);
+	checkRaycast(bvh, boxes, start2, end2);
+	checkRaycast(bvh, boxes, start3, end3);
+
+	// Aim at the centers of some of the boxes, so that there's at least one hit
+	for (uint32 i = 0; i < boxes.size(); i += 25) {
+		const float center[3] = {
+			(boxes[i].min[0] + boxes[i].max[0]) / 2.0f,
+			(boxes[i].min[1] + boxes[i].max[1]) / 2.0f,
+			(boxes[i].min[2] + boxes[i].max[2]) / 2.0f
+		};
+
+		checkRaycast(bvh, boxes, start1, center);
+		checkRaycast(bvh, boxes, start2, center);
+	}
+}
+
+static uint32 countInserted(const std::vector<Box> &boxes) {
+	uint32 count = 0;
+	for (std::vector<Box>::const_iterator b = boxes.begin(); b != boxes.end(); ++b)
+		if (b->inserted)
+			count++;
+
+	return count;
+}
+
+static void testIntersect() {
+	const float min[3] = { -1.0f, -1.0f, -1.0f };
+	const float max[3] = {  1.0f,  1.0f,  1.0f };
+
+	float distance = -1.0f;
+
+	const float start1[3] = { -3.0f, 0.0f, 0.0f }, end1[3] = { 1.0f, 0.0f, 0.0f };
+	CHECK(Graphics::BVH::intersect(start1, end1, min, max, distance));
+	CHECK((distance > 0.49f) && (distance < 0.51f));
+
+	// Starting within the box
+	const float start2[3] = {  0.0f, 0.0f, 0.0f }, end2[3] = { 5.0f, 5.0f, 5.0f };
+	CHECK(Graphics::BVH::intersect(start2, end2, min, max, distance));
+	CHECK(distance == 0.0f);
+
+	// Ending before the box
+	const float start3[3] = { -5.0f, 0.0f, 0.0f }, end3[3] = { -2.0f, 0.0f, 0.0f };
+	CHECK(!Graphics::BVH::intersect(start3, end3, min, max, distance));
+
+	// Passing by the box
+	const float start4[3] = { -5.0f, 2.0f, 0.0f }, end4[3] = {  5.0f, 2.0f, 0.0f };
+	CHECK(!Graphics::BVH::intersect(start4, end4, min, max, distance));
+}
+
+static void testHierarchy() {
+	Test::Random random;
+
+	Graphics::BVH bvh;
+	CHECK(bvh.getCount() == 0);
+
+	std::vector<Box> boxes(kObjectCount);
+
+	// Insert
+	for (uint32 i = 0; i < boxes.size(); i++) {
+		randomBox(random, boxes[i]);
+
+		boxes[i].proxy    = bvh.insert(getObject(i), boxes[i].min, boxes[i].max);
+		boxes[i].inserted = true;
+
+		CHECK(boxes[i].proxy != Graphics::BVH::kInvalidProxy);
+	}
+
+	CHECK(bvh.getCount() == kObjectCount);
+	checkAll(bvh, boxes);
+
+	// Move, both slightly (staying within the enlarged leaf) and far away
+	for (uint32 i = 0; i < boxes.size(); i += 2) {
+		if (i % 4) {
+			for (int j = 0; j < 3; j++) {
+				boxes[i].min[j] += 0.01f;
+				boxes[i].max[j] += 0.01f;
+			}
+		} else
+			randomBox(random, boxes[i]);
+
+		bvh.move(boxes[i].proxy, boxes[i].min, boxes[i].max);
+	}
+
+	CHECK(bvh.getCount() == kObjectCount);
+	checkAll(bvh, boxes);
+
+	// Remove
+	for (uint32 i = 0; i < boxes.size(); i += 3) {
+		bvh.remove(boxes[i].proxy);
+		boxes[i].inserted = false;
+	}
+
+	CHECK(bvh.getCount() == countInserted(boxes));
+	checkAll(bvh, boxes);
+
+	// Insert again, reusing the freed nodes
+	for (uint32 i = 0; i < boxes.size(); i += 6) {
+		randomBox(random, boxes[i]);
+
+		boxes[i].proxy    = bvh.insert(getObject(i), boxes[i].min, boxes[i].max);
+		boxes[i].inserted = true;
+	}
+
+	CHECK(bvh.getCount() == countInserted(boxes));
+	checkAll(bvh, boxes);
+
+	// Remove everything
+	for (uint32 i = 0; i < boxes.size(); i++) {
+		if (!boxes[i].inserted)
+			continue;
+
+		bvh.remove(boxes[i].proxy);
+		boxes[i].inserted = false;
+	}
+
+	CHECK(bvh.getCount() == 0);
+	checkAll(bvh, boxes);
+
+	// An empty hierarchy finds nothing, even with a frustum that culls nothing
+	std::vector<Graphics::Renderable *> objects;
+	bvh.query(Graphics::Frustum(), objects);
+	CHECK(objects.empty());
+}
+
+static void testClear() {
+	Test::Random random;
+
+	Graphics::BVH bvh;
+
+	std::vector<Box> boxes(kObjectCount / 10);
+	for (uint32 i = 0; i < boxes.size(); i++) {
+		randomBox(random, boxes[i]);
+
+		boxes[i].proxy    = bvh.insert(getObject(i), boxes[i].min, boxes[i].max);
+		boxes[i].inserted = true;
+	}
+
+	CHECK(bvh.getCount() == boxes.size());
+
+	bvh.clear();
+	CHECK(bvh.getCount() == 0);
+
+	std::vector<Graphics::Renderable *> objects;
+	bvh.query(Graphics::Frustum(), objects);
+	CHECK(objects.empty());
+
+	// Still usable afterwards
+	boxes[0].proxy = bvh.insert(getObject(0), boxes[0].min, boxes[0].max);
+	CHECK(bvh.getCount() == 1);
+
+	bvh.query(Graphics::Frustum(), objects);
+	CHECK((objects.size() == 1) && (objects[0] == getObject(0)));
+}
+
+int main() {
+	testIntersect();
+	testHierarchy();
+	testClear();
+
+	return Test::getResult("test_bvh");
+}
@@ -0,0 +1,91 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for Common::FilePoolManager.
+ */
+
+#include <cstdio>
+
+#include "src/common/ustring.h"
+#include "src/common/filepool.h"
+
+#include "tests/unittest.h"
+
+static const char *kFileName = "test_filepool.tmp";
+
+static bool createFile() {
+	std::FILE *file = std::fopen(kFileName, "wb");
+	if (!file)
+		return false;
+
+	const bool written = std::fputs("0123456789", file) >= 0;
+
+	std::fclose(file);
+	return written;
+}
+
+static bool readFile() {
+	char data[4] = { 0, 0, 0, 0 };
+
+	return (FilePoolMan.read(kFileName, 3, data, 3) == 3) && (Common::UString(data) == "345");
+}
+
+static void testOwners() {
+	const Common::UString fileName(kFileName);
+
+	FilePoolMan.resetStatistics();
+
+	// Two archives of the same file
+	FilePoolMan.open(fileName);
+	FilePoolMan.open(fileName);
+
+	CHECK(readFile());
+	CHECK(FilePoolMan.getStatistics().opens == 1);
+
+	// The first one goes away, the second one keeps using the same handle
+	FilePoolMan.close(fileName);
+
+	CHECK(readFile());
+	CHECK(FilePoolMan.getStatistics().opens       == 1);
+	CHECK(FilePoolMan.getStatistics().openHandles == 1);
+
+	// The last one goes away, closing the handle
+	FilePoolMan.close(fileName);
+
+	CHECK(FilePoolMan.getStatistics().openHandles == 0);
+
+	// Reading without any owner still works, reopening the file
+	CHECK(readFile());
+	CHECK(FilePoolMan.getStatistics().opens == 2);
+
+	FilePoolMan.clear();
+	CHECK(FilePoolMan.getStatistics().openHandles == 0);
+}
+
+int main() {
+	CHECK(createFile());
+
+	testOwners();
+
+	std::remove(kFileName);
+
+	return Test::getResult("test_filepool");
+}
@@ -0,0 +1,133 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for Graphics::Frustum.
+ */
+
+#include "src/common/transmatrix.h"
+
+#include "src/graphics/frustum.h"
+
+#include "tests/unittest.h"
+
+/** Is a cube of this size around this center within the frustum? */
+static bool isIn(const Graphics::Frustum &frustum, float x, float y, float z, float size) {
+	const float min[3] = { x - size / 2.0f, y - size / 2.0f, z - size / 2.0f };
+	const float max[3] = { x + size / 2.0f, y + size / 2.0f, z + size / 2.0f };
+
+	return frustum.isIn(min, max);
+}
+
+static void testDefault() {
+	Graphics::Frustum frustum;
+
+	// Before any planes are set, nothing is culled
+	CHECK( isIn(frustum,     0.0f, 0.0f,     0.0f, 1.0f));
+	CHECK( isIn(frustum, 10000.0f, 0.0f, -10000.0f, 1.0f));
+}
+
+static void testPerspective() {
+	// 90 degrees field of view, looking down the negative z axis
+	Common::TransformationMatrix projection;
+	projection.perspective(90.0f, 1.0f, 1.0f, 100.0f);
+
+	Graphics::Frustum frustum;
+	frustum.set(projection);
+
+	// Fully within
+	CHECK( isIn(frustum,   0.0f,   0.0f,  -10.0f, 1.0f));
+	CHECK( isIn(frustum,   9.0f,  -9.0f,  -10.0f, 1.0f));
+	CHECK( isIn(frustum,   0.0f,   0.0f,  -99.0f, 1.0f));
+
+	// Behind the camera, before the near plane and beyond the far plane
+	CHECK(!isIn(frustum,   0.0f,   0.0f,   10.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f,   0.0f,   -0.5f, 0.2f));
+	CHECK(!isIn(frustum,   0.0f,   0.0f, -200.0f, 1.0f));
+
+	// Outside of the left, right, bottom and top planes
+	CHECK(!isIn(frustum, -12.0f,   0.0f,  -10.0f, 1.0f));
+	CHECK(!isIn(frustum,  12.0f,   0.0f,  -10.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f, -12.0f,  -10.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f,  12.0f,  -10.0f, 1.0f));
+
+	// Just within and just outside of the right plane, at x == -z
+	CHECK( isIn(frustum,  19.9f,   0.0f,  -20.0f, 0.1f));
+	CHECK(!isIn(frustum,  20.1f,   0.0f,  -20.0f, 0.1f));
+
+	// Intersecting a plane counts as within
+	CHECK( isIn(frustum,  10.0f,   0.0f,  -10.0f, 2.0f));
+	CHECK( isIn(frustum,   0.0f,   0.0f,   -1.0f, 1.0f));
+	CHECK( isIn(frustum,   0.0f,   0.0f, -100.0f, 1.0f));
+
+	// Enclosing the whole frustum
+	CHECK( isIn(frustum,   0.0f,   0.0f,    0.0f, 1000.0f));
+}
+
+static void testOrtho() {
+	Common::TransformationMatrix projection;
+	projection.ortho(-10.0f, 10.0f, -5.0f, 5.0f, 1.0f, 50.0f);
+
+	Graphics::Frustum frustum;
+	frustum.set(projection);
+
+	CHECK( isIn(frustum,   0.0f,  0.0f, -20.0f, 1.0f));
+	CHECK( isIn(frustum,   9.0f,  4.0f, -20.0f, 1.0f));
+	CHECK( isIn(frustum,  -9.0f, -4.0f,  -2.0f, 1.0f));
+
+	CHECK(!isIn(frustum,  11.0f,  0.0f, -20.0f, 1.0f));
+	CHECK(!isIn(frustum, -11.0f,  0.0f, -20.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f,  6.0f, -20.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f, -6.0f, -20.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f,  0.0f,  -0.2f, 0.2f));
+	CHECK(!isIn(frustum,   0.0f,  0.0f, -51.0f, 1.0f));
+
+	CHECK( isIn(frustum,  10.0f,  5.0f, -50.0f, 1.0f));
+}
+
+static void testModelView() {
+	Common::TransformationMatrix projection;
+	projection.perspective(90.0f, 1.0f, 1.0f, 100.0f);
+
+	// The camera stands at (100, 0, 0), turned to look down the positive x axis
+	Common::TransformationMatrix modelview;
+	modelview.rotate(90.0f, 0.0f, 1.0f, 0.0f);
+	modelview.translate(-100.0f, 0.0f, 0.0f);
+
+	Graphics::Frustum frustum;
+	frustum.set(projection * modelview);
+
+	CHECK( isIn(frustum, 110.0f, 0.0f,   0.0f, 1.0f));
+	CHECK( isIn(frustum, 150.0f, 0.0f,  40.0f, 1.0f));
+
+	CHECK(!isIn(frustum,  90.0f, 0.0f,   0.0f, 1.0f));
+	CHECK(!isIn(frustum,   0.0f, 0.0f, -10.0f, 1.0f));
+	CHECK(!isIn(frustum, 110.0f, 0.0f,  20.0f, 1.0f));
+	CHECK(!isIn(frustum, 250.0f, 0.0f,   0.0f, 1.0f));
+}
+
+int main() {
+	testDefault();
+	testPerspective();
+	testOrtho();
+	testModelView();
+
+	return Test::getResult("test_frustum");
+}
@@ -0,0 +1,72 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the NWScript VM's value stack.
+ */
+
+#include "src/common/ustring.h"
+
+#include "src/aurora/nwscript/ncsfile.h"
+
+#include "tests/unittest.h"
+
+using Aurora::NWScript::NCSStack;
+
+static void testStrings() {
+	NCSStack stack;
+
+	// Long enough to live on the heap
+	const Common::UString string("A string that is long enough not to be stored inline");
+
+	stack.pushString(string);
+	CHECK(stack.getString(stack.top()) == string);
+
+	// Pushing a string out of the stack's own pool, while the pool grows
+	for (int i = 0; i < 1000; i++)
+		stack.pushString(stack.getString(stack.top()));
+
+	CHECK(stack.getString(stack.top()) == string);
+
+	stack.pushString(Common::UString("!"));
+	stack.concatStrings();
+
+	CHECK(stack.getString(stack.top()) == (string + "!"));
+}
+
+static void testInts() {
+	NCSStack stack;
+
+	for (int32 i = 0; i < 100; i++)
+		stack.pushInt(i);
+
+	int32 sum = 0;
+	for (int32 i = 0; i < 100; i++)
+		sum += stack.popInt();
+
+	CHECK(sum == 4950);
+}
+
+int main() {
+	testStrings();
+	testInts();
+
+	return Test::getResult("test_ncsstack");
+}
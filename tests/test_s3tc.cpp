@@ -0,0 +1,194 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the DXTn decompressor.
+ *
+ *  The output is compared against the old stream-based decompressor, which
+ *  is kept here as the reference.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/util.h"
+#include "src/common/stream.h"
+
+#include "src/graphics/images/s3tc.h"
+
+#include "tests/unittest.h"
+#include "tests/benchmark.h"
+
+namespace Reference {
+
+static uint32 convert565To8888(uint16 color) {
+	return ((color & 0x1F) << 11) | ((color & 0x7E0) << 13) | ((color & 0xF800) << 16) | 0xFF;
+}
+
+static uint32 interpolate32(double weight, uint32 color_0, uint32 color_1) {
+	byte r[3], g[3], b[3], a[3];
+	r[0] = color_0 >> 24;
+	r[1] = color_1 >> 24;
+	r[2] = (byte)((1.0f - weight) * (double)r[0] + weight * (double)r[1]);
+	g[0] = (color_0 >> 16) & 0xFF;
+	g[1] = (color_1 >> 16) & 0xFF;
+	g[2] = (byte)((1.0f - weight) * (double)g[0] + weight * (double)g[1]);
+	b[0] = (color_0 >> 8) & 0xFF;
+	b[1] = (color_1 >> 8) & 0xFF;
+	b[2] = (byte)((1.0f - weight) * (double)b[0] + weight * (double)b[1]);
+	a[0] = color_0 & 0xFF;
+	a[1] = color_1 & 0xFF;
+	a[2] = (byte)((1.0f - weight) * (double)a[0] + weight * (double)a[1]);
+	return r[2] << 24 | g[2] << 16 | b[2] << 8 | a[2];
+}
+
+static void readColors(Common::SeekableReadStream &src, uint32 *blended, bool dxt1) {
+	const uint16 color_0 = src.readUint16LE();
+	const uint16 color_1 = src.readUint16LE();
+
+	blended[0] = convert565To8888(color_0);
+	blended[1] = convert565To8888(color_1);
+
+	if (dxt1 && (color_0 <= color_1)) {
+		blended[2] = interpolate32(0.5f, blended[0], blended[1]);
+		blended[3] = 0;
+		return;
+	}
+
+	if (!dxt1) {
+		blended[0] &= 0xFFFFFF00;
+		blended[1] &= 0xFFFFFF00;
+	}
+
+	blended[2] = interpolate32(0.333333f, blended[0], blended[1]);
+	blended[3] = interpolate32(0.666666f, blended[0], blended[1]);
+}
+
+static void decompress(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height,
+                       uint32 pitch, int dxtn) {
+
+	for (int32 ty = height; ty > 0; ty -= 4) {
+		for (uint32 tx = 0; tx < width; tx += 4) {
+			uint16 alpha3[4] = { 0, 0, 0, 0 };
+			byte   alphab[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+			uint64 alphabl   = 0;
+
+			if (dxtn == 3) {
+				for (int i = 0; i < 4; i++)
+					alpha3[i] = src.readUint16LE();
+			} else if (dxtn == 5) {
+				alphab[0] = src.readByte();
+				alphab[1] = src.readByte();
+
+				alphabl  = src.readUint32LE();
+				alphabl |= ((uint64) src.readUint16LE()) << 32;
+
+				if (alphab[0] > alphab[1]) {
+					for (int i = 1; i < 7; i++)
+						alphab[i + 1] = (byte)(((7 - i) * (double)alphab[0] + i * (double)alphab[1] + 3.0f) / 7.0f);
+				} else {
+					for (int i = 1; i < 5; i++)
+						alphab[i + 1] = (byte)(((5 - i) * (double)alphab[0] + i * (double)alphab[1] + 2.0f) / 5.0f);
+
+					alphab[6] = 0;
+					alphab[7] = 255;
+				}
+			}
+
+			uint32 blended[4];
+			readColors(src, blended, dxtn == 1);
+
+			uint32 cpx = src.readUint32BE();
+			uint32 blockWidth = MIN<uint32>(width, 4);
+			uint32 blockHeight = MIN<uint32>(height, 4);
+
+			for (byte y = 0; y < blockHeight; ++y) {
+				for (byte x = 0; x < blockWidth; ++x) {
+					uint32 alpha = 0;
+					if (dxtn == 3)
+						alpha = ((alpha3[y] >> (x * 4)) & 0xF) << 4;
+					else if (dxtn == 5)
+						alpha = alphab[(alphabl >> (3 * (4 * (3 - y) + x))) & 7];
+
+					WRITE_BE_UINT32(dest + (height - 1 - (ty - blockHeight + y)) * pitch + (tx + x) * 4, blended[cpx & 3] | alpha);
+					cpx >>= 2;
+				}
+			}
+		}
+	}
+}
+
+} // End of namespace Reference
+
+static bool compare(int dxtn, uint32 width, uint32 height, Test::Random &random) {
+	const uint32 blockSize = (dxtn == 1) ? 8 : 16;
+	const uint32 srcSize   = ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+	const uint32 pitch     = width * 4;
+
+	std::vector<byte> src(srcSize);
+	for (uint32 i = 0; i < srcSize; i++)
+		src[i] = random.next(256);
+
+	// Compare the whole buffers, so that stray writes show up as well
+	std::vector<byte> expected(pitch * height, 0xCD), decoded(pitch * height, 0xCD);
+
+	Common::MemoryReadStream stream(&src[0], srcSize);
+	Reference::decompress(&expected[0], stream, width, height, pitch, dxtn);
+
+	if      (dxtn == 1)
+		Graphics::decompressDXT1(&decoded[0], &src[0], srcSize, width, height, pitch);
+	else if (dxtn == 3)
+		Graphics::decompressDXT3(&decoded[0], &src[0], srcSize, width, height, pitch);
+	else if (dxtn == 5)
+		Graphics::decompressDXT5(&decoded[0], &src[0], srcSize, width, height, pitch);
+
+	return std::memcmp(&expected[0], &decoded[0], expected.size()) == 0;
+}
+
+static void testDecompress(int dxtn) {
+	// Mip maps smaller than a block and whole blocks
+	static const uint32 kSizes[][2] = {
+		{1, 1}, {2, 2}, {1, 2}, {2, 1}, {2, 4}, {4, 2}, {2, 8}, {8, 2}, {4, 4}, {8, 8}, {16, 4}, {32, 32}
+	};
+
+	Test::Random random;
+
+	for (uint32 i = 0; i < ARRAYSIZE(kSizes); i++) {
+		const uint32 width  = kSizes[i][0];
+		const uint32 height = kSizes[i][1];
+
+		bool identical = true;
+		for (int j = 0; j < 64; j++)
+			identical = compare(dxtn, width, height, random) && identical;
+
+		if (!CHECK(identical))
+			std::fprintf(stderr, "DXT%d %ux%u differs from the old decompressor\n", dxtn, width, height);
+	}
+}
+
+int main() {
+	testDecompress(1);
+	testDecompress(3);
+	testDecompress(5);
+
+	return Test::getResult("test_s3tc");
+}
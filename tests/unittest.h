@@ -0,0 +1,65 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Minimal helpers for the unit tests.
+ */
+
+#ifndef TESTS_UNITTEST_H
+#define TESTS_UNITTEST_H
+
+#include <cstdio>
+
+namespace Test {
+
+/** Return the number of failed checks so far. */
+inline int &getFailures() {
+	static int failures = 0;
+
+	return failures;
+}
+
+/** Count and report a failed check. */
+inline bool check(bool condition, const char *file, int line, const char *text) {
+	if (!condition) {
+		std::fprintf(stderr, "%s:%d: Check failed: %s\n", file, line, text);
+		getFailures()++;
+	}
+
+	return condition;
+}
+
+/** Print the result of a unit test, returning the process exit code. */
+inline int getResult(const char *name) {
+	if (getFailures() > 0) {
+		std::fprintf(stderr, "%s: %d check(s) failed\n", name, getFailures());
+		return 1;
+	}
+
+	std::printf("%s: OK\n", name);
+	return 0;
+}
+
+} // End of namespace Test
+
+/** Check that a condition holds, reporting it if it doesn't. */
+#define CHECK(x) Test::check((x), __FILE__, __LINE__, #x)
+
+#endif // TESTS_UNITTEST_H